@@ -33,8 +33,11 @@ enum {
   LIBMOBJECT_OPERATION_NOFLAG             = 0,
   LIBMOBJECT_OPERATION_BALANCE_READS      = 1,
   LIBMOBJECT_OPERATION_LOCALIZE_READS     = 2,
+  /* read operations wait for the write operations received before them
+     (by default, they only wait for the one being executed) */
   LIBMOBJECT_OPERATION_ORDER_READS_WRITES = 4,
   LIBMOBJECT_OPERATION_IGNORE_CACHE       = 8,
+  /* the server executes the operation without locking the object */
   LIBMOBJECT_OPERATION_SKIPRWLOCKS        = 16,
   LIBMOBJECT_OPERATION_IGNORE_OVERLAY     = 32,
   /* send requests to cluster despite the cluster or pool being marked
@@ -46,6 +49,15 @@ enum {
    */
   LIBMOBJECT_OPERATION_FULL_FORCE		= 128,
   LIBMOBJECT_OPERATION_IGNORE_REDIRECT	= 256,
+  /* write operations are acknowledged once their data is visible, and
+     reported safe once it has been persisted (see
+     mobject_store_aio_wait_for_safe) */
+  LIBMOBJECT_OPERATION_EARLY_ACK          = 512,
+  /* a write or write_full covering exactly the range of a previous write
+     overwrites its data in place instead of adding a new version of it;
+     reads of older versions of the object then see the new data, and the
+     range may be partially overwritten if the server fails */
+  LIBMOBJECT_OPERATION_OVERWRITE_IN_PLACE = 1024,
 };
 /** @} */
 
@@ -140,6 +152,15 @@ typedef struct mobject_store_completion* mobject_store_completion_t;
 
 #define MOBJECT_COMPLETION_NULL ((mobject_store_completion_t)0)
 
+/**
+ * @typedef mobject_store_completion_queue_t
+ * Gathers the completions of many asynchronous operations, so that
+ * they can be waited on and reaped together.
+ */
+typedef struct mobject_store_completion_queue* mobject_store_completion_queue_t;
+
+#define MOBJECT_COMPLETION_QUEUE_NULL ((mobject_store_completion_queue_t)0)
+
 /*****************************************
  * mobject store setup/teardown routines *
  *****************************************/
@@ -232,6 +253,61 @@ int mobject_store_ioctx_create(
  */
 void mobject_store_ioctx_destroy(mobject_store_ioctx_t ioctx);
 
+/**
+ * Enable client-side write buffering on an I/O context. Small writes
+ * (mobject_store_write_op_write) and appends (mobject_store_write_op_append)
+ * issued by mobject_store_write_op_operate that extend the data already
+ * buffered for the same object are coalesced into a single write operation.
+ * Buffered data is sent when the buffer of an object is full, when it has
+ * been pending for more than max_delay seconds (checked whenever the I/O
+ * context is used), when another operation targets the same object, or
+ * when mobject_store_ioctx_flush or mobject_store_ioctx_destroy is called.
+ *
+ * Errors from buffered writes are reported by the call that flushes them,
+ * or by the next call to mobject_store_ioctx_flush with a NULL oid.
+ *
+ * @param[in] ioctx     io context
+ * @param[in] max_bytes maximum number of bytes buffered per object
+ *                      (0 disables buffering, flushing pending writes)
+ * @param[in] max_delay maximum time in seconds a write may remain buffered
+ * @returns 0 on success, negative error code on failure
+ */
+int mobject_store_ioctx_set_write_buffer(
+    mobject_store_ioctx_t ioctx,
+    size_t max_bytes,
+    double max_delay);
+
+/**
+ * Enable the client-side read cache on an I/O context. The results of
+ * stat, read and omap_get_vals_by_keys actions are kept in memory along
+ * with the version of the object they come from. A read operation that
+ * only contains such actions and whose data is in the cache is served
+ * locally as long as the lease granted by the server (see the
+ * "read_lease_ms" provider setting) is valid; once it has expired, the
+ * client checks with the server that the object has not changed before
+ * using the cached data. Writes issued through this I/O context
+ * invalidate the cached data of the object they modify.
+ *
+ * @param[in] ioctx     io context
+ * @param[in] max_bytes maximum amount of cached data
+ *                      (0 disables the cache, dropping its content)
+ * @returns 0 on success, negative error code on failure
+ */
+int mobject_store_ioctx_set_read_cache(
+    mobject_store_ioctx_t ioctx,
+    size_t max_bytes);
+
+/**
+ * Send the buffered writes of an object, or of all objects.
+ *
+ * @param[in] ioctx     io context
+ * @param[in] oid       name of the object, NULL for all objects
+ * @returns 0 on success, negative error code on failure
+ */
+int mobject_store_ioctx_flush(
+    mobject_store_ioctx_t ioctx,
+    const char * oid);
+
 /******************************
  * mobject store i/o routines *
  ******************************/
@@ -308,6 +384,22 @@ void mobject_store_write_op_writesame(mobject_store_write_op_t write_op,
 void mobject_store_write_op_append(mobject_store_write_op_t write_op,
 		                   const char *buffer,
 				   size_t len);
+
+/**
+ * Append to end of object, getting the offset at which the data was
+ * written. Concurrent appends to an object are written one after the
+ * other, each at the offset returned to it.
+ * @param write_op operation to add this action to
+ * @param buffer bytes to write
+ * @param len length of buffer
+ * @param poffset where to store the offset of the data (may be NULL)
+ * @param prval where to store the return value of the action (may be NULL)
+ */
+void mobject_store_write_op_append2(mobject_store_write_op_t write_op,
+                                    const char *buffer,
+                                    size_t len,
+                                    uint64_t *poffset,
+                                    int *prval);
 /**
  * Remove object
  * @param write_op operation to add this action to
@@ -333,7 +425,9 @@ void mobject_store_write_op_zero(mobject_store_write_op_t write_op,
                                  uint64_t len);
 
 /**
- * Set key/value pairs on an object
+ * Set key/value pairs on an object. Keys are at most 128 characters long:
+ * the omap actions of a write operation with a longer key fail, and those
+ * of a read operation set their return value to -EINVAL.
  *
  * @param write_op operation to add this action to
  * @param keys array of null-terminated char arrays representing keys to set
@@ -358,6 +452,93 @@ void mobject_store_write_op_omap_rm_keys(mobject_store_write_op_t write_op,
                                          char const* const* keys,
                                          size_t keys_len);
 
+/**
+ * Remove the key/value pairs of an object whose keys are in a range
+ *
+ * @param write_op operation to add this action to
+ * @param start first key of the range (included)
+ * @param end end of the range (excluded), "" to remove all the keys
+ *        from start on
+ */
+void mobject_store_write_op_omap_rm_range(mobject_store_write_op_t write_op,
+                                          const char* start,
+                                          const char* end);
+
+/**
+ * Remove all key/value pairs from an object
+ *
+ * @param write_op operation to add this action to
+ */
+void mobject_store_write_op_omap_clear(mobject_store_write_op_t write_op);
+
+/**
+ * Atomically add delta to the value of a key, which must be a native
+ * int64_t (a key that does not exist counts as 0)
+ *
+ * @param write_op operation to add this action to
+ * @param key key whose value to update
+ * @param delta value to add
+ * @param presult where to store the new value, or NULL
+ * @param prval where to store the return value of this action: 0 on
+ *        success, -EINVAL if the value is not an int64_t or the key is
+ *        too long
+ */
+void mobject_store_write_op_omap_add(mobject_store_write_op_t write_op,
+                                     const char* key,
+                                     int64_t delta,
+                                     int64_t* presult,
+                                     int* prval);
+
+/**
+ * Atomically set the value of a key if its current value is the one
+ * expected. The other actions of the write operation are performed
+ * whether or not the value was set.
+ *
+ * @param write_op operation to add this action to
+ * @param key key whose value to set
+ * @param cmp_val expected value, or NULL if the key must not exist
+ * @param cmp_len length of the expected value
+ * @param val new value
+ * @param val_len length of the new value
+ * @param prval where to store the return value of this action: 0 if the
+ *        value was set, -ECANCELED if the current value did not match,
+ *        -EINVAL if the key is too long
+ */
+void mobject_store_write_op_omap_cmpxchg(mobject_store_write_op_t write_op,
+                                         const char* key,
+                                         const char* cmp_val,
+                                         size_t cmp_len,
+                                         const char* val,
+                                         size_t val_len,
+                                         int* prval);
+
+/**
+ * Prepare a write operation to be performed repeatedly. Its buffers are
+ * registered once and for all, and it can then be performed any number
+ * of times, on any object, with the offsets and lengths of its actions
+ * changed in between with mobject_store_write_op_rebind. No action can
+ * be added once the operation is prepared.
+ * @param write_op operation to prepare
+ * @param io the ioctx the operation will be performed with
+ * @returns 0 on success, negative error code on failure
+ */
+int mobject_store_write_op_prepare(mobject_store_write_op_t write_op,
+                                   mobject_store_ioctx_t io);
+
+/**
+ * Change the offset and length of the index-th action of a write operation
+ * (see mobject_write_op_rebind in mobject-client.h).
+ * @param write_op operation to modify
+ * @param index index of the action in the operation
+ * @param offset new offset
+ * @param len new length
+ * @returns 0 on success, negative error code on failure
+ */
+int mobject_store_write_op_rebind(mobject_store_write_op_t write_op,
+                                  size_t index,
+                                  uint64_t offset,
+                                  size_t len);
+
 /**
  * Perform a write operation synchronously
  * @param write_op operation to perform
@@ -388,6 +569,26 @@ int mobject_store_aio_write_op_operate(mobject_store_write_op_t write_op,
                                        time_t *mtime,
                                        int flags);
 
+/**
+ * Perform a batch of write operations synchronously. The operations are
+ * grouped by the server responsible for their object, and each group is
+ * sent in a single RPC. Operations targetting the same object are executed
+ * in the order in which they appear in the batch.
+ * @param write_ops operations to perform
+ * @param io the ioctx that the objects are in
+ * @param oids the object ids, one per operation
+ * @param count number of operations
+ * @param flags flags to apply to all the operations (LIBMOBJECT_OPERATION_*)
+ * @param rets where to store the return value of each operation (may be NULL)
+ * @returns 0 on success, the first error encountered otherwise
+ */
+int mobject_store_write_op_operate_batch(mobject_store_write_op_t *write_ops,
+                                         mobject_store_ioctx_t io,
+                                         const char * const *oids,
+                                         size_t count,
+                                         int flags,
+                                         int *rets);
+
 /**
  * Create a new mobject_store_read_op_t write operation. This will store all
  * actions to be performed atomically. You must call
@@ -474,6 +675,56 @@ void mobject_store_read_op_omap_get_vals(mobject_store_read_op_t read_op,
                                          mobject_store_omap_iter_t *iter,
                                          int *prval);
 
+/**
+ * Start iterating over keys on an object, in pages.
+ *
+ * Same as mobject_store_read_op_omap_get_keys(), but fewer than
+ * max_return keys may be returned when they do not fit in the bulk
+ * region receiving large results (see the MOBJECT_OMAP_BULK_SIZE
+ * environment variable). *pmore tells whether keys remain after the last
+ * one returned; the next page is obtained by passing that key as
+ * start_after.
+ *
+ * @param read_op operation to add this action to
+ * @param start_after list keys starting after start_after
+ * @param max_return list no more than max_return keys
+ * @param iter where to store the iterator
+ * @param pmore where to store whether more keys remain
+ * @param prval where to store the return value from this action
+ */
+void mobject_store_read_op_omap_get_keys2(mobject_store_read_op_t read_op,
+                                          const char *start_after,
+                                          uint64_t max_return,
+                                          mobject_store_omap_iter_t *iter,
+                                          unsigned char *pmore,
+                                          int *prval);
+
+/**
+ * Start iterating over key/value pairs on an object, in pages.
+ *
+ * Same as mobject_store_read_op_omap_get_vals(), but fewer than
+ * max_return pairs may be returned when they do not fit in the bulk
+ * region receiving large results (see the MOBJECT_OMAP_BULK_SIZE
+ * environment variable). *pmore tells whether pairs remain after the
+ * last one returned; the next page is obtained by passing its key as
+ * start_after.
+ *
+ * @param read_op operation to add this action to
+ * @param start_after list keys starting after start_after
+ * @param filter_prefix list only keys beginning with filter_prefix
+ * @param max_return list no more than max_return key/value pairs
+ * @param iter where to store the iterator
+ * @param pmore where to store whether more pairs remain
+ * @param prval where to store the return value from this action
+ */
+void mobject_store_read_op_omap_get_vals2(mobject_store_read_op_t read_op,
+                                          const char *start_after,
+                                          const char *filter_prefix,
+                                          uint64_t max_return,
+                                          mobject_store_omap_iter_t *iter,
+                                          unsigned char *pmore,
+                                          int *prval);
+
 /**
  * Start iterating over specific key/value pairs
  *
@@ -491,6 +742,30 @@ void mobject_store_read_op_omap_get_vals_by_keys(mobject_store_read_op_t read_op
                                                  mobject_store_omap_iter_t *iter,
                                                  int *prval);
 
+/**
+ * Prepare a read operation to be performed repeatedly
+ * (see mobject_store_write_op_prepare).
+ * @param read_op operation to prepare
+ * @param io the ioctx the operation will be performed with
+ * @returns 0 on success, negative error code on failure
+ */
+int mobject_store_read_op_prepare(mobject_store_read_op_t read_op,
+                                  mobject_store_ioctx_t io);
+
+/**
+ * Change the offset and length of the index-th action of a read
+ * operation, which must be a read action no larger than its buffer.
+ * @param read_op operation to modify
+ * @param index index of the action in the operation
+ * @param offset new offset
+ * @param len new length
+ * @returns 0 on success, negative error code on failure
+ */
+int mobject_store_read_op_rebind(mobject_store_read_op_t read_op,
+                                 size_t index,
+                                 uint64_t offset,
+                                 size_t len);
+
 /**
  * Perform a read operation synchronously
  * @param read_op operation to perform
@@ -517,6 +792,24 @@ int mobject_store_aio_read_op_operate(mobject_store_read_op_t read_op,
                                       const char *oid,
                                       int flags);
 
+/**
+ * Perform a batch of read operations synchronously. The operations are
+ * grouped by the server responsible for their object, and each group is
+ * sent in a single RPC. Read operations issued through a batch bypass the
+ * read cache of the ioctx.
+ * @param read_ops operations to perform
+ * @param io the ioctx that the objects are in
+ * @param oids the object ids, one per operation
+ * @param count number of operations
+ * @param flags flags to apply to all the operations (LIBMOBJECT_OPERATION_*)
+ * @returns 0 on success, the first error encountered otherwise
+ */
+int mobject_store_read_op_operate_batch(mobject_store_read_op_t *read_ops,
+                                        mobject_store_ioctx_t io,
+                                        const char * const *oids,
+                                        size_t count,
+                                        int flags);
+
 /**
  * Get the next omap key/value pair on the object
  *
@@ -566,7 +859,18 @@ typedef void (*mobject_store_callback_t)(mobject_store_completion_t cb, void *ar
  * on the OSDs.
  *
  * @note Read operations only get a complete callback.
+ * @note Writes are persisted by the server before it responds, so both
+ * callbacks are called once the response is received (complete first),
+ * unless the operation was started with LIBMOBJECT_OPERATION_EARLY_ACK,
+ * in which case the safe callback is only called once the server reports
+ * the data as persisted.
  * @note BUG: this should check for ENOMEM instead of throwing an exception
+ * @note Callbacks are called from a ULT of the client's margo instance as
+ * soon as the server's response is received, without the application
+ * having to wait on the completion. Setting the MOBJECT_CLIENT_PROGRESS_THREAD
+ * environment variable to 1 before mobject_store_connect makes them run on
+ * a dedicated progress thread, so that they do not depend on the
+ * application yielding to Argobots.
  *
  * @param cb_arg application-defined data passed to the callback functions
  * @param cb_complete the function to be called when the operation is
@@ -593,6 +897,18 @@ int mobject_store_aio_create_completion(void *cb_arg,
  */
 int mobject_store_aio_wait_for_complete(mobject_store_completion_t c);
 
+/**
+ * Block until an operation is safe
+ *
+ * This means it is on stable storage on all replicas. For writes
+ * started with LIBMOBJECT_OPERATION_EARLY_ACK, this may happen
+ * after the operation completed.
+ *
+ * @param c operation to wait for
+ * @returns 0
+ */
+int mobject_store_aio_wait_for_safe(mobject_store_completion_t c);
+
 /**
  * Has an asynchronous operation completed?
  *
@@ -604,6 +920,17 @@ int mobject_store_aio_wait_for_complete(mobject_store_completion_t c);
  */
 int mobject_store_aio_is_complete(mobject_store_completion_t c);
 
+/**
+ * Is an asynchronous operation safe?
+ *
+ * @warning This does not imply that the safe callback has
+ * finished
+ *
+ * @param c async operation to inspect
+ * @returns whether c is safe
+ */
+int mobject_store_aio_is_safe(mobject_store_completion_t c);
+
 /**
  * Get the return value of an asynchronous operation
  *
@@ -627,6 +954,85 @@ int mobject_store_aio_get_return_value(mobject_store_completion_t c);
  */
 void mobject_store_aio_release(mobject_store_completion_t c);
 
+/**
+ * Create a completion queue.
+ *
+ * @param pcq where to store the completion queue
+ * @returns 0
+ */
+int mobject_store_aio_create_completion_queue(
+    mobject_store_completion_queue_t *pcq);
+
+/**
+ * Release a completion queue. All the operations attached to the queue
+ * must have completed. Completions that have not been reaped are
+ * detached from the queue but not released.
+ *
+ * @param cq completion queue to release
+ * @returns 0 on success, -1 if operations are still in flight
+ */
+int mobject_store_aio_release_completion_queue(
+    mobject_store_completion_queue_t cq);
+
+/**
+ * Attach a completion to a completion queue. The completion may be
+ * attached before or after the operation using it has been started.
+ * Once attached, the completion is returned by exactly one call to
+ * mobject_store_aio_wait_any, mobject_store_aio_wait_n or
+ * mobject_store_aio_reap (or mobject_store_aio_wait_for_complete),
+ * after its callbacks have been called.
+ *
+ * @param cq completion queue
+ * @param c completion to attach
+ * @returns 0 on success, -1 if the completion is already attached
+ */
+int mobject_store_aio_completion_queue_add(
+    mobject_store_completion_queue_t cq,
+    mobject_store_completion_t c);
+
+/**
+ * Block until one of the operations attached to the queue completes.
+ *
+ * @param cq completion queue
+ * @param completion where to store the completed operation
+ * @returns 0 on success, -1 if no operation is attached to the queue
+ */
+int mobject_store_aio_wait_any(
+    mobject_store_completion_queue_t cq,
+    mobject_store_completion_t *completion);
+
+/**
+ * Block until n of the operations attached to the queue complete (or
+ * all of them if less than n are attached).
+ *
+ * @param cq completion queue
+ * @param n number of operations to wait for
+ * @param completions array of n entries where to store completed operations
+ * @param count where to store the number of completed operations returned
+ * @returns 0 on success, negative error code on failure
+ */
+int mobject_store_aio_wait_n(
+    mobject_store_completion_queue_t cq,
+    size_t n,
+    mobject_store_completion_t *completions,
+    size_t *count);
+
+/**
+ * Return up to max operations attached to the queue that have already
+ * completed, without blocking.
+ *
+ * @param cq completion queue
+ * @param max maximum number of operations to return
+ * @param completions array of max entries where to store completed operations
+ * @param count where to store the number of completed operations returned
+ * @returns 0 on success, negative error code on failure
+ */
+int mobject_store_aio_reap(
+    mobject_store_completion_queue_t cq,
+    size_t max,
+    mobject_store_completion_t *completions,
+    size_t *count);
+
 #ifdef __cplusplus
 }
 #endif
@@ -56,6 +56,7 @@ typedef mobject_store_callback_t   rados_callback_t;
 #define rados_write_op_zero                 mobject_store_write_op_zero
 #define rados_write_op_omap_set             mobject_store_write_op_omap_set
 #define rados_write_op_omap_rm_keys         mobject_store_write_op_omap_rm_keys
+#define rados_write_op_omap_clear           mobject_store_write_op_omap_clear
 #define rados_write_op_operate              mobject_store_write_op_operate
 #define rados_aio_write_op_operate          mobject_store_aio_write_op_operate
 #define rados_create_read_op                mobject_store_create_read_op
@@ -64,6 +65,8 @@ typedef mobject_store_callback_t   rados_callback_t;
 #define rados_read_op_read                  mobject_store_read_op_read
 #define rados_read_op_omap_get_vals         mobject_store_read_op_omap_get_vals
 #define rados_read_op_omap_get_vals_by_keys mobject_store_read_op_omap_get_vals_by_keys
+#define rados_read_op_omap_get_keys2        mobject_store_read_op_omap_get_keys2
+#define rados_read_op_omap_get_vals2        mobject_store_read_op_omap_get_vals2
 #define rados_read_op_operate               mobject_store_read_op_operate
 #define rados_aio_read_op_operate           mobject_store_aio_read_op_operate
 #define rados_omap_get_next                 mobject_store_omap_get_next
@@ -71,6 +74,8 @@ typedef mobject_store_callback_t   rados_callback_t;
 #define rados_aio_create_completion         mobject_store_aio_create_completion
 #define rados_aio_wait_for_complete         mobject_store_aio_wait_for_complete
 #define rados_aio_is_complete               mobject_store_aio_is_complete
+#define rados_aio_wait_for_safe             mobject_store_aio_wait_for_safe
+#define rados_aio_is_safe                   mobject_store_aio_is_safe
 #define rados_aio_get_return_value          mobject_store_aio_get_return_value
 #define rados_aio_release                   mobject_store_aio_release
 
@@ -170,6 +170,22 @@ extern "C" {
             const char *buffer,
             size_t len);
 
+    /**
+     * Append to end of object, getting the offset at which the data
+     * was written.
+     * @param write_op operation to add this action to
+     * @param buffer bytes to write
+     * @param len length of buffer
+     * @param poffset where to store the offset of the data (may be NULL)
+     * @param prval where to store the return value of the action (may be NULL)
+     */
+    void mobject_write_op_append2(
+            mobject_store_write_op_t write_op,
+            const char *buffer,
+            size_t len,
+            uint64_t *poffset,
+            int *prval);
+
     /**
      * Remove object
      * @param write_op operation to add this action to
@@ -224,6 +240,105 @@ extern "C" {
             char const* const* keys,
             size_t keys_len);
 
+    /**
+     * Remove the key/value pairs of an object whose keys are in a range
+     *
+     * @param write_op operation to add this action to
+     * @param start first key of the range (included)
+     * @param end end of the range (excluded), "" to remove all the keys
+     *        from start on
+     */
+    void mobject_write_op_omap_rm_range(
+            mobject_store_write_op_t write_op,
+            const char* start,
+            const char* end);
+
+    /**
+     * Remove all key/value pairs from an object
+     *
+     * @param write_op operation to add this action to
+     */
+    void mobject_write_op_omap_clear(mobject_store_write_op_t write_op);
+
+    /**
+     * Atomically add delta to the value of a key, which must be a native
+     * int64_t (a key that does not exist counts as 0)
+     *
+     * @param write_op operation to add this action to
+     * @param key key whose value to update
+     * @param delta value to add
+     * @param presult where to store the new value, or NULL
+     * @param prval where to store the return value of this action: 0 on
+     *        success, -EINVAL if the value is not an int64_t
+     */
+    void mobject_write_op_omap_add(
+            mobject_store_write_op_t write_op,
+            const char* key,
+            int64_t delta,
+            int64_t* presult,
+            int* prval);
+
+    /**
+     * Atomically set the value of a key if its current value is the one
+     * expected
+     *
+     * @param write_op operation to add this action to
+     * @param key key whose value to set
+     * @param cmp_val expected value, or NULL if the key must not exist
+     * @param cmp_len length of the expected value
+     * @param val new value
+     * @param val_len length of the new value
+     * @param prval where to store the return value of this action: 0 if
+     *        the value was set, -ECANCELED if the current value did not
+     *        match
+     */
+    void mobject_write_op_omap_cmpxchg(
+            mobject_store_write_op_t write_op,
+            const char* key,
+            const char* cmp_val,
+            size_t cmp_len,
+            const char* val,
+            size_t val_len,
+            int* prval);
+
+    /**
+     * Prepare a write operation so that it can be performed several
+     * times without registering its buffers again. Actions can no longer
+     * be added to the write operation, but the offsets and lengths of its
+     * actions can be changed with mobject_write_op_rebind between two
+     * calls to mobject_write_op_operate, and the content of its buffers
+     * can be modified while it is not being performed.
+     * @param client client that will perform the operation
+     * @param write_op operation to prepare
+     *
+     * @return 0 on success, -1 on failure
+     */
+    int mobject_write_op_prepare(
+            mobject_client_t client,
+            mobject_store_write_op_t write_op);
+
+    /**
+     * Change the offset and length of an action of a write operation.
+     * The action is the index-th action added to the write operation.
+     * offset is ignored for write_full and append actions, len for
+     * truncate actions, and len is the total number of bytes to write
+     * for writesame actions. Once the write operation has been prepared,
+     * the data of write, write_full and append actions must fit in the
+     * buffer given when the action was added.
+     * @param write_op operation to modify
+     * @param index index of the action
+     * @param offset new offset
+     * @param len new length
+     *
+     * @return 0 on success, -1 if the action has no offset or length to
+     * change or does not fit in its buffer
+     */
+    int mobject_write_op_rebind(
+            mobject_store_write_op_t write_op,
+            size_t index,
+            uint64_t offset,
+            size_t len);
+
     /**
      * Perform a write operation synchronously
      * @param write_op operation to perform
@@ -258,6 +373,29 @@ extern "C" {
             int flags,
             mobject_request_t* req);
 
+    /**
+     * Perform a batch of write operations synchronously. The write_ops
+     * must all target objects managed by the same provider: they are
+     * sent in a single RPC and executed in order by the provider, as if
+     * they had been issued one by one with mobject_write_op_operate.
+     * @param count number of write operations
+     * @param write_ops write operations to perform
+     * @param pool_name the name of the pool in which to write
+     * @param oids object ids, one per write operation
+     * @param flags flags to apply to all the operations (LIBMOBJECT_OPERATION_*)
+     * @param rets where to store the return value of each operation (may be NULL)
+     *
+     * @return 0 if the batch was executed, -1 otherwise
+     */
+    int mobject_write_op_operate_batch(
+            mobject_provider_handle_t handle,
+            size_t count,
+            mobject_store_write_op_t* write_ops,
+            const char* pool_name,
+            const char* const* oids,
+            int flags,
+            int* rets);
+
     /**
      * Create a new mobject_store_read_op_t write operation. This will store all
      * actions to be performed atomically. You must call
@@ -347,6 +485,50 @@ extern "C" {
             mobject_store_omap_iter_t *iter,
             int *prval);
 
+    /**
+     * Same as mobject_read_op_omap_get_keys, but fewer than max_return
+     * keys may be returned when the results are pushed to a bulk region
+     * too small to hold them all. *pmore tells whether keys remain after
+     * the last one returned.
+     *
+     * @param read_op operation to add this action to
+     * @param start_after list keys starting after start_after
+     * @param max_return list no more than max_return keys
+     * @param iter where to store the iterator
+     * @param pmore where to store whether more keys remain
+     * @param prval where to store the return value from this action
+     */
+    void mobject_read_op_omap_get_keys2(
+            mobject_store_read_op_t read_op,
+            const char *start_after,
+            uint64_t max_return,
+            mobject_store_omap_iter_t *iter,
+            unsigned char *pmore,
+            int *prval);
+
+    /**
+     * Same as mobject_read_op_omap_get_vals, but fewer than max_return
+     * pairs may be returned when the results are pushed to a bulk region
+     * too small to hold them all. *pmore tells whether pairs remain after
+     * the last one returned.
+     *
+     * @param read_op operation to add this action to
+     * @param start_after list keys starting after start_after
+     * @param filter_prefix list only keys beginning with filter_prefix
+     * @param max_return list no more than max_return key/value pairs
+     * @param iter where to store the iterator
+     * @param pmore where to store whether more pairs remain
+     * @param prval where to store the return value from this action
+     */
+    void mobject_read_op_omap_get_vals2(
+            mobject_store_read_op_t read_op,
+            const char *start_after,
+            const char *filter_prefix,
+            uint64_t max_return,
+            mobject_store_omap_iter_t *iter,
+            unsigned char *pmore,
+            int *prval);
+
     /**
      * Start iterating over specific key/value pairs
      *
@@ -365,6 +547,36 @@ extern "C" {
             mobject_store_omap_iter_t *iter,
             int *prval);
 
+    /**
+     * Prepare a read operation so that it can be performed several times
+     * without registering its buffers again (see mobject_write_op_prepare).
+     * @param client client that will perform the operation
+     * @param read_op operation to prepare
+     *
+     * @return 0 on success, -1 on failure
+     */
+    int mobject_read_op_prepare(
+            mobject_client_t client,
+            mobject_store_read_op_t read_op);
+
+    /**
+     * Change the offset and length of the index-th action of a read
+     * operation, which must be a read action. Once the read operation has
+     * been prepared, len must not exceed the length of the buffer given
+     * when the action was added.
+     * @param read_op operation to modify
+     * @param index index of the action
+     * @param offset new offset
+     * @param len new length
+     *
+     * @return 0 on success, -1 on failure
+     */
+    int mobject_read_op_rebind(
+            mobject_store_read_op_t read_op,
+            size_t index,
+            uint64_t offset,
+            size_t len);
+
 
     /**
      * Perform a read operation synchronously
@@ -380,6 +592,27 @@ extern "C" {
             const char *oid,
             int flags);
 
+    /**
+     * Perform a batch of read operations synchronously. The read_ops must
+     * all target objects managed by the same provider: they are sent in
+     * a single RPC and executed in order by the provider. The results of
+     * each read_op are reported through the pointers passed to its actions.
+     * @param count number of read operations
+     * @param read_ops read operations to perform
+     * @param pool_name the pool that the objects are in
+     * @param oids object ids, one per read operation
+     * @param flags flags to apply to all the operations (LIBMOBJECT_OPERATION_*)
+     *
+     * @return 0 if the batch was executed, -1 otherwise
+     */
+    int mobject_read_op_operate_batch(
+            mobject_provider_handle_t handle,
+            size_t count,
+            mobject_store_read_op_t* read_ops,
+            const char *pool_name,
+            const char* const* oids,
+            int flags);
+
     /**
      * Perform a read operation asynchronously
      * @param read_op operation to perform
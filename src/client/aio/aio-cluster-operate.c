@@ -20,6 +20,13 @@ int mobject_store_aio_write_op_operate(mobject_store_write_op_t   write_op,
                                        time_t*                    mtime,
                                        int                        flags)
 {
+    // buffered writes to the same object must reach the server first
+    if (io->write_back) {
+        int r = mobject_write_back_flush(io, oid);
+        if (r != 0) return r;
+    }
+    if (io->read_cache) mobject_read_cache_invalidate(io->read_cache, oid);
+
     // XXX pick other servers using ch-placement
     ssg_member_id_t svr_id;
     ssg_get_group_member_id_from_rank(io->cluster->gid, 0, &svr_id);
@@ -29,13 +36,18 @@ int mobject_store_aio_write_op_operate(mobject_store_write_op_t   write_op,
     mobject_provider_handle_t mph;
     mobject_provider_handle_create(io->cluster->mobject_clt, svr_addr, 1, &mph);
     mobject_request_t req;
-    mobject_aio_write_op_operate(mph, write_op, io->pool_name, oid, mtime,
-                                 flags, &req);
+    int r = mobject_aio_write_op_operate(mph, write_op, io->pool_name, oid,
+                                         mtime, flags, &req);
     mobject_provider_handle_release(mph);
+    if (r != 0) return r;
 
-    completion->request = req;
+    if (io->read_cache) {
+        r = mobject_completion_invalidate_on_ack(completion, io->read_cache,
+                                                 oid);
+        if (r != 0) mobject_read_cache_invalidate(io->read_cache, oid);
+    }
 
-    return 0;
+    return mobject_completion_start(completion, req);
 }
 
 int mobject_store_aio_read_op_operate(mobject_store_read_op_t    read_op,
@@ -44,6 +56,11 @@ int mobject_store_aio_read_op_operate(mobject_store_read_op_t    read_op,
                                       const char*                oid,
                                       int                        flags)
 {
+    if (io->write_back) {
+        int r = mobject_write_back_flush(io, oid);
+        if (r != 0) return r;
+    }
+
     // XXX pick other servers using ch-placement
     ssg_member_id_t svr_id;
     ssg_get_group_member_id_from_rank(io->cluster->gid, 0, &svr_id);
@@ -53,10 +70,10 @@ int mobject_store_aio_read_op_operate(mobject_store_read_op_t    read_op,
     mobject_provider_handle_t mph;
     mobject_provider_handle_create(io->cluster->mobject_clt, svr_addr, 1, &mph);
     mobject_request_t req;
-    mobject_aio_read_op_operate(mph, read_op, io->pool_name, oid, flags, &req);
+    int r = mobject_aio_read_op_operate(mph, read_op, io->pool_name, oid,
+                                        flags, &req);
     mobject_provider_handle_release(mph);
+    if (r != 0) return r;
 
-    completion->request = req;
-
-    return 0;
+    return mobject_completion_start(completion, req);
 }
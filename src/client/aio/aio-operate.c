@@ -10,6 +10,8 @@
 #include "src/client/mobject-client-impl.h"
 #include "src/io-chain/prepare-write-op.h"
 #include "src/io-chain/prepare-read-op.h"
+#include "src/io-chain/write-op-impl.h"
+#include "src/io-chain/read-op-impl.h"
 #include "src/rpc-types/write-op.h"
 #include "src/rpc-types/read-op.h"
 #include "src/util/log.h"
@@ -29,8 +31,11 @@ int mobject_aio_write_op_operate(mobject_provider_handle_t mph,
     in.object_name = oid;
     in.pool_name   = pool_name;
     in.write_op    = write_op;
+    in.flags       = flags;
+    in.wire_format = mph->wire_format;
     // TODO take mtime into account
 
+    write_op->wire_format = mph->wire_format;
     prepare_write_op(mph->client->mid, write_op);
 
     hg_addr_t svr_addr = mph->addr;
@@ -66,6 +71,10 @@ int mobject_aio_write_op_operate(mobject_provider_handle_t mph,
     tmp_req->op.write_op      = write_op;
     tmp_req->request          = mreq;
     tmp_req->handle           = h;
+    if (flags & LIBMOBJECT_OPERATION_EARLY_ACK) {
+        mobject_provider_handle_ref_incr(mph);
+        tmp_req->mph = mph;
+    }
 
     *req = tmp_req;
 
@@ -86,7 +95,13 @@ int mobject_aio_read_op_operate(mobject_provider_handle_t mph,
     in.object_name = oid;
     in.pool_name   = pool_name;
     in.read_op     = read_op;
+    in.flags       = flags;
+    in.wire_format = mph->wire_format;
 
+    if (!read_op->ready) {
+        read_op->wire_format    = mph->wire_format;
+        read_op->omap_bulk_size = mph->client->omap_bulk_size;
+    }
     prepare_read_op(mph->client->mid, read_op);
 
     hg_addr_t svr_addr = mph->addr;
@@ -130,24 +145,51 @@ int mobject_aio_read_op_operate(mobject_provider_handle_t mph,
 
 int mobject_aio_wait(mobject_request_t req, int* ret)
 {
+    mobject_provider_handle_t mph = MOBJECT_PROVIDER_HANDLE_NULL;
+    uint64_t                  persist_seq;
+
+    int r = mobject_aio_wait_early_ack(req, ret, &mph, &persist_seq);
+    if (mph != MOBJECT_PROVIDER_HANDLE_NULL)
+        mobject_provider_handle_release(mph);
+    return r;
+}
+
+int mobject_aio_wait_early_ack(mobject_request_t          req,
+                               int*                       ret,
+                               mobject_provider_handle_t* mph,
+                               uint64_t*                  persist_seq)
+{
+    *mph         = MOBJECT_PROVIDER_HANDLE_NULL;
+    *persist_seq = 0;
+
     if (req == MOBJECT_REQUEST_NULL) return -1;
 
     int r = margo_wait(req->request);
-    if (r != HG_SUCCESS) { return r; }
+    if (r != HG_SUCCESS) {
+        *ret = r;
+        /* the reference to the provider handle is released by the caller */
+        if (req->type == MOBJECT_AIO_WRITE) *mph = req->mph;
+        margo_destroy(req->handle);
+        free(req);
+        return r;
+    }
     req->request = MARGO_REQUEST_NULL;
 
     switch (req->type) {
 
     case MOBJECT_AIO_WRITE: {
         write_op_out_t resp;
-        r = margo_get_output(req->handle, &resp);
+        *mph = req->mph;
+        r    = margo_get_output(req->handle, &resp);
         if (r != HG_SUCCESS) {
             *ret = r;
             margo_destroy(req->handle);
             free(req);
             return r;
         }
-        *ret = resp.ret;
+        *ret         = resp.ret;
+        *persist_seq = resp.persist_seq;
+        feed_write_op_pointers_from_results(req->op.write_op, &resp.results);
         r    = margo_free_output(req->handle, &resp);
         if (r != HG_SUCCESS) { *ret = r; }
         margo_destroy(req->handle);
@@ -0,0 +1,140 @@
+/*
+ * (C) 2017 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdlib.h>
+#include "mobject-store-config.h"
+#include "libmobject-store.h"
+#include "src/client/aio/completion.h"
+#include "src/util/utlist.h"
+#include "src/util/log.h"
+
+int mobject_store_aio_create_completion_queue(
+    mobject_store_completion_queue_t* pcq)
+{
+    mobject_store_completion_queue_t cq
+        = (mobject_store_completion_queue_t)calloc(1, sizeof(*cq));
+    MOBJECT_ASSERT(cq != 0, "Could not allocate completion queue");
+    ABT_mutex_create(&cq->mutex);
+    ABT_cond_create(&cq->cond);
+    *pcq = cq;
+    return 0;
+}
+
+int mobject_store_aio_release_completion_queue(
+    mobject_store_completion_queue_t cq)
+{
+    if (cq == MOBJECT_COMPLETION_QUEUE_NULL) return -1;
+
+    ABT_mutex_lock(cq->mutex);
+    if (cq->pending || cq->completed) {
+        ABT_mutex_unlock(cq->mutex);
+        MOBJECT_LOG("Warning: trying to release a completion queue "
+                    "with completions still attached");
+        return -1;
+    }
+    ABT_mutex_unlock(cq->mutex);
+
+    ABT_cond_free(&cq->cond);
+    ABT_mutex_free(&cq->mutex);
+    free(cq);
+    return 0;
+}
+
+int mobject_store_aio_completion_queue_add(mobject_store_completion_queue_t cq,
+                                           mobject_store_completion_t       c)
+{
+    if (cq == MOBJECT_COMPLETION_QUEUE_NULL || c == MOBJECT_COMPLETION_NULL)
+        return -1;
+
+    ABT_mutex_lock(ABT_MUTEX_MEMORY_GET_HANDLE(&c->mutex));
+    if (c->queue != MOBJECT_COMPLETION_QUEUE_NULL) {
+        ABT_mutex_unlock(ABT_MUTEX_MEMORY_GET_HANDLE(&c->mutex));
+        return -1;
+    }
+    c->queue = cq;
+    ABT_mutex_lock(cq->mutex);
+    if (c->done) {
+        DL_APPEND(cq->completed, c);
+        c->in_list = COMPLETION_IN_COMPLETED_LIST;
+    } else {
+        DL_APPEND(cq->pending, c);
+        c->in_list = COMPLETION_IN_PENDING_LIST;
+        /* the operation may already have been started, and even have
+         * received its response while waiting for the data to be safe */
+        if (c->started) cq->num_pending += 1;
+    }
+    ABT_cond_broadcast(cq->cond);
+    ABT_mutex_unlock(cq->mutex);
+    ABT_mutex_unlock(ABT_MUTEX_MEMORY_GET_HANDLE(&c->mutex));
+
+    return 0;
+}
+
+int mobject_store_aio_reap(mobject_store_completion_queue_t cq,
+                           size_t                           max,
+                           mobject_store_completion_t*      completions,
+                           size_t*                          count)
+{
+    mobject_store_completion_t c;
+    size_t                     i, n = 0;
+
+    if (cq == MOBJECT_COMPLETION_QUEUE_NULL) return -1;
+
+    ABT_mutex_lock(cq->mutex);
+    while (n < max && cq->completed) {
+        c = cq->completed;
+        DL_DELETE(cq->completed, c);
+        c->in_list       = COMPLETION_IN_NO_LIST;
+        completions[n++] = c;
+    }
+    ABT_mutex_unlock(cq->mutex);
+
+    /* reaped completions no longer refer to the queue, which may
+     * therefore be released before them */
+    for (i = 0; i < n; i++) {
+        c = completions[i];
+        ABT_mutex_lock(ABT_MUTEX_MEMORY_GET_HANDLE(&c->mutex));
+        c->queue = MOBJECT_COMPLETION_QUEUE_NULL;
+        ABT_mutex_unlock(ABT_MUTEX_MEMORY_GET_HANDLE(&c->mutex));
+    }
+
+    *count = n;
+    return 0;
+}
+
+int mobject_store_aio_wait_n(mobject_store_completion_queue_t cq,
+                             size_t                           n,
+                             mobject_store_completion_t*      completions,
+                             size_t*                          count)
+{
+    mobject_store_completion_t c;
+    size_t                     num_completed;
+
+    if (cq == MOBJECT_COMPLETION_QUEUE_NULL) return -1;
+
+    /* wait until n operations have completed, or until all the operations
+     * in the queue have completed if there are less than n of them */
+    ABT_mutex_lock(cq->mutex);
+    while (1) {
+        DL_COUNT(cq->completed, c, num_completed);
+        if (num_completed >= n || cq->num_pending == 0) break;
+        ABT_cond_wait(cq->cond, cq->mutex);
+    }
+    ABT_mutex_unlock(cq->mutex);
+
+    return mobject_store_aio_reap(cq, n, completions, count);
+}
+
+int mobject_store_aio_wait_any(mobject_store_completion_queue_t cq,
+                               mobject_store_completion_t*      completion)
+{
+    size_t count = 0;
+    int    r     = mobject_store_aio_wait_n(cq, 1, completion, &count);
+    if (r != 0) return r;
+    /* no operation in flight in the queue */
+    if (count == 0) return -1;
+    return 0;
+}
@@ -5,13 +5,22 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include "mobject-store-config.h"
 #include "libmobject-store.h"
+#include "src/client/mobject-client-impl.h"
 #include "src/client/aio/completion.h"
 #include "src/rpc-types/read-op.h"
 #include "src/rpc-types/write-op.h"
+#include "src/util/utlist.h"
 #include "src/util/log.h"
 
+#define COMPLETION_MUTEX(c) ABT_MUTEX_MEMORY_GET_HANDLE(&(c)->mutex)
+#define COMPLETION_COND(c)  ABT_COND_MEMORY_GET_HANDLE(&(c)->cond)
+
+static void completion_ult(void* arg);
+static void completion_unref(mobject_store_completion_t c);
+
 int mobject_store_aio_create_completion(void*                       cb_arg,
                                         mobject_store_callback_t    cb_complete,
                                         mobject_store_callback_t    cb_safe,
@@ -25,6 +34,7 @@ int mobject_store_aio_create_completion(void*                       cb_arg,
     completion->cb_complete = cb_complete;
     completion->cb_safe     = cb_safe;
     completion->cb_arg      = cb_arg;
+    completion->refcount    = 1;
     *pc                     = completion;
     return 0;
 }
@@ -33,18 +43,47 @@ int mobject_store_aio_wait_for_complete(mobject_store_completion_t c)
 {
     if (c == MOBJECT_COMPLETION_NULL) { return -1; }
 
-    MOBJECT_ASSERT(c->request != MOBJECT_REQUEST_NULL,
+    MOBJECT_ASSERT(c->done || c->request != MOBJECT_REQUEST_NULL
+                       || c->acked,
                    "Invalid completion handle");
-    int ret;
-    int r = mobject_aio_wait(c->request, &ret);
-    if (r != 0) return (r);
 
-    c->ret_value = ret;
-    c->request   = MOBJECT_REQUEST_NULL;
+    mobject_store_completion_queue_t cq = c->queue;
+    if (cq != MOBJECT_COMPLETION_QUEUE_NULL) {
+        /* the completion is returned here instead of by the queue */
+        ABT_mutex_lock(cq->mutex);
+        while (!c->done) ABT_cond_wait(cq->cond, cq->mutex);
+        if (c->in_list == COMPLETION_IN_COMPLETED_LIST) {
+            DL_DELETE(cq->completed, c);
+            c->in_list = COMPLETION_IN_NO_LIST;
+        }
+        ABT_mutex_unlock(cq->mutex);
+        ABT_mutex_lock(COMPLETION_MUTEX(c));
+        c->queue = MOBJECT_COMPLETION_QUEUE_NULL;
+        ABT_mutex_unlock(COMPLETION_MUTEX(c));
+        return 0;
+    }
 
-    if (c->cb_safe) (c->cb_safe)(c, c->cb_arg);
+    ABT_mutex_lock(COMPLETION_MUTEX(c));
+    while (!c->acked) ABT_cond_wait(COMPLETION_COND(c), COMPLETION_MUTEX(c));
+    ABT_mutex_unlock(COMPLETION_MUTEX(c));
 
-    if (c->cb_complete) (c->cb_complete)(c, c->cb_arg);
+    return 0;
+}
+
+int mobject_store_aio_wait_for_safe(mobject_store_completion_t c)
+{
+    if (c == MOBJECT_COMPLETION_NULL) { return -1; }
+
+    MOBJECT_ASSERT(c->done || c->request != MOBJECT_REQUEST_NULL
+                       || c->acked,
+                   "Invalid completion handle");
+
+    if (c->queue != MOBJECT_COMPLETION_QUEUE_NULL)
+        return mobject_store_aio_wait_for_complete(c);
+
+    ABT_mutex_lock(COMPLETION_MUTEX(c));
+    while (!c->done) ABT_cond_wait(COMPLETION_COND(c), COMPLETION_MUTEX(c));
+    ABT_mutex_unlock(COMPLETION_MUTEX(c));
 
     return 0;
 }
@@ -53,12 +92,14 @@ int mobject_store_aio_is_complete(mobject_store_completion_t c)
 {
     if (c == MOBJECT_COMPLETION_NULL) { return 1; }
 
-    if (c->request == MOBJECT_REQUEST_NULL) { return 1; }
+    return c->acked || c->request == MOBJECT_REQUEST_NULL;
+}
 
-    int flag;
-    mobject_aio_test(c->request, &flag);
+int mobject_store_aio_is_safe(mobject_store_completion_t c)
+{
+    if (c == MOBJECT_COMPLETION_NULL) { return 1; }
 
-    return flag;
+    return c->done || (c->request == MOBJECT_REQUEST_NULL && !c->acked);
 }
 
 int mobject_store_aio_get_return_value(mobject_store_completion_t c)
@@ -74,8 +115,141 @@ int mobject_store_aio_get_return_value(mobject_store_completion_t c)
 void mobject_store_aio_release(mobject_store_completion_t c)
 {
     if (c == MOBJECT_COMPLETION_NULL) return;
-    MOBJECT_ASSERT(c->request == MOBJECT_REQUEST_NULL,
-                   "Trying to release a completion handle before operation "
-                   "completed (will lead to memory leaks)");
+    /* the completion is actually freed once its operation completed,
+     * which allows releasing it from its own callbacks */
+    completion_unref(c);
+}
+
+int mobject_completion_start(mobject_store_completion_t c,
+                             mobject_request_t          req)
+{
+    margo_instance_id mid = margo_hg_handle_get_instance(req->handle);
+    ABT_pool          pool;
+    int               ret;
+
+    ABT_mutex_lock(COMPLETION_MUTEX(c));
+    c->request = req;
+    c->started = 1;
+    c->refcount += 1;
+    if (c->queue != MOBJECT_COMPLETION_QUEUE_NULL) {
+        ABT_mutex_lock(c->queue->mutex);
+        c->queue->num_pending += 1;
+        ABT_mutex_unlock(c->queue->mutex);
+    }
+    ABT_mutex_unlock(COMPLETION_MUTEX(c));
+
+    margo_get_handler_pool(mid, &pool);
+    ret = ABT_thread_create(pool, completion_ult, c, ABT_THREAD_ATTR_NULL,
+                            NULL);
+    if (ret != ABT_SUCCESS) {
+        /* complete the operation from the calling ULT instead */
+        margo_error(mid, "[mobject] %s:%d: ABT_thread_create returned %d",
+                    __func__, __LINE__, ret);
+        completion_ult(c);
+    }
+    return 0;
+}
+
+int mobject_completion_invalidate_on_ack(mobject_store_completion_t c,
+                                         mobject_read_cache_t       cache,
+                                         const char*                oid)
+{
+    char* written_oid = strdup(oid);
+    if (!written_oid) return -1;
+    free(c->written_oid);
+    c->written_oid = written_oid;
+    c->read_cache  = cache;
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                          STATIC FUNCTIONS BELOW                            //
+////////////////////////////////////////////////////////////////////////////////
+
+static void completion_ult(void* arg)
+{
+    mobject_store_completion_t       c   = (mobject_store_completion_t)arg;
+    mobject_store_completion_queue_t cq  = MOBJECT_COMPLETION_QUEUE_NULL;
+    mobject_provider_handle_t        mph = MOBJECT_PROVIDER_HANDLE_NULL;
+    uint64_t                         persist_seq = 0;
+    int                              ret         = 0;
+
+    /* blocks on the request's eventual until the response arrives */
+    int r = mobject_aio_wait_early_ack(c->request, &ret, &mph, &persist_seq);
+
+    /* reads sent while the write was in flight may have cached old data */
+    if (c->read_cache) {
+        mobject_read_cache_invalidate(c->read_cache, c->written_oid);
+        free(c->written_oid);
+        c->written_oid = NULL;
+        c->read_cache  = NULL;
+    }
+
+    ABT_mutex_lock(COMPLETION_MUTEX(c));
+    c->ret_value = r != 0 ? r : ret;
+    c->request   = MOBJECT_REQUEST_NULL;
+    c->acked     = 1;
+    ABT_cond_broadcast(COMPLETION_COND(c));
+    ABT_mutex_unlock(COMPLETION_MUTEX(c));
+
+    if (c->cb_complete) (c->cb_complete)(c, c->cb_arg);
+
+    /* the write was acknowledged before being persisted */
+    if (mph != MOBJECT_PROVIDER_HANDLE_NULL) {
+        if (persist_seq != 0) {
+            r = mobject_persist_wait(mph, persist_seq);
+            if (r != 0 && c->ret_value == 0) c->ret_value = r;
+        }
+        mobject_provider_handle_release(mph);
+    }
+
+    if (c->cb_safe) (c->cb_safe)(c, c->cb_arg);
+
+    /* wake up the waiters */
+    ABT_mutex_lock(COMPLETION_MUTEX(c));
+    c->started = 0;
+    cq = c->queue;
+    if (cq != MOBJECT_COMPLETION_QUEUE_NULL) {
+        ABT_mutex_lock(cq->mutex);
+        c->done = 1;
+        if (c->in_list == COMPLETION_IN_PENDING_LIST) {
+            DL_DELETE(cq->pending, c);
+            DL_APPEND(cq->completed, c);
+            c->in_list = COMPLETION_IN_COMPLETED_LIST;
+        }
+        cq->num_pending -= 1;
+        ABT_cond_broadcast(cq->cond);
+        ABT_mutex_unlock(cq->mutex);
+    } else {
+        c->done = 1;
+    }
+    ABT_cond_broadcast(COMPLETION_COND(c));
+    ABT_mutex_unlock(COMPLETION_MUTEX(c));
+
+    completion_unref(c);
+}
+
+static void completion_unref(mobject_store_completion_t c)
+{
+    mobject_store_completion_queue_t cq;
+
+    ABT_mutex_lock(COMPLETION_MUTEX(c));
+    c->refcount -= 1;
+    if (c->refcount != 0) {
+        ABT_mutex_unlock(COMPLETION_MUTEX(c));
+        return;
+    }
+    /* detach the completion from its queue if it was never reaped */
+    cq = c->queue;
+    if (cq != MOBJECT_COMPLETION_QUEUE_NULL) {
+        ABT_mutex_lock(cq->mutex);
+        if (c->in_list == COMPLETION_IN_PENDING_LIST)
+            DL_DELETE(cq->pending, c);
+        else if (c->in_list == COMPLETION_IN_COMPLETED_LIST)
+            DL_DELETE(cq->completed, c);
+        ABT_mutex_unlock(cq->mutex);
+    }
+    ABT_mutex_unlock(COMPLETION_MUTEX(c));
+    free(c->written_oid);
     free(c);
 }
@@ -9,6 +9,7 @@
 #include <margo.h>
 #include "mobject-store-config.h"
 #include "libmobject-store.h"
+#include "src/client/read-cache.h"
 
 /**
  * The mobject_store_completion object is used for asynchronous
@@ -24,7 +25,72 @@ struct mobject_store_completion {
     mobject_store_callback_t cb_safe;     // safe callback
     void*                    cb_arg;      // arguments for callbacks
     mobject_request_t        request;     // margo request to wait on
+    /* read cache in which a written object is invalidated upon response */
+    mobject_read_cache_t read_cache;
+    char*                written_oid;
     int                      ret_value;   // return value of the operation
+    ABT_mutex_memory         mutex;       // protects the fields below
+    ABT_cond_memory          cond;        // signaled upon completion
+    int                      started;     // operation started, not done
+    int                      acked;       // response received
+    int                      done;        // operation completed and safe
+    int                      refcount;    // user + ULT waiting for the op
+    /* completion queue the completion is attached to, if any */
+    mobject_store_completion_queue_t queue;
+    int                              in_list; // see completion_list_t
+    struct mobject_store_completion* prev;    // links in the queue
+    struct mobject_store_completion* next;
 };
 
+/**
+ * List of its completion queue a completion belongs to
+ * (protected by the queue's mutex).
+ */
+typedef enum completion_list_t
+{
+    COMPLETION_IN_NO_LIST,
+    COMPLETION_IN_PENDING_LIST,
+    COMPLETION_IN_COMPLETED_LIST
+} completion_list_t;
+
+/**
+ * A completion queue gathers completions from many asynchronous
+ * operations. When the server's response to an operation arrives,
+ * the ULT waiting for it moves its completion from the pending list
+ * to the completed list and signals the queue's condition variable,
+ * so that callers of wait_any/wait_n block without polling the
+ * individual requests.
+ */
+struct mobject_store_completion_queue {
+    ABT_mutex                  mutex;
+    ABT_cond                   cond;
+    mobject_store_completion_t pending;     // attached, not completed
+    mobject_store_completion_t completed;   // completed, not yet reaped
+    size_t                     num_pending; // started, not completed
+};
+
+/**
+ * Associates the request of an asynchronous operation with the
+ * completion and starts a ULT that waits for the server's response,
+ * then calls the completion's callbacks and wakes up its waiters.
+ * For writes sent with LIBMOBJECT_OPERATION_EARLY_ACK, the complete
+ * callback is called when the response arrives and the safe callback
+ * once the server reports the data as persisted.
+ * The ULT runs in the handler pool of the client's margo instance, so
+ * callbacks are called as soon as the response is received without
+ * the application having to wait on the completion.
+ */
+int mobject_completion_start(mobject_store_completion_t c,
+                             mobject_request_t          req);
+
+/**
+ * Makes the completion of a write invalidate the object in the read
+ * cache when the response arrives, so that reads of the object sent
+ * while the write was in flight aren't served from the cache.
+ * Must be called before mobject_completion_start.
+ */
+int mobject_completion_invalidate_on_ack(mobject_store_completion_t c,
+                                         mobject_read_cache_t       cache,
+                                         const char*                oid);
+
 #endif
@@ -23,6 +23,24 @@
 
 static unsigned long sdbm_hash(const char* str);
 
+static unsigned long mobject_store_rank_of(mobject_store_ioctx_t io,
+                                           const char*           oid);
+
+struct batch_entry {
+    unsigned long rank;
+    size_t        index;
+};
+
+static int batch_entry_cmp(const void* a, const void* b);
+
+static int mobject_store_batch_prologue(mobject_store_ioctx_t io,
+                                        const char* const*    oids,
+                                        size_t                count);
+
+static struct batch_entry* mobject_store_batch_sort(mobject_store_ioctx_t io,
+                                                    const char* const*    oids,
+                                                    size_t count);
+
 static margo_log_level log_level = MARGO_LOG_INFO;
 
 static int
@@ -97,7 +115,13 @@ int mobject_store_connect(mobject_store_t cluster)
 
     /* initialize margo */
     /* XXX: probably want to expose some way of tweaking threading parameters */
-    margo_instance_id mid = margo_init(proto, MARGO_SERVER_MODE, 0, -1);
+    /* a progress thread lets aio callbacks run while the application is
+     * busy outside of mobject */
+    char* progress_thread_env = getenv(MOBJECT_CLIENT_PROGRESS_THREAD_ENV);
+    int   use_progress_thread
+        = progress_thread_env && strcmp(progress_thread_env, "1") == 0;
+    margo_instance_id mid
+        = margo_init(proto, MARGO_SERVER_MODE, use_progress_thread, -1);
     if (mid == MARGO_INSTANCE_NULL) {
         margo_error(NULL, "Unable to initialize margo");
         return -1;
@@ -230,10 +254,38 @@ int mobject_store_ioctx_create(mobject_store_t        cluster,
 
 void mobject_store_ioctx_destroy(mobject_store_ioctx_t ioctx)
 {
+    if (ioctx && ioctx->write_back) mobject_write_back_destroy(ioctx);
+    if (ioctx) mobject_read_cache_destroy(ioctx->read_cache);
     if (ioctx) free(ioctx->pool_name);
     free(ioctx);
 }
 
+int mobject_store_ioctx_set_write_buffer(mobject_store_ioctx_t ioctx,
+                                         size_t                max_bytes,
+                                         double                max_delay)
+{
+    int ret = 0;
+    if (ioctx->write_back) ret = mobject_write_back_destroy(ioctx);
+    if (max_bytes == 0) return ret;
+    int r = mobject_write_back_create(max_bytes, max_delay, &ioctx->write_back);
+    return ret != 0 ? ret : r;
+}
+
+int mobject_store_ioctx_set_read_cache(mobject_store_ioctx_t ioctx,
+                                       size_t                max_bytes)
+{
+    mobject_read_cache_destroy(ioctx->read_cache);
+    ioctx->read_cache = NULL;
+    if (max_bytes == 0) return 0;
+    return mobject_read_cache_create(max_bytes, &ioctx->read_cache);
+}
+
+int mobject_store_ioctx_flush(mobject_store_ioctx_t ioctx, const char* oid)
+{
+    if (!ioctx->write_back) return 0;
+    return mobject_write_back_flush(ioctx, oid);
+}
+
 mobject_store_write_op_t mobject_store_create_write_op(void)
 {
     return mobject_create_write_op();
@@ -284,6 +336,15 @@ void mobject_store_write_op_append(mobject_store_write_op_t write_op,
     mobject_write_op_append(write_op, buffer, len);
 }
 
+void mobject_store_write_op_append2(mobject_store_write_op_t write_op,
+                                    const char*              buffer,
+                                    size_t                   len,
+                                    uint64_t*                poffset,
+                                    int*                     prval)
+{
+    mobject_write_op_append2(write_op, buffer, len, poffset, prval);
+}
+
 void mobject_store_write_op_remove(mobject_store_write_op_t write_op)
 {
     mobject_write_op_remove(write_op);
@@ -318,31 +379,81 @@ void mobject_store_write_op_omap_rm_keys(mobject_store_write_op_t write_op,
     mobject_write_op_omap_rm_keys(write_op, keys, keys_len);
 }
 
+void mobject_store_write_op_omap_rm_range(mobject_store_write_op_t write_op,
+                                          const char*              start,
+                                          const char*              end)
+{
+    mobject_write_op_omap_rm_range(write_op, start, end);
+}
+
+void mobject_store_write_op_omap_clear(mobject_store_write_op_t write_op)
+{
+    mobject_write_op_omap_clear(write_op);
+}
+
+void mobject_store_write_op_omap_add(mobject_store_write_op_t write_op,
+                                     const char*              key,
+                                     int64_t                  delta,
+                                     int64_t*                 presult,
+                                     int*                     prval)
+{
+    mobject_write_op_omap_add(write_op, key, delta, presult, prval);
+}
+
+void mobject_store_write_op_omap_cmpxchg(mobject_store_write_op_t write_op,
+                                         const char*              key,
+                                         const char*              cmp_val,
+                                         size_t                   cmp_len,
+                                         const char*              val,
+                                         size_t                   val_len,
+                                         int*                     prval)
+{
+    mobject_write_op_omap_cmpxchg(write_op, key, cmp_val, cmp_len, val,
+                                  val_len, prval);
+}
+
+int mobject_store_write_op_prepare(mobject_store_write_op_t write_op,
+                                   mobject_store_ioctx_t    io)
+{
+    return mobject_write_op_prepare(io->cluster->mobject_clt, write_op);
+}
+
+int mobject_store_write_op_rebind(mobject_store_write_op_t write_op,
+                                  size_t                   index,
+                                  uint64_t                 offset,
+                                  size_t                   len)
+{
+    return mobject_write_op_rebind(write_op, index, offset, len);
+}
+
 int mobject_store_write_op_operate(mobject_store_write_op_t write_op,
                                    mobject_store_ioctx_t    io,
                                    const char*              oid,
                                    time_t*                  mtime,
                                    int                      flags)
 {
-    mobject_provider_handle_t mph      = MOBJECT_PROVIDER_HANDLE_NULL;
-    uint64_t                  oid_hash = sdbm_hash(oid);
-    unsigned long             server_rank;
-    ch_placement_find_closest(io->cluster->ch_instance, oid_hash, 1,
-                              &server_rank);
-    ssg_member_id_t svr_id;
-    ssg_get_group_member_id_from_rank(io->cluster->gid, server_rank, &svr_id);
-    hg_addr_t svr_addr;
-    ssg_get_group_member_addr(io->cluster->gid, svr_id, &svr_addr);
+    mobject_provider_handle_t mph = MOBJECT_PROVIDER_HANDLE_NULL;
+    int                       r;
+
+    if (io->write_back) {
+        mobject_write_back_flush_expired(io);
+        r = mobject_write_back_absorb(io, write_op, oid, mtime, flags);
+        if (r != 0) {
+            if (io->read_cache)
+                mobject_read_cache_invalidate(io->read_cache, oid);
+            return r == 1 ? 0 : r;
+        }
+    }
 
-    // TODO for now multiplex id is hard-coded as 1
-    // XXX multiple providers may be in the same node (with distinct mplex ids)
-    int r = mobject_provider_handle_create(io->cluster->mobject_clt, svr_addr,
-                                           1, &mph);
+    r = mobject_store_locate(io, oid, &mph);
     if (r != 0) return r;
 
+    /* invalidated before and after the write, see read-cache.h */
+    if (io->read_cache) mobject_read_cache_invalidate(io->read_cache, oid);
     r = mobject_write_op_operate(mph, write_op, io->pool_name, oid, mtime,
                                  flags);
     mobject_provider_handle_release(mph);
+    if (io->read_cache) mobject_read_cache_invalidate(io->read_cache, oid);
     return r;
 }
 
@@ -395,6 +506,29 @@ void mobject_store_read_op_omap_get_vals(mobject_store_read_op_t read_op,
                                   max_return, iter, prval);
 }
 
+void mobject_store_read_op_omap_get_keys2(mobject_store_read_op_t read_op,
+                                          const char* start_after,
+                                          uint64_t    max_return,
+                                          mobject_store_omap_iter_t* iter,
+                                          unsigned char*             pmore,
+                                          int*                       prval)
+{
+    mobject_read_op_omap_get_keys2(read_op, start_after, max_return, iter,
+                                   pmore, prval);
+}
+
+void mobject_store_read_op_omap_get_vals2(mobject_store_read_op_t read_op,
+                                          const char* start_after,
+                                          const char* filter_prefix,
+                                          uint64_t    max_return,
+                                          mobject_store_omap_iter_t* iter,
+                                          unsigned char*             pmore,
+                                          int*                       prval)
+{
+    mobject_read_op_omap_get_vals2(read_op, start_after, filter_prefix,
+                                   max_return, iter, pmore, prval);
+}
+
 void mobject_store_read_op_omap_get_vals_by_keys(
     mobject_store_read_op_t    read_op,
     char const* const*         keys,
@@ -405,26 +539,38 @@ void mobject_store_read_op_omap_get_vals_by_keys(
     mobject_read_op_omap_get_vals_by_keys(read_op, keys, keys_len, iter, prval);
 }
 
+int mobject_store_read_op_prepare(mobject_store_read_op_t read_op,
+                                  mobject_store_ioctx_t   io)
+{
+    return mobject_read_op_prepare(io->cluster->mobject_clt, read_op);
+}
+
+int mobject_store_read_op_rebind(mobject_store_read_op_t read_op,
+                                 size_t                  index,
+                                 uint64_t                offset,
+                                 size_t                  len)
+{
+    return mobject_read_op_rebind(read_op, index, offset, len);
+}
+
 int mobject_store_read_op_operate(mobject_store_read_op_t read_op,
                                   mobject_store_ioctx_t   ioctx,
                                   const char*             oid,
                                   int                     flags)
 {
-    mobject_provider_handle_t mph      = MOBJECT_PROVIDER_HANDLE_NULL;
-    uint64_t                  oid_hash = sdbm_hash(oid);
-    unsigned long             server_rank;
-    ch_placement_find_closest(ioctx->cluster->ch_instance, oid_hash, 1,
-                              &server_rank);
-    ssg_member_id_t svr_id;
-    ssg_get_group_member_id_from_rank(ioctx->cluster->gid, server_rank,
-                                      &svr_id);
-    hg_addr_t svr_addr;
-    ssg_get_group_member_addr(ioctx->cluster->gid, svr_id, &svr_addr);
+    mobject_provider_handle_t mph = MOBJECT_PROVIDER_HANDLE_NULL;
+    int                       r;
 
-    // XXX multiple providers may be in the same node (with distinct mplex ids)
-    // TODO for now multiplex id is hard-coded as 1
-    int r = mobject_provider_handle_create(ioctx->cluster->mobject_clt,
-                                           svr_addr, 1, &mph);
+    if (ioctx->write_back) {
+        mobject_write_back_flush_expired(ioctx);
+        r = mobject_write_back_flush(ioctx, oid);
+        if (r != 0) return r;
+    }
+
+    if (ioctx->read_cache)
+        return mobject_read_cache_operate(ioctx, read_op, oid, flags);
+
+    r = mobject_store_locate(ioctx, oid, &mph);
     if (r != 0) return r;
 
     r = mobject_read_op_operate(mph, read_op, ioctx->pool_name, oid, flags);
@@ -432,6 +578,125 @@ int mobject_store_read_op_operate(mobject_store_read_op_t read_op,
     return r;
 }
 
+int mobject_store_write_op_operate_batch(mobject_store_write_op_t* write_ops,
+                                         mobject_store_ioctx_t     io,
+                                         const char* const*        oids,
+                                         size_t                    count,
+                                         int                       flags,
+                                         int*                      rets)
+{
+    mobject_provider_handle_t mph = MOBJECT_PROVIDER_HANDLE_NULL;
+    struct batch_entry*       entries;
+    mobject_store_write_op_t* group_ops;
+    const char**              group_oids;
+    int*                      group_rets;
+    size_t                    i, j, n;
+    int                       r, ret = 0;
+
+    if (count == 0) return 0;
+
+    r = mobject_store_batch_prologue(io, oids, count);
+    if (r != 0) return r;
+
+    entries    = mobject_store_batch_sort(io, oids, count);
+    group_ops  = calloc(count, sizeof(*group_ops));
+    group_oids = calloc(count, sizeof(*group_oids));
+    group_rets = calloc(count, sizeof(*group_rets));
+
+    /* send one RPC per server, with all the write_ops it is responsible for */
+    for (i = 0; i < count; i += n) {
+        for (n = 0; i + n < count && entries[i + n].rank == entries[i].rank;
+             n++) {
+            group_ops[n]  = write_ops[entries[i + n].index];
+            group_oids[n] = oids[entries[i + n].index];
+            group_rets[n] = 0;
+        }
+        if (io->read_cache) {
+            for (j = 0; j < n; j++)
+                mobject_read_cache_invalidate(io->read_cache, group_oids[j]);
+        }
+        r = mobject_store_locate(io, group_oids[0], &mph);
+        if (r == 0) {
+            r = mobject_write_op_operate_batch(mph, n, group_ops,
+                                               io->pool_name, group_oids,
+                                               flags, group_rets);
+            mobject_provider_handle_release(mph);
+        }
+        if (r != 0 && ret == 0) ret = r;
+        for (j = 0; j < n; j++) {
+            if (rets) rets[entries[i + j].index] = r != 0 ? r : group_rets[j];
+            if (io->read_cache)
+                mobject_read_cache_invalidate(io->read_cache, group_oids[j]);
+        }
+    }
+
+    free(group_rets);
+    free(group_oids);
+    free(group_ops);
+    free(entries);
+    return ret;
+}
+
+int mobject_store_read_op_operate_batch(mobject_store_read_op_t* read_ops,
+                                        mobject_store_ioctx_t    io,
+                                        const char* const*       oids,
+                                        size_t                   count,
+                                        int                      flags)
+{
+    mobject_provider_handle_t mph = MOBJECT_PROVIDER_HANDLE_NULL;
+    struct batch_entry*       entries;
+    mobject_store_read_op_t*  group_ops;
+    const char**              group_oids;
+    size_t                    i, n;
+    int                       r, ret = 0;
+
+    if (count == 0) return 0;
+
+    r = mobject_store_batch_prologue(io, oids, count);
+    if (r != 0) return r;
+
+    entries    = mobject_store_batch_sort(io, oids, count);
+    group_ops  = calloc(count, sizeof(*group_ops));
+    group_oids = calloc(count, sizeof(*group_oids));
+
+    /* send one RPC per server, with all the read_ops it is responsible for */
+    for (i = 0; i < count; i += n) {
+        for (n = 0; i + n < count && entries[i + n].rank == entries[i].rank;
+             n++) {
+            group_ops[n]  = read_ops[entries[i + n].index];
+            group_oids[n] = oids[entries[i + n].index];
+        }
+        r = mobject_store_locate(io, group_oids[0], &mph);
+        if (r == 0) {
+            r = mobject_read_op_operate_batch(mph, n, group_ops, io->pool_name,
+                                              group_oids, flags);
+            mobject_provider_handle_release(mph);
+        }
+        if (r != 0 && ret == 0) ret = r;
+    }
+
+    free(group_oids);
+    free(group_ops);
+    free(entries);
+    return ret;
+}
+
+int mobject_store_locate(mobject_store_ioctx_t      io,
+                         const char*                oid,
+                         mobject_provider_handle_t* mph)
+{
+    unsigned long   server_rank = mobject_store_rank_of(io, oid);
+    ssg_member_id_t svr_id;
+    ssg_get_group_member_id_from_rank(io->cluster->gid, server_rank, &svr_id);
+    hg_addr_t svr_addr;
+    ssg_get_group_member_addr(io->cluster->gid, svr_id, &svr_addr);
+
+    // XXX multiple providers may be in the same node (with distinct mplex ids)
+    // TODO for now multiplex id is hard-coded as 1
+    return mobject_provider_handle_create(io->cluster->mobject_clt, svr_addr, 1,
+                                          mph);
+}
+
 // send a shutdown signal to a server cluster
 static int
 mobject_store_shutdown_servers(struct mobject_store_handle* cluster_handle)
@@ -460,3 +725,57 @@ static unsigned long sdbm_hash(const char* str)
 
     return hash;
 }
+
+static unsigned long mobject_store_rank_of(mobject_store_ioctx_t io,
+                                           const char*           oid)
+{
+    uint64_t      oid_hash = sdbm_hash(oid);
+    unsigned long server_rank;
+    ch_placement_find_closest(io->cluster->ch_instance, oid_hash, 1,
+                              &server_rank);
+    return server_rank;
+}
+
+static int batch_entry_cmp(const void* a, const void* b)
+{
+    const struct batch_entry* ea = (const struct batch_entry*)a;
+    const struct batch_entry* eb = (const struct batch_entry*)b;
+    if (ea->rank != eb->rank) return ea->rank < eb->rank ? -1 : 1;
+    /* keep the order of the batch within a server */
+    if (ea->index != eb->index) return ea->index < eb->index ? -1 : 1;
+    return 0;
+}
+
+// writes buffered for objects of a batch must reach the servers first
+static int mobject_store_batch_prologue(mobject_store_ioctx_t io,
+                                        const char* const*    oids,
+                                        size_t                count)
+{
+    size_t i;
+    int    r;
+
+    if (!io->write_back) return 0;
+
+    mobject_write_back_flush_expired(io);
+    for (i = 0; i < count; i++) {
+        r = mobject_write_back_flush(io, oids[i]);
+        if (r != 0) return r;
+    }
+    return 0;
+}
+
+// sorts the entries of a batch by the rank of the server they target
+static struct batch_entry* mobject_store_batch_sort(mobject_store_ioctx_t io,
+                                                    const char* const*    oids,
+                                                    size_t count)
+{
+    struct batch_entry* entries = calloc(count, sizeof(*entries));
+    size_t              i;
+
+    for (i = 0; i < count; i++) {
+        entries[i].rank  = mobject_store_rank_of(io, oids[i]);
+        entries[i].index = i;
+    }
+    qsort(entries, count, sizeof(*entries), batch_entry_cmp);
+    return entries;
+}
@@ -12,9 +12,12 @@
 
 #include "libmobject-store.h"
 #include "mobject-client.h"
+#include "src/client/write-back.h"
+#include "src/client/read-cache.h"
 
-#define MOBJECT_CLUSTER_FILE_ENV          "MOBJECT_CLUSTER_FILE"
-#define MOBJECT_CLUSTER_SHUTDOWN_KILL_ENV "MOBJECT_SHUTDOWN_KILL_SERVERS"
+#define MOBJECT_CLUSTER_FILE_ENV           "MOBJECT_CLUSTER_FILE"
+#define MOBJECT_CLUSTER_SHUTDOWN_KILL_ENV  "MOBJECT_SHUTDOWN_KILL_SERVERS"
+#define MOBJECT_CLIENT_PROGRESS_THREAD_ENV "MOBJECT_CLIENT_PROGRESS_THREAD"
 
 typedef struct ch_placement_instance* chi_t;
 
@@ -27,8 +30,18 @@ struct mobject_store_handle {
 };
 
 struct mobject_store_ioctx {
-    mobject_store_t cluster;
-    char*           pool_name;
+    mobject_store_t      cluster;
+    char*                pool_name;
+    mobject_write_back_t write_back; // NULL unless write buffering is enabled
+    mobject_read_cache_t read_cache; // NULL unless read caching is enabled
 };
 
+/**
+ * Creates a provider handle for the server responsible for the
+ * given object. The handle must be released by the caller.
+ */
+int mobject_store_locate(mobject_store_ioctx_t      io,
+                         const char*                oid,
+                         mobject_provider_handle_t* mph);
+
 #endif
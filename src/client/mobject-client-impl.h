@@ -11,6 +11,7 @@
 #include <stdlib.h>
 #include <margo.h>
 #include <ssg.h>
+#include <abt.h>
 
 #include "mobject-client.h"
 
@@ -23,8 +24,29 @@ struct mobject_client {
     hg_id_t mobject_write_op_rpc_id;
     hg_id_t mobject_read_op_rpc_id;
     hg_id_t mobject_shutdown_rpc_id;
+    hg_id_t mobject_object_version_rpc_id;
+    hg_id_t mobject_write_op_batch_rpc_id;
+    hg_id_t mobject_read_op_batch_rpc_id;
+    hg_id_t mobject_persist_wait_rpc_id;
+    hg_id_t mobject_wire_format_rpc_id;
 
     uint64_t num_provider_handles;
+
+    uint8_t wire_format;    // most recent format ops may be sent in
+    size_t  omap_bulk_size; // size of the regions receiving omap results
+
+    /* formats negotiated with the providers, so that each provider is
+     * asked only once (see mobject_provider_handle_create) */
+    struct provider_wire_format* wire_formats;
+    ABT_mutex_memory             wire_formats_mutex;
+};
+
+struct provider_wire_format {
+    hg_addr_t                    addr;
+    uint16_t                     provider_id;
+    uint8_t                      wire_format;
+    struct provider_wire_format* prev;
+    struct provider_wire_format* next;
 };
 
 struct mobject_provider_handle {
@@ -32,6 +54,7 @@ struct mobject_provider_handle {
     hg_addr_t        addr;
     uint16_t         provider_id;
     uint64_t         refcount;
+    uint8_t          wire_format; // format ops are sent in (see wire-format.h)
 };
 
 typedef enum mobject_op_req_type
@@ -48,6 +71,49 @@ struct mobject_request {
     } op;                  // operation that initiated the request
     margo_request request; // margo request to wait on
     hg_handle_t   handle;  // handle of the RPC sent for this operation
+    /* provider to ask for persistence of early-acknowledged writes */
+    mobject_provider_handle_t mph;
 };
 
+/**
+ * Same as mobject_read_op_operate, but also returns the version of the
+ * object observed by the server before executing the read_op, and the
+ * duration (in ms) of the lease granted on that version.
+ */
+int mobject_read_op_operate_versioned(mobject_provider_handle_t mph,
+                                      mobject_store_read_op_t   read_op,
+                                      const char*               pool_name,
+                                      const char*               oid,
+                                      int                       flags,
+                                      uint64_t*                 version,
+                                      uint32_t*                 lease_ms);
+
+/**
+ * Retrieves the current version of an object and a new lease on it.
+ */
+int mobject_object_version(mobject_provider_handle_t mph,
+                           const char*               pool_name,
+                           const char*               oid,
+                           uint64_t*                 version,
+                           uint32_t*                 lease_ms);
+
+/**
+ * Same as mobject_aio_wait, but for a write sent with
+ * LIBMOBJECT_OPERATION_EARLY_ACK, also hands over to the caller a
+ * reference to the provider handle and the sequence number to pass to
+ * mobject_persist_wait to find out when its data has been persisted.
+ * *persist_seq is set to 0 when there is nothing to wait for.
+ */
+int mobject_aio_wait_early_ack(mobject_request_t          req,
+                               int*                       ret,
+                               mobject_provider_handle_t* mph,
+                               uint64_t*                  persist_seq);
+
+/**
+ * Blocks until the provider has persisted the regions written by
+ * early-acknowledged writes up to persist_seq. Returns 0 on success,
+ * -1 if the RPC failed or the data could not be persisted.
+ */
+int mobject_persist_wait(mobject_provider_handle_t mph, uint64_t persist_seq);
+
 #endif
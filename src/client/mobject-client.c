@@ -17,8 +17,15 @@
 #include "src/client/mobject-client-impl.h"
 #include "src/io-chain/prepare-write-op.h"
 #include "src/io-chain/prepare-read-op.h"
+#include "src/io-chain/write-op-impl.h"
+#include "src/io-chain/read-op-impl.h"
 #include "src/rpc-types/write-op.h"
 #include "src/rpc-types/read-op.h"
+#include "src/rpc-types/object-version.h"
+#include "src/rpc-types/batch-op.h"
+#include "src/rpc-types/wire-format.h"
+#include "src/io-chain/wire-format.h"
+#include "src/util/utlist.h"
 #include "src/util/log.h"
 
 static int mobject_client_register(mobject_client_t  client,
@@ -56,6 +63,16 @@ static int mobject_client_register(mobject_client_t  client,
                               &client->mobject_write_op_rpc_id, &flag);
         margo_registered_name(mid, "mobject_read_op",
                               &client->mobject_read_op_rpc_id, &flag);
+        margo_registered_name(mid, "mobject_object_version",
+                              &client->mobject_object_version_rpc_id, &flag);
+        margo_registered_name(mid, "mobject_write_op_batch",
+                              &client->mobject_write_op_batch_rpc_id, &flag);
+        margo_registered_name(mid, "mobject_read_op_batch",
+                              &client->mobject_read_op_batch_rpc_id, &flag);
+        margo_registered_name(mid, "mobject_persist_wait",
+                              &client->mobject_persist_wait_rpc_id, &flag);
+        margo_registered_name(mid, "mobject_wire_format",
+                              &client->mobject_wire_format_rpc_id, &flag);
 
     } else {
 
@@ -63,6 +80,20 @@ static int mobject_client_register(mobject_client_t  client,
             mid, "mobject_write_op", write_op_in_t, write_op_out_t, NULL);
         client->mobject_read_op_rpc_id = MARGO_REGISTER(
             mid, "mobject_read_op", read_op_in_t, read_op_out_t, NULL);
+        client->mobject_object_version_rpc_id
+            = MARGO_REGISTER(mid, "mobject_object_version", object_version_in_t,
+                             object_version_out_t, NULL);
+        client->mobject_write_op_batch_rpc_id
+            = MARGO_REGISTER(mid, "mobject_write_op_batch", write_op_batch_in_t,
+                             write_op_batch_out_t, NULL);
+        client->mobject_read_op_batch_rpc_id
+            = MARGO_REGISTER(mid, "mobject_read_op_batch", read_op_batch_in_t,
+                             read_op_batch_out_t, NULL);
+        client->mobject_persist_wait_rpc_id
+            = MARGO_REGISTER(mid, "mobject_persist_wait", persist_wait_in_t,
+                             persist_wait_out_t, NULL);
+        client->mobject_wire_format_rpc_id = MARGO_REGISTER(
+            mid, "mobject_wire_format", void, wire_format_out_t, NULL);
     }
 
     return 0;
@@ -75,6 +106,20 @@ int mobject_client_init(margo_instance_id mid, mobject_client_t* client)
 
     c->num_provider_handles = 0;
 
+    // ops are sent in the compact format unless told otherwise
+    char* wire_format_env = getenv(MOBJECT_WIRE_FORMAT_ENV);
+    if (wire_format_env && atoi(wire_format_env) == MOBJECT_WIRE_FORMAT_LEGACY)
+        c->wire_format = MOBJECT_WIRE_FORMAT_LEGACY;
+    else
+        c->wire_format = MOBJECT_WIRE_FORMAT_COMPACT;
+
+    // large omap results are pushed into bulk regions of this size
+    char* omap_bulk_env = getenv(MOBJECT_OMAP_BULK_SIZE_ENV);
+    if (omap_bulk_env)
+        c->omap_bulk_size = strtoull(omap_bulk_env, NULL, 0);
+    else
+        c->omap_bulk_size = MOBJECT_DEFAULT_OMAP_BULK_SIZE;
+
     int ret = mobject_client_register(c, mid);
     if (ret != 0) return ret;
 
@@ -90,11 +135,87 @@ int mobject_client_finalize(mobject_client_t client)
                       "mobject_client_finalize was called",
                       client->num_provider_handles);
     }
+    struct provider_wire_format *f, *tmp;
+    DL_FOREACH_SAFE(client->wire_formats, f, tmp)
+    {
+        DL_DELETE(client->wire_formats, f);
+        margo_addr_free(client->mid, f->addr);
+        free(f);
+    }
     free(client->client_addr);
     free(client);
     return 0;
 }
 
+/* Asks the provider for the most recent wire format it can decode.
+ * Providers that predate this query only decode the legacy format, so an
+ * unknown RPC is answered with it. Other failures also fall back to the
+ * legacy format, but are not remembered so that the provider is asked
+ * again by the next handle. */
+static uint8_t negotiate_wire_format(mobject_client_t client,
+                                     hg_addr_t        addr,
+                                     uint16_t         provider_id)
+{
+    if (client->wire_format == MOBJECT_WIRE_FORMAT_LEGACY)
+        return MOBJECT_WIRE_FORMAT_LEGACY;
+
+    ABT_mutex mutex = ABT_MUTEX_MEMORY_GET_HANDLE(&client->wire_formats_mutex);
+    struct provider_wire_format* f;
+
+    ABT_mutex_lock(mutex);
+    DL_FOREACH(client->wire_formats, f)
+    {
+        if (f->provider_id == provider_id
+            && margo_addr_cmp(client->mid, f->addr, addr)) {
+            uint8_t format = f->wire_format;
+            ABT_mutex_unlock(mutex);
+            return format;
+        }
+    }
+    ABT_mutex_unlock(mutex);
+
+    uint8_t     format = MOBJECT_WIRE_FORMAT_LEGACY;
+    hg_handle_t h;
+    hg_return_t ret
+        = margo_create(client->mid, addr, client->mobject_wire_format_rpc_id, &h);
+    if (ret != HG_SUCCESS) return format;
+
+    ret = margo_provider_forward(provider_id, h, NULL);
+    if (ret == HG_SUCCESS) {
+        wire_format_out_t out;
+        ret = margo_get_output(h, &out);
+        if (ret == HG_SUCCESS) {
+            format = out.wire_format < client->wire_format ? out.wire_format
+                                                           : client->wire_format;
+            margo_free_output(h, &out);
+        }
+    } else if (ret == HG_NO_MATCH) {
+        ret = HG_SUCCESS; // provider from before the negotiation
+    }
+    margo_destroy(h);
+
+    if (ret != HG_SUCCESS) {
+        margo_warning(client->mid,
+                      "[mobject] %s:%d: could not query the wire format of "
+                      "provider %u (ret = %d), using the legacy format",
+                      __func__, __LINE__, provider_id, ret);
+        return format;
+    }
+
+    f = (struct provider_wire_format*)calloc(1, sizeof(*f));
+    if (!f) return format;
+    if (margo_addr_dup(client->mid, addr, &f->addr) != HG_SUCCESS) {
+        free(f);
+        return format;
+    }
+    f->provider_id = provider_id;
+    f->wire_format = format;
+    ABT_mutex_lock(mutex);
+    DL_APPEND(client->wire_formats, f);
+    ABT_mutex_unlock(mutex);
+    return format;
+}
+
 int mobject_provider_handle_create(mobject_client_t           client,
                                    hg_addr_t                  addr,
                                    uint16_t                   provider_id,
@@ -116,6 +237,7 @@ int mobject_provider_handle_create(mobject_client_t           client,
     provider->client      = client;
     provider->provider_id = provider_id;
     provider->refcount    = 1;
+    provider->wire_format = negotiate_wire_format(client, addr, provider_id);
 
     client->num_provider_handles += 1;
 
@@ -147,6 +269,14 @@ int mobject_shutdown(mobject_client_t client, hg_addr_t addr)
     return margo_shutdown_remote_instance(client->mid, addr);
 }
 
+int mobject_write_op_prepare(mobject_client_t         client,
+                             mobject_store_write_op_t write_op)
+{
+    if (!write_op->ready) write_op->wire_format = client->wire_format;
+    prepare_write_op(client->mid, write_op);
+    return 0;
+}
+
 int mobject_write_op_operate(mobject_provider_handle_t mph,
                              mobject_store_write_op_t  write_op,
                              const char*               pool_name,
@@ -162,8 +292,12 @@ int mobject_write_op_operate(mobject_provider_handle_t mph,
     in.pool_name   = pool_name;
     in.write_op    = write_op;
     in.client_addr = client->client_addr;
+    // synchronous writes return once persisted, so early acks are useless
+    in.flags       = flags & ~LIBMOBJECT_OPERATION_EARLY_ACK;
+    in.wire_format = mph->wire_format;
     // TODO take mtime into account
 
+    write_op->wire_format = mph->wire_format;
     prepare_write_op(client->mid, write_op);
 
     hg_addr_t svr_addr = mph->addr;
@@ -207,10 +341,24 @@ int mobject_write_op_operate(mobject_provider_handle_t mph,
         return -1;
     }
 
+    feed_write_op_pointers_from_results(write_op, &resp.results);
+    int r = resp.ret;
+
     margo_free_output(h, &resp);
 
     margo_destroy(h);
 
+    return r;
+}
+
+int mobject_read_op_prepare(mobject_client_t        client,
+                            mobject_store_read_op_t read_op)
+{
+    if (!read_op->ready) {
+        read_op->wire_format    = client->wire_format;
+        read_op->omap_bulk_size = client->omap_bulk_size;
+    }
+    prepare_read_op(client->mid, read_op);
     return 0;
 }
 
@@ -219,6 +367,18 @@ int mobject_read_op_operate(mobject_provider_handle_t mph,
                             const char*               pool_name,
                             const char*               oid,
                             int                       flags)
+{
+    return mobject_read_op_operate_versioned(mph, read_op, pool_name, oid,
+                                             flags, NULL, NULL);
+}
+
+int mobject_read_op_operate_versioned(mobject_provider_handle_t mph,
+                                      mobject_store_read_op_t   read_op,
+                                      const char*               pool_name,
+                                      const char*               oid,
+                                      int                       flags,
+                                      uint64_t*                 version,
+                                      uint32_t*                 lease_ms)
 {
     hg_return_t ret;
 
@@ -228,7 +388,13 @@ int mobject_read_op_operate(mobject_provider_handle_t mph,
     in.pool_name   = pool_name;
     in.read_op     = read_op;
     in.client_addr = mph->client->client_addr;
+    in.flags       = flags;
+    in.wire_format = mph->wire_format;
 
+    if (!read_op->ready) {
+        read_op->wire_format    = mph->wire_format;
+        read_op->omap_bulk_size = client->omap_bulk_size;
+    }
     prepare_read_op(mph->client->mid, read_op);
 
     hg_addr_t svr_addr = mph->addr;
@@ -274,9 +440,302 @@ int mobject_read_op_operate(mobject_provider_handle_t mph,
     }
 
     feed_read_op_pointers_from_response(read_op, resp.responses);
+    if (version) *version = resp.version;
+    if (lease_ms) *lease_ms = resp.lease_ms;
 
     margo_free_output(h, &resp);
     margo_destroy(h);
 
     return 0;
 }
+
+int mobject_object_version(mobject_provider_handle_t mph,
+                           const char*               pool_name,
+                           const char*               oid,
+                           uint64_t*                 version,
+                           uint32_t*                 lease_ms)
+{
+    hg_return_t          ret;
+    mobject_client_t     client = mph->client;
+    object_version_in_t  in;
+    object_version_out_t out;
+    hg_handle_t          h;
+
+    in.pool_name   = pool_name;
+    in.object_name = oid;
+
+    ret = margo_create(client->mid, mph->addr,
+                       client->mobject_object_version_rpc_id, &h);
+    if (ret != HG_SUCCESS) {
+        margo_error(client->mid,
+                    "[mobject] %s:%d: margo_create() failed in"
+                    " mobject_object_version() (ret = %d)",
+                    __func__, __LINE__, ret);
+        return -1;
+    }
+
+    ret = margo_provider_forward(mph->provider_id, h, &in);
+    if (ret != HG_SUCCESS) {
+        margo_error(client->mid,
+                    "[mobject] %s:%d: margo_forward() failed in"
+                    " mobject_object_version() (ret = %d)",
+                    __func__, __LINE__, ret);
+        margo_destroy(h);
+        return -1;
+    }
+
+    ret = margo_get_output(h, &out);
+    if (ret != HG_SUCCESS) {
+        margo_error(client->mid,
+                    "[mobject] %s:%d: margo_get_output() failed in"
+                    " mobject_object_version() (ret = %d)",
+                    __func__, __LINE__, ret);
+        margo_destroy(h);
+        return -1;
+    }
+
+    *version  = out.version;
+    *lease_ms = out.lease_ms;
+
+    margo_free_output(h, &out);
+    margo_destroy(h);
+
+    return 0;
+}
+
+int mobject_persist_wait(mobject_provider_handle_t mph, uint64_t persist_seq)
+{
+    hg_return_t        ret;
+    mobject_client_t   client = mph->client;
+    persist_wait_in_t  in;
+    persist_wait_out_t out;
+    hg_handle_t        h;
+    int                r;
+
+    in.persist_seq = persist_seq;
+
+    ret = margo_create(client->mid, mph->addr,
+                       client->mobject_persist_wait_rpc_id, &h);
+    if (ret != HG_SUCCESS) {
+        margo_error(client->mid,
+                    "[mobject] %s:%d: margo_create() failed in"
+                    " mobject_persist_wait() (ret = %d)",
+                    __func__, __LINE__, ret);
+        return -1;
+    }
+
+    ret = margo_provider_forward(mph->provider_id, h, &in);
+    if (ret != HG_SUCCESS) {
+        margo_error(client->mid,
+                    "[mobject] %s:%d: margo_forward() failed in"
+                    " mobject_persist_wait() (ret = %d)",
+                    __func__, __LINE__, ret);
+        margo_destroy(h);
+        return -1;
+    }
+
+    ret = margo_get_output(h, &out);
+    if (ret != HG_SUCCESS) {
+        margo_error(client->mid,
+                    "[mobject] %s:%d: margo_get_output() failed in"
+                    " mobject_persist_wait() (ret = %d)",
+                    __func__, __LINE__, ret);
+        margo_destroy(h);
+        return -1;
+    }
+
+    r = out.ret;
+
+    margo_free_output(h, &out);
+    margo_destroy(h);
+
+    return r;
+}
+
+int mobject_write_op_operate_batch(mobject_provider_handle_t mph,
+                                   size_t                    count,
+                                   mobject_store_write_op_t* write_ops,
+                                   const char*               pool_name,
+                                   const char* const*        oids,
+                                   int                       flags,
+                                   int*                      rets)
+{
+    hg_return_t         ret;
+    mobject_client_t    client = mph->client;
+    write_op_batch_in_t in;
+    hg_handle_t         h;
+    size_t              i;
+    void**              saved_pointers;
+
+    if (count == 0) return 0;
+
+    if (mph->addr == HG_ADDR_NULL) {
+        margo_error(client->mid,
+                    "[mobject] %s:%d: NULL provider address passed to "
+                    "mobject_write_op_operate_batch",
+                    __func__, __LINE__);
+        return -1;
+    }
+
+    for (i = 0; i < count; i++) write_ops[i]->wire_format = mph->wire_format;
+    if (prepare_write_op_batch(client->mid, write_ops, count, &in.bulk_handle,
+                               &saved_pointers)
+        != 0) {
+        margo_error(client->mid,
+                    "[mobject] %s:%d: could not expose the buffers of the "
+                    "batch of write_ops",
+                    __func__, __LINE__);
+        return -1;
+    }
+
+    in.client_addr        = client->client_addr;
+    in.pool_name          = pool_name;
+    in.flags              = flags;
+    in.batch.wire_format  = mph->wire_format;
+    in.batch.count        = count;
+    in.batch.object_names = (hg_const_string_t*)oids;
+    in.batch.write_ops    = write_ops;
+
+    ret = margo_create(client->mid, mph->addr,
+                       client->mobject_write_op_batch_rpc_id, &h);
+    if (ret != HG_SUCCESS) {
+        margo_error(client->mid,
+                    "[mobject] %s:%d: margo_create() failed in"
+                    " mobject_write_op_operate_batch() (ret = %d)",
+                    __func__, __LINE__, ret);
+        margo_bulk_free(in.bulk_handle);
+        restore_write_op_batch(write_ops, count, saved_pointers);
+        return -1;
+    }
+
+    ret = margo_provider_forward(mph->provider_id, h, &in);
+    margo_bulk_free(in.bulk_handle);
+    restore_write_op_batch(write_ops, count, saved_pointers);
+    if (ret != HG_SUCCESS) {
+        margo_error(client->mid,
+                    "[mobject] %s:%d: margo_forward() failed in"
+                    " mobject_write_op_operate_batch() (ret = %d)",
+                    __func__, __LINE__, ret);
+        margo_destroy(h);
+        return -1;
+    }
+
+    write_op_batch_out_t out;
+    ret = margo_get_output(h, &out);
+    if (ret != HG_SUCCESS) {
+        margo_error(client->mid,
+                    "[mobject] %s:%d: margo_get_output() failed in"
+                    " mobject_write_op_operate_batch() (ret = %d)",
+                    __func__, __LINE__, ret);
+        margo_destroy(h);
+        return -1;
+    }
+
+    if (rets) {
+        for (i = 0; i < count && i < out.results.count; i++)
+            rets[i] = out.results.rets[i];
+    }
+    for (i = 0; i < count && i < out.results.count; i++)
+        feed_write_op_pointers_from_results(write_ops[i],
+                                            &out.results.results[i]);
+
+    margo_free_output(h, &out);
+    margo_destroy(h);
+
+    return 0;
+}
+
+int mobject_read_op_operate_batch(mobject_provider_handle_t mph,
+                                  size_t                    count,
+                                  mobject_store_read_op_t*  read_ops,
+                                  const char*               pool_name,
+                                  const char* const*        oids,
+                                  int                       flags)
+{
+    hg_return_t        ret;
+    mobject_client_t   client = mph->client;
+    read_op_batch_in_t in;
+    hg_handle_t        h;
+    size_t             i;
+    void**             saved_pointers;
+
+    if (count == 0) return 0;
+
+    if (mph->addr == HG_ADDR_NULL) {
+        margo_error(client->mid,
+                    "[mobject] %s:%d: NULL provider address passed to "
+                    "mobject_read_op_operate_batch",
+                    __func__, __LINE__);
+        return -1;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (read_ops[i]->ready) continue;
+        read_ops[i]->wire_format    = mph->wire_format;
+        read_ops[i]->omap_bulk_size = client->omap_bulk_size;
+    }
+    if (prepare_read_op_batch(client->mid, read_ops, count, &in.bulk_handle,
+                              &saved_pointers)
+        != 0) {
+        margo_error(client->mid,
+                    "[mobject] %s:%d: could not expose the buffers of the "
+                    "batch of read_ops",
+                    __func__, __LINE__);
+        return -1;
+    }
+
+    in.client_addr        = client->client_addr;
+    in.pool_name          = pool_name;
+    in.flags              = flags;
+    in.batch.wire_format  = mph->wire_format;
+    in.batch.count        = count;
+    in.batch.object_names = (hg_const_string_t*)oids;
+    in.batch.read_ops     = read_ops;
+
+    ret = margo_create(client->mid, mph->addr,
+                       client->mobject_read_op_batch_rpc_id, &h);
+    if (ret != HG_SUCCESS) {
+        margo_error(client->mid,
+                    "[mobject] %s:%d: margo_create() failed in"
+                    " mobject_read_op_operate_batch() (ret = %d)",
+                    __func__, __LINE__, ret);
+        margo_bulk_free(in.bulk_handle);
+        restore_read_op_batch(read_ops, count, saved_pointers);
+        return -1;
+    }
+
+    ret = margo_provider_forward(mph->provider_id, h, &in);
+    margo_bulk_free(in.bulk_handle);
+    if (ret != HG_SUCCESS) {
+        margo_error(client->mid,
+                    "[mobject] %s:%d: margo_forward() failed in"
+                    " mobject_read_op_operate_batch() (ret = %d)",
+                    __func__, __LINE__, ret);
+        margo_destroy(h);
+        restore_read_op_batch(read_ops, count, saved_pointers);
+        return -1;
+    }
+
+    read_op_batch_out_t out;
+    ret = margo_get_output(h, &out);
+    if (ret != HG_SUCCESS) {
+        margo_error(client->mid,
+                    "[mobject] %s:%d: margo_get_output() failed in"
+                    " mobject_read_op_operate_batch() (ret = %d)",
+                    __func__, __LINE__, ret);
+        margo_destroy(h);
+        restore_read_op_batch(read_ops, count, saved_pointers);
+        return -1;
+    }
+
+    for (i = 0; i < count && i < out.results.count; i++)
+        feed_read_op_pointers_from_response(read_ops[i],
+                                            out.results.responses[i]);
+    // the responses were read from the regions of the omap results
+    restore_read_op_batch(read_ops, count, saved_pointers);
+
+    margo_free_output(h, &out);
+    margo_destroy(h);
+
+    return 0;
+}
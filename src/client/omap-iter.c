@@ -13,18 +13,15 @@ int mobject_store_omap_get_next(mobject_store_omap_iter_t iter,
                                 char**                    val,
                                 size_t*                   len)
 {
-    if (iter->current == NULL) {
+    if (iter->current >= iter->num_items) {
         *key = NULL;
         *val = NULL;
         *len = 0;
         return -1;
     }
 
-    *key          = iter->current->key;
-    *val          = iter->current->value;
-    *len          = iter->current->value_size;
-    iter->current = iter->current->next;
-    if (iter->current == iter->head) iter->current = NULL;
+    omap_iter_get(iter, iter->current, key, val, len);
+    iter->current += 1;
 
     return 0;
 }
@@ -0,0 +1,504 @@
+/*
+ * (C) 2017 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "mobject-store-config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <margo.h>
+
+#include "libmobject-store.h"
+#include "src/client/cluster.h"
+#include "src/client/read-cache.h"
+#include "src/client/mobject-client-impl.h"
+#include "src/io-chain/read-op-impl.h"
+#include "src/omap-iter/omap-iter-impl.h"
+#include "src/util/utlist.h"
+#include "src/util/log.h"
+
+typedef struct rc_extent {
+    uint64_t          offset; // offset of the read
+    size_t            len;    // requested length
+    size_t            avail;  // bytes actually returned (<len past the end)
+    char*             data;
+    struct rc_extent* prev;
+    struct rc_extent* next;
+} rc_extent;
+
+typedef struct rc_omap_value {
+    char*                 key;
+    char*                 value;
+    size_t                value_size;
+    int                   found; // 0 if the key is known to be absent
+    struct rc_omap_value* prev;
+    struct rc_omap_value* next;
+} rc_omap_value;
+
+typedef struct rc_entry {
+    char*            oid;
+    uint64_t         version;   // version the cached data was read from
+    double           lease_end; // time at which the lease expires
+    int              has_size;  // size was returned by a stat
+    int              has_mtime; // mtime was returned by a stat
+    uint64_t         size;
+    time_t           mtime;
+    rc_extent*       extents;
+    rc_omap_value*   omap;
+    size_t           bytes; // amount of data cached for this entry
+    struct rc_entry* prev;
+    struct rc_entry* next;
+} rc_entry;
+
+/* number of invalidation generations, objects share them by hash */
+#define RC_GENERATIONS 256
+
+struct mobject_read_cache {
+    ABT_mutex_memory mutex;
+    size_t           max_bytes;
+    size_t           bytes;
+    rc_entry*        entries; // least recently used first
+    /* bumped by every invalidation of the objects hashing to them, so that
+     * a read sent before a write doesn't cache what it read once the write
+     * has invalidated the object */
+    uint64_t generations[RC_GENERATIONS];
+};
+
+static uint64_t* generation_of(mobject_read_cache_t cache, const char* oid)
+{
+    unsigned long hash = 0;
+    int           c;
+
+    while ((c = *oid++)) hash = c + (hash << 6) + (hash << 16) - hash;
+    return &cache->generations[hash % RC_GENERATIONS];
+}
+
+static rc_entry* find_entry(mobject_read_cache_t cache, const char* oid)
+{
+    rc_entry* e;
+    DL_FOREACH(cache->entries, e)
+    {
+        if (strcmp(e->oid, oid) == 0) return e;
+    }
+    return NULL;
+}
+
+static void clear_entry(mobject_read_cache_t cache, rc_entry* e)
+{
+    rc_extent *    ext, *tmp_ext;
+    rc_omap_value *val, *tmp_val;
+
+    DL_FOREACH_SAFE(e->extents, ext, tmp_ext)
+    {
+        DL_DELETE(e->extents, ext);
+        free(ext->data);
+        free(ext);
+    }
+    DL_FOREACH_SAFE(e->omap, val, tmp_val)
+    {
+        DL_DELETE(e->omap, val);
+        free(val->key);
+        free(val->value);
+        free(val);
+    }
+    e->has_size  = 0;
+    e->has_mtime = 0;
+    cache->bytes -= e->bytes;
+    e->bytes = 0;
+}
+
+static void drop_entry(mobject_read_cache_t cache, rc_entry* e)
+{
+    clear_entry(cache, e);
+    DL_DELETE(cache->entries, e);
+    free(e->oid);
+    free(e);
+}
+
+static rc_extent* find_extent(rc_entry* e, uint64_t offset, size_t len)
+{
+    rc_extent* ext;
+    DL_FOREACH(e->extents, ext)
+    {
+        if (ext->offset <= offset && offset + len <= ext->offset + ext->len)
+            return ext;
+    }
+    return NULL;
+}
+
+static rc_omap_value* find_omap_value(rc_entry* e, const char* key)
+{
+    rc_omap_value* val;
+    DL_FOREACH(e->omap, val)
+    {
+        if (strcmp(val->key, key) == 0) return val;
+    }
+    return NULL;
+}
+
+/* checks that every action of the read_op can be answered from the entry */
+static int can_serve(rc_entry* e, mobject_store_read_op_t read_op)
+{
+    rd_action_base_t action;
+
+    if (read_op->ready || read_op->num_actions == 0) return 0;
+
+    DL_FOREACH(read_op->actions, action)
+    {
+        switch (action->type) {
+        case READ_OPCODE_STAT: {
+            READ_ACTION_DOWNCAST(a, action, STAT);
+            if ((a->psize && !e->has_size) || (a->pmtime && !e->has_mtime))
+                return 0;
+        } break;
+        case READ_OPCODE_READ: {
+            READ_ACTION_DOWNCAST(a, action, READ);
+            if (!find_extent(e, a->offset, a->len)) return 0;
+        } break;
+        case READ_OPCODE_OMAP_GET_VALS_BY_KEYS: {
+            READ_ACTION_DOWNCAST(a, action, OMAP_GET_VALS_BY_KEYS);
+            const char* key = a->data;
+            for (size_t i = 0; i < a->num_keys; i++) {
+                if (!find_omap_value(e, key)) return 0;
+                key += strlen(key) + 1;
+            }
+        } break;
+        default:
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void serve(rc_entry* e, mobject_store_read_op_t read_op)
+{
+    rd_action_base_t action;
+
+    DL_FOREACH(read_op->actions, action)
+    {
+        switch (action->type) {
+        case READ_OPCODE_STAT: {
+            READ_ACTION_DOWNCAST(a, action, STAT);
+            if (a->psize) *(a->psize) = e->size;
+            if (a->pmtime) *(a->pmtime) = e->mtime;
+            if (a->prval) *(a->prval) = 0;
+        } break;
+        case READ_OPCODE_READ: {
+            READ_ACTION_DOWNCAST(a, action, READ);
+            rc_extent* ext  = find_extent(e, a->offset, a->len);
+            size_t     skip = a->offset - ext->offset;
+            size_t     n    = 0;
+            if (ext->avail > skip)
+                n = ext->avail - skip < a->len ? ext->avail - skip : a->len;
+            memcpy((char*)a->buffer.as_pointer, ext->data + skip, n);
+            if (a->bytes_read) *(a->bytes_read) = n;
+            if (a->prval) *(a->prval) = 0;
+        } break;
+        case READ_OPCODE_OMAP_GET_VALS_BY_KEYS: {
+            READ_ACTION_DOWNCAST(a, action, OMAP_GET_VALS_BY_KEYS);
+            mobject_store_omap_iter_t iter;
+            omap_iter_create(&iter);
+            const char* key = a->data;
+            for (size_t i = 0; i < a->num_keys; i++) {
+                rc_omap_value* val = find_omap_value(e, key);
+                if (val->found)
+                    omap_iter_append(iter, key, val->value, val->value_size);
+                key += strlen(key) + 1;
+            }
+            if (a->iter)
+                *(a->iter) = iter;
+            else
+                omap_iter_free(iter);
+            if (a->prval) *(a->prval) = 0;
+        } break;
+        default:
+            break;
+        }
+    }
+}
+
+static void cache_extent(mobject_read_cache_t cache,
+                         rc_entry*            e,
+                         uint64_t             offset,
+                         size_t               len,
+                         const char*          buffer,
+                         size_t               avail)
+{
+    rc_extent *ext, *tmp;
+
+    /* extents covered by the new one are useless */
+    DL_FOREACH_SAFE(e->extents, ext, tmp)
+    {
+        if (offset <= ext->offset && ext->offset + ext->len <= offset + len) {
+            DL_DELETE(e->extents, ext);
+            e->bytes -= ext->avail;
+            cache->bytes -= ext->avail;
+            free(ext->data);
+            free(ext);
+        }
+    }
+
+    ext = (rc_extent*)calloc(1, sizeof(*ext));
+    if (!ext) return;
+    ext->data = (char*)malloc(avail ? avail : 1);
+    if (!ext->data) {
+        free(ext);
+        return;
+    }
+    memcpy(ext->data, buffer, avail);
+    ext->offset = offset;
+    ext->len    = len;
+    ext->avail  = avail;
+    DL_APPEND(e->extents, ext);
+    e->bytes += avail;
+    cache->bytes += avail;
+}
+
+static void cache_omap_value(mobject_read_cache_t cache,
+                             rc_entry*            e,
+                             const char*          key,
+                             const char*          value,
+                             size_t               value_size,
+                             int                  found)
+{
+    rc_omap_value* val = find_omap_value(e, key);
+    if (val) {
+        DL_DELETE(e->omap, val);
+        e->bytes -= strlen(val->key) + val->value_size;
+        cache->bytes -= strlen(val->key) + val->value_size;
+        free(val->key);
+        free(val->value);
+        free(val);
+    }
+
+    val = (rc_omap_value*)calloc(1, sizeof(*val));
+    if (!val) return;
+    val->key   = strdup(key);
+    val->value = value_size ? (char*)malloc(value_size) : NULL;
+    if (!val->key || (value_size && !val->value)) {
+        free(val->key);
+        free(val->value);
+        free(val);
+        return;
+    }
+    if (value_size) memcpy(val->value, value, value_size);
+    val->value_size = value_size;
+    val->found      = found;
+    DL_APPEND(e->omap, val);
+    e->bytes += strlen(key) + value_size;
+    cache->bytes += strlen(key) + value_size;
+}
+
+/* caches the results of a read_op that has been executed by the server;
+ * read_buffers holds the local pointers of the READ actions, which have
+ * been replaced by bulk offsets when the read_op was prepared */
+static void populate(mobject_read_cache_t    cache,
+                     rc_entry*               e,
+                     mobject_store_read_op_t read_op,
+                     const char**            read_buffers)
+{
+    rd_action_base_t action;
+    size_t           i = 0;
+
+    DL_FOREACH(read_op->actions, action)
+    {
+        switch (action->type) {
+        case READ_OPCODE_STAT: {
+            READ_ACTION_DOWNCAST(a, action, STAT);
+            if (a->prval && *(a->prval) != 0) break;
+            if (a->psize) {
+                e->has_size = 1;
+                e->size     = *(a->psize);
+            }
+            if (a->pmtime) {
+                e->has_mtime = 1;
+                e->mtime     = *(a->pmtime);
+            }
+        } break;
+        case READ_OPCODE_READ: {
+            READ_ACTION_DOWNCAST(a, action, READ);
+            if (!a->bytes_read || (a->prval && *(a->prval) != 0)) break;
+            cache_extent(cache, e, a->offset, a->len, read_buffers[i],
+                         *(a->bytes_read));
+        } break;
+        case READ_OPCODE_OMAP_GET_VALS_BY_KEYS: {
+            READ_ACTION_DOWNCAST(a, action, OMAP_GET_VALS_BY_KEYS);
+            if (!a->iter || !*(a->iter) || (a->prval && *(a->prval) != 0))
+                break;
+            mobject_store_omap_iter_t iter = *(a->iter);
+            const char*               key  = a->data;
+            for (size_t k = 0; k < a->num_keys; k++) {
+                char*  node_key;
+                char*  node_val;
+                size_t node_val_size, n;
+                for (n = 0; n < iter->num_items; n++) {
+                    omap_iter_get(iter, n, &node_key, &node_val,
+                                  &node_val_size);
+                    if (node_key && strcmp(node_key, key) == 0) break;
+                }
+                if (n < iter->num_items)
+                    cache_omap_value(cache, e, key, node_val, node_val_size, 1);
+                else
+                    cache_omap_value(cache, e, key, NULL, 0, 0);
+                key += strlen(key) + 1;
+            }
+        } break;
+        default:
+            break;
+        }
+        i += 1;
+    }
+}
+
+/* evicts the least recently used entries until the cache fits in memory */
+static void evict(mobject_read_cache_t cache)
+{
+    while (cache->bytes > cache->max_bytes && cache->entries)
+        drop_entry(cache, cache->entries);
+}
+
+int mobject_read_cache_create(size_t max_bytes, mobject_read_cache_t* cache)
+{
+    mobject_read_cache_t tmp = (mobject_read_cache_t)calloc(1, sizeof(*tmp));
+    if (!tmp) return -1;
+    tmp->max_bytes = max_bytes;
+    *cache         = tmp;
+    return 0;
+}
+
+void mobject_read_cache_destroy(mobject_read_cache_t cache)
+{
+    rc_entry *e, *tmp;
+    if (!cache) return;
+    DL_FOREACH_SAFE(cache->entries, e, tmp) { drop_entry(cache, e); }
+    free(cache);
+}
+
+void mobject_read_cache_invalidate(mobject_read_cache_t cache,
+                                   const char*          oid)
+{
+    ABT_mutex_lock(ABT_MUTEX_MEMORY_GET_HANDLE(&cache->mutex));
+    rc_entry* e = find_entry(cache, oid);
+    if (e) drop_entry(cache, e);
+    *generation_of(cache, oid) += 1;
+    ABT_mutex_unlock(ABT_MUTEX_MEMORY_GET_HANDLE(&cache->mutex));
+}
+
+int mobject_read_cache_operate(mobject_store_ioctx_t   io,
+                               mobject_store_read_op_t read_op,
+                               const char*             oid,
+                               int                     flags)
+{
+    mobject_read_cache_t      cache = io->read_cache;
+    mobject_provider_handle_t mph   = MOBJECT_PROVIDER_HANDLE_NULL;
+    rc_entry*                 e;
+    uint64_t                  version;
+    uint32_t                  lease_ms;
+    uint64_t                  generation;
+    double                    t;
+    int                       servable;
+    int                       r;
+
+    ABT_mutex_lock(ABT_MUTEX_MEMORY_GET_HANDLE(&cache->mutex));
+    generation = *generation_of(cache, oid);
+    e          = find_entry(cache, oid);
+    servable   = e && can_serve(e, read_op);
+    if (servable && ABT_get_wtime() < e->lease_end) {
+        serve(e, read_op);
+        DL_DELETE(cache->entries, e);
+        DL_APPEND(cache->entries, e);
+        ABT_mutex_unlock(ABT_MUTEX_MEMORY_GET_HANDLE(&cache->mutex));
+        return 0;
+    }
+    ABT_mutex_unlock(ABT_MUTEX_MEMORY_GET_HANDLE(&cache->mutex));
+
+    r = mobject_store_locate(io, oid, &mph);
+    if (r != 0) return r;
+
+    /* the lease has expired, check whether the object has changed */
+    if (servable) {
+        t = ABT_get_wtime();
+        r = mobject_object_version(mph, io->pool_name, oid, &version,
+                                   &lease_ms);
+        if (r == 0) {
+            ABT_mutex_lock(ABT_MUTEX_MEMORY_GET_HANDLE(&cache->mutex));
+            e = find_entry(cache, oid);
+            if (e && e->version == version && can_serve(e, read_op)) {
+                e->lease_end = t + lease_ms / 1000.0;
+                serve(e, read_op);
+                DL_DELETE(cache->entries, e);
+                DL_APPEND(cache->entries, e);
+                ABT_mutex_unlock(
+                    ABT_MUTEX_MEMORY_GET_HANDLE(&cache->mutex));
+                mobject_provider_handle_release(mph);
+                return 0;
+            }
+            if (e && e->version != version) clear_entry(cache, e);
+            ABT_mutex_unlock(ABT_MUTEX_MEMORY_GET_HANDLE(&cache->mutex));
+        }
+    }
+
+    /* remember where the data of READ actions lands */
+    const char**     read_buffers = NULL;
+    rd_action_base_t action;
+    size_t           i = 0;
+    if (!read_op->ready) {
+        read_buffers
+            = (const char**)calloc(read_op->num_actions, sizeof(*read_buffers));
+        DL_FOREACH(read_op->actions, action)
+        {
+            if (action->type == READ_OPCODE_READ)
+                read_buffers[i] = ((rd_action_read_t)action)->buffer.as_pointer;
+            i += 1;
+        }
+    }
+
+    t = ABT_get_wtime();
+    r = mobject_read_op_operate_versioned(mph, read_op, io->pool_name, oid,
+                                          flags, &version, &lease_ms);
+    mobject_provider_handle_release(mph);
+    if (r != 0 || !read_buffers) {
+        free(read_buffers);
+        return r;
+    }
+
+    ABT_mutex_lock(ABT_MUTEX_MEMORY_GET_HANDLE(&cache->mutex));
+    /* the object was written while the read was in flight, the results
+     * may predate the write */
+    if (*generation_of(cache, oid) != generation) {
+        ABT_mutex_unlock(ABT_MUTEX_MEMORY_GET_HANDLE(&cache->mutex));
+        free(read_buffers);
+        return 0;
+    }
+    e = find_entry(cache, oid);
+    if (!e) {
+        e = (rc_entry*)calloc(1, sizeof(*e));
+        if (e) e->oid = strdup(oid);
+        if (e && !e->oid) {
+            free(e);
+            e = NULL;
+        }
+        if (e) {
+            e->version = version;
+            DL_APPEND(cache->entries, e);
+        }
+    } else {
+        DL_DELETE(cache->entries, e);
+        DL_APPEND(cache->entries, e);
+    }
+    if (e) {
+        if (e->version != version) {
+            clear_entry(cache, e);
+            e->version = version;
+        }
+        e->lease_end = t + lease_ms / 1000.0;
+        populate(cache, e, read_op, read_buffers);
+        evict(cache);
+    }
+    ABT_mutex_unlock(ABT_MUTEX_MEMORY_GET_HANDLE(&cache->mutex));
+
+    free(read_buffers);
+    return 0;
+}
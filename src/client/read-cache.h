@@ -0,0 +1,56 @@
+/*
+ * (C) 2017 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __MOBJECT_READ_CACHE_H
+#define __MOBJECT_READ_CACHE_H
+
+#include "libmobject-store.h"
+
+/**
+ * The read cache is an opt-in, per-ioctx structure keeping the results
+ * of stat, read and omap_get_vals_by_keys actions, tagged with the
+ * version of the object they were read from.
+ *
+ * Each server reply carries the object's version and a lease (in ms).
+ * While the lease is valid, read_ops that can be entirely answered from
+ * the cache are served locally. Once the lease has expired, the client
+ * asks the server for the current version of the object: if it has not
+ * changed, the lease is renewed and the read_op is served locally,
+ * otherwise the cached data is dropped and the read_op is sent.
+ *
+ * Writes issued through the same ioctx invalidate the cached object
+ * when they are sent and again when they complete, and reads that were
+ * in flight during an invalidation don't populate the cache. Writes from
+ * other clients are seen at the latest when the lease expires.
+ */
+typedef struct mobject_read_cache* mobject_read_cache_t;
+
+/**
+ * Creates a read cache holding at most max_bytes of data.
+ */
+int mobject_read_cache_create(size_t max_bytes, mobject_read_cache_t* cache);
+
+/**
+ * Destroys the read cache.
+ */
+void mobject_read_cache_destroy(mobject_read_cache_t cache);
+
+/**
+ * Drops the cached content of an object and prevents the reads of the
+ * object that are in flight from caching their results.
+ */
+void mobject_read_cache_invalidate(mobject_read_cache_t cache,
+                                   const char*          oid);
+
+/**
+ * Executes the read_op, either from the cache or by sending it to the
+ * server responsible for the object and caching the results.
+ */
+int mobject_read_cache_operate(mobject_store_ioctx_t   io,
+                               mobject_store_read_op_t read_op,
+                               const char*             oid,
+                               int                     flags);
+
+#endif
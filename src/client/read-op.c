@@ -32,11 +32,12 @@ void mobject_read_op_stat(mobject_store_read_op_t read_op,
     MOBJECT_ASSERT(!(read_op->ready),
                    "can't modify a read_op that is ready to be processed");
 
-    rd_action_stat_t action = (rd_action_stat_t)calloc(1, sizeof(*action));
-    action->base.type       = READ_OPCODE_STAT;
-    action->psize           = psize;
-    action->pmtime          = pmtime;
-    action->prval           = prval;
+    rd_action_stat_t action
+        = (rd_action_stat_t)alloc_read_action(read_op, sizeof(*action));
+    action->base.type = READ_OPCODE_STAT;
+    action->psize     = psize;
+    action->pmtime    = pmtime;
+    action->prval     = prval;
 
     READ_ACTION_UPCAST(base, action);
     DL_APPEND(read_op->actions, base);
@@ -56,7 +57,8 @@ void mobject_read_op_read(mobject_store_read_op_t read_op,
     MOBJECT_ASSERT(!(read_op->ready),
                    "can't modify a read_op that is ready to be processed");
 
-    rd_action_read_t action   = (rd_action_read_t)calloc(1, sizeof(*action));
+    rd_action_read_t action
+        = (rd_action_read_t)alloc_read_action(read_op, sizeof(*action));
     action->base.type         = READ_OPCODE_READ;
     action->offset            = offset;
     action->len               = len;
@@ -77,6 +79,17 @@ void mobject_read_op_omap_get_keys(mobject_store_read_op_t    read_op,
                                    uint64_t                   max_return,
                                    mobject_store_omap_iter_t* iter,
                                    int*                       prval)
+{
+    mobject_read_op_omap_get_keys2(read_op, start_after, max_return, iter,
+                                   NULL, prval);
+}
+
+void mobject_read_op_omap_get_keys2(mobject_store_read_op_t    read_op,
+                                    const char*                start_after,
+                                    uint64_t                   max_return,
+                                    mobject_store_omap_iter_t* iter,
+                                    unsigned char*             pmore,
+                                    int*                       prval)
 {
     MOBJECT_ASSERT(read_op != MOBJECT_READ_OP_NULL,
                    "invalid mobject_store_read_op_t object");
@@ -86,14 +99,20 @@ void mobject_read_op_omap_get_keys(mobject_store_read_op_t    read_op,
     size_t strl = strlen(start_after);
 
     rd_action_omap_get_keys_t action
-        = (rd_action_omap_get_keys_t)calloc(1, sizeof(*action) + strl);
+        = (rd_action_omap_get_keys_t)alloc_read_action(
+            read_op, sizeof(*action) + strl + 1);
+    char* data          = (char*)(action + 1);
     action->base.type   = READ_OPCODE_OMAP_GET_KEYS;
-    action->start_after = action->data;
+    action->data        = data;
+    action->start_after = data;
     action->max_return  = max_return;
     action->iter        = iter;
     action->prval       = prval;
+    action->pmore       = pmore;
     action->data_size   = strl + 1;
-    strcpy(action->data, start_after);
+    strcpy(data, start_after);
+    // results may only be truncated if the caller can ask for the rest
+    action->results.pageable = pmore != NULL;
 
     READ_ACTION_UPCAST(base, action);
     DL_APPEND(read_op->actions, base);
@@ -107,6 +126,18 @@ void mobject_read_op_omap_get_vals(mobject_store_read_op_t    read_op,
                                    uint64_t                   max_return,
                                    mobject_store_omap_iter_t* iter,
                                    int*                       prval)
+{
+    mobject_read_op_omap_get_vals2(read_op, start_after, filter_prefix,
+                                   max_return, iter, NULL, prval);
+}
+
+void mobject_read_op_omap_get_vals2(mobject_store_read_op_t    read_op,
+                                    const char*                start_after,
+                                    const char*                filter_prefix,
+                                    uint64_t                   max_return,
+                                    mobject_store_omap_iter_t* iter,
+                                    unsigned char*             pmore,
+                                    int*                       prval)
 {
     MOBJECT_ASSERT(read_op != MOBJECT_READ_OP_NULL,
                    "invalid mobject_store_read_op_t object");
@@ -119,16 +150,22 @@ void mobject_read_op_omap_get_vals(mobject_store_read_op_t    read_op,
     size_t extra_mem = strl1 + strl2;
 
     rd_action_omap_get_vals_t action
-        = (rd_action_omap_get_vals_t)calloc(1, sizeof(*action) - 1 + extra_mem);
+        = (rd_action_omap_get_vals_t)alloc_read_action(
+            read_op, sizeof(*action) + extra_mem);
+    char* data            = (char*)(action + 1);
     action->base.type     = READ_OPCODE_OMAP_GET_VALS;
-    action->start_after   = action->data;
-    action->filter_prefix = action->data + strl1;
+    action->data          = data;
+    action->start_after   = data;
+    action->filter_prefix = data + strl1;
     action->max_return    = max_return;
     action->iter          = iter;
     action->prval         = prval;
+    action->pmore         = pmore;
     action->data_size     = extra_mem;
-    strcpy(action->data, start_after);
-    strcpy(action->data + strl1, filter_prefix);
+    strcpy(data, start_after);
+    strcpy(data + strl1, filter_prefix);
+    // results may only be truncated if the caller can ask for the rest
+    action->results.pageable = pmore != NULL;
 
     READ_ACTION_UPCAST(base, action);
     DL_APPEND(read_op->actions, base);
@@ -153,14 +190,15 @@ void mobject_read_op_omap_get_vals_by_keys(mobject_store_read_op_t    read_op,
     for (i = 0; i < keys_len; i++) { extra_mem += strlen(keys[i]) + 1; }
 
     rd_action_omap_get_vals_by_keys_t action
-        = (rd_action_omap_get_vals_by_keys_t)calloc(1, sizeof(*action) - 1
-                                                           + extra_mem);
+        = (rd_action_omap_get_vals_by_keys_t)alloc_read_action(
+            read_op, sizeof(*action) + extra_mem);
     action->base.type = READ_OPCODE_OMAP_GET_VALS_BY_KEYS;
     action->num_keys  = keys_len;
     action->iter      = iter;
     action->prval     = prval;
     action->data_size = extra_mem;
-    char* s           = action->data;
+    action->data      = (const char*)(action + 1);
+    char* s           = (char*)(action + 1);
     for (i = 0; i < keys_len; i++) {
         strcpy(s, keys[i]);
         s += strlen(keys[i]) + 1;
@@ -171,3 +209,47 @@ void mobject_read_op_omap_get_vals_by_keys(mobject_store_read_op_t    read_op,
 
     read_op->num_actions += 1;
 }
+
+/* Number of bytes registered for the buffer of a READ action of a
+ * prepared read_op: the distance to the next region of the bulk handle
+ * (the buffer of a READ action or the results of an omap action), or to
+ * the end of the bulk handle, see prepare_read_op. Returns 0 if the
+ * read_op has no bulk handle. */
+static size_t registered_size(mobject_store_read_op_t read_op,
+                              rd_action_read_t        action)
+{
+    rd_action_base_t next;
+    omap_results_t*  results;
+
+    for (next = action->base.next; next; next = next->next) {
+        if (next->type == READ_OPCODE_READ)
+            return ((rd_action_read_t)next)->buffer.as_offset
+                 - action->buffer.as_offset;
+        results = read_action_omap_results(next);
+        if (results && results->size != 0)
+            return results->offset - action->buffer.as_offset;
+    }
+    if (read_op->bulk_handle == HG_BULK_NULL) return 0;
+    return HG_Bulk_get_size(read_op->bulk_handle) - action->buffer.as_offset;
+}
+
+int mobject_read_op_rebind(mobject_store_read_op_t read_op,
+                           size_t                  index,
+                           uint64_t                offset,
+                           size_t                  len)
+{
+    MOBJECT_ASSERT(read_op != MOBJECT_READ_OP_NULL,
+                   "invalid mobject_store_read_op_t object");
+
+    rd_action_base_t action = read_op->actions;
+    size_t           i;
+    for (i = 0; i < index && action; i++) action = action->next;
+    if (!action || action->type != READ_OPCODE_READ) return -1;
+
+    READ_ACTION_DOWNCAST(a, action, READ);
+    // once prepared, the data must fit in the memory registered for it
+    if (read_op->ready && len > registered_size(read_op, a)) return -1;
+    a->offset = offset;
+    a->len    = len;
+    return 0;
+}
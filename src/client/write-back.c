@@ -0,0 +1,336 @@
+/*
+ * (C) 2017 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "mobject-store-config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <margo.h>
+
+#include "libmobject-store.h"
+#include "src/client/cluster.h"
+#include "src/client/write-back.h"
+#include "src/io-chain/write-op-impl.h"
+#include "src/util/utlist.h"
+#include "src/util/log.h"
+
+typedef enum
+{
+    WB_MODE_WRITE,
+    WB_MODE_APPEND
+} wb_mode_t;
+
+typedef struct wb_entry {
+    char*            oid;        // name of the object
+    wb_mode_t        mode;       // write at offset or append
+    uint64_t         offset;     // start offset (WB_MODE_WRITE only)
+    int              flags;      // flags of the buffered operations
+    char*            data;       // buffered bytes
+    size_t           size;       // number of buffered bytes
+    double           first_time; // time at which the entry was created
+    struct wb_entry* prev;
+    struct wb_entry* next;
+} wb_entry;
+
+typedef struct wb_error {
+    char*            oid;   // name of the object
+    int              error; // error of an age-triggered flush
+    struct wb_error* prev;
+    struct wb_error* next;
+} wb_error;
+
+struct mobject_write_back {
+    ABT_mutex_memory mutex;
+    size_t           max_bytes;
+    double           max_delay;
+    wb_entry*        entries;
+    wb_error*        deferred_errors; // errors from age-triggered flushes
+};
+
+static wb_entry* find_entry(mobject_write_back_t wb, const char* oid)
+{
+    wb_entry* e;
+    DL_FOREACH(wb->entries, e)
+    {
+        if (strcmp(e->oid, oid) == 0) return e;
+    }
+    return NULL;
+}
+
+static wb_error* find_error(mobject_write_back_t wb, const char* oid)
+{
+    wb_error* d;
+    DL_FOREACH(wb->deferred_errors, d)
+    {
+        if (strcmp(d->oid, oid) == 0) return d;
+    }
+    return NULL;
+}
+
+/* remembers the error of an age-triggered flush until the object is
+ * flushed explicitly, keeping the first error of each object */
+static void defer_error(mobject_write_back_t wb, const char* oid, int error)
+{
+    if (find_error(wb, oid)) return;
+    wb_error* d = (wb_error*)calloc(1, sizeof(*d));
+    if (!d) return;
+    d->oid = strdup(oid);
+    if (!d->oid) {
+        free(d);
+        return;
+    }
+    d->error = error;
+    DL_APPEND(wb->deferred_errors, d);
+}
+
+/* removes the deferred error, returning it */
+static int take_error(mobject_write_back_t wb, wb_error* d)
+{
+    int error = d->error;
+    DL_DELETE(wb->deferred_errors, d);
+    free(d->oid);
+    free(d);
+    return error;
+}
+
+static void free_entry(mobject_write_back_t wb, wb_entry* e)
+{
+    DL_DELETE(wb->entries, e);
+    free(e->oid);
+    free(e->data);
+    free(e);
+}
+
+/* sends the content of an entry as a single write_op and frees the entry */
+static int flush_entry(mobject_store_ioctx_t io, wb_entry* e)
+{
+    mobject_provider_handle_t mph;
+    mobject_store_write_op_t  write_op;
+    int                       ret;
+
+    write_op = mobject_create_write_op();
+    if (e->mode == WB_MODE_APPEND)
+        mobject_write_op_append(write_op, e->data, e->size);
+    else
+        mobject_write_op_write(write_op, e->data, e->offset, e->size);
+
+    ret = mobject_store_locate(io, e->oid, &mph);
+    if (ret == 0) {
+        ret = mobject_write_op_operate(mph, write_op, io->pool_name, e->oid,
+                                       NULL, e->flags);
+        mobject_provider_handle_release(mph);
+    }
+    if (ret != 0)
+        margo_error(io->cluster->mid,
+                    "Unable to flush %zu buffered bytes for object %s (ret=%d)",
+                    e->size, e->oid, ret);
+
+    mobject_release_write_op(write_op);
+    free_entry(io->write_back, e);
+    return ret;
+}
+
+/*
+ * Checks that the write_op only contains WRITE and APPEND actions
+ * forming a contiguous range of bytes, the APPEND actions not having
+ * result pointers (their results are only known once flushed). On
+ * success, sets the mode, the start offset and the total length of the
+ * range and returns 1.
+ */
+static int
+get_op_range(mobject_store_write_op_t write_op, wb_mode_t* mode,
+             uint64_t* offset, size_t* len)
+{
+    wr_action_base_t action;
+    int              first = 1;
+
+    if (write_op->ready || write_op->num_actions == 0) return 0;
+
+    *len = 0;
+    DL_FOREACH(write_op->actions, action)
+    {
+        if (action->type == WRITE_OPCODE_APPEND) {
+            WRITE_ACTION_DOWNCAST(a, action, APPEND);
+            if (a->poffset || a->prval) return 0;
+            if (!first && *mode != WB_MODE_APPEND) return 0;
+            *mode = WB_MODE_APPEND;
+            *len += a->len;
+        } else if (action->type == WRITE_OPCODE_WRITE) {
+            WRITE_ACTION_DOWNCAST(w, action, WRITE);
+            if (first) {
+                *mode   = WB_MODE_WRITE;
+                *offset = w->offset;
+            } else if (*mode != WB_MODE_WRITE || w->offset != *offset + *len) {
+                return 0;
+            }
+            *len += w->len;
+        } else {
+            return 0;
+        }
+        first = 0;
+    }
+    return 1;
+}
+
+/* copies the data of the write_op at the end of the entry */
+static void copy_op_data(wb_entry* e, mobject_store_write_op_t write_op)
+{
+    wr_action_base_t action;
+    DL_FOREACH(write_op->actions, action)
+    {
+        if (action->type == WRITE_OPCODE_APPEND) {
+            WRITE_ACTION_DOWNCAST(a, action, APPEND);
+            memcpy(e->data + e->size, a->buffer.as_pointer, a->len);
+            e->size += a->len;
+        } else {
+            WRITE_ACTION_DOWNCAST(w, action, WRITE);
+            memcpy(e->data + e->size, w->buffer.as_pointer, w->len);
+            e->size += w->len;
+        }
+    }
+}
+
+int mobject_write_back_create(size_t                max_bytes,
+                              double                max_delay,
+                              mobject_write_back_t* wb)
+{
+    mobject_write_back_t tmp = (mobject_write_back_t)calloc(1, sizeof(*tmp));
+    if (!tmp) return -1;
+    tmp->max_bytes = max_bytes;
+    tmp->max_delay = max_delay;
+    *wb            = tmp;
+    return 0;
+}
+
+int mobject_write_back_destroy(mobject_store_ioctx_t io)
+{
+    int ret = mobject_write_back_flush(io, NULL);
+    free(io->write_back);
+    io->write_back = NULL;
+    return ret;
+}
+
+int mobject_write_back_absorb(mobject_store_ioctx_t    io,
+                              mobject_store_write_op_t write_op,
+                              const char*              oid,
+                              time_t*                  mtime,
+                              int                      flags)
+{
+    mobject_write_back_t wb = io->write_back;
+    wb_mode_t            mode;
+    uint64_t             offset = 0;
+    size_t               len;
+    int                  ret    = 0;
+
+    ABT_mutex_lock(ABT_MUTEX_MEMORY_GET_HANDLE(&wb->mutex));
+
+    wb_entry* e = find_entry(wb, oid);
+
+    /* operations setting an explicit mtime or that aren't a contiguous
+     * range of small writes/appends are sent as-is, after any pending
+     * entry for the same object to preserve ordering */
+    if (mtime || !get_op_range(write_op, &mode, &offset, &len)
+        || len > wb->max_bytes) {
+        if (e) ret = flush_entry(io, e);
+        ABT_mutex_unlock(ABT_MUTEX_MEMORY_GET_HANDLE(&wb->mutex));
+        return ret;
+    }
+
+    /* check whether the operation extends the pending entry */
+    if (e
+        && (e->mode != mode || e->flags != flags
+            || e->size + len > wb->max_bytes
+            || (mode == WB_MODE_WRITE && offset != e->offset + e->size))) {
+        ret = flush_entry(io, e);
+        e   = NULL;
+        if (ret != 0) goto finish;
+    }
+
+    if (!e) {
+        e = (wb_entry*)calloc(1, sizeof(*e));
+        if (!e) {
+            ret = -1;
+            goto finish;
+        }
+        e->data = (char*)malloc(wb->max_bytes);
+        e->oid  = strdup(oid);
+        if (!e->data || !e->oid) {
+            free(e->data);
+            free(e->oid);
+            free(e);
+            ret = -1;
+            goto finish;
+        }
+        e->mode       = mode;
+        e->offset     = offset;
+        e->flags      = flags;
+        e->first_time = ABT_get_wtime();
+        DL_APPEND(wb->entries, e);
+    }
+
+    copy_op_data(e, write_op);
+    ret = 1;
+
+    if (e->size == wb->max_bytes) {
+        int fret = flush_entry(io, e);
+        if (fret != 0) ret = fret;
+    }
+
+finish:
+    ABT_mutex_unlock(ABT_MUTEX_MEMORY_GET_HANDLE(&wb->mutex));
+    return ret;
+}
+
+int mobject_write_back_flush(mobject_store_ioctx_t io, const char* oid)
+{
+    mobject_write_back_t wb = io->write_back;
+    wb_entry *           e, *tmp;
+    wb_error *           d, *dtmp;
+    int                  ret = 0;
+
+    ABT_mutex_lock(ABT_MUTEX_MEMORY_GET_HANDLE(&wb->mutex));
+    if (oid) {
+        /* the deferred error happened first, report it in priority */
+        d = find_error(wb, oid);
+        if (d) ret = take_error(wb, d);
+        e = find_entry(wb, oid);
+        if (e) {
+            int r = flush_entry(io, e);
+            if (r != 0 && ret == 0) ret = r;
+        }
+    } else {
+        DL_FOREACH_SAFE(wb->deferred_errors, d, dtmp)
+        {
+            int r = take_error(wb, d);
+            if (ret == 0) ret = r;
+        }
+        DL_FOREACH_SAFE(wb->entries, e, tmp)
+        {
+            int r = flush_entry(io, e);
+            if (r != 0 && ret == 0) ret = r;
+        }
+    }
+    ABT_mutex_unlock(ABT_MUTEX_MEMORY_GET_HANDLE(&wb->mutex));
+    return ret;
+}
+
+void mobject_write_back_flush_expired(mobject_store_ioctx_t io)
+{
+    mobject_write_back_t wb = io->write_back;
+    wb_entry *           e, *tmp;
+    double               now = ABT_get_wtime();
+
+    ABT_mutex_lock(ABT_MUTEX_MEMORY_GET_HANDLE(&wb->mutex));
+    DL_FOREACH_SAFE(wb->entries, e, tmp)
+    {
+        if (now - e->first_time < wb->max_delay) continue;
+        char* e_oid = strdup(e->oid);
+        int   r     = flush_entry(io, e);
+        if (r != 0 && e_oid) defer_error(wb, e_oid, r);
+        free(e_oid);
+    }
+    ABT_mutex_unlock(ABT_MUTEX_MEMORY_GET_HANDLE(&wb->mutex));
+}
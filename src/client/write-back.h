@@ -0,0 +1,71 @@
+/*
+ * (C) 2017 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __MOBJECT_WRITE_BACK_H
+#define __MOBJECT_WRITE_BACK_H
+
+#include <time.h>
+#include "libmobject-store.h"
+
+/**
+ * The write-back buffer is an opt-in, per-ioctx structure that
+ * coalesces small contiguous writes and appends to the same object
+ * into a single larger write_op. Each object has at most one pending
+ * entry, which is either in "write" mode (a contiguous byte range
+ * starting at a known offset) or in "append" mode (bytes to be appended
+ * to the end of the object).
+ *
+ * An entry is flushed when adding to it would exceed the buffer size,
+ * when it has been pending for longer than the configured delay (this
+ * is checked every time the ioctx is used), when an operation that
+ * cannot be buffered targets the same object, when the same object is
+ * read, and when mobject_store_ioctx_flush or
+ * mobject_store_ioctx_destroy is called.
+ */
+typedef struct mobject_write_back* mobject_write_back_t;
+
+/**
+ * Creates a write-back buffer. max_bytes is the maximum number of bytes
+ * buffered per object, max_delay the maximum time (in seconds) a buffered
+ * write may remain pending.
+ */
+int mobject_write_back_create(size_t                max_bytes,
+                              double                max_delay,
+                              mobject_write_back_t* wb);
+
+/**
+ * Flushes all pending entries and destroys the write-back buffer.
+ * Returns the first error encountered while flushing, if any.
+ */
+int mobject_write_back_destroy(mobject_store_ioctx_t io);
+
+/**
+ * Tries to buffer the write_op. Returns 1 if the operation has been
+ * absorbed (the caller must not send it), 0 if the caller should send it
+ * (any pending entry for the object has been flushed beforehand), or
+ * a negative error code if flushing a pending entry failed.
+ */
+int mobject_write_back_absorb(mobject_store_ioctx_t    io,
+                              mobject_store_write_op_t write_op,
+                              const char*              oid,
+                              time_t*                  mtime,
+                              int                      flags);
+
+/**
+ * Flushes the pending entry of the given object, or of all objects if
+ * oid is NULL. Returns 0 on success, or the first error encountered
+ * for these objects since they were last flushed by this function
+ * (including errors of entries flushed because of their age, which are
+ * remembered per object until reported).
+ */
+int mobject_write_back_flush(mobject_store_ioctx_t io, const char* oid);
+
+/**
+ * Flushes the entries that have been pending for longer than the
+ * configured delay.
+ */
+void mobject_write_back_flush_expired(mobject_store_ioctx_t io);
+
+#endif
@@ -32,9 +32,10 @@ void mobject_write_op_create(mobject_store_write_op_t write_op,
     MOBJECT_ASSERT(!(write_op->ready),
                    "can't modify a write_op that is ready to be processed");
 
-    wr_action_create_t action = (wr_action_create_t)calloc(1, sizeof(*action));
-    action->base.type         = WRITE_OPCODE_CREATE;
-    action->exclusive         = exclusive;
+    wr_action_create_t action
+        = (wr_action_create_t)alloc_write_action(write_op, sizeof(*action));
+    action->base.type = WRITE_OPCODE_CREATE;
+    action->exclusive = exclusive;
 
     WRITE_ACTION_UPCAST(base, action);
     DL_APPEND(write_op->actions, base);
@@ -52,7 +53,8 @@ void mobject_write_op_write(mobject_store_write_op_t write_op,
     MOBJECT_ASSERT(!(write_op->ready),
                    "can't modify a write_op that is ready to be processed");
 
-    wr_action_write_t action  = (wr_action_write_t)calloc(1, sizeof(*action));
+    wr_action_write_t action
+        = (wr_action_write_t)alloc_write_action(write_op, sizeof(*action));
     action->base.type         = WRITE_OPCODE_WRITE;
     action->buffer.as_pointer = buffer;
     action->len               = len;
@@ -74,7 +76,7 @@ void mobject_write_op_write_full(mobject_store_write_op_t write_op,
                    "can't modify a write_op that is ready to be processed");
 
     wr_action_write_full_t action
-        = (wr_action_write_full_t)calloc(1, sizeof(*action));
+        = (wr_action_write_full_t)alloc_write_action(write_op, sizeof(*action));
     action->base.type         = WRITE_OPCODE_WRITE_FULL;
     action->buffer.as_pointer = buffer;
     action->len               = len;
@@ -115,7 +117,7 @@ void mobject_write_op_write_same(mobject_store_write_op_t write_op,
                    "can't modify a write_op that is ready to be processed");
 
     wr_action_write_same_t action
-        = (wr_action_write_same_t)calloc(1, sizeof(*action));
+        = (wr_action_write_same_t)alloc_write_action(write_op, sizeof(*action));
     action->base.type         = WRITE_OPCODE_WRITE_SAME;
     action->buffer.as_pointer = buffer;
     action->data_len          = data_len;
@@ -131,16 +133,28 @@ void mobject_write_op_write_same(mobject_store_write_op_t write_op,
 void mobject_write_op_append(mobject_store_write_op_t write_op,
                              const char*              buffer,
                              size_t                   len)
+{
+    mobject_write_op_append2(write_op, buffer, len, NULL, NULL);
+}
+
+void mobject_write_op_append2(mobject_store_write_op_t write_op,
+                              const char*              buffer,
+                              size_t                   len,
+                              uint64_t*                poffset,
+                              int*                     prval)
 {
     MOBJECT_ASSERT(write_op != MOBJECT_WRITE_OP_NULL,
                    "invalid mobject_store_write_op_t object");
     MOBJECT_ASSERT(!(write_op->ready),
                    "can't modify a write_op that is ready to be processed");
 
-    wr_action_append_t action = (wr_action_append_t)calloc(1, sizeof(*action));
+    wr_action_append_t action
+        = (wr_action_append_t)alloc_write_action(write_op, sizeof(*action));
     action->base.type         = WRITE_OPCODE_APPEND;
     action->buffer.as_pointer = buffer;
     action->len               = len;
+    action->poffset           = poffset;
+    action->prval             = prval;
 
     WRITE_ACTION_UPCAST(base, action);
     DL_APPEND(write_op->actions, base);
@@ -155,8 +169,9 @@ void mobject_write_op_remove(mobject_store_write_op_t write_op)
     MOBJECT_ASSERT(!(write_op->ready),
                    "can't modify a write_op that is ready to be processed");
 
-    wr_action_remove_t action = (wr_action_remove_t)calloc(1, sizeof(*action));
-    action->base.type         = WRITE_OPCODE_REMOVE;
+    wr_action_remove_t action
+        = (wr_action_remove_t)alloc_write_action(write_op, sizeof(*action));
+    action->base.type = WRITE_OPCODE_REMOVE;
 
     /* THE FOLLOWING IS A POTENTIAL (INCOMPLETE) OPTIMIZATION
         // a remove operation will make all previous operations unnecessary
@@ -191,7 +206,7 @@ void mobject_write_op_truncate(mobject_store_write_op_t write_op,
                    "can't modify a write_op that is ready to be processed");
 
     wr_action_truncate_t action
-        = (wr_action_truncate_t)calloc(1, sizeof(*action));
+        = (wr_action_truncate_t)alloc_write_action(write_op, sizeof(*action));
     action->base.type = WRITE_OPCODE_TRUNCATE;
     action->offset    = offset;
 
@@ -210,10 +225,11 @@ void mobject_write_op_zero(mobject_store_write_op_t write_op,
     MOBJECT_ASSERT(!(write_op->ready),
                    "can't modify a write_op that is ready to be processed");
 
-    wr_action_zero_t action = (wr_action_zero_t)calloc(1, sizeof(*action));
-    action->base.type       = WRITE_OPCODE_ZERO;
-    action->offset          = offset;
-    action->len             = len;
+    wr_action_zero_t action
+        = (wr_action_zero_t)alloc_write_action(write_op, sizeof(*action));
+    action->base.type = WRITE_OPCODE_ZERO;
+    action->offset    = offset;
+    action->len       = len;
 
     WRITE_ACTION_UPCAST(base, action);
     DL_APPEND(write_op->actions, base);
@@ -240,13 +256,14 @@ void mobject_write_op_omap_set(mobject_store_write_op_t write_op,
         extra_size += lens[i];
     }
 
-    wr_action_omap_set_t action
-        = (wr_action_omap_set_t)calloc(1, sizeof(*action) - 1 + extra_size);
+    wr_action_omap_set_t action = (wr_action_omap_set_t)alloc_write_action(
+        write_op, sizeof(*action) + extra_size);
     action->base.type = WRITE_OPCODE_OMAP_SET;
     action->num       = num;
     action->data_size = extra_size;
+    action->data      = (const char*)(action + 1);
 
-    char* data = action->data;
+    char* data = (char*)(action + 1);
     for (i = 0; i < num; i++) {
         // serialize key
         strcpy(data, keys[i]);
@@ -280,12 +297,14 @@ void mobject_write_op_omap_rm_keys(mobject_store_write_op_t write_op,
     for (i = 0; i < keys_len; i++) { extra_mem += strlen(keys[i]) + 1; }
 
     wr_action_omap_rm_keys_t action
-        = (wr_action_omap_rm_keys_t)calloc(1, sizeof(*action) - 1 + extra_mem);
+        = (wr_action_omap_rm_keys_t)alloc_write_action(
+            write_op, sizeof(*action) + extra_mem);
     action->base.type = WRITE_OPCODE_OMAP_RM_KEYS;
     action->num_keys  = keys_len;
     action->data_size = extra_mem;
+    action->data      = (const char*)(action + 1);
 
-    char* data = action->data;
+    char* data = (char*)(action + 1);
     // serialize the keys
     for (i = 0; i < keys_len; i++) {
         strcpy(data, keys[i]);
@@ -297,3 +316,215 @@ void mobject_write_op_omap_rm_keys(mobject_store_write_op_t write_op,
 
     write_op->num_actions += 1;
 }
+
+void mobject_write_op_omap_rm_range(mobject_store_write_op_t write_op,
+                                    const char*              start,
+                                    const char*              end)
+{
+    MOBJECT_ASSERT(write_op != MOBJECT_WRITE_OP_NULL,
+                   "invalid mobject_store_write_op_t object");
+    MOBJECT_ASSERT(!(write_op->ready),
+                   "can't modify a write_op that is ready to be processed");
+
+    size_t start_size = strlen(start) + 1;
+    size_t end_size   = strlen(end) + 1;
+
+    wr_action_omap_rm_range_t action
+        = (wr_action_omap_rm_range_t)alloc_write_action(
+            write_op, sizeof(*action) + start_size + end_size);
+    action->base.type = WRITE_OPCODE_OMAP_RM_RANGE;
+    action->data_size = start_size + end_size;
+    action->data      = (const char*)(action + 1);
+
+    // serialize the two keys
+    char* data = (char*)(action + 1);
+    memcpy(data, start, start_size);
+    memcpy(data + start_size, end, end_size);
+
+    WRITE_ACTION_UPCAST(base, action);
+    DL_APPEND(write_op->actions, base);
+
+    write_op->num_actions += 1;
+}
+
+void mobject_write_op_omap_clear(mobject_store_write_op_t write_op)
+{
+    MOBJECT_ASSERT(write_op != MOBJECT_WRITE_OP_NULL,
+                   "invalid mobject_store_write_op_t object");
+    MOBJECT_ASSERT(!(write_op->ready),
+                   "can't modify a write_op that is ready to be processed");
+
+    wr_action_omap_clear_t action
+        = (wr_action_omap_clear_t)alloc_write_action(write_op, sizeof(*action));
+    action->base.type = WRITE_OPCODE_OMAP_CLEAR;
+
+    WRITE_ACTION_UPCAST(base, action);
+    DL_APPEND(write_op->actions, base);
+
+    write_op->num_actions += 1;
+}
+
+void mobject_write_op_omap_add(mobject_store_write_op_t write_op,
+                               const char*              key,
+                               int64_t                  delta,
+                               int64_t*                 presult,
+                               int*                     prval)
+{
+    MOBJECT_ASSERT(write_op != MOBJECT_WRITE_OP_NULL,
+                   "invalid mobject_store_write_op_t object");
+    MOBJECT_ASSERT(!(write_op->ready),
+                   "can't modify a write_op that is ready to be processed");
+
+    size_t key_size = strlen(key) + 1;
+
+    wr_action_omap_add_t action = (wr_action_omap_add_t)alloc_write_action(
+        write_op, sizeof(*action) + key_size);
+    action->base.type = WRITE_OPCODE_OMAP_ADD;
+    action->delta     = delta;
+    action->presult   = presult;
+    action->prval     = prval;
+    action->data_size = key_size;
+    action->data      = (const char*)(action + 1);
+
+    memcpy(action + 1, key, key_size);
+
+    WRITE_ACTION_UPCAST(base, action);
+    DL_APPEND(write_op->actions, base);
+
+    write_op->num_actions += 1;
+}
+
+void mobject_write_op_omap_cmpxchg(mobject_store_write_op_t write_op,
+                                   const char*              key,
+                                   const char*              cmp_val,
+                                   size_t                   cmp_len,
+                                   const char*              val,
+                                   size_t                   val_len,
+                                   int*                     prval)
+{
+    MOBJECT_ASSERT(write_op != MOBJECT_WRITE_OP_NULL,
+                   "invalid mobject_store_write_op_t object");
+    MOBJECT_ASSERT(!(write_op->ready),
+                   "can't modify a write_op that is ready to be processed");
+
+    size_t key_size = strlen(key) + 1;
+    if (cmp_val == NULL) cmp_len = 0;
+
+    wr_action_omap_cmpxchg_t action
+        = (wr_action_omap_cmpxchg_t)alloc_write_action(
+            write_op, sizeof(*action) + key_size + cmp_len + val_len);
+    action->base.type = WRITE_OPCODE_OMAP_CMPXCHG;
+    action->absent    = cmp_val == NULL;
+    action->cmp_len   = cmp_len;
+    action->val_len   = val_len;
+    action->prval     = prval;
+    action->data_size = key_size + cmp_len + val_len;
+    action->data      = (const char*)(action + 1);
+
+    // serialize the key, the expected value and the new value
+    char* data = (char*)(action + 1);
+    memcpy(data, key, key_size);
+    if (cmp_len) memcpy(data + key_size, cmp_val, cmp_len);
+    if (val_len) memcpy(data + key_size + cmp_len, val, val_len);
+
+    WRITE_ACTION_UPCAST(base, action);
+    DL_APPEND(write_op->actions, base);
+
+    write_op->num_actions += 1;
+}
+
+/* gets the position of the data of an action in the bulk handle,
+ * returns 0 if the action has no data */
+static int buffer_position(wr_action_base_t action, uint64_t* pos)
+{
+    switch (action->type) {
+    case WRITE_OPCODE_WRITE:
+        *pos = ((wr_action_write_t)action)->buffer.as_offset;
+        return 1;
+    case WRITE_OPCODE_WRITE_FULL:
+        *pos = ((wr_action_write_full_t)action)->buffer.as_offset;
+        return 1;
+    case WRITE_OPCODE_WRITE_SAME:
+        *pos = ((wr_action_write_same_t)action)->buffer.as_offset;
+        return 1;
+    case WRITE_OPCODE_APPEND:
+        *pos = ((wr_action_append_t)action)->buffer.as_offset;
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/* Number of bytes registered for the data of an action of a prepared
+ * write_op. prepare_write_op places the buffers one after the other in
+ * the bulk handle, so this is the distance to the next buffer (or to
+ * the end of the bulk handle). Returns 0 if it cannot be known, which
+ * is the case for write_ops prepared as part of a batch. */
+static size_t registered_size(mobject_store_write_op_t write_op,
+                              wr_action_base_t         action)
+{
+    uint64_t         pos, next_pos;
+    wr_action_base_t next;
+
+    if (!buffer_position(action, &pos)) return 0;
+    for (next = action->next; next; next = next->next) {
+        if (buffer_position(next, &next_pos)) return next_pos - pos;
+    }
+    if (write_op->bulk_handle == HG_BULK_NULL) return 0;
+    return HG_Bulk_get_size(write_op->bulk_handle) - pos;
+}
+
+int mobject_write_op_rebind(mobject_store_write_op_t write_op,
+                            size_t                   index,
+                            uint64_t                 offset,
+                            size_t                   len)
+{
+    MOBJECT_ASSERT(write_op != MOBJECT_WRITE_OP_NULL,
+                   "invalid mobject_store_write_op_t object");
+
+    wr_action_base_t action = write_op->actions;
+    size_t           i;
+    for (i = 0; i < index && action; i++) action = action->next;
+    if (!action) return -1;
+
+    // once prepared, the data must fit in the memory registered for it
+    // (the length of a WRITE_SAME is that of the range being written)
+    uint64_t pos;
+    if (write_op->ready && buffer_position(action, &pos)
+        && action->type != WRITE_OPCODE_WRITE_SAME
+        && len > registered_size(write_op, action))
+        return -1;
+
+    switch (action->type) {
+    case WRITE_OPCODE_WRITE: {
+        WRITE_ACTION_DOWNCAST(a, action, WRITE);
+        a->offset = offset;
+        a->len    = len;
+    } break;
+    case WRITE_OPCODE_WRITE_FULL: {
+        WRITE_ACTION_DOWNCAST(a, action, WRITE_FULL);
+        a->len = len;
+    } break;
+    case WRITE_OPCODE_WRITE_SAME: {
+        WRITE_ACTION_DOWNCAST(a, action, WRITE_SAME);
+        a->offset    = offset;
+        a->write_len = len;
+    } break;
+    case WRITE_OPCODE_APPEND: {
+        WRITE_ACTION_DOWNCAST(a, action, APPEND);
+        a->len = len;
+    } break;
+    case WRITE_OPCODE_TRUNCATE: {
+        WRITE_ACTION_DOWNCAST(a, action, TRUNCATE);
+        a->offset = offset;
+    } break;
+    case WRITE_OPCODE_ZERO: {
+        WRITE_ACTION_DOWNCAST(a, action, ZERO);
+        a->offset = offset;
+        a->len    = len;
+    } break;
+    default:
+        return -1;
+    }
+    return 0;
+}
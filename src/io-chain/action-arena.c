@@ -0,0 +1,56 @@
+/*
+ * (C) 2017 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "src/io-chain/action-arena.h"
+#include "src/util/log.h"
+
+#define ACTION_ARENA_ALIGN      16
+#define ACTION_ARENA_FIRST_SIZE 512
+
+struct action_arena_chunk {
+    struct action_arena_chunk* next;
+    size_t                     size; // capacity of data
+    size_t                     used; // bytes of data handed out
+    _Alignas(ACTION_ARENA_ALIGN) char data[];
+};
+
+void* action_arena_alloc(struct action_arena* arena, size_t size)
+{
+    struct action_arena_chunk* chunk = arena->chunks;
+    void*                      ptr;
+
+    size = (size + ACTION_ARENA_ALIGN - 1) & ~(size_t)(ACTION_ARENA_ALIGN - 1);
+
+    if (chunk == NULL || chunk->size - chunk->used < size) {
+        size_t chunk_size
+            = chunk == NULL ? ACTION_ARENA_FIRST_SIZE : 2 * chunk->size;
+        while (chunk_size < size) chunk_size *= 2;
+        chunk = (struct action_arena_chunk*)malloc(sizeof(*chunk) + chunk_size);
+        MOBJECT_ASSERT(chunk != NULL, "Could not allocate action arena");
+        chunk->size   = chunk_size;
+        chunk->used   = 0;
+        chunk->next   = arena->chunks;
+        arena->chunks = chunk;
+    }
+
+    ptr = chunk->data + chunk->used;
+    chunk->used += size;
+    memset(ptr, 0, size);
+    return ptr;
+}
+
+void action_arena_release(struct action_arena* arena)
+{
+    struct action_arena_chunk* chunk = arena->chunks;
+    while (chunk) {
+        struct action_arena_chunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    arena->chunks = NULL;
+}
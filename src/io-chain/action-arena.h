@@ -0,0 +1,43 @@
+/*
+ * (C) 2017 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __MOBJECT_ACTION_ARENA_H
+#define __MOBJECT_ACTION_ARENA_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * The actions of a read_op or write_op are allocated from an arena
+ * owned by the op instead of being allocated one by one. The arena is
+ * a list of chunks of geometrically increasing sizes: most actions of
+ * an op end up contiguous in memory, and growing the arena does not
+ * move the actions already allocated (the lists linking them hold
+ * pointers). Memory is only given back when the op is released.
+ */
+struct action_arena_chunk;
+
+struct action_arena {
+    struct action_arena_chunk* chunks; // most recently allocated first
+};
+
+/**
+ * Allocates size bytes of zeroed memory from the arena.
+ */
+void* action_arena_alloc(struct action_arena* arena, size_t size);
+
+/**
+ * Frees all the memory allocated from the arena.
+ */
+void action_arena_release(struct action_arena* arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -114,4 +114,49 @@ typedef struct args_wr_action_RM_KEYS {
     size_t data_size;
 } args_wr_action_omap_rm_keys;
 
+/**
+ * rm_range operation
+ * data_size represents the size of the extra data
+ * to be read after this header.
+ * extra data contains the first and end keys of the range
+ * (see write-actions.h for the format)
+ */
+typedef struct args_wr_action_RM_RANGE {
+    size_t data_size;
+} args_wr_action_omap_rm_range;
+
+/**
+ * omap_clear operation
+ * no header (so no definition needed)
+ * no extra data
+ */
+// typedef struct args_wr_action_OMAP_CLEAR {
+// } args_wr_action_omap_clear;
+
+/**
+ * omap_add operation
+ * data_size represents the size of the extra data
+ * to be read after this header.
+ * extra data contains the key
+ * (see write-actions.h for the format)
+ */
+typedef struct args_wr_action_OMAP_ADD {
+    int64_t delta;
+    size_t  data_size;
+} args_wr_action_omap_add;
+
+/**
+ * omap_cmpxchg operation
+ * data_size represents the size of the extra data
+ * to be read after this header.
+ * extra data contains the key, expected value and new value
+ * (see write-actions.h for the format)
+ */
+typedef struct args_wr_action_OMAP_CMPXCHG {
+    int32_t absent;
+    size_t  cmp_len;
+    size_t  val_len;
+    size_t  data_size;
+} args_wr_action_omap_cmpxchg;
+
 #endif
@@ -14,6 +14,20 @@ static void prepare_read(uint64_t*        cur_offset,
                          void**           ptr,
                          size_t*          len);
 
+static int prepare_omap_results(uint64_t*       cur_offset,
+                                size_t          size,
+                                omap_results_t* results,
+                                void**          ptr,
+                                size_t*         len);
+
+static size_t collect_read_op_buffers(mobject_store_read_op_t read_op,
+                                      uint64_t*               cur_offset,
+                                      void**                  pointers,
+                                      size_t*                 lengths);
+
+static size_t restore_read_op_buffers(mobject_store_read_op_t read_op,
+                                      void**                  pointers);
+
 void prepare_read_op(margo_instance_id mid, mobject_store_read_op_t read_op)
 {
     if (read_op->ready == 1) return;
@@ -22,29 +36,12 @@ void prepare_read_op(margo_instance_id mid, mobject_store_read_op_t read_op)
         return;
     }
 
-    rd_action_base_t action;
-
     void**   pointers = (void**)calloc(read_op->num_actions, sizeof(void*));
     size_t*  lengths  = (size_t*)calloc(read_op->num_actions, sizeof(size_t));
     uint64_t current_offset = 0;
-    size_t   i              = 0;
-
-    DL_FOREACH(read_op->actions, action)
-    {
-
-        switch (action->type) {
-        case READ_OPCODE_READ:
-            prepare_read(&current_offset, (rd_action_read_t)action,
-                         pointers + i, lengths + i);
-            i += 1;
-            break;
-        default:
-            /* nothing to do for other op types */
-            break;
-        }
-    }
 
-    uint32_t count = i;
+    uint32_t count
+        = collect_read_op_buffers(read_op, &current_offset, pointers, lengths);
     if (count != 0) {
         hg_return_t ret
             = margo_bulk_create(mid, count, pointers, lengths,
@@ -59,10 +56,138 @@ void prepare_read_op(margo_instance_id mid, mobject_store_read_op_t read_op)
     free(lengths);
 }
 
+int prepare_read_op_batch(margo_instance_id        mid,
+                          mobject_store_read_op_t* read_ops,
+                          size_t                   count,
+                          hg_bulk_t*               bulk_handle,
+                          void***                  saved_pointers)
+{
+    size_t i, num_actions = 0;
+
+    *bulk_handle    = HG_BULK_NULL;
+    *saved_pointers = NULL;
+
+    for (i = 0; i < count; i++) {
+        if (read_ops[i]->ready == 0) num_actions += read_ops[i]->num_actions;
+    }
+
+    void**   pointers = (void**)calloc(num_actions + 1, sizeof(void*));
+    size_t*  lengths  = (size_t*)calloc(num_actions + 1, sizeof(size_t));
+    uint64_t current_offset = 0;
+    uint32_t num_buffers    = 0;
+
+    for (i = 0; i < count; i++) {
+        if (read_ops[i]->ready == 1) continue;
+        num_buffers += collect_read_op_buffers(read_ops[i], &current_offset,
+                                               pointers + num_buffers,
+                                               lengths + num_buffers);
+        read_ops[i]->ready = 1;
+    }
+
+    int ret = 0;
+    if (num_buffers != 0) {
+        hg_return_t hret = margo_bulk_create(mid, num_buffers, pointers,
+                                             lengths, HG_BULK_WRITE_ONLY,
+                                             bulk_handle);
+        if (hret != HG_SUCCESS) ret = -1;
+    }
+
+    free(lengths);
+    if (ret == 0)
+        *saved_pointers = pointers;
+    else
+        restore_read_op_batch(read_ops, count, pointers);
+
+    return ret;
+}
+
+void restore_read_op_batch(mobject_store_read_op_t* read_ops,
+                           size_t                   count,
+                           void**                   saved_pointers)
+{
+    size_t i, num_buffers = 0;
+
+    if (saved_pointers == NULL) return;
+
+    for (i = 0; i < count; i++) {
+        /* read_ops prepared on their own keep their bulk handle, and
+         * a read_op that appears twice is restored once */
+        if (read_ops[i]->bulk_handle != HG_BULK_NULL || !read_ops[i]->ready)
+            continue;
+        num_buffers += restore_read_op_buffers(read_ops[i],
+                                               saved_pointers + num_buffers);
+        read_ops[i]->ready = 0;
+    }
+
+    free(saved_pointers);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //                          STATIC FUNCTIONS BELOW                            //
 ////////////////////////////////////////////////////////////////////////////////
 
+static size_t collect_read_op_buffers(mobject_store_read_op_t read_op,
+                                      uint64_t*               cur_offset,
+                                      void**                  pointers,
+                                      size_t*                 lengths)
+{
+    rd_action_base_t action;
+    size_t           i = 0;
+
+    DL_FOREACH(read_op->actions, action)
+    {
+
+        switch (action->type) {
+        case READ_OPCODE_READ:
+            prepare_read(cur_offset, (rd_action_read_t)action, pointers + i,
+                         lengths + i);
+            i += 1;
+            break;
+        case READ_OPCODE_OMAP_GET_KEYS:
+        case READ_OPCODE_OMAP_GET_VALS:
+        case READ_OPCODE_OMAP_GET_VALS_BY_KEYS:
+            /* the legacy format has no room for the region */
+            if (read_op->wire_format != MOBJECT_WIRE_FORMAT_COMPACT) break;
+            i += prepare_omap_results(cur_offset, read_op->omap_bulk_size,
+                                      read_action_omap_results(action),
+                                      pointers + i, lengths + i);
+            break;
+        default:
+            /* nothing to do for other op types */
+            break;
+        }
+    }
+
+    return i;
+}
+
+static size_t restore_read_op_buffers(mobject_store_read_op_t read_op,
+                                      void**                  pointers)
+{
+    rd_action_base_t action;
+    omap_results_t*  results;
+    size_t           i = 0;
+
+    DL_FOREACH(read_op->actions, action)
+    {
+        if (action->type == READ_OPCODE_READ) {
+            ((rd_action_read_t)action)->buffer.as_pointer = pointers[i++];
+            continue;
+        }
+        /* the region of omap results is allocated again when the
+         * read_op is prepared again */
+        results = read_action_omap_results(action);
+        if (results == NULL || results->buffer == NULL) continue;
+        free(results->buffer);
+        results->buffer = NULL;
+        results->size   = 0;
+        results->offset = 0;
+        i += 1;
+    }
+
+    return i;
+}
+
 static void prepare_read(uint64_t*        cur_offset,
                          rd_action_read_t action,
                          void**           ptr,
@@ -74,3 +199,20 @@ static void prepare_read(uint64_t*        cur_offset,
     *len                     = action->len;
     action->buffer.as_offset = pos;
 }
+
+static int prepare_omap_results(uint64_t*       cur_offset,
+                                size_t          size,
+                                omap_results_t* results,
+                                void**          ptr,
+                                size_t*         len)
+{
+    if (size == 0) return 0;
+    results->buffer = (char*)malloc(size);
+    if (results->buffer == NULL) return 0;
+    results->size   = size;
+    results->offset = *cur_offset;
+    *cur_offset += size;
+    *ptr = results->buffer;
+    *len = size;
+    return 1;
+}
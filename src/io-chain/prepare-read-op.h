@@ -18,4 +18,32 @@
  */
 void prepare_read_op(margo_instance_id mid, mobject_store_read_op_t read_op);
 
+/**
+ * Prepares a batch of read_ops to be sent in a single RPC. The buffers
+ * of all the read_ops are stitched together into a single bulk handle,
+ * returned in bulk_handle (HG_BULK_NULL if there is no buffer), and
+ * offsets keep increasing from one read_op to the next. The read_ops
+ * themselves do not own a bulk handle: the caller must free bulk_handle
+ * once the RPC has completed, and give saved_pointers, which holds the
+ * pointers the offsets replaced, to restore_read_op_batch. read_ops that
+ * were already prepared keep their own bulk handle.
+ *
+ * Returns 0 on success, -1 if the bulk handle could not be created.
+ */
+int prepare_read_op_batch(margo_instance_id        mid,
+                          mobject_store_read_op_t* read_ops,
+                          size_t                   count,
+                          hg_bulk_t*               bulk_handle,
+                          void***                  saved_pointers);
+
+/**
+ * Restores the pointers of the read_ops prepared by prepare_read_op_batch
+ * and makes them not ready again, so that they can be modified, sent on
+ * their own or as part of another batch. Must be called once the RPC has
+ * completed and its response has been processed. Frees saved_pointers.
+ */
+void restore_read_op_batch(mobject_store_read_op_t* read_ops,
+                           size_t                   count,
+                           void**                   saved_pointers);
+
 #endif
@@ -29,6 +29,14 @@ static void convert_append(uint64_t*          cur_offset,
                            void**             ptr,
                            size_t*            len);
 
+static size_t collect_write_op_buffers(mobject_store_write_op_t write_op,
+                                       uint64_t*                cur_offset,
+                                       void**                   pointers,
+                                       size_t*                  lengths);
+
+static size_t restore_write_op_buffers(mobject_store_write_op_t write_op,
+                                       void**                   pointers);
+
 void prepare_write_op(margo_instance_id mid, mobject_store_write_op_t write_op)
 {
     if (write_op->ready == 1) return;
@@ -37,34 +45,125 @@ void prepare_write_op(margo_instance_id mid, mobject_store_write_op_t write_op)
         return;
     }
 
-    wr_action_base_t action;
-
     void**   pointers = (void**)calloc(write_op->num_actions, sizeof(void*));
     size_t*  lengths  = (size_t*)calloc(write_op->num_actions, sizeof(size_t));
     uint64_t current_offset = 0;
-    size_t   i              = 0;
+
+    uint32_t count = collect_write_op_buffers(write_op, &current_offset,
+                                              pointers, lengths);
+    if (count != 0) {
+        hg_return_t ret
+            = margo_bulk_create(mid, count, pointers, lengths,
+                                HG_BULK_READ_ONLY, &(write_op->bulk_handle));
+        // TODO handle error
+        assert(ret == HG_SUCCESS);
+    }
+
+    write_op->ready = 1;
+
+    free(pointers);
+    free(lengths);
+}
+
+int prepare_write_op_batch(margo_instance_id         mid,
+                           mobject_store_write_op_t* write_ops,
+                           size_t                    count,
+                           hg_bulk_t*                bulk_handle,
+                           void***                   saved_pointers)
+{
+    size_t i, num_actions = 0;
+
+    *bulk_handle    = HG_BULK_NULL;
+    *saved_pointers = NULL;
+
+    for (i = 0; i < count; i++) {
+        if (write_ops[i]->ready == 0) num_actions += write_ops[i]->num_actions;
+    }
+
+    void**   pointers = (void**)calloc(num_actions + 1, sizeof(void*));
+    size_t*  lengths  = (size_t*)calloc(num_actions + 1, sizeof(size_t));
+    uint64_t current_offset = 0;
+    uint32_t num_buffers    = 0;
+
+    for (i = 0; i < count; i++) {
+        if (write_ops[i]->ready == 1) continue;
+        num_buffers += collect_write_op_buffers(write_ops[i], &current_offset,
+                                                pointers + num_buffers,
+                                                lengths + num_buffers);
+        write_ops[i]->ready = 1;
+    }
+
+    int ret = 0;
+    if (num_buffers != 0) {
+        hg_return_t hret = margo_bulk_create(mid, num_buffers, pointers,
+                                             lengths, HG_BULK_READ_ONLY,
+                                             bulk_handle);
+        if (hret != HG_SUCCESS) ret = -1;
+    }
+
+    free(lengths);
+    if (ret == 0)
+        *saved_pointers = pointers;
+    else
+        restore_write_op_batch(write_ops, count, pointers);
+
+    return ret;
+}
+
+void restore_write_op_batch(mobject_store_write_op_t* write_ops,
+                            size_t                    count,
+                            void**                    saved_pointers)
+{
+    size_t i, num_buffers = 0;
+
+    if (saved_pointers == NULL) return;
+
+    for (i = 0; i < count; i++) {
+        /* write_ops prepared on their own keep their bulk handle, and
+         * a write_op that appears twice is restored once */
+        if (write_ops[i]->bulk_handle != HG_BULK_NULL || !write_ops[i]->ready)
+            continue;
+        num_buffers += restore_write_op_buffers(write_ops[i],
+                                                saved_pointers + num_buffers);
+        write_ops[i]->ready = 0;
+    }
+
+    free(saved_pointers);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                          STATIC FUNCTIONS BELOW                            //
+////////////////////////////////////////////////////////////////////////////////
+
+static size_t collect_write_op_buffers(mobject_store_write_op_t write_op,
+                                       uint64_t*                cur_offset,
+                                       void**                   pointers,
+                                       size_t*                  lengths)
+{
+    wr_action_base_t action;
+    size_t           i = 0;
 
     DL_FOREACH(write_op->actions, action)
     {
 
         switch (action->type) {
         case WRITE_OPCODE_WRITE:
-            convert_write(&current_offset, (wr_action_write_t)action,
-                          pointers + i, lengths + i);
+            convert_write(cur_offset, (wr_action_write_t)action, pointers + i,
+                          lengths + i);
             i += 1;
             break;
         case WRITE_OPCODE_WRITE_FULL:
-            convert_write_full(&current_offset, (wr_action_write_full_t)action,
+            convert_write_full(cur_offset, (wr_action_write_full_t)action,
                                pointers + i, lengths + i);
             i += 1;
             break;
         case WRITE_OPCODE_WRITE_SAME:
-            convert_write_same(&current_offset, (wr_action_write_same_t)action,
+            convert_write_same(cur_offset, (wr_action_write_same_t)action,
                                pointers + i, lengths + i);
             i += 1;
             break;
         case WRITE_OPCODE_APPEND:
-            convert_append(&current_offset, (wr_action_append_t)action,
+            convert_append(cur_offset, (wr_action_append_t)action,
                            pointers + i, lengths + i);
             i += 1;
             break;
@@ -74,22 +173,41 @@ void prepare_write_op(margo_instance_id mid, mobject_store_write_op_t write_op)
         }
     }
 
-    uint32_t count = i;
-    if (count != 0) {
-        hg_return_t ret
-            = margo_bulk_create(mid, count, pointers, lengths,
-                                HG_BULK_READ_ONLY, &(write_op->bulk_handle));
-        // TODO handle error
-        assert(ret == HG_SUCCESS);
+    return i;
+}
+
+static size_t restore_write_op_buffers(mobject_store_write_op_t write_op,
+                                       void**                   pointers)
+{
+    wr_action_base_t action;
+    size_t           i = 0;
+
+    DL_FOREACH(write_op->actions, action)
+    {
+        switch (action->type) {
+        case WRITE_OPCODE_WRITE:
+            ((wr_action_write_t)action)->buffer.as_pointer = pointers[i++];
+            break;
+        case WRITE_OPCODE_WRITE_FULL:
+            ((wr_action_write_full_t)action)->buffer.as_pointer
+                = pointers[i++];
+            break;
+        case WRITE_OPCODE_WRITE_SAME:
+            ((wr_action_write_same_t)action)->buffer.as_pointer
+                = pointers[i++];
+            break;
+        case WRITE_OPCODE_APPEND:
+            ((wr_action_append_t)action)->buffer.as_pointer = pointers[i++];
+            break;
+        default:
+            /* nothing to do for other op types */
+            break;
+        }
     }
 
-    write_op->ready = 1;
+    return i;
 }
 
-////////////////////////////////////////////////////////////////////////////////
-//                          STATIC FUNCTIONS BELOW                            //
-////////////////////////////////////////////////////////////////////////////////
-
 static void convert_write(uint64_t*         cur_offset,
                           wr_action_write_t action,
                           void**            ptr,
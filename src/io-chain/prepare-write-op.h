@@ -18,4 +18,32 @@
  */
 void prepare_write_op(margo_instance_id mid, mobject_store_write_op_t write_op);
 
+/**
+ * Prepares a batch of write_ops to be sent in a single RPC. The buffers
+ * of all the write_ops are stitched together into a single bulk handle,
+ * returned in bulk_handle (HG_BULK_NULL if there is no buffer), and
+ * offsets keep increasing from one write_op to the next. The write_ops
+ * themselves do not own a bulk handle: the caller must free bulk_handle
+ * once the RPC has completed, and give saved_pointers, which holds the
+ * pointers the offsets replaced, to restore_write_op_batch. write_ops that
+ * were already prepared keep their own bulk handle.
+ *
+ * Returns 0 on success, -1 if the bulk handle could not be created.
+ */
+int prepare_write_op_batch(margo_instance_id         mid,
+                           mobject_store_write_op_t* write_ops,
+                           size_t                    count,
+                           hg_bulk_t*                bulk_handle,
+                           void***                   saved_pointers);
+
+/**
+ * Restores the pointers of the write_ops prepared by prepare_write_op_batch
+ * and makes them not ready again, so that they can be modified, sent on
+ * their own or as part of another batch. Must be called once the RPC has
+ * completed. Frees saved_pointers.
+ */
+void restore_write_op_batch(mobject_store_write_op_t* write_ops,
+                            size_t                    count,
+                            void**                    saved_pointers);
+
 #endif
@@ -0,0 +1,142 @@
+/*
+ * (C) 2017 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <stdlib.h>
+#include <mercury_proc.h>
+#include <mercury_proc_string.h>
+#include "src/io-chain/proc-batch.h"
+#include "src/io-chain/proc-write-actions.h"
+#include "src/io-chain/proc-read-actions.h"
+#include "src/io-chain/proc-read-responses.h"
+
+/**
+ * The batch types are serialized as their count followed by the
+ * serialization of each entry, batches of ops being preceded by the wire
+ * format of their ops. Arrays are allocated when decoding and
+ * released (along with their content) when freeing.
+ */
+
+hg_return_t hg_proc_write_op_batch_t(hg_proc_t proc, write_op_batch_t* batch)
+{
+    hg_return_t ret = HG_SUCCESS;
+    uint32_t    i;
+
+    ret = hg_proc_uint8_t(proc, &(batch->wire_format));
+    if (ret != HG_SUCCESS) return ret;
+    ret = hg_proc_uint32_t(proc, &(batch->count));
+    if (ret != HG_SUCCESS) return ret;
+
+    if (hg_proc_get_op(proc) == HG_DECODE) {
+        batch->object_names = calloc(batch->count, sizeof(hg_const_string_t));
+        batch->write_ops
+            = calloc(batch->count, sizeof(mobject_store_write_op_t));
+    }
+
+    for (i = 0; i < batch->count; i++) {
+        ret = hg_proc_hg_const_string_t(proc, &(batch->object_names[i]));
+        if (ret != HG_SUCCESS) return ret;
+        ret = hg_proc_mobject_store_write_op_t(proc, &(batch->write_ops[i]),
+                                               batch->wire_format);
+        if (ret != HG_SUCCESS) return ret;
+    }
+
+    if (hg_proc_get_op(proc) == HG_FREE) {
+        free(batch->object_names);
+        free(batch->write_ops);
+    }
+
+    return ret;
+}
+
+hg_return_t hg_proc_read_op_batch_t(hg_proc_t proc, read_op_batch_t* batch)
+{
+    hg_return_t ret = HG_SUCCESS;
+    uint32_t    i;
+
+    ret = hg_proc_uint8_t(proc, &(batch->wire_format));
+    if (ret != HG_SUCCESS) return ret;
+    ret = hg_proc_uint32_t(proc, &(batch->count));
+    if (ret != HG_SUCCESS) return ret;
+
+    if (hg_proc_get_op(proc) == HG_DECODE) {
+        batch->object_names = calloc(batch->count, sizeof(hg_const_string_t));
+        batch->read_ops = calloc(batch->count, sizeof(mobject_store_read_op_t));
+    }
+
+    for (i = 0; i < batch->count; i++) {
+        ret = hg_proc_hg_const_string_t(proc, &(batch->object_names[i]));
+        if (ret != HG_SUCCESS) return ret;
+        ret = hg_proc_mobject_store_read_op_t(proc, &(batch->read_ops[i]),
+                                              batch->wire_format);
+        if (ret != HG_SUCCESS) return ret;
+    }
+
+    if (hg_proc_get_op(proc) == HG_FREE) {
+        free(batch->object_names);
+        free(batch->read_ops);
+    }
+
+    return ret;
+}
+
+hg_return_t hg_proc_write_result_batch_t(hg_proc_t             proc,
+                                         write_result_batch_t* batch)
+{
+    hg_return_t ret = HG_SUCCESS;
+    uint32_t    i;
+
+    ret = hg_proc_uint32_t(proc, &(batch->count));
+    if (ret != HG_SUCCESS) return ret;
+
+    if (hg_proc_get_op(proc) == HG_DECODE) {
+        batch->rets    = calloc(batch->count, sizeof(int32_t));
+        batch->results = calloc(batch->count, sizeof(write_results_t));
+    }
+
+    for (i = 0; i < batch->count; i++) {
+        if (hg_proc_get_op(proc) != HG_FREE) {
+            ret = hg_proc_int32_t(proc, &(batch->rets[i]));
+            if (ret != HG_SUCCESS) return ret;
+        }
+        ret = hg_proc_write_results_t(proc, &(batch->results[i]));
+        if (ret != HG_SUCCESS) return ret;
+    }
+
+    if (hg_proc_get_op(proc) == HG_FREE) {
+        free(batch->rets);
+        free(batch->results);
+    }
+
+    return ret;
+}
+
+hg_return_t hg_proc_read_result_batch_t(hg_proc_t            proc,
+                                        read_result_batch_t* batch)
+{
+    hg_return_t ret = HG_SUCCESS;
+    uint32_t    i;
+
+    ret = hg_proc_uint32_t(proc, &(batch->count));
+    if (ret != HG_SUCCESS) return ret;
+
+    if (hg_proc_get_op(proc) == HG_DECODE) {
+        batch->responses = calloc(batch->count, sizeof(read_response_t));
+        batch->versions  = calloc(batch->count, sizeof(uint64_t));
+    }
+
+    for (i = 0; i < batch->count; i++) {
+        ret = hg_proc_read_response_t(proc, &(batch->responses[i]));
+        if (ret != HG_SUCCESS) return ret;
+        ret = hg_proc_uint64_t(proc, &(batch->versions[i]));
+        if (ret != HG_SUCCESS) return ret;
+    }
+
+    if (hg_proc_get_op(proc) == HG_FREE) {
+        free(batch->responses);
+        free(batch->versions);
+    }
+
+    return ret;
+}
@@ -0,0 +1,66 @@
+/*
+ * (C) 2017 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __MOBJECT_PROC_BATCH_H
+#define __MOBJECT_PROC_BATCH_H
+
+#include <margo.h>
+#include "libmobject-store.h"
+#include "src/io-chain/read-resp-impl.h"
+#include "src/io-chain/write-results.h"
+
+/**
+ * A batch of write_ops, each targetting its own object. The buffers of
+ * all the write_ops are exposed through a single bulk handle that is
+ * sent alongside the batch (see prepare_write_op_batch).
+ */
+typedef struct write_op_batch {
+    uint8_t                   wire_format; // see wire-format.h
+    uint32_t                  count;
+    hg_const_string_t*        object_names;
+    mobject_store_write_op_t* write_ops;
+} write_op_batch_t;
+
+/**
+ * A batch of read_ops, each targetting its own object.
+ */
+typedef struct read_op_batch {
+    uint8_t                  wire_format; // see wire-format.h
+    uint32_t                 count;
+    hg_const_string_t*       object_names;
+    mobject_store_read_op_t* read_ops;
+} read_op_batch_t;
+
+/**
+ * Results of a batch of write_ops, one return value and the results of
+ * the actions of the write_op (see write-results.h) per object.
+ */
+typedef struct write_result_batch {
+    uint32_t         count;
+    int32_t*         rets;
+    write_results_t* results;
+} write_result_batch_t;
+
+/**
+ * Results of a batch of read_ops, one response chain and one object
+ * version per object.
+ */
+typedef struct read_result_batch {
+    uint32_t         count;
+    read_response_t* responses;
+    uint64_t*        versions;
+} read_result_batch_t;
+
+hg_return_t hg_proc_write_op_batch_t(hg_proc_t proc, write_op_batch_t* batch);
+
+hg_return_t hg_proc_read_op_batch_t(hg_proc_t proc, read_op_batch_t* batch);
+
+hg_return_t hg_proc_write_result_batch_t(hg_proc_t             proc,
+                                         write_result_batch_t* batch);
+
+hg_return_t hg_proc_read_result_batch_t(hg_proc_t            proc,
+                                        read_result_batch_t* batch);
+
+#endif
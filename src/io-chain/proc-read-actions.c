@@ -6,6 +6,7 @@
 #include "src/io-chain/proc-read-actions.h"
 #include "src/io-chain/args-read-actions.h"
 #include "src/io-chain/read-op-impl.h"
+#include "src/io-chain/wire-format.h"
 #include "src/util/utlist.h"
 #include "src/util/log.h"
 #include <stdlib.h>
@@ -17,42 +18,66 @@
  * by creating an args_rd_action_* object and passing it the required
  * parameters, then serializing the structure along with potential
  * additional data.
+ *
+ * Decoded actions are allocated from the read_op's arena, and the
+ * strings they embed are not copied: they point into the buffer that
+ * is being decoded, which remains valid until the input is freed.
  */
 
 typedef hg_return_t (*encode_fn)(hg_proc_t, uint64_t*, void*);
-typedef hg_return_t (*decode_fn)(hg_proc_t, uint64_t*, void*);
+typedef hg_return_t (*decode_fn)(hg_proc_t,
+                                  mobject_store_read_op_t,
+                                  uint64_t*,
+                                  void*);
+
+static hg_return_t
+decode_data_view(hg_proc_t proc, size_t size, const char** data);
+
+static hg_return_t proc_read_op_compact(hg_proc_t               proc,
+                                        mobject_store_read_op_t read_op);
 
 static hg_return_t
 encode_read_action_stat(hg_proc_t proc, uint64_t* pos, rd_action_stat_t action);
 
-static hg_return_t decode_read_action_stat(hg_proc_t         proc,
-                                           uint64_t*         pos,
-                                           rd_action_stat_t* action);
+static hg_return_t decode_read_action_stat(hg_proc_t               proc,
+                                           mobject_store_read_op_t read_op,
+                                           uint64_t*               pos,
+                                           rd_action_stat_t*       action);
 
 static hg_return_t
 encode_read_action_read(hg_proc_t proc, uint64_t* pos, rd_action_read_t action);
 
-static hg_return_t decode_read_action_read(hg_proc_t         proc,
-                                           uint64_t*         pos,
-                                           rd_action_read_t* action);
+static hg_return_t decode_read_action_read(hg_proc_t               proc,
+                                           mobject_store_read_op_t read_op,
+                                           uint64_t*               pos,
+                                           rd_action_read_t*       action);
 
 static hg_return_t encode_read_action_omap_get_keys(
     hg_proc_t proc, uint64_t* pos, rd_action_omap_get_keys_t action);
 
 static hg_return_t decode_read_action_omap_get_keys(
-    hg_proc_t proc, uint64_t* pos, rd_action_omap_get_keys_t* action);
+    hg_proc_t                  proc,
+    mobject_store_read_op_t    read_op,
+    uint64_t*                  pos,
+    rd_action_omap_get_keys_t* action);
 
 static hg_return_t encode_read_action_omap_get_vals(
     hg_proc_t proc, uint64_t* pos, rd_action_omap_get_vals_t action);
 
 static hg_return_t decode_read_action_omap_get_vals(
-    hg_proc_t proc, uint64_t* pos, rd_action_omap_get_vals_t* action);
+    hg_proc_t                  proc,
+    mobject_store_read_op_t    read_op,
+    uint64_t*                  pos,
+    rd_action_omap_get_vals_t* action);
 
 static hg_return_t encode_read_action_omap_get_vals_by_keys(
     hg_proc_t proc, uint64_t* pos, rd_action_omap_get_vals_by_keys_t action);
 
 static hg_return_t decode_read_action_omap_get_vals_by_keys(
-    hg_proc_t proc, uint64_t* pos, rd_action_omap_get_vals_by_keys_t* action);
+    hg_proc_t                          proc,
+    mobject_store_read_op_t            read_op,
+    uint64_t*                          pos,
+    rd_action_omap_get_vals_by_keys_t* action);
 
 /**
  * The following two arrays are here to avoid a big switch.
@@ -80,10 +105,12 @@ static decode_fn decode_read_action[_READ_OPCODE_END_ENUM_]
  * Serialization function for mobject_store_read_op_t objects.
  * For encoding, the object should be prepared first (that is, the union fields
  * pointing to either a buffer or an offset in a bulk should be an offset in a
- * bulk).
+ * bulk). format is the wire format negotiated with the peer, sent in the
+ * RPC input ahead of the read_op (see wire-format.h).
  */
 hg_return_t hg_proc_mobject_store_read_op_t(hg_proc_t                proc,
-                                            mobject_store_read_op_t* read_op)
+                                            mobject_store_read_op_t* read_op,
+                                            uint8_t                  format)
 {
     rd_action_base_t elem;
     hg_return_t      ret      = HG_SUCCESS;
@@ -95,6 +122,8 @@ hg_return_t hg_proc_mobject_store_read_op_t(hg_proc_t                proc,
 
         MOBJECT_ASSERT((*read_op)->ready,
                        "Cannot encode a read_op before it has been prepared");
+        if (format == MOBJECT_WIRE_FORMAT_COMPACT)
+            return proc_read_op_compact(proc, *read_op);
         // encode the bulk handle associated with the series of operations
         ret = hg_proc_hg_bulk_t(proc, &((*read_op)->bulk_handle));
         if (ret != HG_SUCCESS) return ret;
@@ -122,6 +151,12 @@ hg_return_t hg_proc_mobject_store_read_op_t(hg_proc_t                proc,
 
         *read_op          = create_read_op();
         (*read_op)->ready = 1;
+
+        (*read_op)->wire_format = format;
+        if (format == MOBJECT_WIRE_FORMAT_COMPACT)
+            return proc_read_op_compact(proc, *read_op);
+        if (format != MOBJECT_WIRE_FORMAT_LEGACY) return HG_PROTOCOL_ERROR;
+
         // decode the bulk handle
         ret = hg_proc_hg_bulk_t(proc, &((*read_op)->bulk_handle));
         if (ret != HG_SUCCESS) return ret;
@@ -140,7 +175,8 @@ hg_return_t hg_proc_mobject_store_read_op_t(hg_proc_t                proc,
             MOBJECT_ASSERT((opcode > 0 || opcode < _READ_OPCODE_END_ENUM_),
                            "Invalid write_op opcode");
             // decode the action's arguments
-            ret = decode_read_action[opcode](proc, &position, &next_action);
+            ret = decode_read_action[opcode](proc, *read_op, &position,
+                                             &next_action);
             if (ret != HG_SUCCESS) return ret;
             next_action->type = opcode;
             // append to the list
@@ -167,11 +203,13 @@ encode_read_action_stat(hg_proc_t proc, uint64_t* pos, rd_action_stat_t action)
     return HG_SUCCESS;
 }
 
-static hg_return_t
-decode_read_action_stat(hg_proc_t proc, uint64_t* pos, rd_action_stat_t* action)
+static hg_return_t decode_read_action_stat(hg_proc_t               proc,
+                                           mobject_store_read_op_t read_op,
+                                           uint64_t*               pos,
+                                           rd_action_stat_t*       action)
 {
     hg_return_t ret = HG_SUCCESS;
-    *action         = (rd_action_stat_t)calloc(1, sizeof(**action));
+    *action = (rd_action_stat_t)alloc_read_action(read_op, sizeof(**action));
     return ret;
 }
 
@@ -186,15 +224,17 @@ encode_read_action_read(hg_proc_t proc, uint64_t* pos, rd_action_read_t action)
     return hg_proc_memcpy(proc, &a, sizeof(a));
 }
 
-static hg_return_t
-decode_read_action_read(hg_proc_t proc, uint64_t* pos, rd_action_read_t* action)
+static hg_return_t decode_read_action_read(hg_proc_t               proc,
+                                           mobject_store_read_op_t read_op,
+                                           uint64_t*               pos,
+                                           rd_action_read_t*       action)
 {
     hg_return_t         ret = HG_SUCCESS;
     args_rd_action_read a;
     ret = hg_proc_memcpy(proc, &a, sizeof(a));
     if (ret != HG_SUCCESS) return ret;
 
-    *action                     = (rd_action_read_t)calloc(1, sizeof(**action));
+    *action = (rd_action_read_t)alloc_read_action(read_op, sizeof(**action));
     (*action)->offset           = a.offset;
     (*action)->len              = a.len;
     (*action)->buffer.as_offset = a.bulk_offset;
@@ -214,25 +254,28 @@ static hg_return_t encode_read_action_omap_get_keys(
     ret = hg_proc_memcpy(proc, &a, sizeof(a));
     if (ret != HG_SUCCESS) return ret;
 
-    ret = hg_proc_memcpy(proc, action->data, action->data_size);
+    ret = hg_proc_memcpy(proc, (void*)action->data, action->data_size);
     return ret;
 }
 
 static hg_return_t decode_read_action_omap_get_keys(
-    hg_proc_t proc, uint64_t* pos, rd_action_omap_get_keys_t* action)
+    hg_proc_t                  proc,
+    mobject_store_read_op_t    read_op,
+    uint64_t*                  pos,
+    rd_action_omap_get_keys_t* action)
 {
     hg_return_t                  ret = HG_SUCCESS;
     args_rd_action_omap_get_keys a;
     ret = hg_proc_memcpy(proc, &a, sizeof(a));
     if (ret != HG_SUCCESS) return ret;
 
-    *action = (rd_action_omap_get_keys_t)calloc(1, sizeof(**action) - 1
-                                                       + a.data_size);
-    (*action)->max_return  = a.max_return;
-    (*action)->data_size   = a.data_size;
-    (*action)->start_after = (*action)->data;
+    *action = (rd_action_omap_get_keys_t)alloc_read_action(read_op,
+                                                           sizeof(**action));
+    (*action)->max_return = a.max_return;
+    (*action)->data_size  = a.data_size;
 
-    ret = hg_proc_memcpy(proc, (*action)->data, (*action)->data_size);
+    ret = decode_data_view(proc, a.data_size, &(*action)->data);
+    (*action)->start_after = (*action)->data;
     return ret;
 }
 
@@ -247,27 +290,31 @@ static hg_return_t encode_read_action_omap_get_vals(
     ret = hg_proc_memcpy(proc, &a, sizeof(a));
     if (ret != HG_SUCCESS) return ret;
 
-    ret = hg_proc_memcpy(proc, action->data, action->data_size);
+    ret = hg_proc_memcpy(proc, (void*)action->data, action->data_size);
 
     return ret;
 }
 
 static hg_return_t decode_read_action_omap_get_vals(
-    hg_proc_t proc, uint64_t* pos, rd_action_omap_get_vals_t* action)
+    hg_proc_t                  proc,
+    mobject_store_read_op_t    read_op,
+    uint64_t*                  pos,
+    rd_action_omap_get_vals_t* action)
 {
     hg_return_t                  ret = HG_SUCCESS;
     args_rd_action_omap_get_vals a;
     ret = hg_proc_memcpy(proc, &a, sizeof(a));
     if (ret != HG_SUCCESS) return ret;
 
-    *action = (rd_action_omap_get_vals_t)calloc(1, sizeof(**action) - 1
-                                                       + a.data_size);
-    (*action)->max_return  = a.max_return;
-    (*action)->data_size   = a.data_size;
-    (*action)->start_after = (*action)->data;
+    *action = (rd_action_omap_get_vals_t)alloc_read_action(read_op,
+                                                           sizeof(**action));
+    (*action)->max_return = a.max_return;
+    (*action)->data_size  = a.data_size;
 
-    ret      = hg_proc_memcpy(proc, (*action)->data, (*action)->data_size);
-    size_t s = strlen((*action)->start_after);
+    ret = decode_data_view(proc, a.data_size, &(*action)->data);
+    if (ret != HG_SUCCESS) return ret;
+    (*action)->start_after   = (*action)->data;
+    size_t s                 = strlen((*action)->start_after);
     (*action)->filter_prefix = (*action)->data + s + 1;
 
     return ret;
@@ -284,25 +331,174 @@ static hg_return_t encode_read_action_omap_get_vals_by_keys(
     ret = hg_proc_memcpy(proc, &a, sizeof(a));
     if (ret != HG_SUCCESS) return ret;
 
-    ret = hg_proc_memcpy(proc, action->data, action->data_size);
+    ret = hg_proc_memcpy(proc, (void*)action->data, action->data_size);
 
     return ret;
 }
 
 static hg_return_t decode_read_action_omap_get_vals_by_keys(
-    hg_proc_t proc, uint64_t* pos, rd_action_omap_get_vals_by_keys_t* action)
+    hg_proc_t                          proc,
+    mobject_store_read_op_t            read_op,
+    uint64_t*                          pos,
+    rd_action_omap_get_vals_by_keys_t* action)
 {
     hg_return_t                          ret = HG_SUCCESS;
     args_rd_action_omap_get_vals_by_keys a;
     ret = hg_proc_memcpy(proc, &a, sizeof(a));
     if (ret != HG_SUCCESS) return ret;
 
-    *action = (rd_action_omap_get_vals_by_keys_t)calloc(1, sizeof(**action) - 1
-                                                               + a.data_size);
+    *action = (rd_action_omap_get_vals_by_keys_t)alloc_read_action(
+        read_op, sizeof(**action));
     (*action)->num_keys  = a.num_keys;
     (*action)->data_size = a.data_size;
 
-    ret = hg_proc_memcpy(proc, (*action)->data, (*action)->data_size);
+    ret = decode_data_view(proc, a.data_size, &(*action)->data);
 
     return ret;
 }
+
+static hg_return_t
+decode_data_view(hg_proc_t proc, size_t size, const char** data)
+{
+    void* ptr = hg_proc_save_ptr(proc, size);
+    if (ptr == NULL) return HG_OVERFLOW;
+    *data = (const char*)ptr;
+    return hg_proc_restore_ptr(proc, ptr, size);
+}
+
+/* sizes of the actions, to allocate them when decoding */
+static const size_t read_action_size[_READ_OPCODE_END_ENUM_]
+    = {0,
+       sizeof(struct rd_action_STAT),
+       sizeof(struct rd_action_READ),
+       sizeof(struct rd_action_OMAP_GET_KEYS),
+       sizeof(struct rd_action_OMAP_GET_VALS),
+       sizeof(struct rd_action_OMAP_GET_VALS_BY_KEYS)};
+
+static hg_return_t
+proc_data(hg_proc_t proc, size_t size, const char** data)
+{
+    if (hg_proc_get_op(proc) == HG_DECODE)
+        return decode_data_view(proc, size, data);
+    return hg_proc_memcpy(proc, (void*)*data, size);
+}
+
+/* Encodes or decodes the region receiving the results of an omap action
+ * (see omap_results_t), its position being encoded as that of the data
+ * of a READ action */
+static hg_return_t
+proc_omap_results(hg_proc_t proc, uint64_t* pos, omap_results_t* results)
+{
+    hg_return_t ret;
+    int64_t     delta;
+
+    ret = proc_varsize(proc, &results->size);
+    if (ret != HG_SUCCESS || results->size == 0) return ret;
+    delta = (int64_t)(results->offset - *pos);
+    ret   = proc_svarint(proc, &delta);
+    if (ret != HG_SUCCESS) return ret;
+    results->offset = *pos + (uint64_t)delta;
+    *pos            = results->offset + results->size;
+    return hg_proc_uint8_t(proc, &results->pageable);
+}
+
+/* Encodes or decodes the fields of an action in the compact format
+ * (see proc_write_action_compact in proc-write-actions.c). pos is the
+ * position following the data of the previous action in the bulk. */
+static hg_return_t
+proc_read_action_compact(hg_proc_t proc, uint64_t* pos, rd_action_base_t action)
+{
+    hg_return_t ret = HG_SUCCESS;
+    int64_t     delta;
+
+#define PROC(x)                            \
+    do {                                   \
+        ret = (x);                         \
+        if (ret != HG_SUCCESS) return ret; \
+    } while (0)
+
+    switch (action->type) {
+    case READ_OPCODE_STAT:
+        break;
+    case READ_OPCODE_READ: {
+        rd_action_read_t a = (rd_action_read_t)action;
+        PROC(proc_varsize(proc, &a->len));
+        delta = (int64_t)(a->buffer.as_offset - *pos);
+        PROC(proc_svarint(proc, &delta));
+        a->buffer.as_offset = *pos + (uint64_t)delta;
+        *pos                = a->buffer.as_offset + a->len;
+        PROC(proc_varint(proc, &a->offset));
+    } break;
+    case READ_OPCODE_OMAP_GET_KEYS: {
+        rd_action_omap_get_keys_t a = (rd_action_omap_get_keys_t)action;
+        PROC(proc_varint(proc, &a->max_return));
+        PROC(proc_varsize(proc, &a->data_size));
+        PROC(proc_data(proc, a->data_size, &a->data));
+        if (hg_proc_get_op(proc) == HG_DECODE) a->start_after = a->data;
+        PROC(proc_omap_results(proc, pos, &a->results));
+    } break;
+    case READ_OPCODE_OMAP_GET_VALS: {
+        rd_action_omap_get_vals_t a = (rd_action_omap_get_vals_t)action;
+        PROC(proc_varint(proc, &a->max_return));
+        PROC(proc_varsize(proc, &a->data_size));
+        PROC(proc_data(proc, a->data_size, &a->data));
+        if (hg_proc_get_op(proc) == HG_DECODE) {
+            a->start_after   = a->data;
+            a->filter_prefix = a->data + strlen(a->start_after) + 1;
+        }
+        PROC(proc_omap_results(proc, pos, &a->results));
+    } break;
+    case READ_OPCODE_OMAP_GET_VALS_BY_KEYS: {
+        rd_action_omap_get_vals_by_keys_t a
+            = (rd_action_omap_get_vals_by_keys_t)action;
+        PROC(proc_varsize(proc, &a->num_keys));
+        PROC(proc_varsize(proc, &a->data_size));
+        PROC(proc_data(proc, a->data_size, &a->data));
+        PROC(proc_omap_results(proc, pos, &a->results));
+    } break;
+    default:
+        return HG_PROTOCOL_ERROR;
+    }
+
+#undef PROC
+
+    return ret;
+}
+
+static hg_return_t proc_read_op_compact(hg_proc_t               proc,
+                                        mobject_store_read_op_t read_op)
+{
+    uint64_t         pos         = 0;
+    rd_action_base_t action      = read_op->actions;
+    uint64_t         num_actions = read_op->num_actions;
+    hg_return_t      ret;
+    uint64_t         i;
+
+    ret = hg_proc_hg_bulk_t(proc, &read_op->bulk_handle);
+    if (ret != HG_SUCCESS) return ret;
+    ret = proc_varint(proc, &num_actions);
+    if (ret != HG_SUCCESS) return ret;
+
+    for (i = 0; i < num_actions; i++) {
+        uint8_t opcode = action ? (uint8_t)action->type : 0;
+        ret            = hg_proc_uint8_t(proc, &opcode);
+        if (ret != HG_SUCCESS) return ret;
+
+        if (hg_proc_get_op(proc) == HG_DECODE) {
+            if (opcode == 0 || opcode >= _READ_OPCODE_END_ENUM_)
+                return HG_PROTOCOL_ERROR;
+            action = (rd_action_base_t)alloc_read_action(
+                read_op, read_action_size[opcode]);
+            action->type = (read_op_code_t)opcode;
+            DL_APPEND(read_op->actions, action);
+            read_op->num_actions += 1;
+        }
+
+        ret = proc_read_action_compact(proc, &pos, action);
+        if (ret != HG_SUCCESS) return ret;
+
+        action = action->next;
+    }
+
+    return HG_SUCCESS;
+}
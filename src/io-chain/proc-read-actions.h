@@ -11,9 +11,11 @@
 
 /**
  * This function is the traditional hg_proc_* function meant to serialize
- * a mobject_store_read_op_t object to send it through RPC.
+ * a mobject_store_read_op_t object to send it through RPC, in the given
+ * wire format (see wire-format.h).
  */
 hg_return_t hg_proc_mobject_store_read_op_t(hg_proc_t                proc,
-                                            mobject_store_read_op_t* read_op);
+                                            mobject_store_read_op_t* read_op,
+                                            uint8_t                  format);
 
 #endif
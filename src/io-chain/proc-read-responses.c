@@ -139,9 +139,16 @@ hg_return_t decode_read_response(hg_proc_t proc, rd_response_read_t* r)
 hg_return_t encode_omap_response(hg_proc_t proc, rd_response_omap_t r)
 {
     hg_return_t ret;
-    ret = hg_proc_memcpy(proc, &(r->prval), sizeof(r->prval));
+    uint8_t     more = r->iter ? r->iter->more : 0;
+    ret              = hg_proc_memcpy(proc, &(r->prval), sizeof(r->prval));
     if (ret != HG_SUCCESS) return ret;
     ret = hg_proc_mobject_store_omap_iter_t(proc, &(r->iter));
+    if (ret != HG_SUCCESS) return ret;
+    ret = hg_proc_uint8_t(proc, &more);
+    if (ret != HG_SUCCESS) return ret;
+    ret = hg_proc_hg_size_t(proc, &(r->bulk_items));
+    if (ret != HG_SUCCESS) return ret;
+    ret = hg_proc_hg_size_t(proc, &(r->bulk_size));
     return ret;
 }
 
@@ -153,5 +160,11 @@ hg_return_t decode_omap_response(hg_proc_t proc, rd_response_omap_t* r)
     ret             = hg_proc_memcpy(proc, &((*r)->prval), sizeof((*r)->prval));
     if (ret != HG_SUCCESS) return ret;
     ret = hg_proc_mobject_store_omap_iter_t(proc, &((*r)->iter));
+    if (ret != HG_SUCCESS) return ret;
+    ret = hg_proc_uint8_t(proc, &((*r)->iter->more));
+    if (ret != HG_SUCCESS) return ret;
+    ret = hg_proc_hg_size_t(proc, &((*r)->bulk_items));
+    if (ret != HG_SUCCESS) return ret;
+    ret = hg_proc_hg_size_t(proc, &((*r)->bulk_size));
     return ret;
 }
@@ -6,9 +6,11 @@
 #include "src/io-chain/proc-write-actions.h"
 #include "src/io-chain/args-write-actions.h"
 #include "src/io-chain/write-op-impl.h"
+#include "src/io-chain/wire-format.h"
 #include "src/util/utlist.h"
 #include "src/util/log.h"
 #include <stdlib.h>
+#include <string.h>
 
 /**
  * This file contains the main hg_proc_mobject_store_write_op_t
@@ -17,84 +19,162 @@
  * by creating an args_wr_action_* object and passing it the required
  * parameters, then serializing the structure along with potential
  * additional data.
+ *
+ * Decoded actions are allocated from the write_op's arena, and the keys
+ * and values of omap actions are not copied: they point into the buffer
+ * that is being decoded, which remains valid until the input is freed.
  */
 
 typedef hg_return_t (*encode_fn)(hg_proc_t, uint64_t*, void*);
-typedef hg_return_t (*decode_fn)(hg_proc_t, uint64_t*, void*);
+typedef hg_return_t (*decode_fn)(hg_proc_t,
+                                  mobject_store_write_op_t,
+                                  uint64_t*,
+                                  void*);
+
+static hg_return_t
+decode_data_view(hg_proc_t proc, size_t size, const char** data);
+
+static int is_range_data(const char* data, size_t size);
+
+static size_t key_data_size(const char* data, size_t size);
+
+static int is_cmpxchg_data(wr_action_omap_cmpxchg_t a);
+
+static int is_omap_set_data(const char* data, size_t size, size_t num);
+
+static int is_keys_data(const char* data, size_t size, size_t num);
+
+static hg_return_t proc_write_op_compact(hg_proc_t                proc,
+                                         mobject_store_write_op_t write_op);
 
 static hg_return_t encode_write_action_create(hg_proc_t          proc,
                                               uint64_t*          pos,
                                               wr_action_create_t action);
 
-static hg_return_t decode_write_action_create(hg_proc_t           proc,
-                                              uint64_t*           pos,
-                                              wr_action_create_t* action);
+static hg_return_t decode_write_action_create(hg_proc_t                proc,
+                                              mobject_store_write_op_t write_op,
+                                              uint64_t*                pos,
+                                              wr_action_create_t*      action);
 
 static hg_return_t encode_write_action_write(hg_proc_t         proc,
                                              uint64_t*         pos,
                                              wr_action_write_t action);
 
-static hg_return_t decode_write_action_write(hg_proc_t          proc,
-                                             uint64_t*          pos,
-                                             wr_action_write_t* action);
+static hg_return_t decode_write_action_write(hg_proc_t                proc,
+                                             mobject_store_write_op_t write_op,
+                                             uint64_t*                pos,
+                                             wr_action_write_t*       action);
 
 static hg_return_t encode_write_action_write_full(
     hg_proc_t proc, uint64_t* pos, wr_action_write_full_t action);
 
 static hg_return_t decode_write_action_write_full(
-    hg_proc_t proc, uint64_t* pos, wr_action_write_full_t* action);
+    hg_proc_t                proc,
+    mobject_store_write_op_t write_op,
+    uint64_t*                pos,
+    wr_action_write_full_t*  action);
 
 static hg_return_t encode_write_action_write_same(
     hg_proc_t proc, uint64_t* pos, wr_action_write_same_t action);
 
 static hg_return_t decode_write_action_write_same(
-    hg_proc_t proc, uint64_t* pos, wr_action_write_same_t* action);
+    hg_proc_t                proc,
+    mobject_store_write_op_t write_op,
+    uint64_t*                pos,
+    wr_action_write_same_t*  action);
 
 static hg_return_t encode_write_action_append(hg_proc_t          proc,
                                               uint64_t*          pos,
                                               wr_action_append_t action);
 
-static hg_return_t decode_write_action_append(hg_proc_t           proc,
-                                              uint64_t*           pos,
-                                              wr_action_append_t* action);
+static hg_return_t decode_write_action_append(hg_proc_t                proc,
+                                              mobject_store_write_op_t write_op,
+                                              uint64_t*                pos,
+                                              wr_action_append_t*      action);
 
 static hg_return_t encode_write_action_remove(hg_proc_t          proc,
                                               uint64_t*          pos,
                                               wr_action_remove_t action);
 
-static hg_return_t decode_write_action_remove(hg_proc_t           proc,
-                                              uint64_t*           pos,
-                                              wr_action_remove_t* action);
+static hg_return_t decode_write_action_remove(hg_proc_t                proc,
+                                              mobject_store_write_op_t write_op,
+                                              uint64_t*                pos,
+                                              wr_action_remove_t*      action);
 
 static hg_return_t encode_write_action_truncate(hg_proc_t            proc,
                                                 uint64_t*            pos,
                                                 wr_action_truncate_t action);
 
-static hg_return_t decode_write_action_truncate(hg_proc_t             proc,
-                                                uint64_t*             pos,
-                                                wr_action_truncate_t* action);
+static hg_return_t decode_write_action_truncate(
+    hg_proc_t                proc,
+    mobject_store_write_op_t write_op,
+    uint64_t*                pos,
+    wr_action_truncate_t*    action);
 
 static hg_return_t encode_write_action_zero(hg_proc_t        proc,
                                             uint64_t*        pos,
                                             wr_action_zero_t action);
 
-static hg_return_t decode_write_action_zero(hg_proc_t         proc,
-                                            uint64_t*         pos,
-                                            wr_action_zero_t* action);
+static hg_return_t decode_write_action_zero(hg_proc_t                proc,
+                                            mobject_store_write_op_t write_op,
+                                            uint64_t*                pos,
+                                            wr_action_zero_t*        action);
 
 static hg_return_t encode_write_action_omap_set(hg_proc_t            proc,
                                                 uint64_t*            pos,
                                                 wr_action_omap_set_t action);
 
-static hg_return_t decode_write_action_omap_set(hg_proc_t             proc,
-                                                uint64_t*             pos,
-                                                wr_action_omap_set_t* action);
+static hg_return_t decode_write_action_omap_set(
+    hg_proc_t                proc,
+    mobject_store_write_op_t write_op,
+    uint64_t*                pos,
+    wr_action_omap_set_t*    action);
 
 static hg_return_t encode_write_action_omap_rm_keys(
     hg_proc_t proc, uint64_t* pos, wr_action_omap_rm_keys_t action);
 
 static hg_return_t decode_write_action_omap_rm_keys(
-    hg_proc_t proc, uint64_t* pos, wr_action_omap_rm_keys_t* action);
+    hg_proc_t                 proc,
+    mobject_store_write_op_t  write_op,
+    uint64_t*                 pos,
+    wr_action_omap_rm_keys_t* action);
+
+static hg_return_t encode_write_action_omap_rm_range(
+    hg_proc_t proc, uint64_t* pos, wr_action_omap_rm_range_t action);
+
+static hg_return_t decode_write_action_omap_rm_range(
+    hg_proc_t                  proc,
+    mobject_store_write_op_t   write_op,
+    uint64_t*                  pos,
+    wr_action_omap_rm_range_t* action);
+
+static hg_return_t encode_write_action_omap_clear(
+    hg_proc_t proc, uint64_t* pos, wr_action_omap_clear_t action);
+
+static hg_return_t decode_write_action_omap_clear(
+    hg_proc_t                proc,
+    mobject_store_write_op_t write_op,
+    uint64_t*                pos,
+    wr_action_omap_clear_t*  action);
+
+static hg_return_t encode_write_action_omap_add(hg_proc_t            proc,
+                                                uint64_t*            pos,
+                                                wr_action_omap_add_t action);
+
+static hg_return_t decode_write_action_omap_add(
+    hg_proc_t                proc,
+    mobject_store_write_op_t write_op,
+    uint64_t*                pos,
+    wr_action_omap_add_t*    action);
+
+static hg_return_t encode_write_action_omap_cmpxchg(
+    hg_proc_t proc, uint64_t* pos, wr_action_omap_cmpxchg_t action);
+
+static hg_return_t decode_write_action_omap_cmpxchg(
+    hg_proc_t                 proc,
+    mobject_store_write_op_t  write_op,
+    uint64_t*                 pos,
+    wr_action_omap_cmpxchg_t* action);
 
 /**
  * The following two arrays are here to avoid a big switch.
@@ -112,7 +192,11 @@ static encode_fn encode_write_action[_WRITE_OPCODE_END_ENUM_]
        (encode_fn)encode_write_action_truncate,
        (encode_fn)encode_write_action_zero,
        (encode_fn)encode_write_action_omap_set,
-       (encode_fn)encode_write_action_omap_rm_keys};
+       (encode_fn)encode_write_action_omap_rm_keys,
+       (encode_fn)encode_write_action_omap_rm_range,
+       (encode_fn)encode_write_action_omap_clear,
+       (encode_fn)encode_write_action_omap_add,
+       (encode_fn)encode_write_action_omap_cmpxchg};
 
 /* decoding functions */
 static decode_fn decode_write_action[_WRITE_OPCODE_END_ENUM_]
@@ -126,16 +210,22 @@ static decode_fn decode_write_action[_WRITE_OPCODE_END_ENUM_]
        (decode_fn)decode_write_action_truncate,
        (decode_fn)decode_write_action_zero,
        (decode_fn)decode_write_action_omap_set,
-       (decode_fn)decode_write_action_omap_rm_keys};
+       (decode_fn)decode_write_action_omap_rm_keys,
+       (decode_fn)decode_write_action_omap_rm_range,
+       (decode_fn)decode_write_action_omap_clear,
+       (decode_fn)decode_write_action_omap_add,
+       (decode_fn)decode_write_action_omap_cmpxchg};
 
 /**
  * Serialization function for mobject_store_write_op_t objects.
  * For encoding, the object should be prepared first (that is, the union fields
  * pointing to either a buffer or an offset in a bulk should be an offset in a
- * bulk).
+ * bulk). format is the wire format negotiated with the peer, sent in the
+ * RPC input ahead of the write_op (see wire-format.h).
  */
 hg_return_t hg_proc_mobject_store_write_op_t(hg_proc_t                 proc,
-                                             mobject_store_write_op_t* write_op)
+                                             mobject_store_write_op_t* write_op,
+                                             uint8_t                   format)
 {
     wr_action_base_t elem;
     hg_return_t      ret      = HG_SUCCESS;
@@ -147,6 +237,8 @@ hg_return_t hg_proc_mobject_store_write_op_t(hg_proc_t                 proc,
 
         MOBJECT_ASSERT((*write_op)->ready,
                        "Cannot encode a write_op before it has been prepared");
+        if (format == MOBJECT_WIRE_FORMAT_COMPACT)
+            return proc_write_op_compact(proc, *write_op);
         // encode the bulk handle associated with the series of operations
         ret = hg_proc_hg_bulk_t(proc, &((*write_op)->bulk_handle));
         if (ret != HG_SUCCESS) return ret;
@@ -175,6 +267,11 @@ hg_return_t hg_proc_mobject_store_write_op_t(hg_proc_t                 proc,
         *write_op          = create_write_op();
         (*write_op)->ready = 1;
 
+        (*write_op)->wire_format = format;
+        if (format == MOBJECT_WIRE_FORMAT_COMPACT)
+            return proc_write_op_compact(proc, *write_op);
+        if (format != MOBJECT_WIRE_FORMAT_LEGACY) return HG_PROTOCOL_ERROR;
+
         // decode the bulk handle
         ret = hg_proc_hg_bulk_t(proc, &((*write_op)->bulk_handle));
         if (ret != HG_SUCCESS) return ret;
@@ -193,7 +290,8 @@ hg_return_t hg_proc_mobject_store_write_op_t(hg_proc_t                 proc,
             MOBJECT_ASSERT((opcode > 0 && opcode < _WRITE_OPCODE_END_ENUM_),
                            "Invalid write_op opcode");
             // decode the action's arguments
-            ret = decode_write_action[opcode](proc, &position, &next_action);
+            ret = decode_write_action[opcode](proc, *write_op, &position,
+                                              &next_action);
             if (ret != HG_SUCCESS) return ret;
             next_action->type = opcode;
             // append to the list
@@ -222,16 +320,18 @@ static hg_return_t encode_write_action_create(hg_proc_t          proc,
     return hg_proc_memcpy(proc, &a, sizeof(a));
 }
 
-static hg_return_t decode_write_action_create(hg_proc_t           proc,
-                                              uint64_t*           pos,
-                                              wr_action_create_t* action)
+static hg_return_t decode_write_action_create(hg_proc_t                proc,
+                                              mobject_store_write_op_t write_op,
+                                              uint64_t*                pos,
+                                              wr_action_create_t*      action)
 {
     hg_return_t           ret = HG_SUCCESS;
     args_wr_action_create a;
     ret = hg_proc_memcpy(proc, &a, sizeof(a));
     if (ret != HG_SUCCESS) return ret;
 
-    *action              = (wr_action_create_t)calloc(1, sizeof(**action));
+    *action = (wr_action_create_t)alloc_write_action(write_op,
+                                                     sizeof(**action));
     (*action)->exclusive = a.exclusive;
 
     return ret;
@@ -242,24 +342,25 @@ static hg_return_t encode_write_action_write(hg_proc_t         proc,
                                              wr_action_write_t action)
 {
     args_wr_action_write a;
-    a.buffer_position = *pos;
+    a.buffer_position = action->buffer.as_offset;
     a.len             = action->len;
     a.offset          = action->offset;
     *pos += action->len;
     return hg_proc_memcpy(proc, &a, sizeof(a));
 }
 
-static hg_return_t decode_write_action_write(hg_proc_t          proc,
-                                             uint64_t*          pos,
-                                             wr_action_write_t* action)
+static hg_return_t decode_write_action_write(hg_proc_t                proc,
+                                             mobject_store_write_op_t write_op,
+                                             uint64_t*                pos,
+                                             wr_action_write_t*       action)
 {
     hg_return_t          ret = HG_SUCCESS;
     args_wr_action_write a;
     ret = hg_proc_memcpy(proc, &a, sizeof(a));
     if (ret != HG_SUCCESS) return ret;
 
-    *action = (wr_action_write_t)calloc(1, sizeof(**action));
-    (*action)->buffer.as_offset = *pos;
+    *action = (wr_action_write_t)alloc_write_action(write_op, sizeof(**action));
+    (*action)->buffer.as_offset = a.buffer_position;
     (*action)->len              = a.len;
     (*action)->offset           = a.offset;
     *pos += a.len;
@@ -272,22 +373,26 @@ static hg_return_t encode_write_action_write_full(hg_proc_t              proc,
                                                   wr_action_write_full_t action)
 {
     args_wr_action_write_full a;
-    a.buffer_position = *pos;
+    a.buffer_position = action->buffer.as_offset;
     a.len             = action->len;
     *pos += action->len;
     return hg_proc_memcpy(proc, &a, sizeof(a));
 }
 
 static hg_return_t decode_write_action_write_full(
-    hg_proc_t proc, uint64_t* pos, wr_action_write_full_t* action)
+    hg_proc_t                proc,
+    mobject_store_write_op_t write_op,
+    uint64_t*                pos,
+    wr_action_write_full_t*  action)
 {
     hg_return_t               ret = HG_SUCCESS;
     args_wr_action_write_full a;
     ret = hg_proc_memcpy(proc, &a, sizeof(a));
     if (ret != HG_SUCCESS) return ret;
 
-    *action = (wr_action_write_full_t)calloc(1, sizeof(**action));
-    (*action)->buffer.as_offset = *pos;
+    *action = (wr_action_write_full_t)alloc_write_action(write_op,
+                                                         sizeof(**action));
+    (*action)->buffer.as_offset = a.buffer_position;
     (*action)->len              = a.len;
     *pos += a.len;
 
@@ -299,7 +404,7 @@ static hg_return_t encode_write_action_write_same(hg_proc_t              proc,
                                                   wr_action_write_same_t action)
 {
     args_wr_action_write_same a;
-    a.buffer_position = *pos;
+    a.buffer_position = action->buffer.as_offset;
     a.data_len        = action->data_len;
     a.write_len       = action->write_len;
     a.offset          = action->offset;
@@ -308,15 +413,19 @@ static hg_return_t encode_write_action_write_same(hg_proc_t              proc,
 }
 
 static hg_return_t decode_write_action_write_same(
-    hg_proc_t proc, uint64_t* pos, wr_action_write_same_t* action)
+    hg_proc_t                proc,
+    mobject_store_write_op_t write_op,
+    uint64_t*                pos,
+    wr_action_write_same_t*  action)
 {
     hg_return_t               ret = HG_SUCCESS;
     args_wr_action_write_same a;
     ret = hg_proc_memcpy(proc, &a, sizeof(a));
     if (ret != HG_SUCCESS) return ret;
 
-    *action = (wr_action_write_same_t)calloc(1, sizeof(**action));
-    (*action)->buffer.as_offset = *pos;
+    *action = (wr_action_write_same_t)alloc_write_action(write_op,
+                                                         sizeof(**action));
+    (*action)->buffer.as_offset = a.buffer_position;
     (*action)->data_len         = a.data_len;
     (*action)->write_len        = a.write_len;
     (*action)->offset           = a.offset;
@@ -330,23 +439,25 @@ static hg_return_t encode_write_action_append(hg_proc_t          proc,
                                               wr_action_append_t action)
 {
     args_wr_action_append a;
-    a.buffer_position = *pos;
+    a.buffer_position = action->buffer.as_offset;
     a.len             = action->len;
     *pos += action->len;
     return hg_proc_memcpy(proc, &a, sizeof(a));
 }
 
-static hg_return_t decode_write_action_append(hg_proc_t           proc,
-                                              uint64_t*           pos,
-                                              wr_action_append_t* action)
+static hg_return_t decode_write_action_append(hg_proc_t                proc,
+                                              mobject_store_write_op_t write_op,
+                                              uint64_t*                pos,
+                                              wr_action_append_t*      action)
 {
     hg_return_t           ret = HG_SUCCESS;
     args_wr_action_append a;
     ret = hg_proc_memcpy(proc, &a, sizeof(a));
     if (ret != HG_SUCCESS) return ret;
 
-    *action = (wr_action_append_t)calloc(1, sizeof(**action));
-    (*action)->buffer.as_offset = *pos;
+    *action = (wr_action_append_t)alloc_write_action(write_op,
+                                                     sizeof(**action));
+    (*action)->buffer.as_offset = a.buffer_position;
     (*action)->len              = a.len;
     *pos += a.len;
 
@@ -360,12 +471,14 @@ static hg_return_t encode_write_action_remove(hg_proc_t          proc,
     return HG_SUCCESS;
 }
 
-static hg_return_t decode_write_action_remove(hg_proc_t           proc,
-                                              uint64_t*           pos,
-                                              wr_action_remove_t* action)
+static hg_return_t decode_write_action_remove(hg_proc_t                proc,
+                                              mobject_store_write_op_t write_op,
+                                              uint64_t*                pos,
+                                              wr_action_remove_t*      action)
 {
     hg_return_t ret = HG_SUCCESS;
-    *action         = (wr_action_remove_t)calloc(1, sizeof(**action));
+    *action = (wr_action_remove_t)alloc_write_action(write_op,
+                                                     sizeof(**action));
 
     return ret;
 }
@@ -379,16 +492,19 @@ static hg_return_t encode_write_action_truncate(hg_proc_t            proc,
     return hg_proc_memcpy(proc, &a, sizeof(a));
 }
 
-static hg_return_t decode_write_action_truncate(hg_proc_t             proc,
-                                                uint64_t*             pos,
-                                                wr_action_truncate_t* action)
+static hg_return_t decode_write_action_truncate(
+    hg_proc_t                proc,
+    mobject_store_write_op_t write_op,
+    uint64_t*                pos,
+    wr_action_truncate_t*    action)
 {
     hg_return_t             ret = HG_SUCCESS;
     args_wr_action_truncate a;
     ret = hg_proc_memcpy(proc, &a, sizeof(a));
     if (ret != HG_SUCCESS) return ret;
 
-    *action           = (wr_action_truncate_t)calloc(1, sizeof(**action));
+    *action = (wr_action_truncate_t)alloc_write_action(write_op,
+                                                       sizeof(**action));
     (*action)->offset = a.offset;
 
     return ret;
@@ -403,16 +519,17 @@ encode_write_action_zero(hg_proc_t proc, uint64_t* pos, wr_action_zero_t action)
     return hg_proc_memcpy(proc, &a, sizeof(a));
 }
 
-static hg_return_t decode_write_action_zero(hg_proc_t         proc,
-                                            uint64_t*         pos,
-                                            wr_action_zero_t* action)
+static hg_return_t decode_write_action_zero(hg_proc_t                proc,
+                                            mobject_store_write_op_t write_op,
+                                            uint64_t*                pos,
+                                            wr_action_zero_t*        action)
 {
     hg_return_t         ret = HG_SUCCESS;
     args_wr_action_zero a;
     ret = hg_proc_memcpy(proc, &a, sizeof(a));
     if (ret != HG_SUCCESS) return ret;
 
-    *action           = (wr_action_zero_t)calloc(1, sizeof(**action));
+    *action = (wr_action_zero_t)alloc_write_action(write_op, sizeof(**action));
     (*action)->offset = a.offset;
     (*action)->len    = a.len;
 
@@ -428,24 +545,29 @@ static hg_return_t encode_write_action_omap_set(hg_proc_t            proc,
     a.data_size     = action->data_size;
     hg_return_t ret = hg_proc_memcpy(proc, &a, sizeof(a));
     if (ret != HG_SUCCESS) return ret;
-    return hg_proc_memcpy(proc, action->data, action->data_size);
+    return hg_proc_memcpy(proc, (void*)action->data, action->data_size);
 }
 
-static hg_return_t decode_write_action_omap_set(hg_proc_t             proc,
-                                                uint64_t*             pos,
-                                                wr_action_omap_set_t* action)
+static hg_return_t decode_write_action_omap_set(
+    hg_proc_t                proc,
+    mobject_store_write_op_t write_op,
+    uint64_t*                pos,
+    wr_action_omap_set_t*    action)
 {
     hg_return_t             ret = HG_SUCCESS;
     args_wr_action_omap_set a;
     ret = hg_proc_memcpy(proc, &a, sizeof(a));
     if (ret != HG_SUCCESS) return ret;
 
-    *action
-        = (wr_action_omap_set_t)calloc(1, sizeof(**action) - 1 + a.data_size);
+    *action = (wr_action_omap_set_t)alloc_write_action(write_op,
+                                                       sizeof(**action));
     (*action)->num       = a.num;
     (*action)->data_size = a.data_size;
 
-    ret = hg_proc_memcpy(proc, (*action)->data, a.data_size);
+    ret = decode_data_view(proc, a.data_size, &(*action)->data);
+    if (ret != HG_SUCCESS) return ret;
+    if (!is_omap_set_data((*action)->data, a.data_size, a.num))
+        return HG_PROTOCOL_ERROR;
 
     return ret;
 }
@@ -458,23 +580,427 @@ static hg_return_t encode_write_action_omap_rm_keys(
     a.data_size     = action->data_size;
     hg_return_t ret = hg_proc_memcpy(proc, &a, sizeof(a));
     if (ret != HG_SUCCESS) return ret;
-    return hg_proc_memcpy(proc, action->data, action->data_size);
+    return hg_proc_memcpy(proc, (void*)action->data, action->data_size);
 }
 
 static hg_return_t decode_write_action_omap_rm_keys(
-    hg_proc_t proc, uint64_t* pos, wr_action_omap_rm_keys_t* action)
+    hg_proc_t                 proc,
+    mobject_store_write_op_t  write_op,
+    uint64_t*                 pos,
+    wr_action_omap_rm_keys_t* action)
 {
     hg_return_t                 ret = HG_SUCCESS;
     args_wr_action_omap_rm_keys a;
     ret = hg_proc_memcpy(proc, &a, sizeof(a));
     if (ret != HG_SUCCESS) return ret;
 
-    *action = (wr_action_omap_rm_keys_t)calloc(1, sizeof(**action) - 1
-                                                      + a.data_size);
+    *action = (wr_action_omap_rm_keys_t)alloc_write_action(write_op,
+                                                           sizeof(**action));
     (*action)->num_keys  = a.num_keys;
     (*action)->data_size = a.data_size;
 
-    ret = hg_proc_memcpy(proc, (*action)->data, a.data_size);
+    ret = decode_data_view(proc, a.data_size, &(*action)->data);
+    if (ret != HG_SUCCESS) return ret;
+    if (!is_keys_data((*action)->data, a.data_size, a.num_keys))
+        return HG_PROTOCOL_ERROR;
+
+    return ret;
+}
+
+static hg_return_t encode_write_action_omap_rm_range(
+    hg_proc_t proc, uint64_t* pos, wr_action_omap_rm_range_t action)
+{
+    args_wr_action_omap_rm_range a;
+    a.data_size     = action->data_size;
+    hg_return_t ret = hg_proc_memcpy(proc, &a, sizeof(a));
+    if (ret != HG_SUCCESS) return ret;
+    return hg_proc_memcpy(proc, (void*)action->data, action->data_size);
+}
+
+static hg_return_t decode_write_action_omap_rm_range(
+    hg_proc_t                  proc,
+    mobject_store_write_op_t   write_op,
+    uint64_t*                  pos,
+    wr_action_omap_rm_range_t* action)
+{
+    hg_return_t                  ret = HG_SUCCESS;
+    args_wr_action_omap_rm_range a;
+    ret = hg_proc_memcpy(proc, &a, sizeof(a));
+    if (ret != HG_SUCCESS) return ret;
+
+    *action = (wr_action_omap_rm_range_t)alloc_write_action(write_op,
+                                                            sizeof(**action));
+    (*action)->data_size = a.data_size;
+
+    ret = decode_data_view(proc, a.data_size, &(*action)->data);
+    if (ret != HG_SUCCESS) return ret;
+    if (!is_range_data((*action)->data, a.data_size)) return HG_PROTOCOL_ERROR;
+
+    return ret;
+}
+
+static hg_return_t encode_write_action_omap_clear(hg_proc_t              proc,
+                                                  uint64_t*              pos,
+                                                  wr_action_omap_clear_t action)
+{
+    return HG_SUCCESS;
+}
+
+static hg_return_t decode_write_action_omap_clear(
+    hg_proc_t                proc,
+    mobject_store_write_op_t write_op,
+    uint64_t*                pos,
+    wr_action_omap_clear_t*  action)
+{
+    *action = (wr_action_omap_clear_t)alloc_write_action(write_op,
+                                                         sizeof(**action));
+    return HG_SUCCESS;
+}
+
+static hg_return_t encode_write_action_omap_add(hg_proc_t            proc,
+                                                uint64_t*            pos,
+                                                wr_action_omap_add_t action)
+{
+    args_wr_action_omap_add a;
+    a.delta         = action->delta;
+    a.data_size     = action->data_size;
+    hg_return_t ret = hg_proc_memcpy(proc, &a, sizeof(a));
+    if (ret != HG_SUCCESS) return ret;
+    return hg_proc_memcpy(proc, (void*)action->data, action->data_size);
+}
+
+static hg_return_t decode_write_action_omap_add(
+    hg_proc_t                proc,
+    mobject_store_write_op_t write_op,
+    uint64_t*                pos,
+    wr_action_omap_add_t*    action)
+{
+    hg_return_t             ret = HG_SUCCESS;
+    args_wr_action_omap_add a;
+    ret = hg_proc_memcpy(proc, &a, sizeof(a));
+    if (ret != HG_SUCCESS) return ret;
+
+    *action = (wr_action_omap_add_t)alloc_write_action(write_op,
+                                                       sizeof(**action));
+    (*action)->delta     = a.delta;
+    (*action)->data_size = a.data_size;
+
+    ret = decode_data_view(proc, a.data_size, &(*action)->data);
+    if (ret != HG_SUCCESS) return ret;
+    if (key_data_size((*action)->data, a.data_size) != a.data_size)
+        return HG_PROTOCOL_ERROR;
 
     return ret;
 }
+
+static hg_return_t encode_write_action_omap_cmpxchg(
+    hg_proc_t proc, uint64_t* pos, wr_action_omap_cmpxchg_t action)
+{
+    args_wr_action_omap_cmpxchg a;
+    a.absent        = action->absent;
+    a.cmp_len       = action->cmp_len;
+    a.val_len       = action->val_len;
+    a.data_size     = action->data_size;
+    hg_return_t ret = hg_proc_memcpy(proc, &a, sizeof(a));
+    if (ret != HG_SUCCESS) return ret;
+    return hg_proc_memcpy(proc, (void*)action->data, action->data_size);
+}
+
+static hg_return_t decode_write_action_omap_cmpxchg(
+    hg_proc_t                 proc,
+    mobject_store_write_op_t  write_op,
+    uint64_t*                 pos,
+    wr_action_omap_cmpxchg_t* action)
+{
+    hg_return_t                 ret = HG_SUCCESS;
+    args_wr_action_omap_cmpxchg a;
+    ret = hg_proc_memcpy(proc, &a, sizeof(a));
+    if (ret != HG_SUCCESS) return ret;
+
+    *action = (wr_action_omap_cmpxchg_t)alloc_write_action(write_op,
+                                                           sizeof(**action));
+    (*action)->absent    = a.absent;
+    (*action)->cmp_len   = a.cmp_len;
+    (*action)->val_len   = a.val_len;
+    (*action)->data_size = a.data_size;
+
+    ret = decode_data_view(proc, a.data_size, &(*action)->data);
+    if (ret != HG_SUCCESS) return ret;
+    if (!is_cmpxchg_data(*action)) return HG_PROTOCOL_ERROR;
+
+    return ret;
+}
+
+/* size of the null-terminated key at the beginning of data (including its
+ * null byte), 0 if there is none */
+static size_t key_data_size(const char* data, size_t size)
+{
+    const char* end = size ? memchr(data, '\0', size) : NULL;
+    return end ? (size_t)(end - data) + 1 : 0;
+}
+
+/* checks that the data of an omap_cmpxchg action is made of a key followed
+ * by the expected and new values, since the visitor relies on it */
+static int is_cmpxchg_data(wr_action_omap_cmpxchg_t a)
+{
+    size_t key_size = key_data_size(a->data, a->data_size);
+    return key_size != 0 && a->cmp_len <= a->data_size - key_size
+        && a->val_len == a->data_size - key_size - a->cmp_len;
+}
+
+/* checks that the data of an omap_set action is made of exactly num
+ * [key,len,value] entries, since the visitor relies on it */
+static int is_omap_set_data(const char* data, size_t size, size_t num)
+{
+    size_t i, pos = 0, key_size, len;
+    for (i = 0; i < num; i++) {
+        key_size = key_data_size(data + pos, size - pos);
+        if (key_size == 0) return 0;
+        pos += key_size;
+        if (size - pos < sizeof(len)) return 0;
+        memcpy(&len, data + pos, sizeof(len));
+        pos += sizeof(len);
+        if (len > size - pos) return 0;
+        pos += len;
+    }
+    return pos == size;
+}
+
+/* checks that the data of an omap_rm_keys action is made of exactly num
+ * null-terminated keys, since the visitor relies on it */
+static int is_keys_data(const char* data, size_t size, size_t num)
+{
+    size_t i, pos = 0, key_size;
+    for (i = 0; i < num; i++) {
+        key_size = key_data_size(data + pos, size - pos);
+        if (key_size == 0) return 0;
+        pos += key_size;
+    }
+    return pos == size;
+}
+
+/* checks that the data of an omap_rm_range action is made of exactly two
+ * null-terminated keys, since the visitor relies on it */
+static int is_range_data(const char* data, size_t size)
+{
+    const char* end = memchr(data, '\0', size);
+    if (end == NULL) return 0;
+    end += 1;
+    size -= end - data;
+    return size > 0 && memchr(end, '\0', size) == end + size - 1;
+}
+
+static hg_return_t
+decode_data_view(hg_proc_t proc, size_t size, const char** data)
+{
+    void* ptr = hg_proc_save_ptr(proc, size);
+    if (ptr == NULL) return HG_OVERFLOW;
+    *data = (const char*)ptr;
+    return hg_proc_restore_ptr(proc, ptr, size);
+}
+
+/* sizes of the actions, to allocate them when decoding */
+static const size_t write_action_size[_WRITE_OPCODE_END_ENUM_]
+    = {0,
+       sizeof(struct wr_action_CREATE),
+       sizeof(struct wr_action_WRITE),
+       sizeof(struct wr_action_WRITE_FULL),
+       sizeof(struct wr_action_WRITE_SAME),
+       sizeof(struct wr_action_APPEND),
+       sizeof(struct wr_action_REMOVE),
+       sizeof(struct wr_action_TRUNCATE),
+       sizeof(struct wr_action_ZERO),
+       sizeof(struct wr_action_OMAP_SET),
+       sizeof(struct wr_action_RM_KEYS),
+       sizeof(struct wr_action_RM_RANGE),
+       sizeof(struct wr_action_OMAP_CLEAR),
+       sizeof(struct wr_action_OMAP_ADD),
+       sizeof(struct wr_action_OMAP_CMPXCHG)};
+
+/* what the previous actions of the write_op imply about the next one */
+typedef struct {
+    uint64_t pos;         // position following the previous data in the bulk
+    uint64_t next_offset; // end of the previous action in the object
+} compact_state_t;
+
+static hg_return_t proc_buffer_position(hg_proc_t        proc,
+                                        compact_state_t* st,
+                                        buffer_u*        buffer,
+                                        uint64_t         len)
+{
+    int64_t     delta = (int64_t)(buffer->as_offset - st->pos);
+    hg_return_t ret   = proc_svarint(proc, &delta);
+    buffer->as_offset = st->pos + (uint64_t)delta;
+    st->pos           = buffer->as_offset + len;
+    return ret;
+}
+
+static hg_return_t
+proc_object_offset(hg_proc_t proc, compact_state_t* st, uint64_t* offset)
+{
+    int64_t     delta = (int64_t)(*offset - st->next_offset);
+    hg_return_t ret   = proc_svarint(proc, &delta);
+    *offset           = st->next_offset + (uint64_t)delta;
+    return ret;
+}
+
+static hg_return_t
+proc_data(hg_proc_t proc, size_t size, const char** data)
+{
+    if (hg_proc_get_op(proc) == HG_DECODE)
+        return decode_data_view(proc, size, data);
+    return hg_proc_memcpy(proc, (void*)*data, size);
+}
+
+/* Encodes or decodes the fields of an action in the compact format. When
+ * decoding, the action has been zeroed, so the same code serves both
+ * directions. */
+static hg_return_t proc_write_action_compact(hg_proc_t        proc,
+                                             compact_state_t* st,
+                                             wr_action_base_t action)
+{
+    hg_return_t ret = HG_SUCCESS;
+    uint64_t    v;
+
+#define PROC(x)                            \
+    do {                                   \
+        ret = (x);                         \
+        if (ret != HG_SUCCESS) return ret; \
+    } while (0)
+
+    switch (action->type) {
+    case WRITE_OPCODE_CREATE: {
+        wr_action_create_t a = (wr_action_create_t)action;
+        v                    = a->exclusive;
+        PROC(proc_varint(proc, &v));
+        a->exclusive = (int)v;
+    } break;
+    case WRITE_OPCODE_WRITE: {
+        wr_action_write_t a = (wr_action_write_t)action;
+        PROC(proc_varsize(proc, &a->len));
+        PROC(proc_buffer_position(proc, st, &a->buffer, a->len));
+        PROC(proc_object_offset(proc, st, &a->offset));
+        st->next_offset = a->offset + a->len;
+    } break;
+    case WRITE_OPCODE_WRITE_FULL: {
+        wr_action_write_full_t a = (wr_action_write_full_t)action;
+        PROC(proc_varsize(proc, &a->len));
+        PROC(proc_buffer_position(proc, st, &a->buffer, a->len));
+        st->next_offset = a->len;
+    } break;
+    case WRITE_OPCODE_WRITE_SAME: {
+        wr_action_write_same_t a = (wr_action_write_same_t)action;
+        PROC(proc_varsize(proc, &a->data_len));
+        PROC(proc_varsize(proc, &a->write_len));
+        PROC(proc_buffer_position(proc, st, &a->buffer, a->data_len));
+        PROC(proc_object_offset(proc, st, &a->offset));
+        st->next_offset = a->offset + a->write_len;
+    } break;
+    case WRITE_OPCODE_APPEND: {
+        wr_action_append_t a = (wr_action_append_t)action;
+        PROC(proc_varsize(proc, &a->len));
+        PROC(proc_buffer_position(proc, st, &a->buffer, a->len));
+    } break;
+    case WRITE_OPCODE_REMOVE:
+        st->next_offset = 0;
+        break;
+    case WRITE_OPCODE_TRUNCATE: {
+        wr_action_truncate_t a = (wr_action_truncate_t)action;
+        PROC(proc_object_offset(proc, st, &a->offset));
+        st->next_offset = a->offset;
+    } break;
+    case WRITE_OPCODE_ZERO: {
+        wr_action_zero_t a = (wr_action_zero_t)action;
+        PROC(proc_varint(proc, &a->len));
+        PROC(proc_object_offset(proc, st, &a->offset));
+        st->next_offset = a->offset + a->len;
+    } break;
+    case WRITE_OPCODE_OMAP_SET: {
+        wr_action_omap_set_t a = (wr_action_omap_set_t)action;
+        PROC(proc_varsize(proc, &a->num));
+        PROC(proc_varsize(proc, &a->data_size));
+        PROC(proc_data(proc, a->data_size, &a->data));
+        if (!is_omap_set_data(a->data, a->data_size, a->num))
+            return HG_PROTOCOL_ERROR;
+    } break;
+    case WRITE_OPCODE_OMAP_RM_KEYS: {
+        wr_action_omap_rm_keys_t a = (wr_action_omap_rm_keys_t)action;
+        PROC(proc_varsize(proc, &a->num_keys));
+        PROC(proc_varsize(proc, &a->data_size));
+        PROC(proc_data(proc, a->data_size, &a->data));
+        if (!is_keys_data(a->data, a->data_size, a->num_keys))
+            return HG_PROTOCOL_ERROR;
+    } break;
+    case WRITE_OPCODE_OMAP_RM_RANGE: {
+        wr_action_omap_rm_range_t a = (wr_action_omap_rm_range_t)action;
+        PROC(proc_varsize(proc, &a->data_size));
+        PROC(proc_data(proc, a->data_size, &a->data));
+        if (!is_range_data(a->data, a->data_size)) return HG_PROTOCOL_ERROR;
+    } break;
+    case WRITE_OPCODE_OMAP_CLEAR:
+        break;
+    case WRITE_OPCODE_OMAP_ADD: {
+        wr_action_omap_add_t a = (wr_action_omap_add_t)action;
+        PROC(proc_svarint(proc, &a->delta));
+        PROC(proc_varsize(proc, &a->data_size));
+        PROC(proc_data(proc, a->data_size, &a->data));
+        if (key_data_size(a->data, a->data_size) != a->data_size)
+            return HG_PROTOCOL_ERROR;
+    } break;
+    case WRITE_OPCODE_OMAP_CMPXCHG: {
+        wr_action_omap_cmpxchg_t a = (wr_action_omap_cmpxchg_t)action;
+        v                          = a->absent;
+        PROC(proc_varint(proc, &v));
+        a->absent = (int)v;
+        PROC(proc_varsize(proc, &a->cmp_len));
+        PROC(proc_varsize(proc, &a->val_len));
+        PROC(proc_varsize(proc, &a->data_size));
+        PROC(proc_data(proc, a->data_size, &a->data));
+        if (!is_cmpxchg_data(a)) return HG_PROTOCOL_ERROR;
+    } break;
+    default:
+        return HG_PROTOCOL_ERROR;
+    }
+
+#undef PROC
+
+    return ret;
+}
+
+static hg_return_t proc_write_op_compact(hg_proc_t                proc,
+                                         mobject_store_write_op_t write_op)
+{
+    compact_state_t  st          = {0, 0};
+    wr_action_base_t action      = write_op->actions;
+    uint64_t         num_actions = write_op->num_actions;
+    hg_return_t      ret;
+    uint64_t         i;
+
+    ret = hg_proc_hg_bulk_t(proc, &write_op->bulk_handle);
+    if (ret != HG_SUCCESS) return ret;
+    ret = proc_varint(proc, &num_actions);
+    if (ret != HG_SUCCESS) return ret;
+
+    for (i = 0; i < num_actions; i++) {
+        uint8_t opcode = action ? (uint8_t)action->type : 0;
+        ret            = hg_proc_uint8_t(proc, &opcode);
+        if (ret != HG_SUCCESS) return ret;
+
+        if (hg_proc_get_op(proc) == HG_DECODE) {
+            if (opcode == 0 || opcode >= _WRITE_OPCODE_END_ENUM_)
+                return HG_PROTOCOL_ERROR;
+            action = (wr_action_base_t)alloc_write_action(
+                write_op, write_action_size[opcode]);
+            action->type = (write_op_code_t)opcode;
+            DL_APPEND(write_op->actions, action);
+            write_op->num_actions += 1;
+        }
+
+        ret = proc_write_action_compact(proc, &st, action);
+        if (ret != HG_SUCCESS) return ret;
+
+        action = action->next;
+    }
+
+    return HG_SUCCESS;
+}
@@ -32,6 +32,25 @@ typedef enum
 #define READ_ACTION_UPCAST(base_obj, child_obj) \
     struct rd_action_BASE* base_obj = (struct rd_action_BASE*)child_obj;
 
+/**
+ * Region of the read_op's bulk handle into which the server pushes the
+ * results of an omap action when they are too large to be sent
+ * efficiently in the RPC response (OMAP_RESULTS_INLINE_SIZE bytes), in
+ * the layout of omap_iter_pack. Regions are allocated by prepare_read_op
+ * for read_ops sent in the compact wire format; size is 0 if the action
+ * has none. If the results do not fit in the region, the server pushes
+ * those that fit when the action is pageable (the client asked whether
+ * more entries remain), and sends them all in the response otherwise.
+ */
+typedef struct omap_results {
+    char*    buffer;   // client memory of the region (NULL on the server)
+    uint64_t offset;   // position of the region in the bulk handle
+    size_t   size;     // size of the region
+    uint8_t  pageable; // results may be truncated to fit the region
+} omap_results_t;
+
+#define OMAP_RESULTS_INLINE_SIZE 4096
+
 typedef struct rd_action_BASE {
     read_op_code_t         type;
     struct rd_action_BASE* prev;
@@ -60,10 +79,12 @@ typedef struct rd_action_OMAP_GET_KEYS {
     uint64_t                   max_return;
     mobject_store_omap_iter_t* iter;
     int*                       prval;
+    unsigned char*             pmore;
+    omap_results_t             results;
     size_t                     data_size;
-    char                       data[1];
+    const char*                data;
 } * rd_action_omap_get_keys_t;
-// data field here to hold embedded data (start_after)
+// data field here points to embedded data (start_after)
 
 typedef struct rd_action_OMAP_GET_VALS {
     struct rd_action_BASE      base;
@@ -72,10 +93,12 @@ typedef struct rd_action_OMAP_GET_VALS {
     uint64_t                   max_return;
     mobject_store_omap_iter_t* iter;
     int*                       prval;
+    unsigned char*             pmore;
+    omap_results_t             results;
     size_t                     data_size;
-    char                       data[1];
+    const char*                data;
 } * rd_action_omap_get_vals_t;
-// data field here to hold embedded data (start_after
+// data field here points to embedded data (start_after
 // and filter_prefix strings)
 
 typedef struct rd_action_OMAP_GET_VALS_BY_KEYS {
@@ -83,8 +106,9 @@ typedef struct rd_action_OMAP_GET_VALS_BY_KEYS {
     size_t                     num_keys;
     mobject_store_omap_iter_t* iter;
     int*                       prval;
+    omap_results_t             results;
     size_t                     data_size;
-    char                       data[1];
+    const char*                data;
 } * rd_action_omap_get_vals_by_keys_t;
 // data is a contiguous buffer holding all
 // the null-terminated keys
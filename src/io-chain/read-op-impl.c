@@ -21,6 +21,7 @@ mobject_store_read_op_t create_read_op(void)
     read_op->actions     = (rd_action_base_t)0;
     read_op->bulk_handle = HG_BULK_NULL;
     read_op->ready       = 0;
+    read_op->wire_format = MOBJECT_WIRE_FORMAT_COMPACT;
     return read_op;
 }
 
@@ -28,16 +29,36 @@ void release_read_op(mobject_store_read_op_t read_op)
 {
     if (read_op == MOBJECT_READ_OP_NULL) return;
 
+    rd_action_base_t action;
+    DL_FOREACH(read_op->actions, action)
+    {
+        omap_results_t* results = read_action_omap_results(action);
+        if (results) free(results->buffer);
+    }
+
     if (read_op->bulk_handle != HG_BULK_NULL)
         margo_bulk_free(read_op->bulk_handle);
 
-    rd_action_base_t action, tmp;
-
-    DL_FOREACH_SAFE(read_op->actions, action, tmp)
-    {
-        DL_DELETE(read_op->actions, action);
-        free(action);
-    }
+    action_arena_release(&read_op->arena);
 
     free(read_op);
 }
+
+void* alloc_read_action(mobject_store_read_op_t read_op, size_t size)
+{
+    return action_arena_alloc(&read_op->arena, size);
+}
+
+omap_results_t* read_action_omap_results(rd_action_base_t action)
+{
+    switch (action->type) {
+    case READ_OPCODE_OMAP_GET_KEYS:
+        return &((rd_action_omap_get_keys_t)action)->results;
+    case READ_OPCODE_OMAP_GET_VALS:
+        return &((rd_action_omap_get_vals_t)action)->results;
+    case READ_OPCODE_OMAP_GET_VALS_BY_KEYS:
+        return &((rd_action_omap_get_vals_by_keys_t)action)->results;
+    default:
+        return NULL;
+    }
+}
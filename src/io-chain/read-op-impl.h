@@ -10,6 +10,8 @@
 #include "mobject-store-config.h"
 #include "libmobject-store.h"
 #include "src/io-chain/read-actions.h"
+#include "src/io-chain/action-arena.h"
+#include "src/io-chain/wire-format.h"
 
 /**
  * This object represents a handler for a list of actions
@@ -18,15 +20,46 @@
  * sent to be used for bulk transfers: all pointers
  * have been converted into an offset in a bulk handle.
  * It can therefore be sent to a server and processed.
+ * Actions are allocated from the op's arena (see action-arena.h).
+ * On the server side, the keys embedded in decoded omap actions point
+ * into the buffer of the RPC input rather than being copied.
+ * "wire_format" is the encoding used to send the object (see
+ * wire-format.h). "omap_bulk_size" is the size of the region allocated
+ * for the results of each omap action when the op is prepared (see
+ * omap_results_t in read-actions.h), 0 to always receive them in the
+ * response.
  */
 struct mobject_store_read_op {
-    int              ready;
-    hg_bulk_t        bulk_handle;
-    size_t           num_actions;
-    rd_action_base_t actions;
+    int                 ready;
+    hg_bulk_t           bulk_handle;
+    size_t              num_actions;
+    rd_action_base_t    actions;
+    struct action_arena arena;
+    uint8_t             wire_format;
+    size_t              omap_bulk_size;
 };
 
+/**
+ * Clients use regions of MOBJECT_DEFAULT_OMAP_BULK_SIZE bytes for the
+ * results of omap actions, unless the MOBJECT_OMAP_BULK_SIZE environment
+ * variable gives another size.
+ */
+#define MOBJECT_DEFAULT_OMAP_BULK_SIZE (256 * 1024)
+#define MOBJECT_OMAP_BULK_SIZE_ENV     "MOBJECT_OMAP_BULK_SIZE"
+
 mobject_store_read_op_t create_read_op(void);
 void                    release_read_op(mobject_store_read_op_t read_op);
 
+/**
+ * Allocates a zeroed action of the given size (including any embedded
+ * data) from the read_op's arena. The action is freed with the read_op.
+ */
+void* alloc_read_action(mobject_store_read_op_t read_op, size_t size);
+
+/**
+ * Returns the region receiving the results of an omap action, NULL if
+ * the action is not an omap action.
+ */
+omap_results_t* read_action_omap_results(rd_action_base_t action);
+
 #endif
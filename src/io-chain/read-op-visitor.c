@@ -71,12 +71,20 @@ static void execute_read_op_visitor_on_read(read_op_visitor_t visitor,
                             a->prval);
 }
 
+/* results that do not fit in their region are only truncated (rather
+ * than sent in the response) if the action is pageable */
+static size_t omap_max_bytes(const omap_results_t* results)
+{
+    return results->pageable ? results->size : 0;
+}
+
 static void execute_read_op_visitor_on_omap_get_keys(
     read_op_visitor_t visitor, rd_action_omap_get_keys_t a, void* uargs)
 {
     if (visitor->visit_omap_get_keys)
         visitor->visit_omap_get_keys(uargs, a->start_after, a->max_return,
-                                     a->iter, a->prval);
+                                     omap_max_bytes(&a->results), a->iter,
+                                     a->prval);
 }
 
 static void execute_read_op_visitor_on_omap_get_vals(
@@ -84,7 +92,8 @@ static void execute_read_op_visitor_on_omap_get_vals(
 {
     if (visitor->visit_omap_get_vals)
         visitor->visit_omap_get_vals(uargs, a->start_after, a->filter_prefix,
-                                     a->max_return, a->iter, a->prval);
+                                     a->max_return, omap_max_bytes(&a->results),
+                                     a->iter, a->prval);
 }
 
 static void execute_read_op_visitor_on_omap_get_vals_by_keys(
@@ -13,16 +13,23 @@
 extern "C" {
 #endif
 
+/**
+ * The size_t argument of visit_omap_get_keys and visit_omap_get_vals is
+ * the number of bytes the results can take once packed (see
+ * omap_iter_pack), 0 if unlimited: visitors may stop listing entries
+ * once they have exceeded it, as the server will not send the others.
+ */
 typedef struct read_op_visitor {
     void (*visit_begin)(void*);
     void (*visit_stat)(void*, uint64_t*, time_t*, int*);
     void (*visit_read)(void*, uint64_t, size_t, buffer_u, size_t*, int*);
     void (*visit_omap_get_keys)(
-        void*, const char*, uint64_t, mobject_store_omap_iter_t*, int*);
+        void*, const char*, uint64_t, size_t, mobject_store_omap_iter_t*, int*);
     void (*visit_omap_get_vals)(void*,
                                 const char*,
                                 const char*,
                                 uint64_t,
+                                size_t,
                                 mobject_store_omap_iter_t*,
                                 int*);
     void (*visit_omap_get_vals_by_keys)(
@@ -121,6 +121,75 @@ void feed_read_op_pointers_from_response(mobject_store_read_op_t read_op,
     }
 }
 
+/* pushes the entries of the response that fit in the region, returns
+ * 0 if they have been removed from the response */
+static int push_omap_response(margo_instance_id  mid,
+                              omap_results_t*    results,
+                              rd_response_omap_t r,
+                              hg_addr_t          client_addr,
+                              hg_bulk_t          bulk_handle)
+{
+    mobject_store_omap_iter_t iter  = r->iter;
+    size_t                    size  = omap_iter_packed_size(iter);
+    size_t                    count = 0;
+    if (size <= OMAP_RESULTS_INLINE_SIZE) return -1;
+    if (size > results->size) size = results->size;
+
+    char* buf = (char*)malloc(size);
+    if (!buf) return -1;
+    size = omap_iter_pack(iter, buf, size, &count);
+    // truncating the results is only allowed if the client asks for more
+    if (count == 0 || (count < iter->num_items && !results->pageable)) {
+        free(buf);
+        return -1;
+    }
+
+    hg_bulk_t   local = HG_BULK_NULL;
+    void*       ptr   = buf;
+    hg_size_t   len   = size;
+    hg_return_t hret
+        = margo_bulk_create(mid, 1, &ptr, &len, HG_BULK_READ_ONLY, &local);
+    if (hret == HG_SUCCESS)
+        hret = margo_bulk_transfer(mid, HG_BULK_PUSH, client_addr, bulk_handle,
+                                   results->offset, local, 0, size);
+    if (local != HG_BULK_NULL) margo_bulk_free(local);
+    free(buf);
+    if (hret != HG_SUCCESS) {
+        margo_error(mid, "[mobject] %s:%d: could not push omap results (%d)",
+                    __func__, __LINE__, hret);
+        return -1;
+    }
+
+    omap_iter_create(&r->iter);
+    r->iter->more = iter->more || count < iter->num_items;
+    r->bulk_items = count;
+    r->bulk_size  = size;
+    omap_iter_free(iter);
+    return 0;
+}
+
+void push_omap_results(margo_instance_id       mid,
+                       mobject_store_read_op_t read_op,
+                       read_response_t         response,
+                       hg_addr_t               client_addr,
+                       hg_bulk_t               bulk_handle)
+{
+    rd_action_base_t   a;
+    rd_response_base_t r = response->responses;
+
+    if (bulk_handle == HG_BULK_NULL) return;
+
+    DL_FOREACH(read_op->actions, a)
+    {
+        omap_results_t*    results = read_action_omap_results(a);
+        rd_response_omap_t ro      = (rd_response_omap_t)r;
+        r                          = r->next;
+        if (!results || results->size == 0) continue;
+        if (ro->prval != 0 || !ro->iter) continue;
+        push_omap_response(mid, results, ro, client_addr, bulk_handle);
+    }
+}
+
 rd_response_base_t build_matching_stat(rd_action_stat_t a)
 {
     rd_response_stat_t resp = (rd_response_stat_t)calloc(1, sizeof(*resp));
@@ -185,12 +254,26 @@ void feed_read_action(rd_action_read_t a, rd_response_read_t r)
     if (a->prval) *(a->prval) = r->prval;
 }
 
+/* appends to the iterator of r the entries pushed by the server to the
+ * region of the action */
+static void feed_omap_results(omap_results_t* results, rd_response_omap_t r)
+{
+    if (r->bulk_size == 0) return;
+    if (r->bulk_size > results->size
+        || omap_iter_unpack(r->iter, results->buffer, r->bulk_size,
+                            r->bulk_items)
+               != 0)
+        r->prval = -1;
+}
+
 void feed_omap_get_keys_action(rd_action_omap_get_keys_t a,
                                rd_response_omap_t        r)
 {
     MOBJECT_ASSERT(r->base.type == READ_RESPCODE_OMAP,
                    "Response type does not match the input action");
+    feed_omap_results(&a->results, r);
     if (a->prval) *(a->prval) = r->prval;
+    if (a->pmore) *(a->pmore) = r->iter->more;
     if (a->iter) {
         *(a->iter) = r->iter;
         omap_iter_incr_ref(r->iter);
@@ -202,7 +285,9 @@ void feed_omap_get_vals_action(rd_action_omap_get_vals_t a,
 {
     MOBJECT_ASSERT(r->base.type == READ_RESPCODE_OMAP,
                    "Response type does not match the input action");
+    feed_omap_results(&a->results, r);
     if (a->prval) *(a->prval) = r->prval;
+    if (a->pmore) *(a->pmore) = r->iter->more;
     if (a->iter) {
         *(a->iter) = r->iter;
         omap_iter_incr_ref(r->iter);
@@ -214,6 +299,7 @@ void feed_omap_get_vals_by_keys_action(rd_action_omap_get_vals_by_keys_t a,
 {
     MOBJECT_ASSERT(r->base.type == READ_RESPCODE_OMAP,
                    "Response type does not match the input action");
+    feed_omap_results(&a->results, r);
     if (a->prval) *(a->prval) = r->prval;
     if (a->iter) {
         *(a->iter) = r->iter;
@@ -7,6 +7,7 @@
 #define __MOBJECT_READ_RESP_IMPL_H
 
 #include <stdint.h>
+#include <margo.h>
 #include "mobject-store-config.h"
 #include "libmobject-store.h"
 
@@ -22,4 +23,17 @@ void            free_read_responses(read_response_t response);
 void feed_read_op_pointers_from_response(mobject_store_read_op_t actions,
                                          read_response_t         response);
 
+/**
+ * Called by the server once the read_op has been executed: pushes the
+ * results of its omap actions that are larger than
+ * OMAP_RESULTS_INLINE_SIZE to the regions of the bulk handle exposed by
+ * the client for them (see omap_results_t), removing them from the
+ * responses.
+ */
+void push_omap_results(margo_instance_id       mid,
+                       mobject_store_read_op_t actions,
+                       read_response_t         response,
+                       hg_addr_t               client_addr,
+                       hg_bulk_t               bulk_handle);
+
 #endif
@@ -46,11 +46,15 @@ typedef struct rd_response_READ {
 
 /**
  * omap_* responses
+ * bulk_items entries, packed on bulk_size bytes, have been pushed to the
+ * region of the action (see omap_results_t) rather than sent in iter.
  */
 typedef struct rd_response_OMAP {
     struct rd_response_BASE   base;
     int                       prval;
     mobject_store_omap_iter_t iter;
+    size_t                    bulk_items;
+    size_t                    bulk_size;
 } * rd_response_omap_t;
 
 #endif
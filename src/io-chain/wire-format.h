@@ -0,0 +1,98 @@
+/*
+ * (C) 2017 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __MOBJECT_WIRE_FORMAT_H
+#define __MOBJECT_WIRE_FORMAT_H
+
+#include <stdint.h>
+#include <margo.h>
+
+/**
+ * read_ops and write_ops can be encoded in two formats. The format is
+ * not part of the encoded op: it is sent in the RPC input ahead of it
+ * (see rpc-types/write-op.h, read-op.h and io-chain/proc-batch.h).
+ *
+ * MOBJECT_WIRE_FORMAT_LEGACY encodes the args_*_action_* structures
+ * with their native layout and each opcode as a full enum, exactly as
+ * before the compact format was introduced.
+ *
+ * MOBJECT_WIRE_FORMAT_COMPACT encodes opcodes on a single byte and
+ * integers as varints. Offsets in the object are encoded as the
+ * (zigzag) difference with the end of the previous action, and
+ * positions in the bulk handle as the difference with the position
+ * the data of the action would have if all the data of the op was
+ * contiguous, so that the common cases (sequential actions, buffers
+ * exposed by prepare_*_op) take a single byte.
+ *
+ * When a provider handle is created, the client asks the provider for
+ * the most recent format it decodes (mobject_wire_format RPC) and sends
+ * ops to it in that format, or in the legacy format if the provider
+ * does not know the RPC. Setting the MOBJECT_WIRE_FORMAT environment
+ * variable to 1 makes the client use the legacy format everywhere.
+ */
+#define MOBJECT_WIRE_FORMAT_LEGACY  1
+#define MOBJECT_WIRE_FORMAT_COMPACT 2
+#define MOBJECT_WIRE_FORMAT_ENV     "MOBJECT_WIRE_FORMAT"
+
+/* encodes or decodes an unsigned integer on 1 to 10 bytes, 7 bits at a
+ * time, least significant bits first */
+static inline hg_return_t proc_varint(hg_proc_t proc, uint64_t* value)
+{
+    uint8_t     byte;
+    hg_return_t ret;
+
+    switch (hg_proc_get_op(proc)) {
+    case HG_ENCODE: {
+        uint8_t  buf[10];
+        unsigned n = 0;
+        uint64_t v = *value;
+        while (v >= 0x80) {
+            buf[n++] = (uint8_t)(v | 0x80);
+            v >>= 7;
+        }
+        buf[n++] = (uint8_t)v;
+        return hg_proc_memcpy(proc, buf, n);
+    }
+    case HG_DECODE: {
+        uint64_t v     = 0;
+        unsigned shift = 0;
+        do {
+            if (shift > 63) return HG_PROTOCOL_ERROR;
+            ret = hg_proc_uint8_t(proc, &byte);
+            if (ret != HG_SUCCESS) return ret;
+            v |= (uint64_t)(byte & 0x7f) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+        *value = v;
+        return HG_SUCCESS;
+    }
+    default:
+        return HG_SUCCESS;
+    }
+}
+
+/* same as proc_varint for signed values, using zigzag encoding */
+static inline hg_return_t proc_svarint(hg_proc_t proc, int64_t* value)
+{
+    uint64_t    zz = 0;
+    hg_return_t ret;
+    if (hg_proc_get_op(proc) == HG_ENCODE)
+        zz = ((uint64_t)*value << 1) ^ (uint64_t)(*value >> 63);
+    ret = proc_varint(proc, &zz);
+    if (ret == HG_SUCCESS && hg_proc_get_op(proc) == HG_DECODE)
+        *value = (int64_t)(zz >> 1) ^ -(int64_t)(zz & 1);
+    return ret;
+}
+
+/* proc_varint for size_t values */
+static inline hg_return_t proc_varsize(hg_proc_t proc, size_t* value)
+{
+    uint64_t    v   = *value;
+    hg_return_t ret = proc_varint(proc, &v);
+    *value          = (size_t)v;
+    return ret;
+}
+
+#endif
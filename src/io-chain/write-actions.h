@@ -22,6 +22,10 @@ typedef enum
     WRITE_OPCODE_ZERO,
     WRITE_OPCODE_OMAP_SET,
     WRITE_OPCODE_OMAP_RM_KEYS,
+    WRITE_OPCODE_OMAP_RM_RANGE,
+    WRITE_OPCODE_OMAP_CLEAR,
+    WRITE_OPCODE_OMAP_ADD,
+    WRITE_OPCODE_OMAP_CMPXCHG,
     _WRITE_OPCODE_END_ENUM_
 } write_op_code_t;
 
@@ -72,7 +76,11 @@ typedef struct wr_action_APPEND {
     struct wr_action_BASE base;
     buffer_u              buffer;
     size_t                len;
+    uint64_t*             poffset;
+    int*                  prval;
 } * wr_action_append_t;
+// poffset (the offset at which the data was appended) and prval
+// are handled as in wr_action_omap_add_t.
 
 typedef struct wr_action_REMOVE {
     struct wr_action_BASE base;
@@ -93,10 +101,12 @@ typedef struct wr_action_OMAP_SET {
     struct wr_action_BASE base;
     size_t                num;
     size_t                data_size;
-    char                  data[1];
+    const char*           data;
 } * wr_action_omap_set_t;
-// data above is meant to hold keys, lengths, and values,
-// all put together in the same contiguous buffer.
+// data above points to keys, lengths, and values,
+// all put together in the same contiguous buffer
+// (right after the action on the client side, in the
+// RPC input buffer on the server side).
 // The buffer holds a series of [key,len,value] segments
 // where key is a null-terminated string, len is a size_t,
 // and value is a len-sized segment.
@@ -105,9 +115,49 @@ typedef struct wr_action_RM_KEYS {
     struct wr_action_BASE base;
     size_t                num_keys;
     size_t                data_size;
-    char                  data[1];
+    const char*           data;
 } * wr_action_omap_rm_keys_t;
-// keys above is meant to hold keys in a contiguous buffer.
+// data above points to keys in a contiguous buffer.
 // The keys are null-terminated strings.
 
+typedef struct wr_action_RM_RANGE {
+    struct wr_action_BASE base;
+    size_t                data_size;
+    const char*           data;
+} * wr_action_omap_rm_range_t;
+// data above points to the first key of the range followed by
+// the end of the range (excluded), as null-terminated strings.
+// An empty end key extends the range to the last key.
+
+typedef struct wr_action_OMAP_CLEAR {
+    struct wr_action_BASE base;
+} * wr_action_omap_clear_t;
+
+typedef struct wr_action_OMAP_ADD {
+    struct wr_action_BASE base;
+    int64_t               delta;
+    int64_t*              presult;
+    int*                  prval;
+    size_t                data_size;
+    const char*           data;
+} * wr_action_omap_add_t;
+// data above points to the key, a null-terminated string.
+// presult and prval point to the caller's variables on the
+// client side, and to a write_result_t on the server side
+// (see write-results.h). They are not serialized.
+
+typedef struct wr_action_OMAP_CMPXCHG {
+    struct wr_action_BASE base;
+    int                   absent; // the key must not exist
+    size_t                cmp_len;
+    size_t                val_len;
+    int*                  prval;
+    size_t                data_size;
+    const char*           data;
+} * wr_action_omap_cmpxchg_t;
+// data above points to the key (a null-terminated string),
+// followed by the cmp_len bytes of the expected value and the
+// val_len bytes of the new value. prval is handled as in
+// wr_action_omap_add_t.
+
 #endif
@@ -22,6 +22,7 @@ mobject_store_write_op_t create_write_op(void)
     write_op->bulk_handle = HG_BULK_NULL;
     write_op->num_actions = 0;
     write_op->ready       = 0;
+    write_op->wire_format = MOBJECT_WIRE_FORMAT_COMPACT;
     return write_op;
 }
 
@@ -32,13 +33,12 @@ void release_write_op(mobject_store_write_op_t write_op)
     if (write_op->bulk_handle != HG_BULK_NULL)
         margo_bulk_free(write_op->bulk_handle);
 
-    wr_action_base_t action, tmp;
-
-    DL_FOREACH_SAFE(write_op->actions, action, tmp)
-    {
-        DL_DELETE(write_op->actions, action);
-        free(action);
-    }
+    action_arena_release(&write_op->arena);
 
     free(write_op);
 }
+
+void* alloc_write_action(mobject_store_write_op_t write_op, size_t size)
+{
+    return action_arena_alloc(&write_op->arena, size);
+}
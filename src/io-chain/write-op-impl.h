@@ -10,12 +10,16 @@
 #include "mobject-store-config.h"
 #include "libmobject-store.h"
 #include "src/io-chain/write-actions.h"
+#include "src/io-chain/action-arena.h"
+#include "src/io-chain/wire-format.h"
 
 /**
  * The mobject_store_write_op structure is what a
  * mobject_store_write_op_t points to (see typedef in libmobject-store.h).
  * It mainly contains a list of actions ("child" structures of
- * wr_action_base_t).
+ * wr_action_base_t). The actions, as well as the keys and values they
+ * embed, are allocated from the op's arena (see action-arena.h) using
+ * alloc_write_action.
  *
  * When created on the client side, ready is set to 0 and the
  * bulk_handle is set to HG_BULK_NULL. The actions in the list may have unions
@@ -28,20 +32,32 @@
  * to the list becomes forbidden.
  *
  * The hg_proc_mobject_store_write_op_t function allows serializing and
- * deserializing the object when sending and receiving it. Serializing only
+ * deserializing the object when sending and receiving it, using the format
+ * given by wire_format (see wire-format.h). Serializing only
  * works for a write_op that has been prepared (prepare_bulk_for_write_op has
  * been called). When deserializing, ready is set 1 and the actions
- * refer to offsets in the bulk_handle.
+ * refer to offsets in the bulk_handle. The data of omap actions is then
+ * not copied: it points into the buffer of the RPC input, so a decoded
+ * write_op must not outlive the input it was decoded from.
  */
 struct mobject_store_write_op {
     int ready; // whether the unions in the actions are
                // to be interpreted as offsets in bulk handles
-    hg_bulk_t        bulk_handle; // bulk handle exposing the data
-    size_t           num_actions; // number of action in the linked-list below
-    wr_action_base_t actions;     // list of actions
+    hg_bulk_t           bulk_handle; // bulk handle exposing the data
+    size_t              num_actions; // number of action in the list below
+    wr_action_base_t    actions;     // list of actions
+    struct action_arena arena;       // memory holding the actions
+    uint8_t             wire_format; // encoding used on the wire
 };
 
 mobject_store_write_op_t create_write_op(void);
 void                     release_write_op(mobject_store_write_op_t write_op);
 
+/**
+ * Allocates a zeroed action of the given size (including any embedded
+ * data) from the write_op's arena. The action is freed with the
+ * write_op.
+ */
+void* alloc_write_action(mobject_store_write_op_t write_op, size_t size);
+
 #endif
@@ -40,6 +40,20 @@ static void execute_write_op_visitor_on_omap_set(write_op_visitor_t   visitor,
 static void execute_write_op_visitor_on_omap_rm_keys(write_op_visitor_t visitor,
                                                      wr_action_omap_rm_keys_t a,
                                                      void* uargs);
+static void
+execute_write_op_visitor_on_omap_rm_range(write_op_visitor_t        visitor,
+                                          wr_action_omap_rm_range_t a,
+                                          void*                     uargs);
+static void execute_write_op_visitor_on_omap_clear(write_op_visitor_t visitor,
+                                                   wr_action_omap_clear_t a,
+                                                   void* uargs);
+static void execute_write_op_visitor_on_omap_add(write_op_visitor_t   visitor,
+                                                 wr_action_omap_add_t a,
+                                                 void*                uargs);
+static void
+execute_write_op_visitor_on_omap_cmpxchg(write_op_visitor_t       visitor,
+                                         wr_action_omap_cmpxchg_t a,
+                                         void*                    uargs);
 
 typedef void (*dispatch_fn)(write_op_visitor_t, wr_action_base_t, void* uargs);
 
@@ -54,7 +68,11 @@ static dispatch_fn visitor_dispatch[_WRITE_OPCODE_END_ENUM_]
        (dispatch_fn)execute_write_op_visitor_on_truncate,
        (dispatch_fn)execute_write_op_visitor_on_zero,
        (dispatch_fn)execute_write_op_visitor_on_omap_set,
-       (dispatch_fn)execute_write_op_visitor_on_omap_rm_keys};
+       (dispatch_fn)execute_write_op_visitor_on_omap_rm_keys,
+       (dispatch_fn)execute_write_op_visitor_on_omap_rm_range,
+       (dispatch_fn)execute_write_op_visitor_on_omap_clear,
+       (dispatch_fn)execute_write_op_visitor_on_omap_add,
+       (dispatch_fn)execute_write_op_visitor_on_omap_cmpxchg};
 
 void execute_write_op_visitor(write_op_visitor_t       visitor,
                               mobject_store_write_op_t write_op,
@@ -114,7 +132,8 @@ static void execute_write_op_visitor_on_append(write_op_visitor_t visitor,
                                                wr_action_append_t a,
                                                void*              uargs)
 {
-    if (visitor->visit_append) visitor->visit_append(uargs, a->buffer, a->len);
+    if (visitor->visit_append)
+        visitor->visit_append(uargs, a->buffer, a->len, a->poffset, a->prval);
 }
 
 static void execute_write_op_visitor_on_remove(write_op_visitor_t visitor,
@@ -186,3 +205,49 @@ static void execute_write_op_visitor_on_omap_rm_keys(write_op_visitor_t visitor,
 
     visitor->visit_omap_rm_keys(uargs, keys, num_keys);
 }
+
+static void
+execute_write_op_visitor_on_omap_rm_range(write_op_visitor_t        visitor,
+                                          wr_action_omap_rm_range_t a,
+                                          void*                     uargs)
+{
+    if (visitor->visit_omap_rm_range == NULL) return;
+
+    // the data holds the two null-terminated keys
+    const char* start = a->data;
+    const char* end   = start + strlen(start) + 1;
+
+    visitor->visit_omap_rm_range(uargs, start, end);
+}
+
+static void execute_write_op_visitor_on_omap_clear(write_op_visitor_t visitor,
+                                                   wr_action_omap_clear_t a,
+                                                   void* uargs)
+{
+    if (visitor->visit_omap_clear) visitor->visit_omap_clear(uargs);
+}
+
+static void execute_write_op_visitor_on_omap_add(write_op_visitor_t   visitor,
+                                                 wr_action_omap_add_t a,
+                                                 void*                uargs)
+{
+    if (visitor->visit_omap_add)
+        visitor->visit_omap_add(uargs, a->data, a->delta, a->presult,
+                                a->prval);
+}
+
+static void
+execute_write_op_visitor_on_omap_cmpxchg(write_op_visitor_t       visitor,
+                                         wr_action_omap_cmpxchg_t a,
+                                         void*                    uargs)
+{
+    if (visitor->visit_omap_cmpxchg == NULL) return;
+
+    // the key is followed by the expected value and the new value
+    const char* key = a->data;
+    const char* cmp = key + strlen(key) + 1;
+    const char* val = cmp + a->cmp_len;
+
+    visitor->visit_omap_cmpxchg(uargs, key, a->absent ? NULL : cmp, a->cmp_len,
+                                val, a->val_len, a->prval);
+}
@@ -19,13 +19,18 @@ typedef struct write_op_visitor {
     void (*visit_write)(void*, buffer_u, size_t, uint64_t);
     void (*visit_write_full)(void*, buffer_u, size_t);
     void (*visit_writesame)(void*, buffer_u, size_t, size_t, uint64_t);
-    void (*visit_append)(void*, buffer_u, size_t);
+    void (*visit_append)(void*, buffer_u, size_t, uint64_t*, int*);
     void (*visit_remove)(void*);
     void (*visit_truncate)(void*, uint64_t);
     void (*visit_zero)(void*, uint64_t, uint64_t);
     void (*visit_omap_set)(
         void*, char const* const*, char const* const*, const size_t*, size_t);
     void (*visit_omap_rm_keys)(void*, char const* const*, size_t);
+    void (*visit_omap_rm_range)(void*, const char*, const char*);
+    void (*visit_omap_clear)(void*);
+    void (*visit_omap_add)(void*, const char*, int64_t, int64_t*, int*);
+    void (*visit_omap_cmpxchg)(
+        void*, const char*, const char*, size_t, const char*, size_t, int*);
     void (*visit_end)(void*);
 } * write_op_visitor_t;
 
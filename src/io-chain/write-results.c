@@ -0,0 +1,120 @@
+/*
+ * (C) 2017 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <stdlib.h>
+#include <mercury_proc.h>
+#include "src/io-chain/write-results.h"
+#include "src/io-chain/write-op-impl.h"
+#include "src/util/utlist.h"
+#include "src/util/log.h"
+
+/* sets *prval and *presult (NULL if the action has no value) to the
+ * pointers of an action returning a result, returns 0 for other actions */
+static int result_pointers(wr_action_base_t a, int*** prval, int64_t*** presult)
+{
+    switch (a->type) {
+    case WRITE_OPCODE_APPEND:
+        // offsets are returned as int64_t values
+        *prval   = &((wr_action_append_t)a)->prval;
+        *presult = (int64_t**)&((wr_action_append_t)a)->poffset;
+        return 1;
+    case WRITE_OPCODE_OMAP_ADD:
+        *prval   = &((wr_action_omap_add_t)a)->prval;
+        *presult = &((wr_action_omap_add_t)a)->presult;
+        return 1;
+    case WRITE_OPCODE_OMAP_CMPXCHG:
+        *prval   = &((wr_action_omap_cmpxchg_t)a)->prval;
+        *presult = NULL;
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+void build_matching_write_results(mobject_store_write_op_t write_op,
+                                  write_results_t*         results)
+{
+    wr_action_base_t a;
+    int**            prval;
+    int64_t**        presult;
+
+    results->count   = 0;
+    results->results = NULL;
+    DL_FOREACH(write_op->actions, a)
+    {
+        if (result_pointers(a, &prval, &presult)) results->count += 1;
+    }
+    if (results->count == 0) return;
+
+    results->results = (write_result_t*)calloc(results->count,
+                                               sizeof(*results->results));
+    MOBJECT_ASSERT(results->results != NULL,
+                   "Could not allocate write results");
+
+    write_result_t* r = results->results;
+    DL_FOREACH(write_op->actions, a)
+    {
+        if (!result_pointers(a, &prval, &presult)) continue;
+        *prval = &r->prval;
+        if (presult) *presult = &r->value;
+        r += 1;
+    }
+}
+
+void free_write_results(write_results_t* results)
+{
+    free(results->results);
+    results->results = NULL;
+    results->count   = 0;
+}
+
+void feed_write_op_pointers_from_results(mobject_store_write_op_t write_op,
+                                         const write_results_t*   results)
+{
+    wr_action_base_t a;
+    int**            prval;
+    int64_t**        presult;
+    uint32_t         i = 0;
+
+    DL_FOREACH(write_op->actions, a)
+    {
+        if (!result_pointers(a, &prval, &presult)) continue;
+        MOBJECT_ASSERT(i < results->count,
+                       "Number of results received doesn't match number of "
+                       "actions returning a result in write_op");
+        if (*prval) **prval = results->results[i].prval;
+        if (presult && *presult) **presult = results->results[i].value;
+        i += 1;
+    }
+}
+
+hg_return_t hg_proc_write_results_t(hg_proc_t proc, write_results_t* results)
+{
+    hg_return_t ret = HG_SUCCESS;
+    uint32_t    i;
+
+    ret = hg_proc_uint32_t(proc, &(results->count));
+    if (ret != HG_SUCCESS) return ret;
+
+    if (hg_proc_get_op(proc) == HG_DECODE)
+        results->results = (write_result_t*)calloc(results->count,
+                                                   sizeof(*results->results));
+
+    if (hg_proc_get_op(proc) == HG_FREE) {
+        free(results->results);
+        return ret;
+    }
+
+    for (i = 0; i < results->count; i++) {
+        int32_t prval = results->results[i].prval;
+        ret           = hg_proc_int32_t(proc, &prval);
+        if (ret != HG_SUCCESS) return ret;
+        results->results[i].prval = prval;
+        ret = hg_proc_int64_t(proc, &(results->results[i].value));
+        if (ret != HG_SUCCESS) return ret;
+    }
+
+    return ret;
+}
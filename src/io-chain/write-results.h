@@ -0,0 +1,41 @@
+/*
+ * (C) 2017 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __MOBJECT_WRITE_RESULTS_H
+#define __MOBJECT_WRITE_RESULTS_H
+
+#include <stdint.h>
+#include <margo.h>
+#include "mobject-store-config.h"
+#include "libmobject-store.h"
+
+/**
+ * Results of the actions of a write_op that return something to the
+ * caller (append, omap_add and omap_cmpxchg), in the order of these actions in
+ * the write_op. Before executing a write_op, the server points the prval
+ * and presult fields of these actions to the entries built by
+ * build_matching_write_results. The client copies the entries it
+ * receives to the caller's variables with
+ * feed_write_op_pointers_from_results.
+ */
+typedef struct write_result {
+    int     prval;
+    int64_t value; // offset of an append, new value of an omap_add
+} write_result_t;
+
+typedef struct write_results {
+    uint32_t        count;
+    write_result_t* results;
+} write_results_t;
+
+void build_matching_write_results(mobject_store_write_op_t write_op,
+                                  write_results_t*         results);
+void free_write_results(write_results_t* results);
+void feed_write_op_pointers_from_results(mobject_store_write_op_t write_op,
+                                         const write_results_t*   results);
+
+hg_return_t hg_proc_write_results_t(hg_proc_t proc, write_results_t* results);
+
+#endif
@@ -7,9 +7,53 @@
 #include <string.h>
 #include "libmobject-store.h"
 #include "src/omap-iter/omap-iter-impl.h"
-#include "src/util/utlist.h"
 #include "src/util/log.h"
 
+#define ENTRY_HEADER_SIZE (2 * sizeof(uint64_t))
+
+/* makes room for count more entries and size more bytes of data */
+static int reserve(mobject_store_omap_iter_t iter, size_t count, size_t size)
+{
+    if (iter->num_items + count > iter->offsets_capacity) {
+        size_t capacity = iter->offsets_capacity ? iter->offsets_capacity : 8;
+        while (capacity < iter->num_items + count) capacity *= 2;
+        size_t* offsets
+            = (size_t*)realloc(iter->offsets, capacity * sizeof(size_t));
+        if (!offsets) return -1;
+        iter->offsets          = offsets;
+        iter->offsets_capacity = capacity;
+    }
+    if (iter->data_size + size > iter->data_capacity) {
+        size_t capacity = iter->data_capacity ? iter->data_capacity : 256;
+        while (capacity < iter->data_size + size) capacity *= 2;
+        char* data = (char*)realloc(iter->data, capacity);
+        if (!data) return -1;
+        iter->data          = data;
+        iter->data_capacity = capacity;
+    }
+    return 0;
+}
+
+/* size of the entry of data starting at offset, 0 if it does not fit in
+ * the size bytes of data or is invalid */
+static size_t entry_size(const char* data, size_t size, size_t offset)
+{
+    uint64_t key_size, val_size;
+    size_t   n = offset;
+
+    if (size - n < sizeof(key_size)) return 0;
+    memcpy(&key_size, data + n, sizeof(key_size));
+    n += sizeof(key_size);
+    if (size - n < key_size) return 0;
+    if (key_size != 0 && data[n + key_size - 1] != '\0') return 0;
+    n += key_size;
+    if (size - n < sizeof(val_size)) return 0;
+    memcpy(&val_size, data + n, sizeof(val_size));
+    n += sizeof(val_size);
+    if (size - n < val_size) return 0;
+    return n + val_size - offset;
+}
+
 void omap_iter_create(mobject_store_omap_iter_t* iter)
 {
     *iter              = (mobject_store_omap_iter_t)calloc(1, sizeof(**iter));
@@ -22,16 +66,8 @@ void omap_iter_free(mobject_store_omap_iter_t iter)
     iter->ref_count -= 1;
     if (iter->ref_count > 0) return;
 
-    omap_iter_node_t elt, tmp;
-
-    DL_FOREACH_SAFE(iter->head, elt, tmp)
-    {
-        DL_DELETE(iter->head, elt);
-        if (elt->key) free((void*)(elt->key));
-        if (elt->value) free((void*)(elt->value));
-        free((void*)(elt));
-    }
-
+    free(iter->offsets);
+    free(iter->data);
     free(iter);
 }
 
@@ -48,16 +84,91 @@ void omap_iter_append(mobject_store_omap_iter_t iter,
 {
     MOBJECT_ASSERT(iter, "trying to append to a NULL iterator");
 
-    omap_iter_node_t item = (omap_iter_node_t)calloc(1, sizeof(*item));
-    item->key             = key ? strdup(key) : NULL;
-    item->key_size        = key ? strlen(key) + 1 : 0;
-    item->value_size      = val_size;
-    item->value           = val_size ? (char*)malloc(val_size) : NULL;
-    if (val) memcpy(item->value, val, val_size);
+    uint64_t key_size = key ? strlen(key) + 1 : 0;
+    uint64_t vsize    = val_size;
+    int      ret
+        = reserve(iter, 1, ENTRY_HEADER_SIZE + (size_t)key_size + val_size);
+    MOBJECT_ASSERT(ret == 0, "Could not allocate omap iterator");
+
+    char* p                          = iter->data + iter->data_size;
+    iter->offsets[iter->num_items++] = iter->data_size;
+    memcpy(p, &key_size, sizeof(key_size));
+    p += sizeof(key_size);
+    if (key_size) memcpy(p, key, key_size);
+    p += key_size;
+    memcpy(p, &vsize, sizeof(vsize));
+    p += sizeof(vsize);
+    if (val_size) {
+        if (val)
+            memcpy(p, val, val_size);
+        else
+            memset(p, 0, val_size);
+    }
+    iter->data_size += ENTRY_HEADER_SIZE + key_size + val_size;
+}
+
+void omap_iter_get(mobject_store_omap_iter_t iter,
+                   size_t                    i,
+                   char**                    key,
+                   char**                    val,
+                   size_t*                   val_size)
+{
+    char*    p = iter->data + iter->offsets[i];
+    uint64_t s;
+
+    memcpy(&s, p, sizeof(s));
+    p += sizeof(s);
+    *key = s ? p : NULL;
+    p += s;
+    memcpy(&s, p, sizeof(s));
+    p += sizeof(s);
+    *val      = s ? p : NULL;
+    *val_size = s;
+}
 
-    DL_APPEND(iter->head, item);
+size_t omap_iter_packed_size(mobject_store_omap_iter_t iter)
+{
+    return iter->data_size;
+}
 
-    if (iter->current == NULL) iter->current = iter->head;
+size_t omap_iter_pack(mobject_store_omap_iter_t iter,
+                      char*                     buf,
+                      size_t                    size,
+                      size_t*                   count)
+{
+    size_t n = 0, used;
+
+    // entries are contiguous: find the first one ending after size
+    while (n < iter->num_items) {
+        size_t end
+            = n + 1 < iter->num_items ? iter->offsets[n + 1] : iter->data_size;
+        if (end > size) break;
+        n += 1;
+    }
+    used = n < iter->num_items ? iter->offsets[n] : iter->data_size;
+    if (used) memcpy(buf, iter->data, used);
+    *count = n;
+    return used;
+}
+
+int omap_iter_unpack(mobject_store_omap_iter_t iter,
+                     const char*               buf,
+                     size_t                    size,
+                     size_t                    count)
+{
+    size_t offset = 0, i, s;
+
+    if (reserve(iter, count, size) != 0) return -1;
+    for (i = 0; i < count; i++) {
+        s = entry_size(buf, size, offset);
+        if (s == 0) return -1;
+        iter->offsets[iter->num_items + i] = iter->data_size + offset;
+        offset += s;
+    }
+    if (offset != size) return -1;
 
-    iter->num_items += 1;
+    if (size) memcpy(iter->data + iter->data_size, buf, size);
+    iter->data_size += size;
+    iter->num_items += count;
+    return 0;
 }
@@ -12,21 +12,26 @@
 extern "C" {
 #endif
 
-typedef struct omap_iter_node* omap_iter_node_t;
-
-struct omap_iter_node {
-    char*            key;
-    char*            value;
-    size_t           key_size;
-    size_t           value_size;
-    omap_iter_node_t prev, next;
-};
-
+/**
+ * The entries of an iterator are stored one after the other in a single
+ * buffer (data), in the layout of omap_iter_pack: the size of the key
+ * (including its null byte, 0 if there is no key) on 8 bytes, the key,
+ * the size of the value on 8 bytes, and the value. offsets gives the
+ * position of each entry in data, so that mobject_store_omap_get_next
+ * returns pointers into data without allocating anything, and so that
+ * entries are encoded, decoded and pushed over bulk with a single copy.
+ * Both arrays grow geometrically as entries are appended.
+ */
 struct mobject_store_omap_iter {
-    size_t           num_items;
-    size_t           ref_count;
-    omap_iter_node_t head;
-    omap_iter_node_t current;
+    size_t  num_items;
+    size_t  ref_count;
+    size_t  current;       // index of the next entry to return
+    uint8_t more;          // entries remain after those of the iterator
+    size_t* offsets;       // position of each entry in data
+    size_t  offsets_capacity;
+    char*   data;          // packed entries
+    size_t  data_size;     // bytes of data used by the entries
+    size_t  data_capacity;
 };
 
 void omap_iter_create(mobject_store_omap_iter_t* iter);
@@ -40,6 +45,43 @@ void omap_iter_append(mobject_store_omap_iter_t iter,
                       const char*               val,
                       size_t                    val_size);
 
+/**
+ * Sets key (NULL if the entry has no key), val and val_size to the i-th
+ * entry of iter. The pointers remain valid until an entry is appended
+ * or the iterator is freed.
+ */
+void omap_iter_get(mobject_store_omap_iter_t iter,
+                   size_t                    i,
+                   char**                    key,
+                   char**                    val,
+                   size_t*                   val_size);
+
+/**
+ * Returns the number of bytes needed to pack all the entries of iter
+ * with omap_iter_pack.
+ */
+size_t omap_iter_packed_size(mobject_store_omap_iter_t iter);
+
+/**
+ * Copies the first entries of iter into the size bytes of buf, stopping
+ * at the first entry that does not fit. Returns the number of bytes used
+ * and sets *count to the number of entries packed.
+ */
+size_t omap_iter_pack(mobject_store_omap_iter_t iter,
+                      char*                     buf,
+                      size_t                    size,
+                      size_t*                   count);
+
+/**
+ * Appends to iter the count entries packed by omap_iter_pack in the size
+ * bytes of buf. Returns 0 on success, -1 if buf is not a valid packing
+ * (in which case iter is left unchanged).
+ */
+int omap_iter_unpack(mobject_store_omap_iter_t iter,
+                     const char*               buf,
+                     size_t                    size,
+                     size_t                    count);
+
 #ifdef __cplusplus
 }
 #endif
@@ -7,80 +7,48 @@
 #include <stdlib.h>
 #include <margo.h>
 #include "src/omap-iter/proc-omap-iter.h"
-#include "src/util/utlist.h"
 
+/**
+ * An iterator is encoded as its number of entries and the size of its
+ * packed entries, followed by the packed entries (see omap-iter-impl.h),
+ * which are decoded with a single copy into the buffer of the new
+ * iterator.
+ */
 hg_return_t hg_proc_mobject_store_omap_iter_t(hg_proc_t                  proc,
                                               mobject_store_omap_iter_t* iter)
 {
-    omap_iter_node_t node;
-    hg_return_t      ret = HG_SUCCESS;
+    hg_return_t ret = HG_SUCCESS;
+    hg_size_t   num_items, data_size;
+    void*       data;
 
     switch (hg_proc_get_op(proc)) {
 
     case HG_ENCODE:
 
-        if (*iter == NULL) {
-            hg_size_t s = 0;
-            ret         = hg_proc_hg_size_t(proc, &s);
-            if (ret != HG_SUCCESS) return ret;
-            break;
-        }
-
-        ret = hg_proc_hg_size_t(proc, &((*iter)->num_items));
+        num_items = *iter ? (*iter)->num_items : 0;
+        data_size = *iter ? (*iter)->data_size : 0;
+        ret       = hg_proc_hg_size_t(proc, &num_items);
         if (ret != HG_SUCCESS) return ret;
-
-        DL_FOREACH((*iter)->head, node)
-        {
-            ret = hg_proc_hg_size_t(proc, &(node->key_size));
-            if (ret != HG_SUCCESS) return ret;
-            if (node->key_size) {
-                ret = hg_proc_memcpy(proc, node->key, node->key_size);
-                if (ret != HG_SUCCESS) return ret;
-            }
-            ret = hg_proc_hg_size_t(proc, &(node->value_size));
-            if (ret != HG_SUCCESS) return ret;
-            if (node->value_size) {
-                ret = hg_proc_memcpy(proc, node->value, node->value_size);
-                if (ret != HG_SUCCESS) return ret;
-            }
-        }
-
-        break;
+        ret = hg_proc_hg_size_t(proc, &data_size);
+        if (ret != HG_SUCCESS) return ret;
+        if (data_size) ret = hg_proc_memcpy(proc, (*iter)->data, data_size);
+        return ret;
 
     case HG_DECODE:
 
         omap_iter_create(iter);
-        size_t num_items = 0;
-        ret              = hg_proc_hg_size_t(proc, &num_items);
+        ret = hg_proc_hg_size_t(proc, &num_items);
         if (ret != HG_SUCCESS) return ret;
-
-        unsigned i;
-        size_t   key_size, val_size;
-        char*    key;
-        char*    val;
-        for (i = 0; i < num_items; i++) {
-            ret = hg_proc_hg_size_t(proc, &key_size);
-            if (key_size != 0) {
-                key = (char*)calloc(1, key_size);
-                ret = hg_proc_memcpy(proc, key, key_size);
-                if (ret != HG_SUCCESS) return ret;
-            } else {
-                key = NULL;
-            }
-            ret = hg_proc_hg_size_t(proc, &val_size);
-            if (ret != HG_SUCCESS) return ret;
-            if (val_size != 0) {
-                val = (char*)calloc(1, val_size);
-                ret = hg_proc_memcpy(proc, val, val_size);
-            } else {
-                val = NULL;
-            }
-            omap_iter_append(*iter, key, val, val_size);
-            if (key) free(key);
-            if (val) free(val);
-        }
-
-        break;
+        ret = hg_proc_hg_size_t(proc, &data_size);
+        if (ret != HG_SUCCESS) return ret;
+        if (data_size == 0)
+            return num_items == 0 ? HG_SUCCESS : HG_PROTOCOL_ERROR;
+        data = hg_proc_save_ptr(proc, data_size);
+        if (data == NULL) return HG_OVERFLOW;
+        if (omap_iter_unpack(*iter, (const char*)data, data_size, num_items)
+            != 0)
+            return HG_PROTOCOL_ERROR;
+        return hg_proc_restore_ptr(proc, data, data_size);
 
     case HG_FREE:
 
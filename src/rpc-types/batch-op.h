@@ -0,0 +1,30 @@
+/*
+ * (C) 2018 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __RPC_TYPE_BATCH_OP_H
+#define __RPC_TYPE_BATCH_OP_H
+
+#include <mercury.h>
+#include <mercury_macros.h>
+#include <mercury_proc_string.h>
+#include <libmobject-store.h>
+#include "src/io-chain/proc-batch.h"
+
+MERCURY_GEN_PROC(write_op_batch_in_t,
+                 ((hg_const_string_t)(client_addr))(
+                     (hg_const_string_t)(pool_name))((int32_t)(flags))(
+                     (hg_bulk_t)(bulk_handle))((write_op_batch_t)(batch)))
+
+MERCURY_GEN_PROC(write_op_batch_out_t, ((write_result_batch_t)(results)))
+
+MERCURY_GEN_PROC(read_op_batch_in_t,
+                 ((hg_const_string_t)(client_addr))(
+                     (hg_const_string_t)(pool_name))((int32_t)(flags))(
+                     (hg_bulk_t)(bulk_handle))((read_op_batch_t)(batch)))
+
+MERCURY_GEN_PROC(read_op_batch_out_t,
+                 ((read_result_batch_t)(results))((uint32_t)(lease_ms)))
+
+#endif
@@ -0,0 +1,20 @@
+/*
+ * (C) 2018 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __RPC_TYPE_OBJECT_VERSION_H
+#define __RPC_TYPE_OBJECT_VERSION_H
+
+#include <mercury.h>
+#include <mercury_macros.h>
+#include <mercury_proc_string.h>
+
+MERCURY_GEN_PROC(object_version_in_t,
+                 ((hg_const_string_t)(pool_name))(
+                     (hg_const_string_t)(object_name)))
+
+MERCURY_GEN_PROC(object_version_out_t,
+                 ((uint64_t)(version))((uint32_t)(lease_ms)))
+
+#endif
@@ -14,11 +14,38 @@
 #include "src/io-chain/proc-read-actions.h"
 #include "src/io-chain/proc-read-responses.h"
 
-MERCURY_GEN_PROC(
-    read_op_in_t,
-    ((hg_const_string_t)(client_addr))((hg_const_string_t)(pool_name))(
-        (hg_const_string_t)(object_name))((mobject_store_read_op_t)(read_op)))
+/* the read_op is encoded in wire_format (see wire-format.h), which is
+ * why this input is not generated by MERCURY_GEN_PROC */
+typedef struct {
+    hg_const_string_t       client_addr;
+    hg_const_string_t       pool_name;
+    hg_const_string_t       object_name;
+    int32_t                 flags;
+    uint8_t                 wire_format;
+    mobject_store_read_op_t read_op;
+} read_op_in_t;
 
-MERCURY_GEN_PROC(read_op_out_t, ((read_response_t)(responses)))
+static inline hg_return_t hg_proc_read_op_in_t(hg_proc_t proc, void* data)
+{
+    read_op_in_t* in = (read_op_in_t*)data;
+    hg_return_t   ret;
+
+    ret = hg_proc_hg_const_string_t(proc, &in->client_addr);
+    if (ret != HG_SUCCESS) return ret;
+    ret = hg_proc_hg_const_string_t(proc, &in->pool_name);
+    if (ret != HG_SUCCESS) return ret;
+    ret = hg_proc_hg_const_string_t(proc, &in->object_name);
+    if (ret != HG_SUCCESS) return ret;
+    ret = hg_proc_int32_t(proc, &in->flags);
+    if (ret != HG_SUCCESS) return ret;
+    ret = hg_proc_uint8_t(proc, &in->wire_format);
+    if (ret != HG_SUCCESS) return ret;
+    return hg_proc_mobject_store_read_op_t(proc, &in->read_op,
+                                           in->wire_format);
+}
+
+MERCURY_GEN_PROC(read_op_out_t,
+                 ((read_response_t)(responses))((uint64_t)(version))(
+                     (uint32_t)(lease_ms)))
 
 #endif
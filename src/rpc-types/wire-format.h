@@ -0,0 +1,16 @@
+/*
+ * (C) 2018 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __RPC_TYPE_WIRE_FORMAT_H
+#define __RPC_TYPE_WIRE_FORMAT_H
+
+#include <mercury.h>
+#include <mercury_macros.h>
+
+/* the provider answers with the most recent wire format it can decode
+ * (see src/io-chain/wire-format.h) */
+MERCURY_GEN_PROC(wire_format_out_t, ((uint8_t)(wire_format)))
+
+#endif
@@ -11,14 +11,50 @@
 #include <mercury_proc_string.h>
 #include <libmobject-store.h>
 #include "src/io-chain/proc-write-actions.h"
+#include "src/io-chain/write-results.h"
 #include "src/io-chain/proc-read-actions.h"
 #include "src/io-chain/proc-read-responses.h"
 
-MERCURY_GEN_PROC(
-    write_op_in_t,
-    ((hg_const_string_t)(client_addr))((hg_const_string_t)(pool_name))(
-        (hg_const_string_t)(object_name))((mobject_store_write_op_t)(write_op)))
+/* the write_op is encoded in wire_format (see wire-format.h), which is
+ * why this input is not generated by MERCURY_GEN_PROC */
+typedef struct {
+    hg_const_string_t        client_addr;
+    hg_const_string_t        pool_name;
+    hg_const_string_t        object_name;
+    int32_t                  flags;
+    uint8_t                  wire_format;
+    mobject_store_write_op_t write_op;
+} write_op_in_t;
 
-MERCURY_GEN_PROC(write_op_out_t, ((int32_t)(ret)))
+static inline hg_return_t hg_proc_write_op_in_t(hg_proc_t proc, void* data)
+{
+    write_op_in_t* in = (write_op_in_t*)data;
+    hg_return_t    ret;
+
+    ret = hg_proc_hg_const_string_t(proc, &in->client_addr);
+    if (ret != HG_SUCCESS) return ret;
+    ret = hg_proc_hg_const_string_t(proc, &in->pool_name);
+    if (ret != HG_SUCCESS) return ret;
+    ret = hg_proc_hg_const_string_t(proc, &in->object_name);
+    if (ret != HG_SUCCESS) return ret;
+    ret = hg_proc_int32_t(proc, &in->flags);
+    if (ret != HG_SUCCESS) return ret;
+    ret = hg_proc_uint8_t(proc, &in->wire_format);
+    if (ret != HG_SUCCESS) return ret;
+    return hg_proc_mobject_store_write_op_t(proc, &in->write_op,
+                                            in->wire_format);
+}
+
+/* persist_seq is non-zero if the write_op was acknowledged before its data
+ * was persisted, in which case mobject_persist_wait(persist_seq) returns
+ * once it is; results holds the results of its omap_add and omap_cmpxchg
+ * actions (see write-results.h) */
+MERCURY_GEN_PROC(write_op_out_t,
+                 ((int32_t)(ret))((uint64_t)(persist_seq))(
+                     (write_results_t)(results)))
+
+MERCURY_GEN_PROC(persist_wait_in_t, ((uint64_t)(persist_seq)))
+
+MERCURY_GEN_PROC(persist_wait_out_t, ((int32_t)(ret)))
 
 #endif
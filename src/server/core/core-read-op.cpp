@@ -10,13 +10,17 @@
 #include <vector>
 #include <list>
 #include <cinttypes>
+#include <cerrno>
 #include <bake-client.h>
 #include "src/server/core/core-read-op.h"
 #include "src/server/visitor-args.h"
+#include "src/server/object-locks.h"
+#include "src/server/region-compression.h"
 #include "src/io-chain/read-op-visitor.h"
 #include "src/io-chain/read-resp-impl.h"
 #include "src/omap-iter/omap-iter-impl.h"
 #include "src/server/core/key-types.h"
+#include "src/server/core/key-encoding.h"
 #include "src/server/core/covermap.hpp"
 
 #define ENTERING margo_trace(mid, "[mobject] Entering function %s", __func__);
@@ -26,11 +30,12 @@ static void read_op_exec_begin(void*);
 static void read_op_exec_stat(void*, uint64_t*, time_t*, int*);
 static void read_op_exec_read(void*, uint64_t, size_t, buffer_u, size_t*, int*);
 static void read_op_exec_omap_get_keys(
-    void*, const char*, uint64_t, mobject_store_omap_iter_t*, int*);
+    void*, const char*, uint64_t, size_t, mobject_store_omap_iter_t*, int*);
 static void read_op_exec_omap_get_vals(void*,
                                        const char*,
                                        const char*,
                                        uint64_t,
+                                       size_t,
                                        mobject_store_omap_iter_t*,
                                        int*);
 static void read_op_exec_omap_get_vals_by_keys(
@@ -38,6 +43,15 @@ static void read_op_exec_omap_get_vals_by_keys(
 static void read_op_exec_end(void*);
 
 /* defined in core-write-op.cpp */
+extern int mobject_decode_region(struct mobject_provider* provider,
+                                 const void*              value,
+                                 size_t                   size,
+                                 bake_provider_handle_t*  bake_ph,
+                                 region_descriptor_t*     region,
+                                 region_compression_t*    comp,
+                                 uint8_t*                 digest,
+                                 int*                     has_digest);
+
 extern uint64_t mobject_compute_object_size(struct mobject_provider* provider,
                                             yk_database_handle_t     seg_dbh,
                                             oid_t                    oid,
@@ -47,6 +61,12 @@ static oid_t get_oid_from_name(margo_instance_id    mid,
                                yk_database_handle_t name_dbh,
                                const char*          name);
 
+static int read_compressed_region(server_visitor_args_t       vargs,
+                                  bake_provider_handle_t      bake_ph,
+                                  const region_descriptor_t*  region,
+                                  const region_compression_t* comp,
+                                  std::vector<char>&          data);
+
 static struct read_op_visitor read_op_exec
     = {.visit_begin                 = read_op_exec_begin,
        .visit_stat                  = read_op_exec_stat,
@@ -75,6 +95,10 @@ void read_op_exec_begin(void* u)
         oid        = get_oid_from_name(mid, name_dbh, object_name);
         vargs->oid = oid;
     }
+    if (oid != 0 && vargs->lock_mode != MOBJECT_LOCK_NONE) {
+        mobject_object_lock(vargs->provider, oid, vargs->lock_mode);
+        vargs->locked = 1;
+    }
     LEAVING
 }
 
@@ -129,17 +153,22 @@ void read_op_exec_read(void*    u,
     }
 
     segment_key_t lb;
+    memset(&lb, 0, sizeof(lb));
     lb.oid       = oid;
     lb.timestamp = time(NULL);
     lb.seq_id    = MOBJECT_SEQ_ID_MAX;
+    char   lb_key[MAX_SEGMENT_KEY_SIZE];
+    char   oid_key[OID_KEY_SIZE];
+    size_t lb_size = encode_segment_key(lb_key, &lb);
+    encode_oid_key(oid_key, oid);
 
     covermap<uint64_t> coverage(offset, offset + len);
 
-    size_t        max_segments = 128; // XXX this is a pretty arbitrary number
-    segment_key_t segment_keys[max_segments];
-    hg_size_t     segment_keys_size[max_segments];
-    region_descriptor_t segment_data[max_segments];
-    hg_size_t           segment_data_size[max_segments];
+    size_t    max_segments = 128; // XXX this is a pretty arbitrary number
+    char      segment_keys[max_segments * MAX_SEGMENT_KEY_SIZE];
+    hg_size_t segment_keys_size[max_segments];
+    char      segment_data[max_segments * MAX_SEGMENT_VALUE_SIZE];
+    hg_size_t segment_data_size[max_segments];
 
     bool done          = false;
     int  seg_start_ndx = 0;
@@ -147,16 +176,16 @@ void read_op_exec_read(void*    u,
     while (!coverage.full() && !done) {
 
         yret = yk_list_keyvals_packed(
-            seg_dbh, YOKAN_MODE_DEFAULT, (const void*)&lb,
-            sizeof(lb),                                 /* strict lower bound */
-            (const void*)&oid, sizeof(oid),             /* prefix */
-            max_segments,                               /* count */
-            segment_keys,                               /* keys buffer */
-            max_segments * sizeof(segment_key_t),       /* keys buffer size */
-            segment_keys_size,                          /* key sizes */
-            segment_data,                               /* data buffer */
-            max_segments * sizeof(region_descriptor_t), /* data buffer size */
-            segment_data_size);                         /* data sizes */
+            seg_dbh, YOKAN_MODE_DEFAULT, lb_key,
+            lb_size,                                /* strict lower bound */
+            oid_key, OID_KEY_SIZE,                  /* prefix */
+            max_segments,                           /* count */
+            segment_keys,                           /* keys buffer */
+            max_segments * MAX_SEGMENT_KEY_SIZE,    /* keys buffer size */
+            segment_keys_size,                      /* key sizes */
+            segment_data,                           /* data buffer */
+            max_segments * MAX_SEGMENT_VALUE_SIZE,  /* data buffer size */
+            segment_data_size);                     /* data sizes */
 
         if (yret != YOKAN_SUCCESS) {
             margo_error(mid,
@@ -167,14 +196,25 @@ void read_op_exec_read(void*    u,
             return;
         }
 
-        size_t i;
+        size_t      i;
+        const char* seg_key = segment_keys;
+        const char* seg_val = segment_data;
         for (i = seg_start_ndx; i < max_segments; i++) {
 
-            const segment_key_t&       seg    = segment_keys[i];
-            const region_descriptor_t& region = segment_data[i];
+            segment_key_t seg;
 
-            if (segment_keys_size[i] == YOKAN_NO_MORE_KEYS || seg.oid != oid
-                || coverage.full()) {
+            if (segment_keys_size[i] == YOKAN_NO_MORE_KEYS) {
+                done = true;
+                break;
+            }
+            if (decode_segment_key(seg_key, segment_keys_size[i], &seg) != 0) {
+                *prval = -1;
+                margo_error(mid, "[mobject] %s:%d: invalid segment key",
+                            __func__, __LINE__);
+                LEAVING;
+                return;
+            }
+            if (seg.oid != oid || coverage.full()) {
                 done = true;
                 break;
             }
@@ -190,27 +230,74 @@ void read_op_exec_read(void*    u,
                 break;
 
             case seg_type_t::BAKE_REGION: {
-                // find the bake provider handle associated with the target
-                bake_provider_handle_t bake_ph = BAKE_PROVIDER_HANDLE_NULL;
-                for (unsigned j = 0; j < vargs->provider->num_bake_targets;
-                     j++) {
-                    if (memcmp(&region.tid,
-                               &vargs->provider->bake_targets[j].tid,
-                               sizeof(bake_target_id_t))
-                        == 0) {
-                        bake_ph = vargs->provider->bake_targets[j].ph;
-                        break;
-                    }
-                }
-                if (!bake_ph) {
-                    margo_error(mid,
-                                "[mobject] %s:%d: could not find bake provider "
-                                "handle associated with stored target id",
-                                __func__, __LINE__);
+                bake_provider_handle_t bake_ph;
+                region_descriptor_t    region;
+                region_compression_t   comp;
+                if (mobject_decode_region(vargs->provider, seg_val,
+                                          segment_data_size[i], &bake_ph,
+                                          &region, &comp, nullptr, nullptr)
+                    != 0) {
+                    *prval = -1;
                     LEAVING;
                     return;
                 }
                 auto ranges = coverage.set(seg.start_index, seg.end_index);
+                if (comp.codec != REGION_CODEC_NONE && !ranges.empty()) {
+                    // the region is decompressed as a whole, and the parts
+                    // of it that are read pushed from the server's memory
+                    std::vector<char> data;
+                    if (read_compressed_region(vargs, bake_ph, &region, &comp,
+                                               data)
+                        != 0) {
+                        *prval = -1;
+                        LEAVING;
+                        return;
+                    }
+                    void*     buf_ptrs[1]  = {(void*)data.data()};
+                    hg_size_t buf_sizes[1] = {data.size()};
+                    hg_bulk_t handle;
+                    int ret = margo_bulk_create(mid, 1, buf_ptrs, buf_sizes,
+                                                HG_BULK_READ_ONLY, &handle);
+                    if (ret != HG_SUCCESS) {
+                        margo_error(
+                            mid,
+                            "[mobject] %s:%d: margo_bulk_create returned %d",
+                            __func__, __LINE__, ret);
+                        *prval = -1;
+                        LEAVING;
+                        return;
+                    }
+                    for (auto r : ranges) {
+                        uint64_t region_offset = r.start - seg.start_index;
+                        uint64_t remote_offset = r.start - offset;
+                        if (r.end - seg.start_index > data.size()) {
+                            ret = -1;
+                            margo_error(mid,
+                                        "[mobject] %s:%d: segment larger than "
+                                        "its decompressed region",
+                                        __func__, __LINE__);
+                            break;
+                        }
+                        ret = margo_bulk_transfer(
+                            mid, HG_BULK_PUSH, remote_addr, remote_bulk,
+                            buf.as_offset + remote_offset, handle,
+                            region_offset, r.end - r.start);
+                        if (ret != HG_SUCCESS) {
+                            margo_error(mid,
+                                        "[mobject] %s:%d: margo_bulk_transfer "
+                                        "returned %d",
+                                        __func__, __LINE__, ret);
+                            break;
+                        }
+                    }
+                    margo_bulk_free(handle);
+                    if (ret != HG_SUCCESS) {
+                        *prval = -1;
+                        LEAVING;
+                        return;
+                    }
+                    break;
+                }
                 for (auto r : ranges) {
                     uint64_t segment_size  = r.end - r.start;
                     uint64_t region_offset = r.start - seg.start_index;
@@ -247,7 +334,7 @@ void read_op_exec_read(void*    u,
 
             case seg_type_t::SMALL_REGION: {
                 auto ranges      = coverage.set(seg.start_index, seg.end_index);
-                const char* base = static_cast<const char*>((void*)(&region));
+                const char* base = seg_val;
                 margo_instance_id mid = vargs->provider->mid;
                 for (auto r : ranges) {
                     uint64_t segment_size  = r.end - r.start;
@@ -293,27 +380,57 @@ void read_op_exec_read(void*    u,
             }         // end case seg_type_t::SMALL_REGION
 
             } // end switch
-            // update the start key timestamp to that of the last processed
-            // segment
-            lb.timestamp = seg.timestamp;
-            lb.seq_id    = seg.seq_id;
+            // continue after the last processed segment
+            memcpy(lb_key, seg_key, segment_keys_size[i]);
+            lb_size = segment_keys_size[i];
+            seg_key += segment_keys_size[i];
+            seg_val += segment_data_size[i];
         } // end for
     }
     *bytes_read = coverage.bytes_read();
     LEAVING;
 }
 
+/* Number of entries to request in the next page of an omap listing: as
+ * many as fit in a buffer of buf_size bytes if entries keep the average
+ * size observed so far (entry_size), and no more than remaining. */
+static size_t
+omap_page_count(size_t buf_size, size_t entry_size, uint64_t remaining)
+{
+    size_t n = buf_size / std::max(entry_size, (size_t)1);
+    if (n == 0) n = 1;
+    if (n > remaining) n = remaining;
+    return n;
+}
+
+/* Tells whether the omap database has keys with the given prefix after
+ * the lower bound lb, without fetching them (the one-byte buffer is
+ * enough for Yokan to report that a key exists) */
+static bool omap_has_more(yk_database_handle_t dbh,
+                          const char*          lb,
+                          size_t               lb_size,
+                          const char*          prefix,
+                          size_t               prefix_size)
+{
+    char        key;
+    hg_size_t   ksize = 0;
+    yk_return_t yret  = yk_list_keys_packed(dbh, YOKAN_MODE_DEFAULT, lb,
+                                            lb_size, prefix, prefix_size, 1,
+                                            &key, sizeof(key), &ksize);
+    return yret == YOKAN_SUCCESS && ksize != YOKAN_NO_MORE_KEYS;
+}
+
 void read_op_exec_omap_get_keys(void*                      u,
                                 const char*                start_after,
                                 uint64_t                   max_return,
+                                size_t                     max_bytes,
                                 mobject_store_omap_iter_t* iter,
                                 int*                       prval)
 {
     auto              vargs = static_cast<server_visitor_args_t>(u);
     margo_instance_id mid   = vargs->provider->mid;
     ENTERING;
-    const char*          object_name = vargs->object_name;
-    yk_database_handle_t omap_dbh    = vargs->provider->omap_dbh;
+    yk_database_handle_t omap_dbh = vargs->provider->omap_dbh;
     yk_return_t          yret;
     *prval = 0;
 
@@ -326,56 +443,73 @@ void read_op_exec_omap_get_keys(void*                      u,
     }
 
     omap_iter_create(iter);
-    size_t      lb_size = sizeof(omap_key_t) + MAX_OMAP_KEY_SIZE;
-    omap_key_t* lb      = (omap_key_t*)calloc(1, lb_size);
-    lb->oid             = oid;
-    strcpy(lb->key, start_after);
-
-    hg_size_t max_keys = 10;
-    hg_size_t key_len  = MAX_OMAP_KEY_SIZE + sizeof(omap_key_t);
-    // std::vector<void*>     keys(max_keys);
-    std::vector<hg_size_t> ksizes(max_keys, key_len);
-    // std::vector<std::vector<char>> buffers(max_keys,
-    //                                       std::vector<char>(key_len));
-    // for (auto i = 0; i < max_keys; i++) keys[i] = (void*)buffers[i].data();
-    std::vector<char> keys(max_keys * key_len);
-
-    hg_size_t keys_retrieved = max_keys;
-    hg_size_t count          = 0;
-    do {
-        yret
-            = yk_list_keys_packed(omap_dbh, YOKAN_MODE_DEFAULT, (const void*)lb,
-                                  lb_size, /* strict lower bound */
-                                  (const void*)&oid, sizeof(oid), /* prefix */
-                                  max_keys,                       /* count */
-                                  keys.data(),    /* keys buffer */
-                                  keys.size(),    /* buffer size */
-                                  ksizes.data()); /* key sizes */
+    if (!omap_key_valid(start_after)) {
+        *prval = -EINVAL;
+        LEAVING;
+        return;
+    }
+    size_t            start_len = strlen(start_after);
+    std::vector<char> lb(omap_key_size(start_len));
+    size_t lb_size = encode_omap_key(lb.data(), oid, start_after, start_len);
+    char   oid_key[OID_KEY_SIZE];
+    encode_oid_key(oid_key, oid);
+
+    // keys are listed in pages of at most omap_page_size bytes, the number
+    // of keys requested per page following their average size, until they
+    // exceed what the client can receive (max_bytes)
+    std::vector<char>      keys(vargs->provider->omap_page_size);
+    std::vector<hg_size_t> ksizes;
+    size_t                 key_size = omap_key_size(16); // initial guess
+    uint64_t               count    = 0;
+    size_t                 packed   = 0; // size of the results once packed
+    bool                   done     = false;
+
+    while (!done && count < max_return && (!max_bytes || packed <= max_bytes)) {
+        size_t n = omap_page_count(keys.size(), key_size, max_return - count);
+        ksizes.assign(n, 0);
+        yret = yk_list_keys_packed(omap_dbh, YOKAN_MODE_DEFAULT, lb.data(),
+                                   lb_size,               /* lower bound */
+                                   oid_key, OID_KEY_SIZE, /* prefix */
+                                   n,                     /* count */
+                                   keys.data(),           /* keys buffer */
+                                   keys.size(),           /* buffer size */
+                                   ksizes.data());        /* key sizes */
         if (yret != YOKAN_SUCCESS) {
             *prval = -1;
             margo_error(mid, "[mobject] %s:%d: yk_list_keys_packed returned %d",
                         __func__, __LINE__, yret);
             break;
         }
-        const char* k          = NULL;
-        keys_retrieved         = 0;
-        size_t keys_buf_offset = 0;
-        for (auto i = 0; i < max_keys && count < max_return;
-             i++, count++, keys_retrieved++) {
-            if (ksizes[i] == YOKAN_NO_MORE_KEYS) break;
+        const char* k     = NULL;
+        size_t      k_len = 0;
+        size_t      used  = 0;
+        size_t      i;
+        for (i = 0; i < n; i++) {
+            if (ksizes[i] == YOKAN_NO_MORE_KEYS) {
+                done = true;
+                break;
+            }
+            if (ksizes[i] > YOKAN_LAST_VALID_SIZE) break; // buffer full
             // extract the actual key part, without the oid
-            k = ((omap_key_t*)(keys.data() + keys_buf_offset))->key;
-            omap_iter_append(*iter, k, nullptr, 0);
-            keys_buf_offset += ksizes[i];
+            decode_omap_key(keys.data() + used, ksizes[i], &k, &k_len);
+            omap_iter_append(*iter, std::string(k, k_len).c_str(), nullptr, 0);
+            used += ksizes[i];
+            packed += 2 * sizeof(uint64_t) + k_len + 1;
         }
-        if (k != NULL) {
-            strcpy(lb->key, k);
-            lb_size = strlen(k) + sizeof(omap_key_t);
+        count += i;
+        if (i == 0) {
+            // the next key does not fit in the buffer
+            if (!done) keys.resize(keys.size() * 2);
+            continue;
         }
-    } while (keys_retrieved == max_keys && count < max_return);
+        key_size = used / i;
+        lb.resize(omap_key_size(k_len));
+        lb_size = encode_omap_key(lb.data(), oid, k, k_len);
+    }
+    if (*prval == 0 && !done)
+        (*iter)->more = omap_has_more(omap_dbh, lb.data(), lb_size, oid_key,
+                                      OID_KEY_SIZE);
 
-out:
-    free(lb);
     LEAVING;
 }
 
@@ -383,14 +517,14 @@ void read_op_exec_omap_get_vals(void*                      u,
                                 const char*                start_after,
                                 const char*                filter_prefix,
                                 uint64_t                   max_return,
+                                size_t                     max_bytes,
                                 mobject_store_omap_iter_t* iter,
                                 int*                       prval)
 {
     auto              vargs = static_cast<server_visitor_args_t>(u);
     margo_instance_id mid   = vargs->provider->mid;
     ENTERING;
-    const char*          object_name = vargs->object_name;
-    yk_database_handle_t omap_dbh    = vargs->provider->omap_dbh;
+    yk_database_handle_t omap_dbh = vargs->provider->omap_dbh;
     yk_return_t          yret;
     *prval = 0;
 
@@ -402,85 +536,100 @@ void read_op_exec_omap_get_vals(void*                      u,
         return;
     }
 
-    hg_size_t max_items = std::min(max_return, (decltype(max_return))10);
-    hg_size_t key_len   = MAX_OMAP_KEY_SIZE + sizeof(omap_key_t);
-    hg_size_t val_len   = MAX_OMAP_VAL_SIZE;
-
     omap_iter_create(iter);
-
-    /* omap_key_t equivalent of start_key */
-    hg_size_t   lb_size = key_len;
-    omap_key_t* lb      = (omap_key_t*)calloc(1, lb_size);
-    lb->oid             = oid;
-    strcpy(lb->key, start_after);
-
-    /* omap_key_t equivalent of the filter_prefix */
-    hg_size_t   prefix_size = sizeof(omap_key_t) + strlen(filter_prefix);
-    omap_key_t* prefix      = (omap_key_t*)calloc(1, prefix_size);
-    prefix->oid             = oid;
-    strcpy(prefix->key, filter_prefix);
-    hg_size_t prefix_actual_size
-        = offsetof(omap_key_t, key) + strlen(filter_prefix);
-    /* we need the above because the prefix in sdskv is not considered a string
-     */
-
-    /* initialize structures to pass to SDSKV functions */
-    std::vector<void*>             keys(max_items);
-    std::vector<void*>             vals(max_items);
-    std::vector<hg_size_t>         ksizes(max_items, key_len);
-    std::vector<hg_size_t>         vsizes(max_items, val_len);
-    std::vector<std::vector<char>> key_buffers(max_items,
-                                               std::vector<char>(key_len));
-    std::vector<std::vector<char>> val_buffers(max_items,
-                                               std::vector<char>(val_len));
-    for (auto i = 0; i < max_items; i++) {
-        keys[i] = (void*)key_buffers[i].data();
-        vals[i] = (void*)val_buffers[i].data();
+    if (!omap_key_valid(start_after) || !omap_key_valid(filter_prefix)) {
+        *prval = -EINVAL;
+        LEAVING;
+        return;
     }
 
-    size_t items_retrieved = 0;
-    size_t count           = 0;
-    do {
-        yret = yk_list_keyvals(omap_dbh, YOKAN_MODE_DEFAULT, (const void*)lb,
-                               lb_size, /* strict lower bound */
-                               (const void*)prefix,
-                               prefix_actual_size,          /* prefix */
-                               max_items,                   /* count */
-                               keys.data(), ksizes.data(),  /* keys */
-                               vals.data(), vsizes.data()); /* values */
-
+    /* encoded equivalent of start_key */
+    size_t            start_len = strlen(start_after);
+    std::vector<char> lb(omap_key_size(start_len));
+    size_t lb_size = encode_omap_key(lb.data(), oid, start_after, start_len);
+
+    /* encoded equivalent of the filter_prefix */
+    size_t            filter_len = strlen(filter_prefix);
+    std::vector<char> prefix(omap_key_size(filter_len));
+    size_t            prefix_size
+        = encode_omap_key(prefix.data(), oid, filter_prefix, filter_len);
+
+    /* keys and values are listed in pages of at most omap_page_size bytes
+     * each, the number of items requested per page following their
+     * average size, until they exceed what the client can receive
+     * (max_bytes) */
+    std::vector<char>      keys(vargs->provider->omap_page_size);
+    std::vector<char>      vals(vargs->provider->omap_page_size);
+    std::vector<hg_size_t> ksizes;
+    std::vector<hg_size_t> vsizes;
+    size_t                 key_size = omap_key_size(16); // initial guesses
+    size_t                 val_size = 64;
+    uint64_t               count    = 0;
+    size_t                 packed   = 0; // size of the results once packed
+    bool                   done     = false;
+
+    while (!done && count < max_return && (!max_bytes || packed <= max_bytes)) {
+        size_t n = std::min(
+            omap_page_count(keys.size(), key_size, max_return - count),
+            omap_page_count(vals.size(), val_size, max_return - count));
+        ksizes.assign(n, 0);
+        vsizes.assign(n, 0);
+        yret = yk_list_keyvals_packed(
+            omap_dbh, YOKAN_MODE_DEFAULT, lb.data(),
+            lb_size,                          /* strict lower bound */
+            prefix.data(), prefix_size,       /* prefix */
+            n,                                /* count */
+            keys.data(), keys.size(),         /* keys buffer */
+            ksizes.data(),                    /* key sizes */
+            vals.data(), vals.size(),         /* values buffer */
+            vsizes.data());                   /* value sizes */
         if (yret != YOKAN_SUCCESS) {
             *prval = -1;
-            margo_error(mid, "[mobject] %s:%d: yk_list_keyvals returned %d",
+            margo_error(mid,
+                        "[mobject] %s:%d: yk_list_keyvals_packed returned %d",
                         __func__, __LINE__, yret);
             break;
         }
 
-        for (items_retrieved = 0; items_retrieved < max_items;
-             items_retrieved++) {
-            if (ksizes[items_retrieved] == YOKAN_NO_MORE_KEYS) break;
-        }
-
-        const char* k;
-        for (auto i = 0; i < items_retrieved && count < max_return;
-             i++, count++) {
+        const char* k         = NULL;
+        size_t      k_len     = 0;
+        size_t      keys_used = 0;
+        size_t      vals_used = 0;
+        size_t      i;
+        for (i = 0; i < n; i++) {
+            if (ksizes[i] == YOKAN_NO_MORE_KEYS) {
+                done = true;
+                break;
+            }
+            if (ksizes[i] > YOKAN_LAST_VALID_SIZE
+                || vsizes[i] > YOKAN_LAST_VALID_SIZE)
+                break; // buffers full
             // extract the actual key part, without the oid
-            k = ((omap_key_t*)keys[i])->key;
-            /* this key is not part of the same object, we should leave the loop
-             */
-            if (((omap_key_t*)keys[i])->oid != oid)
-                goto out; /* ugly way of leaving the loop, I know ... */
-
-            omap_iter_append(*iter, k, (const char*)vals[i], vsizes[i]);
+            decode_omap_key(keys.data() + keys_used, ksizes[i], &k, &k_len);
+            omap_iter_append(*iter, std::string(k, k_len).c_str(),
+                             vals.data() + vals_used, vsizes[i]);
+            keys_used += ksizes[i];
+            vals_used += vsizes[i];
+            packed += 2 * sizeof(uint64_t) + k_len + 1 + vsizes[i];
         }
-        memset(lb, 0, lb_size);
-        lb->oid = oid;
-        strcpy(lb->key, k);
-
-    } while (items_retrieved == max_items && count < max_return);
+        count += i;
+        if (i == 0) {
+            // the next item does not fit in the buffers
+            if (!done) {
+                keys.resize(keys.size() * 2);
+                vals.resize(vals.size() * 2);
+            }
+            continue;
+        }
+        key_size = keys_used / i;
+        val_size = vals_used / i;
+        lb.resize(omap_key_size(k_len));
+        lb_size = encode_omap_key(lb.data(), oid, k, k_len);
+    }
+    if (*prval == 0 && !done)
+        (*iter)->more = omap_has_more(omap_dbh, lb.data(), lb_size,
+                                      prefix.data(), prefix_size);
 
-out:
-    free(lb);
     LEAVING;
 }
 
@@ -508,44 +657,72 @@ void read_op_exec_omap_get_vals_by_keys(void*                      u,
 
     omap_iter_create(iter);
 
-    // figure out key sizes
-    std::vector<size_t> ksizes(num_keys);
-    size_t              max_ksize = 0;
-    for (auto i = 0; i < num_keys; i++) {
-        size_t s = offsetof(omap_key_t, key) + strlen(keys[i]) + 1;
-        if (s > max_ksize) max_ksize = s;
-        ksizes[i] = s;
+    if (num_keys == 0) {
+        LEAVING;
+        return;
     }
-    max_ksize += sizeof(omap_key_t);
-
-    // TODO use length_mutli and get_multi or even get_packed
-    // with a large enough buffer
 
-    omap_key_t* key = (omap_key_t*)calloc(1, max_ksize);
     for (size_t i = 0; i < num_keys; i++) {
-        memset(key, 0, max_ksize);
-        key->oid = oid;
-        strcpy(key->key, keys[i]);
-        // get length of the value
-        hg_size_t vsize;
-        yret = yk_length(omap_dbh, YOKAN_MODE_DEFAULT, (const void*)key,
-                         ksizes[i], &vsize);
-        if (yret != YOKAN_SUCCESS) {
-            *prval = -1;
-            margo_error(mid, "[mobject] %s:%d: yk_length returned %d", __func__,
-                        __LINE__, yret);
-            break;
+        if (!omap_key_valid(keys[i])) {
+            *prval = -EINVAL;
+            LEAVING;
+            return;
         }
-        std::vector<char> value(vsize);
-        yret = yk_get(omap_dbh, YOKAN_MODE_DEFAULT, (const void*)key, ksizes[i],
-                      (void*)value.data(), &vsize);
-        if (yret != YOKAN_SUCCESS) {
+    }
+
+    // encode all the keys in a single buffer
+    std::vector<size_t> ksizes(num_keys);
+    std::vector<size_t> vsizes(num_keys);
+    size_t              keys_size = 0;
+    for (size_t i = 0; i < num_keys; i++) {
+        ksizes[i] = omap_key_size(strlen(keys[i]));
+        keys_size += ksizes[i];
+    }
+    std::vector<char> packed_keys(keys_size);
+    char*             k = packed_keys.data();
+    for (size_t i = 0; i < num_keys; i++)
+        k += encode_omap_key(k, oid, keys[i], ksizes[i] - OID_KEY_SIZE);
+
+    // get the size of all the values (YOKAN_KEY_NOT_FOUND for missing keys)
+    yret = yk_length_packed(omap_dbh, YOKAN_MODE_DEFAULT, num_keys,
+                            packed_keys.data(), ksizes.data(), vsizes.data());
+    if (yret != YOKAN_SUCCESS) {
+        *prval = -1;
+        margo_error(mid, "[mobject] %s:%d: yk_length_packed returned %d",
+                    __func__, __LINE__, yret);
+        LEAVING;
+        return;
+    }
+    size_t vals_size = 0;
+    for (size_t i = 0; i < num_keys; i++)
+        if (vsizes[i] <= YOKAN_LAST_VALID_SIZE) vals_size += vsizes[i];
+
+    // get all the values in a single buffer
+    std::vector<char> packed_vals(vals_size);
+    yret = yk_get_packed(omap_dbh, YOKAN_MODE_DEFAULT, num_keys,
+                         packed_keys.data(), ksizes.data(), vals_size,
+                         packed_vals.data(), vsizes.data());
+    if (yret != YOKAN_SUCCESS) {
+        *prval = -1;
+        margo_error(mid, "[mobject] %s:%d: yk_get_packed returned %d",
+                    __func__, __LINE__, yret);
+        LEAVING;
+        return;
+    }
+
+    // missing keys are not returned, as with rados
+    const char* v = packed_vals.data();
+    for (size_t i = 0; i < num_keys; i++) {
+        if (vsizes[i] == YOKAN_KEY_NOT_FOUND) continue;
+        if (vsizes[i] > YOKAN_LAST_VALID_SIZE) {
+            // the value grew between yk_length_packed and yk_get_packed
             *prval = -1;
-            margo_error(mid, "[mobject] %s:%d: sdskv_get returned %d", __func__,
-                        __LINE__, yret);
-            break;
+            margo_error(mid, "[mobject] %s:%d: could not get value of key %s",
+                        __func__, __LINE__, keys[i]);
+            continue;
         }
-        omap_iter_append(*iter, keys[i], value.data(), vsize);
+        omap_iter_append(*iter, keys[i], v, vsizes[i]);
+        v += vsizes[i];
     }
     LEAVING;
 }
@@ -553,6 +730,10 @@ void read_op_exec_omap_get_vals_by_keys(void*                      u,
 void read_op_exec_end(void* u)
 {
     auto vargs = static_cast<server_visitor_args_t>(u);
+    if (vargs->locked) {
+        mobject_object_unlock(vargs->provider, vargs->oid, vargs->lock_mode);
+        vargs->locked = 0;
+    }
 }
 
 static oid_t get_oid_from_name(margo_instance_id    mid,
@@ -568,3 +749,42 @@ static oid_t get_oid_from_name(margo_instance_id    mid,
     LEAVING;
     return result;
 }
+
+/* Reads the compressed data of a region and decompresses it into data.
+ * Returns 0 on success. */
+static int read_compressed_region(server_visitor_args_t       vargs,
+                                  bake_provider_handle_t      bake_ph,
+                                  const region_descriptor_t*  region,
+                                  const region_compression_t* comp,
+                                  std::vector<char>&          data)
+{
+    margo_instance_id mid = vargs->provider->mid;
+    std::vector<char> compressed(comp->size);
+    uint64_t          bytes_read = 0;
+
+    int ret = bake_read(bake_ph, region->tid, region->rid, 0,
+                        compressed.data(), comp->size, &bytes_read);
+    if (ret != 0) {
+        margo_error(mid, "[mobject] %s:%d: bake_read returned %d", __func__,
+                    __LINE__, ret);
+        return -1;
+    }
+    if (bytes_read != comp->size) {
+        margo_error(mid,
+                    "[mobject] %s:%d: bake_read invalid read of %" PRIu64
+                    " (requested %" PRIu32 ")",
+                    __func__, __LINE__, bytes_read, comp->size);
+        return -1;
+    }
+    data.resize(comp->data_size);
+    if (mobject_decompress(comp->codec, compressed.data(), comp->size,
+                           data.data(), comp->data_size)
+        != 0) {
+        margo_error(mid,
+                    "[mobject] %s:%d: could not decompress region "
+                    "(codec %d)",
+                    __func__, __LINE__, comp->codec);
+        return -1;
+    }
+    return 0;
+}
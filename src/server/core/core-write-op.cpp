@@ -4,12 +4,22 @@
  * See COPYRIGHT in top-level directory.
  */
 #include <map>
+#include <set>
+#include <algorithm>
+#include <cerrno>
 #include <cstring>
 #include <string>
 #include <iostream>
 #include <limits>
+#include <vector>
 #include <bake-client.h>
 #include "src/server/visitor-args.h"
+#include "src/server/deferred-persist.h"
+#include "src/server/object-locks.h"
+#include "src/server/object-tails.h"
+#include "src/server/region-compression.h"
+#include "src/server/region-dedup.h"
+#include "src/server/core/key-encoding.h"
 #include "src/io-chain/write-op-visitor.h"
 
 #define ENTERING margo_trace(mid, "[mobject] Entering function %s", __func__);
@@ -21,62 +31,155 @@ static void write_op_exec_create(void*, int);
 static void write_op_exec_write(void*, buffer_u, size_t, uint64_t);
 static void write_op_exec_write_full(void*, buffer_u, size_t);
 static void write_op_exec_writesame(void*, buffer_u, size_t, size_t, uint64_t);
-static void write_op_exec_append(void*, buffer_u, size_t);
+static void write_op_exec_append(void*, buffer_u, size_t, uint64_t*, int*);
 static void write_op_exec_remove(void*);
 static void write_op_exec_truncate(void*, uint64_t);
 static void write_op_exec_zero(void*, uint64_t, uint64_t);
 static void write_op_exec_omap_set(
     void*, char const* const*, char const* const*, const size_t*, size_t);
 static void write_op_exec_omap_rm_keys(void*, char const* const*, size_t);
+static void write_op_exec_omap_rm_range(void*, const char*, const char*);
+static void write_op_exec_omap_clear(void*);
+static void write_op_exec_omap_add(void*, const char*, int64_t, int64_t*, int*);
+static void write_op_exec_omap_cmpxchg(
+    void*, const char*, const char*, size_t, const char*, size_t, int*);
+
+static int omap_erase_range(struct mobject_provider* provider,
+                            oid_t                    oid,
+                            const char*              start,
+                            const char*              end);
 
 static oid_t get_or_create_oid(struct mobject_provider* provider,
                                yk_database_handle_t     oid_dbh,
                                yk_database_handle_t     name_dbh,
                                const char*              object_name);
 
-static void insert_region_log_entry(struct mobject_provider*   provider,
-                                    oid_t                      oid,
-                                    uint64_t                   offset,
-                                    uint64_t                   len,
-                                    const region_descriptor_t* region,
-                                    time_t                     ts = 0);
-
-static void insert_small_region_log_entry(struct mobject_provider* provider,
-                                          oid_t                    oid,
-                                          uint64_t                 offset,
-                                          uint64_t                 len,
-                                          const char*              data,
-                                          time_t                   ts = 0);
-
-static void insert_zero_log_entry(struct mobject_provider* provider,
+static int write_new_region(server_visitor_args_t  vargs,
+                            bake_provider_handle_t bake_ph,
+                            region_descriptor_t*   region,
+                            uint64_t               remote_offset,
+                            uint64_t               len);
+
+static uint64_t object_size(struct mobject_provider* provider, oid_t oid);
+
+static int append_at(server_visitor_args_t vargs,
+                     oid_t                 oid,
+                     uint64_t              remote_offset,
+                     uint64_t              offset,
+                     size_t                len);
+
+static int write_buffered(server_visitor_args_t vargs,
+                          oid_t                 oid,
+                          uint64_t              remote_offset,
+                          uint64_t              offset,
+                          uint64_t              len);
+
+static int write_chunks(server_visitor_args_t vargs,
+                        oid_t                 oid,
+                        uint64_t              offset,
+                        uint64_t              pos,
+                        const char*           data,
+                        uint64_t              len);
+
+static int write_dedup_chunk(server_visitor_args_t vargs,
+                             oid_t                 oid,
+                             uint64_t              offset,
+                             const char*           data,
+                             uint64_t              len);
+
+static int same_region_data(struct mobject_provider*    provider,
+                            bake_provider_handle_t      bake_ph,
+                            const region_descriptor_t*  region,
+                            const region_compression_t* comp,
+                            const char*                 data,
+                            uint64_t                    len);
+
+static int release_dedup_region(struct mobject_provider*   provider,
+                                const uint8_t*             digest,
+                                bake_provider_handle_t     bake_ph,
+                                const region_descriptor_t* region);
+
+static int write_local_data(server_visitor_args_t vargs,
+                            oid_t                 oid,
+                            uint64_t              offset,
+                            const char*           data,
+                            uint64_t              len,
+                            const uint8_t*        digest = nullptr);
+
+static int write_in_place(server_visitor_args_t  vargs,
+                          bake_provider_handle_t bake_ph,
+                          region_descriptor_t*   region,
+                          uint64_t               region_offset,
+                          uint64_t               remote_offset,
+                          uint64_t               len);
+
+static int find_overwritable_region(struct mobject_provider* provider,
+                                    oid_t                    oid,
+                                    uint64_t                 offset,
+                                    uint64_t                 len,
+                                    bake_provider_handle_t*  bake_ph,
+                                    region_descriptor_t*     region);
+
+static int insert_region_log_entry(struct mobject_provider*    provider,
+                                   oid_t                       oid,
+                                   uint64_t                    offset,
+                                   uint64_t                    len,
+                                   unsigned                    target_idx,
+                                   const region_descriptor_t*  region,
+                                   time_t                      ts   = 0,
+                                   const region_compression_t* comp = nullptr,
+                                   const uint8_t*              digest
+                                   = nullptr);
+
+static int insert_small_region_log_entry(struct mobject_provider* provider,
+                                         oid_t                    oid,
+                                         uint64_t                 offset,
+                                         uint64_t                 len,
+                                         const char*              data,
+                                         time_t                   ts = 0);
+
+static int insert_zero_log_entry(struct mobject_provider* provider,
+                                 oid_t                    oid,
+                                 uint64_t                 offset,
+                                 uint64_t                 len,
+                                 time_t                   ts = 0);
+
+static int insert_punch_log_entry(struct mobject_provider* provider,
                                   oid_t                    oid,
                                   uint64_t                 offset,
-                                  uint64_t                 len,
                                   time_t                   ts = 0);
 
-static void insert_punch_log_entry(struct mobject_provider* provider,
-                                   oid_t                    oid,
-                                   uint64_t                 offset,
-                                   time_t                   ts = 0);
-
 uint64_t mobject_compute_object_size(struct mobject_provider* provider,
                                      yk_database_handle_t     seg_dbh,
                                      oid_t                    oid,
                                      time_t                   ts);
 
+int mobject_decode_region(struct mobject_provider* provider,
+                          const void*              value,
+                          size_t                   size,
+                          bake_provider_handle_t*  bake_ph,
+                          region_descriptor_t*     region,
+                          region_compression_t*    comp,
+                          uint8_t*                 digest,
+                          int*                     has_digest);
+
 static struct write_op_visitor write_op_exec
-    = {.visit_begin        = write_op_exec_begin,
-       .visit_create       = write_op_exec_create,
-       .visit_write        = write_op_exec_write,
-       .visit_write_full   = write_op_exec_write_full,
-       .visit_writesame    = write_op_exec_writesame,
-       .visit_append       = write_op_exec_append,
-       .visit_remove       = write_op_exec_remove,
-       .visit_truncate     = write_op_exec_truncate,
-       .visit_zero         = write_op_exec_zero,
-       .visit_omap_set     = write_op_exec_omap_set,
-       .visit_omap_rm_keys = write_op_exec_omap_rm_keys,
-       .visit_end          = write_op_exec_end};
+    = {.visit_begin         = write_op_exec_begin,
+       .visit_create        = write_op_exec_create,
+       .visit_write         = write_op_exec_write,
+       .visit_write_full    = write_op_exec_write_full,
+       .visit_writesame     = write_op_exec_writesame,
+       .visit_append        = write_op_exec_append,
+       .visit_remove        = write_op_exec_remove,
+       .visit_truncate      = write_op_exec_truncate,
+       .visit_zero          = write_op_exec_zero,
+       .visit_omap_set      = write_op_exec_omap_set,
+       .visit_omap_rm_keys  = write_op_exec_omap_rm_keys,
+       .visit_omap_rm_range = write_op_exec_omap_rm_range,
+       .visit_omap_clear    = write_op_exec_omap_clear,
+       .visit_omap_add      = write_op_exec_omap_add,
+       .visit_omap_cmpxchg  = write_op_exec_omap_cmpxchg,
+       .visit_end           = write_op_exec_end};
 
 extern "C" void core_write_op(mobject_store_write_op_t write_op,
                               server_visitor_args_t    vargs)
@@ -93,11 +196,21 @@ void write_op_exec_begin(void* u)
     oid_t oid  = get_or_create_oid(vargs->provider, name_dbh, oid_dbh,
                                   vargs->object_name);
     vargs->oid = oid;
+    /* the object could not be found or created */
+    if (oid == 0) vargs->ret = -1;
+    if (oid != 0 && vargs->lock_mode != MOBJECT_LOCK_NONE) {
+        mobject_object_lock(vargs->provider, oid, vargs->lock_mode);
+        vargs->locked = 1;
+    }
 }
 
 void write_op_exec_end(void* u)
 {
     auto vargs = static_cast<server_visitor_args_t>(u);
+    if (vargs->locked) {
+        mobject_object_unlock(vargs->provider, vargs->oid, vargs->lock_mode);
+        vargs->locked = 0;
+    }
 }
 
 void write_op_exec_create(void* u, int exclusive)
@@ -108,6 +221,7 @@ void write_op_exec_create(void* u, int exclusive)
     ENTERING;
     if (oid == 0) {
         margo_error(mid, "[mobject] %s:%d: oid == 0", __func__, __LINE__);
+        vargs->ret = -1;
     }
     /* nothing to do, the object is actually created in write_op_exec_begin
        if it did not exist before */
@@ -122,17 +236,20 @@ void write_op_exec_write(void* u, buffer_u buf, size_t len, uint64_t offset)
     oid_t oid = vargs->oid;
     if (oid == 0) {
         margo_error(mid, "[mobject] %s:%d: oid == 0", __func__, __LINE__);
+        vargs->ret = -1;
         LEAVING;
         return;
     }
 
+    mobject_object_tail_invalidate(vargs->provider, oid);
+
     struct mobject_provider* provider        = vargs->provider;
     unsigned                 bake_target_idx = oid % provider->num_bake_targets;
+
     bake_provider_handle_t bake_ph = provider->bake_targets[bake_target_idx].ph;
     region_descriptor_t    region
         = {provider->bake_targets[bake_target_idx].tid, 0};
     hg_bulk_t   remote_bulk     = vargs->bulk_handle;
-    const char* remote_addr_str = vargs->client_addr_str;
     hg_addr_t   remote_addr     = vargs->client_addr;
     double      wr_start, wr_end;
 
@@ -147,16 +264,41 @@ void write_op_exec_write(void* u, buffer_u buf, size_t len, uint64_t offset)
     provider->last_wr_start = wr_start;
     ABT_mutex_unlock(ABT_MUTEX_MEMORY_GET_HANDLE(&provider->stats_mutex));
 
-    if (len > SMALL_REGION_THRESHOLD) {
-        ret = bake_create_write_persist_proxy(bake_ph, region.tid, remote_bulk, buf.as_offset,
-                remote_addr_str, len, &region.rid);
+    // falls back to a new region if the data cannot be written in place
+    bool in_place = false;
+    if (vargs->overwrite && len > SMALL_REGION_THRESHOLD) {
+        bake_provider_handle_t old_ph;
+        region_descriptor_t    old_region;
+        in_place = find_overwritable_region(provider, oid, offset, len, &old_ph,
+                                            &old_region)
+                       == 0
+                && write_in_place(vargs, old_ph, &old_region, 0,
+                                  buf.as_offset, len)
+                       == 0;
+    }
+
+    if (in_place) {
+        // the segment of the old region already maps the range
+    } else if (len > SMALL_REGION_THRESHOLD
+               && (provider->zero_detection_size || provider->compression
+                   || provider->dedup_chunk_size)) {
+        ret = write_buffered(vargs, oid, buf.as_offset, offset, len);
         if (ret != 0) {
-            margo_error(mid, "[mobject] %s:%d: bake_create_write_persist_proxy returned %d",
-                        __func__, __LINE__, ret);
+            vargs->ret = -1;
             LEAVING;
             return;
         }
-        insert_region_log_entry(provider, oid, offset, len, &region);
+    } else if (len > SMALL_REGION_THRESHOLD) {
+        ret = write_new_region(vargs, bake_ph, &region, buf.as_offset, len);
+        if (ret != 0) {
+            vargs->ret = -1;
+            LEAVING;
+            return;
+        }
+        if (insert_region_log_entry(provider, oid, offset, len,
+                                    bake_target_idx, &region)
+            != 0)
+            vargs->ret = -1;
     } else {
         margo_instance_id mid = vargs->provider->mid;
         char              data[SMALL_REGION_THRESHOLD];
@@ -168,6 +310,7 @@ void write_op_exec_write(void* u, buffer_u buf, size_t len, uint64_t offset)
         if (ret != 0) {
             margo_error(mid, "[mobject] %s:%d: margo_bulk_create returned %d",
                         __func__, __LINE__, ret);
+            vargs->ret = -1;
             LEAVING;
             return;
         }
@@ -176,13 +319,16 @@ void write_op_exec_write(void* u, buffer_u buf, size_t len, uint64_t offset)
         if (ret != 0) {
             margo_error(mid, "[mobject] %s:%d: margo_bulk_transfer returned %d",
                         __func__, __LINE__, ret);
+            vargs->ret = -1;
             margo_bulk_free(handle);
             LEAVING;
             return;
         }
         margo_bulk_free(handle);
 
-        insert_small_region_log_entry(provider, oid, offset, len, data);
+        if (insert_small_region_log_entry(provider, oid, offset, len, data)
+            != 0)
+            vargs->ret = -1;
     }
 
     ABT_mutex_lock(ABT_MUTEX_MEMORY_GET_HANDLE(&provider->stats_mutex));
@@ -204,8 +350,11 @@ void write_op_exec_write_full(void* u, buffer_u buf, size_t len)
     auto              vargs = static_cast<server_visitor_args_t>(u);
     margo_instance_id mid   = vargs->provider->mid;
     ENTERING;
-    // truncate to 0 then write
-    write_op_exec_truncate(u, 0);
+    // truncate to 0 then write, unless the data replaces the whole object
+    // and may be written in place
+    if (!vargs->overwrite || vargs->oid == 0
+        || object_size(vargs->provider, vargs->oid) != len)
+        write_op_exec_truncate(u, 0);
     write_op_exec_write(u, buf, len, 0);
     LEAVING;
 }
@@ -219,12 +368,14 @@ void write_op_exec_writesame(
     oid_t oid = vargs->oid;
     if (oid == 0) {
         margo_error(mid, "[mobject] %s:%d: oid == 0", __func__, __LINE__);
+        vargs->ret = -1;
         LEAVING;
         return;
     }
 
+    mobject_object_tail_invalidate(vargs->provider, oid);
+
     hg_bulk_t   remote_bulk     = vargs->bulk_handle;
-    const char* remote_addr_str = vargs->client_addr_str;
     hg_addr_t   remote_addr     = vargs->client_addr;
     int         ret;
 
@@ -236,25 +387,10 @@ void write_op_exec_writesame(
         region_descriptor_t region
             = {vargs->provider->bake_targets[bake_target_idx].tid, 0};
 
-        ret = bake_create(bake_ph, region.tid, data_len, &region.rid);
-        if (ret != 0) {
-            margo_error(mid, "[mobject] %s:%d: bake_create returned %d",
-                        __func__, __LINE__, ret);
-            LEAVING;
-            return;
-        }
-        ret = bake_proxy_write(bake_ph, region.tid, region.rid, 0, remote_bulk,
-                               buf.as_offset, remote_addr_str, data_len);
-        if (ret != 0) {
-            margo_error(mid, "[mobject] %s:%d: bake_proxy_write returned %d",
-                        __func__, __LINE__, ret);
-            LEAVING;
-            return;
-        }
-        ret = bake_persist(bake_ph, region.tid, region.rid, 0, data_len);
+        ret = write_new_region(vargs, bake_ph, &region, buf.as_offset,
+                               data_len);
         if (ret != 0) {
-            margo_error(mid, "[mobject] %s:%d: bake_persist returned %d",
-                        __func__, __LINE__, ret);
+            vargs->ret = -1;
             LEAVING;
             return;
         }
@@ -265,9 +401,11 @@ void write_op_exec_writesame(
         for (i = 0; i < write_len; i += data_len) {
             // TODO normally we should have the same timestamps but right now it
             // bugs...
-            insert_region_log_entry(vargs->provider, oid, offset + i,
-                                    std::min(data_len, write_len - i),
-                                    &region); //, ts);
+            if (insert_region_log_entry(vargs->provider, oid, offset + i,
+                                        std::min(data_len, write_len - i),
+                                        bake_target_idx, &region) //, ts);
+                != 0)
+                vargs->ret = -1;
         }
 
     } else {
@@ -282,6 +420,7 @@ void write_op_exec_writesame(
         if (ret != 0) {
             margo_error(mid, "[mobject] %s:%d: margo_bulk_create returned %d",
                         __func__, __LINE__, ret);
+            vargs->ret = -1;
             LEAVING;
             return;
         }
@@ -290,6 +429,7 @@ void write_op_exec_writesame(
         if (ret != 0) {
             margo_error(mid, "[mobject] %s:%d: margo_bulk_transfer returned %d",
                         __func__, __LINE__, ret);
+            vargs->ret = -1;
             margo_bulk_free(handle);
             LEAVING;
             return;
@@ -298,82 +438,53 @@ void write_op_exec_writesame(
 
         size_t i;
         for (i = 0; i < write_len; i += data_len) {
-            insert_small_region_log_entry(vargs->provider, oid, offset + i,
-                                          std::min(data_len, write_len - i),
-                                          data);
+            if (insert_small_region_log_entry(
+                    vargs->provider, oid, offset + i,
+                    std::min(data_len, write_len - i), data)
+                != 0)
+                vargs->ret = -1;
         }
     }
     LEAVING;
 }
 
-void write_op_exec_append(void* u, buffer_u buf, size_t len)
+void write_op_exec_append(
+    void* u, buffer_u buf, size_t len, uint64_t* poffset, int* prval)
 {
     auto              vargs = static_cast<server_visitor_args_t>(u);
     margo_instance_id mid   = vargs->provider->mid;
     ENTERING;
     oid_t oid = vargs->oid;
+    *prval    = -1;
     if (oid == 0) {
         margo_error(mid, "[mobject] %s:%d: oid == 0", __func__, __LINE__);
+        vargs->ret = -1;
         LEAVING;
         return;
     }
 
-    hg_bulk_t   remote_bulk     = vargs->bulk_handle;
-    const char* remote_addr_str = vargs->client_addr_str;
-    hg_addr_t   remote_addr     = vargs->client_addr;
-    int         ret;
-
-    // find out the current length of the object
-    time_t   ts     = time(NULL);
-    uint64_t offset = mobject_compute_object_size(
-        vargs->provider, vargs->provider->segment_dbh, oid, ts);
-
-    if (len > SMALL_REGION_THRESHOLD) {
-
-        unsigned bake_target_idx = oid % vargs->provider->num_bake_targets;
-        bake_provider_handle_t bake_ph
-            = vargs->provider->bake_targets[bake_target_idx].ph;
-        region_descriptor_t region
-            = {vargs->provider->bake_targets[bake_target_idx].tid, 0};
-
-        ret = bake_create_write_persist_proxy(bake_ph, region.tid, remote_bulk, buf.as_offset,
-                remote_addr_str, len, &region.rid);
-        if (ret != 0) {
-            margo_error(mid, "[mobject] %s:%d: bake_create_write_persisti_proxy returned %d",
-                        __func__, __LINE__, ret);
-            LEAVING;
-            return;
-        }
-
-        insert_region_log_entry(vargs->provider, oid, offset, len, &region, ts);
-
+    // reserve the range, concurrent appends writing after it
+    struct mobject_tail_range range;
+    mobject_object_tail_reserve(vargs->provider, oid, len, object_size,
+                                &range);
+    int ret;
+    if (range.in_region) {
+        struct mobject_bake_target* target
+            = &vargs->provider->bake_targets[range.target_idx];
+        region_descriptor_t region = {target->tid, range.rid};
+        ret = write_in_place(vargs, target->ph, &region, range.region_offset,
+                             buf.as_offset, len);
+    } else
+        ret = append_at(vargs, oid, buf.as_offset, range.offset, len);
+    int rret = mobject_object_tail_release(vargs->provider, oid, &range, ret);
+    if (rret == 1)
+        insert_zero_log_entry(vargs->provider, oid, range.offset, len);
+
+    if (ret == 0 && rret == 0) {
+        *poffset = range.offset;
+        *prval   = 0;
     } else {
-
-        margo_instance_id mid = vargs->provider->mid;
-        char              data[SMALL_REGION_THRESHOLD];
-        void*             buf_ptrs[1]  = {(void*)(&data[0])};
-        hg_size_t         buf_sizes[1] = {len};
-        hg_bulk_t         handle;
-        ret = margo_bulk_create(mid, 1, buf_ptrs, buf_sizes, HG_BULK_WRITE_ONLY,
-                                &handle);
-        if (ret != 0) {
-            margo_error(mid, "[mobject] %s:%d: margo_bulk_create returned %d",
-                        __func__, __LINE__, ret);
-            LEAVING;
-            return;
-        }
-        ret = margo_bulk_transfer(mid, HG_BULK_PULL, remote_addr, remote_bulk,
-                                  buf.as_offset, handle, 0, len);
-        if (ret != 0) {
-            margo_error(mid, "[mobject] %s:%d: margo_bulk_transfer returned %d",
-                        __func__, __LINE__, ret);
-            margo_bulk_free(handle);
-            LEAVING;
-            return;
-        }
-        margo_bulk_free(handle);
-
-        insert_small_region_log_entry(vargs->provider, oid, offset, len, data);
+        vargs->ret = -1;
     }
     LEAVING;
 }
@@ -391,107 +502,143 @@ void write_op_exec_remove(void* u)
     yk_return_t          yret;
     int                  bret;
 
+    mobject_object_tail_invalidate(vargs->provider, oid);
+
     /* remove name->OID entry to make object no longer visible to clients */
     yret = yk_erase(name_dbh, YOKAN_MODE_DEFAULT, (const void*)object_name,
                     strlen(object_name) + 1);
     if (yret != YOKAN_SUCCESS) {
         margo_error(mid, "[mobject] %s:%d: sdskv_erase returned %d", __func__,
                     __LINE__, yret);
+        vargs->ret = -1;
         LEAVING;
         return;
     }
 
     /* TODO bg thread for everything beyond this point */
 
-    yret = yk_erase(oid_dbh, YOKAN_MODE_DEFAULT, &oid, sizeof(oid));
+    char oid_key[OID_KEY_SIZE];
+    encode_oid_key(oid_key, oid);
+    yret = yk_erase(oid_dbh, YOKAN_MODE_DEFAULT, oid_key, OID_KEY_SIZE);
     if (yret != YOKAN_SUCCESS) {
         margo_error(mid, "[mobject] %s:%d: sdskv_erase returned %d", __func__,
                     __LINE__, yret);
+        vargs->ret = -1;
+        LEAVING;
+        return;
+    }
+
+    /* remove the omap of the object */
+    if (omap_erase_range(vargs->provider, oid, "", NULL) != 0) {
+        vargs->ret = -1;
         LEAVING;
         return;
     }
 
     segment_key_t lb;
+    memset(&lb, 0, sizeof(lb));
     lb.oid       = oid;
     lb.timestamp = time(NULL);
     lb.seq_id    = MOBJECT_SEQ_ID_MAX;
+    char   lb_key[MAX_SEGMENT_KEY_SIZE];
+    size_t lb_size = encode_segment_key(lb_key, &lb);
 
-    size_t              max_segments = 128; // XXX this is a pretty arbitrary number
-    segment_key_t       segment_keys[max_segments];
-    size_t              segment_keys_sizes[max_segments];
-    region_descriptor_t segment_data[max_segments];
-    size_t              segment_data_sizes[max_segments];
+    size_t max_segments = 128; // XXX this is a pretty arbitrary number
+    char   segment_keys[max_segments * MAX_SEGMENT_KEY_SIZE];
+    size_t segment_keys_sizes[max_segments];
+    char   segment_data[max_segments * MAX_SEGMENT_VALUE_SIZE];
+    size_t segment_data_sizes[max_segments];
+    // regions already removed, the segments of a writesame sharing one
+    std::set<std::string> removed_regions;
 
     /* iterate over and remove all segments for this oid */
     bool done = false;
     while (!done) {
 
         yret = yk_list_keyvals_packed(
-            seg_dbh, YOKAN_MODE_DEFAULT, (const void*)&lb,
-            sizeof(lb),                              /* strict lower bound */
-            (const void*)&oid, sizeof(oid),          /* prefix */
-            max_segments,                            /* max key/val pairs */
-            segment_keys,                            /* keys buffer */
-            max_segments * sizeof(segment_key_t),    /* keys_buf_size */
-            segment_keys_sizes,                      /* key sizes */
-            segment_data,                            /* vals buffer */
-            max_segments * sizeof(region_descriptor_t), /* vals_buf_size */
-            segment_data_sizes);                     /* vals sizes */
+            seg_dbh, YOKAN_MODE_DEFAULT, lb_key,
+            lb_size,                                /* strict lower bound */
+            oid_key, OID_KEY_SIZE,                  /* prefix */
+            max_segments,                           /* max key/val pairs */
+            segment_keys,                           /* keys buffer */
+            max_segments * MAX_SEGMENT_KEY_SIZE,    /* keys_buf_size */
+            segment_keys_sizes,                     /* key sizes */
+            segment_data,                           /* vals buffer */
+            max_segments * MAX_SEGMENT_VALUE_SIZE,  /* vals_buf_size */
+            segment_data_sizes);                    /* vals sizes */
 
         if (yret != YOKAN_SUCCESS) {
             margo_error(mid,
                         "[mobject] %s:%d: yk_list_keyvals_packed returned %d",
                         __func__, __LINE__, yret);
+            vargs->ret = -1;
             LEAVING;
             return;
         }
 
-        size_t i;
+        size_t      i;
+        const char* seg_key = segment_keys;
+        const char* seg_val = segment_data;
         for (i = 0; i < max_segments; ++i) {
-            const segment_key_t&       seg    = segment_keys[i];
-            const region_descriptor_t& region = segment_data[i];
+            segment_key_t seg;
 
             if (segment_keys_sizes[i] == YOKAN_NO_MORE_KEYS) {
                 done = true;
                 break;
             }
+            if (decode_segment_key(seg_key, segment_keys_sizes[i], &seg) != 0) {
+                margo_error(mid, "[mobject] %s:%d: invalid segment key",
+                            __func__, __LINE__);
+                vargs->ret = -1;
+                LEAVING;
+                return;
+            }
 
             if (seg.type == seg_type_t::BAKE_REGION) {
-                // find the provider handle associated with the target
-                bake_provider_handle_t bake_ph = BAKE_PROVIDER_HANDLE_NULL;
-                for (unsigned j = 0; j < vargs->provider->num_bake_targets; j++) {
-                    if (memcmp(&region.tid,
-                                &vargs->provider->bake_targets[j].tid,
-                                sizeof(bake_target_id_t))
-                            == 0) {
-                        bake_ph = vargs->provider->bake_targets[j].ph;
-                    }
-                }
-                if (!bake_ph) {
-                    margo_error(mid,
-                                "[mobject] %s:%d: could not find bake provider "
-                                "handle associated with stored target id",
-                                __func__, __LINE__);
+                bake_provider_handle_t bake_ph;
+                region_descriptor_t    region;
+                uint8_t                digest[REGION_DIGEST_SIZE];
+                int                    dedup;
+                if (mobject_decode_region(vargs->provider, seg_val,
+                                          segment_data_sizes[i], &bake_ph,
+                                          &region, nullptr, digest, &dedup)
+                    != 0) {
+                    vargs->ret = -1;
                     LEAVING;
                     return;
                 }
-                bret = bake_remove(bake_ph, region.tid, region.rid);
-                if (yret != BAKE_SUCCESS) {
+                // a region shared by deduplication is only removed with
+                // its last reference, held by each of its segments
+                std::string id((const char*)&region.tid, sizeof(region.tid));
+                id.append((const char*)&region.rid, sizeof(region.rid));
+                if (dedup)
+                    bret = release_dedup_region(vargs->provider, digest,
+                                                bake_ph, &region);
+                else if (removed_regions.insert(id).second)
+                    bret = bake_remove(bake_ph, region.tid, region.rid);
+                else
+                    bret = BAKE_SUCCESS;
+                if (bret != BAKE_SUCCESS) {
                     margo_error(mid, "[mobject] %s:%d: bake_remove returned %d",
                                 __func__, __LINE__, bret);
+                    vargs->ret = -1;
                     /* XXX should save the error and keep removing */
                     LEAVING;
                     return;
                 }
             }
 
-            yret = yk_erase(seg_dbh, YOKAN_MODE_DEFAULT, &seg, sizeof(seg));
+            yret = yk_erase(seg_dbh, YOKAN_MODE_DEFAULT, seg_key,
+                            segment_keys_sizes[i]);
             if (yret != YOKAN_SUCCESS) {
                 margo_error(mid, "[mobject] %s:%d: yk_erase returned %d",
                             __func__, __LINE__, yret);
+                vargs->ret = -1;
                 LEAVING;
                 return;
             }
+            seg_key += segment_keys_sizes[i];
+            seg_val += segment_data_sizes[i];
         }
     }
 
@@ -506,11 +653,15 @@ void write_op_exec_truncate(void* u, uint64_t offset)
     oid_t oid = vargs->oid;
     if (oid == 0) {
         margo_error(mid, "[mobject] %s:%d: oid == 0", __func__, __LINE__);
+        vargs->ret = -1;
         LEAVING;
         return;
     }
 
-    insert_punch_log_entry(vargs->provider, oid, offset);
+    mobject_object_tail_invalidate(vargs->provider, oid);
+
+    if (insert_punch_log_entry(vargs->provider, oid, offset) != 0)
+        vargs->ret = -1;
     LEAVING;
 }
 
@@ -522,11 +673,15 @@ void write_op_exec_zero(void* u, uint64_t offset, uint64_t len)
     oid_t oid = vargs->oid;
     if (oid == 0) {
         margo_error(mid, "[mobject] %s:%d: oid == 0", __func__, __LINE__);
+        vargs->ret = -1;
         LEAVING;
         return;
     }
 
-    insert_zero_log_entry(vargs->provider, oid, offset, len);
+    mobject_object_tail_invalidate(vargs->provider, oid);
+
+    if (insert_zero_log_entry(vargs->provider, oid, offset, len) != 0)
+        vargs->ret = -1;
     LEAVING;
 }
 
@@ -545,35 +700,54 @@ void write_op_exec_omap_set(void*              u,
 
     if (oid == 0) {
         margo_error(mid, "[mobject] %s:%d: oid == 0", __func__, __LINE__);
+        vargs->ret = -1;
         LEAVING;
         return;
     }
 
-    /* find out the max key length */
-    size_t max_k_len = 0;
-    for (auto i = 0; i < num; i++) {
-        size_t s  = strlen(keys[i]);
-        max_k_len = max_k_len < s ? s : max_k_len;
+    if (num == 0) {
+        LEAVING;
+        return;
     }
 
-    /* create an omap key of the right size */
-    omap_key_t* k = (omap_key_t*)calloc(1, max_k_len + sizeof(omap_key_t));
+    for (size_t i = 0; i < num; i++) {
+        if (!omap_key_valid(keys[i])) {
+            margo_error(mid, "[mobject] %s:%d: omap key longer than %d",
+                        __func__, __LINE__, MAX_OMAP_KEY_SIZE);
+            vargs->ret = -1;
+            LEAVING;
+            return;
+        }
+    }
 
-    // TODO maybe use yk_put_multi/packed instead
+    /* encode all the keys, followed by all the values, in a single buffer
+     * so that they can be sent to Yokan with one yk_put_packed */
+    std::vector<size_t> key_sizes(num);
+    size_t              keys_size = 0;
+    size_t              vals_size = 0;
+    for (size_t i = 0; i < num; i++) {
+        key_sizes[i] = omap_key_size(strlen(keys[i]));
+        keys_size += key_sizes[i];
+        vals_size += lens[i];
+    }
 
-    for (auto i = 0; i < num; i++) {
-        size_t k_len = strlen(keys[i]) + sizeof(omap_key_t);
-        memset(k, 0, max_k_len + sizeof(omap_key_t));
-        k->oid = oid;
-        strcpy(k->key, keys[i]);
-        yret = yk_put(omap_dbh, YOKAN_MODE_DEFAULT, (const void*)k, k_len,
-                      (const void*)vals[i], lens[i]);
-        if (yret != YOKAN_SUCCESS) {
-            margo_error(mid, "[mobject] %s:%d: yk_put returned %d", __func__,
-                        __LINE__, yret);
-        }
+    char* buf = (char*)malloc(keys_size + vals_size);
+    char* k   = buf;
+    char* v   = buf + keys_size;
+    for (size_t i = 0; i < num; i++) {
+        k += encode_omap_key(k, oid, keys[i], key_sizes[i] - OID_KEY_SIZE);
+        memcpy(v, vals[i], lens[i]);
+        v += lens[i];
+    }
+
+    yret = yk_put_packed(omap_dbh, YOKAN_MODE_DEFAULT, num, buf,
+                         key_sizes.data(), buf + keys_size, lens);
+    if (yret != YOKAN_SUCCESS) {
+        margo_error(mid, "[mobject] %s:%d: yk_put_packed returned %d",
+                    __func__, __LINE__, yret);
+        vargs->ret = -1;
     }
-    free(k);
+    free(buf);
     LEAVING;
 }
 
@@ -589,23 +763,332 @@ void write_op_exec_omap_rm_keys(void*              u,
     ENTERING;
     if (oid == 0) {
         margo_error(mid, "[mobject] %s:%d: oid == 0", __func__, __LINE__);
+        vargs->ret = -1;
+        LEAVING;
+        return;
+    }
+
+    if (num_keys == 0) {
         LEAVING;
         return;
     }
 
-    size_t* key_sizes = (size_t*)calloc(num_keys, sizeof(size_t));
     for (size_t i = 0; i < num_keys; i++) {
-        key_sizes[i] = strlen(keys[i]) + 1;
+        if (!omap_key_valid(keys[i])) {
+            margo_error(mid, "[mobject] %s:%d: omap key longer than %d",
+                        __func__, __LINE__, MAX_OMAP_KEY_SIZE);
+            vargs->ret = -1;
+            LEAVING;
+            return;
+        }
+    }
+
+    /* encode all the keys in a single buffer for yk_erase_packed */
+    std::vector<size_t> key_sizes(num_keys);
+    size_t              keys_size = 0;
+    for (size_t i = 0; i < num_keys; i++) {
+        key_sizes[i] = omap_key_size(strlen(keys[i]));
+        keys_size += key_sizes[i];
     }
 
-    yret = yk_erase_multi(omap_dbh, YOKAN_MODE_DEFAULT, num_keys,
-                          (const void* const*)keys, key_sizes);
+    char* buf = (char*)malloc(keys_size);
+    char* k   = buf;
+    for (size_t i = 0; i < num_keys; i++)
+        k += encode_omap_key(k, oid, keys[i], key_sizes[i] - OID_KEY_SIZE);
 
+    yret = yk_erase_packed(omap_dbh, YOKAN_MODE_DEFAULT, num_keys, buf,
+                           key_sizes.data());
     if (yret != YOKAN_SUCCESS) {
-        margo_error(mid, "[mobject] %s:%d: yk_erase_multi returned %d",
+        margo_error(mid, "[mobject] %s:%d: yk_erase_packed returned %d",
                     __func__, __LINE__, yret);
+        vargs->ret = -1;
+    }
+    free(buf);
+    LEAVING;
+}
+
+void write_op_exec_omap_rm_range(void* u, const char* start, const char* end)
+{
+    auto              vargs = static_cast<server_visitor_args_t>(u);
+    margo_instance_id mid   = vargs->provider->mid;
+    oid_t             oid   = vargs->oid;
+    ENTERING;
+    if (oid == 0) {
+        margo_error(mid, "[mobject] %s:%d: oid == 0", __func__, __LINE__);
+        vargs->ret = -1;
+        LEAVING;
+        return;
+    }
+
+    if (!omap_key_valid(start) || !omap_key_valid(end)) {
+        margo_error(mid, "[mobject] %s:%d: omap key longer than %d", __func__,
+                    __LINE__, MAX_OMAP_KEY_SIZE);
+        vargs->ret = -1;
+        LEAVING;
+        return;
+    }
+
+    if (omap_erase_range(vargs->provider, oid, start, *end ? end : NULL)
+        != 0)
+        vargs->ret = -1;
+    LEAVING;
+}
+
+void write_op_exec_omap_clear(void* u)
+{
+    auto              vargs = static_cast<server_visitor_args_t>(u);
+    margo_instance_id mid   = vargs->provider->mid;
+    oid_t             oid   = vargs->oid;
+    ENTERING;
+    if (oid == 0) {
+        margo_error(mid, "[mobject] %s:%d: oid == 0", __func__, __LINE__);
+        vargs->ret = -1;
+        LEAVING;
+        return;
+    }
+
+    if (omap_erase_range(vargs->provider, oid, "", NULL) != 0)
+        vargs->ret = -1;
+    LEAVING;
+}
+
+/* The atomic omap actions of a write_op issued with
+ * LIBMOBJECT_OPERATION_SKIPRWLOCKS lock the object themselves, returning
+ * the mode in which to unlock it */
+static int omap_lock(server_visitor_args_t vargs)
+{
+    if (vargs->locked) return MOBJECT_LOCK_NONE;
+    mobject_object_lock(vargs->provider, vargs->oid, MOBJECT_LOCK_EXCLUSIVE);
+    return MOBJECT_LOCK_EXCLUSIVE;
+}
+
+void write_op_exec_omap_add(
+    void* u, const char* key, int64_t delta, int64_t* presult, int* prval)
+{
+    yk_return_t          yret;
+    auto                 vargs    = static_cast<server_visitor_args_t>(u);
+    margo_instance_id    mid      = vargs->provider->mid;
+    yk_database_handle_t omap_dbh = vargs->provider->omap_dbh;
+    oid_t                oid      = vargs->oid;
+    ENTERING;
+    *prval = 0;
+    if (oid == 0) {
+        *prval = -1;
+        margo_error(mid, "[mobject] %s:%d: oid == 0", __func__, __LINE__);
+        vargs->ret = -1;
+        LEAVING;
+        return;
+    }
+
+    if (!omap_key_valid(key)) {
+        *prval     = -EINVAL;
+        vargs->ret = -1;
+        LEAVING;
+        return;
+    }
+
+    size_t            key_len = strlen(key);
+    std::vector<char> k(omap_key_size(key_len));
+    size_t            k_size = encode_omap_key(k.data(), oid, key, key_len);
+    int64_t           value  = 0;
+    size_t            size   = sizeof(value);
+
+    int mode = omap_lock(vargs);
+    // a missing key counts as 0, other values must be an int64_t
+    yret = yk_get(omap_dbh, YOKAN_MODE_DEFAULT, k.data(), k_size, &value,
+                  &size);
+    if (yret == YOKAN_ERR_KEY_NOT_FOUND) {
+        value = 0;
+    } else if (yret == YOKAN_ERR_BUFFER_SIZE
+               || (yret == YOKAN_SUCCESS && size != sizeof(value))) {
+        *prval = -EINVAL;
+    } else if (yret != YOKAN_SUCCESS) {
+        *prval = -1;
+        margo_error(mid, "[mobject] %s:%d: yk_get returned %d", __func__,
+                    __LINE__, yret);
+        vargs->ret = -1;
+    }
+    if (*prval == 0) {
+        value += delta;
+        yret = yk_put(omap_dbh, YOKAN_MODE_DEFAULT, k.data(), k_size, &value,
+                      sizeof(value));
+        if (yret != YOKAN_SUCCESS) {
+            *prval = -1;
+            margo_error(mid, "[mobject] %s:%d: yk_put returned %d", __func__,
+                        __LINE__, yret);
+            vargs->ret = -1;
+        }
+    }
+    mobject_object_unlock(vargs->provider, oid, mode);
+
+    if (*prval == 0) *presult = value;
+    LEAVING;
+}
+
+void write_op_exec_omap_cmpxchg(void*       u,
+                                const char* key,
+                                const char* cmp,
+                                size_t      cmp_len,
+                                const char* val,
+                                size_t      val_len,
+                                int*        prval)
+{
+    yk_return_t          yret;
+    auto                 vargs    = static_cast<server_visitor_args_t>(u);
+    margo_instance_id    mid      = vargs->provider->mid;
+    yk_database_handle_t omap_dbh = vargs->provider->omap_dbh;
+    oid_t                oid      = vargs->oid;
+    ENTERING;
+    *prval = 0;
+    if (oid == 0) {
+        *prval = -1;
+        margo_error(mid, "[mobject] %s:%d: oid == 0", __func__, __LINE__);
+        vargs->ret = -1;
+        LEAVING;
+        return;
+    }
+
+    if (!omap_key_valid(key)) {
+        *prval     = -EINVAL;
+        vargs->ret = -1;
+        LEAVING;
+        return;
+    }
+
+    size_t            key_len = strlen(key);
+    std::vector<char> k(omap_key_size(key_len));
+    size_t            k_size = encode_omap_key(k.data(), oid, key, key_len);
+    // one more byte than expected, so that a longer value does not match
+    std::vector<char> current(cmp_len + 1);
+    size_t            size = current.size();
+
+    int mode = omap_lock(vargs);
+    yret = yk_get(omap_dbh, YOKAN_MODE_DEFAULT, k.data(), k_size,
+                  current.data(), &size);
+    if (yret == YOKAN_ERR_KEY_NOT_FOUND) {
+        if (cmp) *prval = -ECANCELED;
+    } else if (yret == YOKAN_SUCCESS || yret == YOKAN_ERR_BUFFER_SIZE) {
+        if (!cmp || yret != YOKAN_SUCCESS || size != cmp_len
+            || memcmp(current.data(), cmp, cmp_len) != 0)
+            *prval = -ECANCELED;
+    } else {
+        *prval = -1;
+        margo_error(mid, "[mobject] %s:%d: yk_get returned %d", __func__,
+                    __LINE__, yret);
+        vargs->ret = -1;
+    }
+    if (*prval == 0) {
+        yret = yk_put(omap_dbh, YOKAN_MODE_DEFAULT, k.data(), k_size, val,
+                      val_len);
+        if (yret != YOKAN_SUCCESS) {
+            *prval = -1;
+            margo_error(mid, "[mobject] %s:%d: yk_put returned %d", __func__,
+                        __LINE__, yret);
+            vargs->ret = -1;
+        }
+    }
+    mobject_object_unlock(vargs->provider, oid, mode);
+    LEAVING;
+}
+
+/* Tells whether an encoded omap key sorts before bound, in the order of
+ * Yokan's default comparator */
+static bool omap_key_before(const char*              key,
+                            size_t                   size,
+                            const std::vector<char>& bound)
+{
+    int c = memcmp(key, bound.data(), std::min(size, bound.size()));
+    return c < 0 || (c == 0 && size < bound.size());
+}
+
+/* Erases the omap keys of oid from start (included) to end (excluded, or
+ * to the last key if end is NULL). The keys are listed with the oid as
+ * prefix in pages of omap_page_size bytes, and each page is erased with a
+ * single yk_erase_packed. Returns 0 on success, -1 on error. */
+static int omap_erase_range(struct mobject_provider* provider,
+                            oid_t                    oid,
+                            const char*              start,
+                            const char*              end)
+{
+    margo_instance_id    mid      = provider->mid;
+    yk_database_handle_t omap_dbh = provider->omap_dbh;
+    yk_return_t          yret;
+    ENTERING;
+
+    size_t            start_len = strlen(start);
+    std::vector<char> lb(omap_key_size(start_len));
+    size_t lb_size = encode_omap_key(lb.data(), oid, start, start_len);
+    std::vector<char> ub;
+    if (end) {
+        size_t end_len = strlen(end);
+        ub.resize(omap_key_size(end_len));
+        ub.resize(encode_omap_key(ub.data(), oid, end, end_len));
+        if (!omap_key_before(lb.data(), lb_size, ub)) {
+            LEAVING;
+            return 0;
+        }
+    }
+    char oid_key[OID_KEY_SIZE];
+    encode_oid_key(oid_key, oid);
+
+    std::vector<char>      keys(provider->omap_page_size);
+    std::vector<hg_size_t> ksizes;
+    size_t                 key_size = omap_key_size(16); // initial guess
+    int32_t                mode     = YOKAN_MODE_INCLUSIVE;
+    bool                   done     = false;
+
+    while (!done) {
+        size_t n = std::max(keys.size() / key_size, (size_t)1);
+        ksizes.assign(n, 0);
+        yret = yk_list_keys_packed(omap_dbh, mode, lb.data(),
+                                   lb_size,               /* lower bound */
+                                   oid_key, OID_KEY_SIZE, /* prefix */
+                                   n,                     /* count */
+                                   keys.data(),           /* keys buffer */
+                                   keys.size(),           /* buffer size */
+                                   ksizes.data());        /* key sizes */
+        if (yret != YOKAN_SUCCESS) {
+            margo_error(mid, "[mobject] %s:%d: yk_list_keys_packed returned %d",
+                        __func__, __LINE__, yret);
+            LEAVING;
+            return -1;
+        }
+        size_t used = 0;
+        size_t i;
+        for (i = 0; i < n; i++) {
+            if (ksizes[i] == YOKAN_NO_MORE_KEYS) {
+                done = true;
+                break;
+            }
+            if (ksizes[i] > YOKAN_LAST_VALID_SIZE) break; // buffer full
+            if (end && !omap_key_before(keys.data() + used, ksizes[i], ub)) {
+                done = true;
+                break;
+            }
+            used += ksizes[i];
+        }
+        if (i == 0) {
+            // the next key does not fit in the buffer
+            if (!done) keys.resize(keys.size() * 2);
+            continue;
+        }
+        yret = yk_erase_packed(omap_dbh, YOKAN_MODE_DEFAULT, i, keys.data(),
+                               ksizes.data());
+        if (yret != YOKAN_SUCCESS) {
+            margo_error(mid, "[mobject] %s:%d: yk_erase_packed returned %d",
+                        __func__, __LINE__, yret);
+            LEAVING;
+            return -1;
+        }
+        // continue after the last erased key
+        key_size = used / i;
+        lb_size  = ksizes[i - 1];
+        lb.assign(keys.data() + used - lb_size, keys.data() + used);
+        mode = YOKAN_MODE_DEFAULT;
     }
+
     LEAVING;
+    return 0;
 }
 
 static oid_t get_or_create_oid(struct mobject_provider* provider,
@@ -641,13 +1124,15 @@ static oid_t get_or_create_oid(struct mobject_provider* provider,
     // oid not found (yret == YOKAN_ERR_KEY_NOT_FOUND)
 
     std::hash<std::string> hash_fn;
+    char                   oid_key[OID_KEY_SIZE];
     oid              = hash_fn(std::string(object_name));
     char* name_check = (char*)malloc(object_name_size);
     while (1) {
         /* avoid hash collisions by checking this oid mapping */
-        s    = object_name_size;
-        yret = yk_get(oid_dbh, YOKAN_MODE_DEFAULT, (const void*)&oid,
-                      sizeof(oid), (void*)name_check, &s);
+        s = object_name_size;
+        encode_oid_key(oid_key, oid);
+        yret = yk_get(oid_dbh, YOKAN_MODE_DEFAULT, oid_key, OID_KEY_SIZE,
+                      (void*)name_check, &s);
 
         if (yret == YOKAN_SUCCESS) {
             if (strncmp(object_name, name_check, s) == 0) {
@@ -680,7 +1165,7 @@ static oid_t get_or_create_oid(struct mobject_provider* provider,
         return 0;
     }
     // set oid => name
-    yret = yk_put(oid_dbh, YOKAN_MODE_DEFAULT, &oid, sizeof(oid),
+    yret = yk_put(oid_dbh, YOKAN_MODE_DEFAULT, oid_key, OID_KEY_SIZE,
                   (const void*)object_name, object_name_size);
     if (yret != YOKAN_SUCCESS) {
         margo_error(mid, "[mobject] %s:%d: yk_put returned %d", __func__,
@@ -693,12 +1178,607 @@ static oid_t get_or_create_oid(struct mobject_provider* provider,
     return oid;
 }
 
-static void insert_region_log_entry(struct mobject_provider*   provider,
-                                    oid_t                      oid,
-                                    uint64_t                   offset,
-                                    uint64_t                   len,
-                                    const region_descriptor_t* region,
-                                    time_t                     ts)
+/* size of an object, computed from its segments */
+static uint64_t object_size(struct mobject_provider* provider, oid_t oid)
+{
+    return mobject_compute_object_size(provider, provider->segment_dbh, oid,
+                                       time(NULL));
+}
+
+/* writes the len bytes of data of an append at the offset reserved for
+ * them, returns 0 on success */
+static int append_at(server_visitor_args_t vargs,
+                     oid_t                 oid,
+                     uint64_t              remote_offset,
+                     uint64_t              offset,
+                     size_t                len)
+{
+    margo_instance_id mid         = vargs->provider->mid;
+    hg_bulk_t         remote_bulk = vargs->bulk_handle;
+    hg_addr_t         remote_addr = vargs->client_addr;
+    int               ret;
+
+    // zero detection, compression and dedup apply as to other writes
+    struct mobject_provider* provider = vargs->provider;
+    if (len > SMALL_REGION_THRESHOLD
+        && (provider->zero_detection_size || provider->compression
+            || provider->dedup_chunk_size))
+        return write_buffered(vargs, oid, remote_offset, offset, len);
+
+    if (len > SMALL_REGION_THRESHOLD) {
+
+        unsigned bake_target_idx = oid % vargs->provider->num_bake_targets;
+        bake_provider_handle_t bake_ph
+            = vargs->provider->bake_targets[bake_target_idx].ph;
+        region_descriptor_t region
+            = {vargs->provider->bake_targets[bake_target_idx].tid, 0};
+
+        ret = write_new_region(vargs, bake_ph, &region, remote_offset, len);
+        if (ret != 0) return ret;
+
+        return insert_region_log_entry(vargs->provider, oid, offset, len,
+                                       bake_target_idx, &region);
+    }
+
+    char      data[SMALL_REGION_THRESHOLD];
+    void*     buf_ptrs[1]  = {(void*)(&data[0])};
+    hg_size_t buf_sizes[1] = {len};
+    hg_bulk_t handle;
+    ret = margo_bulk_create(mid, 1, buf_ptrs, buf_sizes, HG_BULK_WRITE_ONLY,
+                            &handle);
+    if (ret != 0) {
+        margo_error(mid, "[mobject] %s:%d: margo_bulk_create returned %d",
+                    __func__, __LINE__, ret);
+        return ret;
+    }
+    ret = margo_bulk_transfer(mid, HG_BULK_PULL, remote_addr, remote_bulk,
+                              remote_offset, handle, 0, len);
+    margo_bulk_free(handle);
+    if (ret != 0) {
+        margo_error(mid, "[mobject] %s:%d: margo_bulk_transfer returned %d",
+                    __func__, __LINE__, ret);
+        return ret;
+    }
+
+    return insert_small_region_log_entry(vargs->provider, oid, offset, len,
+                                         data);
+}
+
+/* whether the size bytes of data are all zeros; the words of each block
+ * are combined without branches so that the compiler vectorizes the
+ * inner loop */
+static bool is_zero(const char* data, size_t size)
+{
+    const size_t block = 256;
+    size_t       i     = 0;
+
+    for (; i + block <= size; i += block) {
+        uint64_t words[block / sizeof(uint64_t)];
+        uint64_t acc = 0;
+        memcpy(words, data + i, block);
+        for (size_t j = 0; j < block / sizeof(uint64_t); j++) acc |= words[j];
+        if (acc != 0) return false;
+    }
+    for (; i < size; i++)
+        if (data[i] != 0) return false;
+    return true;
+}
+
+/* Writes len bytes of the client's bulk handle, starting at remote_offset,
+ * at offset in the object, through a server buffer of at most
+ * MOBJECT_WRITE_BUFFER_SIZE bytes. If provider->zero_detection_size is
+ * set, the data is checked for zeros by blocks of that size: runs of
+ * all-zero blocks are recorded as ZERO segments, and the other runs are
+ * written with write_chunks. The size of the buffer is a multiple of the
+ * block size, and of the chunk size with fixed-size deduplication, so
+ * that blocks and chunks start at the same positions in the write
+ * whatever the buffer they are in (the configuration is rejected unless
+ * one of these sizes divides the other and both fit in the buffer).
+ * Returns 0 on success. */
+static int write_buffered(server_visitor_args_t vargs,
+                          oid_t                 oid,
+                          uint64_t              remote_offset,
+                          uint64_t              offset,
+                          uint64_t              len)
+{
+    struct mobject_provider* provider = vargs->provider;
+    margo_instance_id        mid      = provider->mid;
+    uint64_t                 block    = provider->zero_detection_size;
+    uint64_t                 unit     = block != 0 ? block : 1;
+    uint64_t                 chunk    = MOBJECT_WRITE_BUFFER_SIZE;
+    if (provider->dedup_chunk_size != 0
+        && provider->dedup_chunking == MOBJECT_DEDUP_FIXED)
+        unit = std::max(unit, (uint64_t)provider->dedup_chunk_size);
+    chunk = chunk / unit * unit;
+    chunk = std::min(chunk, len);
+
+    std::vector<char> data(chunk);
+    void*             buf_ptrs[1]  = {(void*)data.data()};
+    hg_size_t         buf_sizes[1] = {chunk};
+    hg_bulk_t         handle;
+    int ret = margo_bulk_create(mid, 1, buf_ptrs, buf_sizes,
+                                HG_BULK_WRITE_ONLY, &handle);
+    if (ret != 0) {
+        margo_error(mid, "[mobject] %s:%d: margo_bulk_create returned %d",
+                    __func__, __LINE__, ret);
+        return ret;
+    }
+
+    for (uint64_t done = 0; done < len && ret == 0; done += chunk) {
+        uint64_t n = std::min(chunk, len - done);
+        ret = margo_bulk_transfer(mid, HG_BULK_PULL, vargs->client_addr,
+                                  vargs->bulk_handle, remote_offset + done,
+                                  handle, 0, n);
+        if (ret != 0) {
+            margo_error(mid,
+                        "[mobject] %s:%d: margo_bulk_transfer returned %d",
+                        __func__, __LINE__, ret);
+            break;
+        }
+        // a run of blocks that are all zeros, or all not, is stored once
+        // the next run starts or the buffer ends (without zero detection,
+        // the buffer is a single block)
+        uint64_t step      = block != 0 ? block : n;
+        uint64_t run_start = 0;
+        bool     run_zero  = block != 0 && is_zero(&data[0], std::min(step, n));
+        for (uint64_t b = step; ret == 0; b += step) {
+            bool zero = b < n && is_zero(&data[b], std::min(step, n - b));
+            if (b < n && zero == run_zero) continue;
+            uint64_t end = std::min(b, n);
+            if (run_zero)
+                ret = insert_zero_log_entry(provider, oid,
+                                            offset + done + run_start,
+                                            end - run_start);
+            else
+                ret = write_chunks(vargs, oid, offset + done + run_start,
+                                   done + run_start, &data[run_start],
+                                   end - run_start);
+            if (b >= n) break;
+            run_start = b;
+            run_zero  = zero;
+        }
+    }
+
+    margo_bulk_free(handle);
+    return ret;
+}
+
+/* Stores the len bytes of data, held by the server, at offset in the
+ * object, pos bytes after the start of the write. If
+ * provider->dedup_chunk_size is set, the data is cut into chunks (see
+ * region-dedup.h) stored with write_dedup_chunk, otherwise it is stored
+ * with write_local_data. Returns 0 on success. */
+static int write_chunks(server_visitor_args_t vargs,
+                        oid_t                 oid,
+                        uint64_t              offset,
+                        uint64_t              pos,
+                        const char*           data,
+                        uint64_t              len)
+{
+    struct mobject_provider* provider = vargs->provider;
+    int                      ret      = 0;
+
+    if (provider->dedup_chunk_size == 0)
+        return write_local_data(vargs, oid, offset, data, len);
+
+    for (uint64_t done = 0; done < len && ret == 0;) {
+        uint64_t n = mobject_dedup_next_chunk(
+            provider->dedup_chunking, provider->dedup_chunk_size, pos + done,
+            data + done, len - done);
+        ret = write_dedup_chunk(vargs, oid, offset + done, data + done, n);
+        done += n;
+    }
+    return ret;
+}
+
+/* Stores a chunk of len bytes of data, held by the server, at offset in
+ * the object. If a region holding the same data is indexed (see
+ * region-dedup.h), the segment points at it; otherwise the chunk is
+ * stored in a new region with write_local_data, which indexes it.
+ * Returns 0 on success. */
+static int write_dedup_chunk(server_visitor_args_t vargs,
+                             oid_t                 oid,
+                             uint64_t              offset,
+                             const char*           data,
+                             uint64_t              len)
+{
+    struct mobject_provider* provider = vargs->provider;
+    margo_instance_id        mid      = provider->mid;
+    uint8_t                  digest[REGION_DIGEST_SIZE];
+    char                     value[MAX_REGION_VALUE_SIZE];
+    size_t                   value_size;
+    uint32_t                 target_idx;
+    region_descriptor_t      region;
+    region_compression_t     comp;
+    int                      ret;
+
+    if (len <= SMALL_REGION_THRESHOLD)
+        return write_local_data(vargs, oid, offset, data, len);
+
+    mobject_dedup_digest(data, len, digest);
+    ret = mobject_dedup_ref(provider, digest, value, &value_size);
+    if (ret < 0) return ret;
+    if (ret == 1)
+        return write_local_data(vargs, oid, offset, data, len, digest);
+
+    if (decode_region_value(value, value_size, &target_idx, &region.rid, &comp,
+                            nullptr, nullptr)
+            != 0
+        || target_idx >= provider->num_bake_targets) {
+        margo_error(mid, "[mobject] %s:%d: invalid index entry", __func__,
+                    __LINE__);
+        return -1;
+    }
+    bake_provider_handle_t bake_ph = provider->bake_targets[target_idx].ph;
+    region.tid                     = provider->bake_targets[target_idx].tid;
+
+    // the data is compared, so that chunks whose digests collide are not
+    // mixed up
+    ret = same_region_data(provider, bake_ph, &region, &comp, data, len);
+    if (ret == 1) {
+        ret = insert_region_log_entry(provider, oid, offset, len, target_idx,
+                                      &region, 0, &comp, digest);
+        if (ret == 0) return 0;
+    }
+    release_dedup_region(provider, digest, bake_ph, &region);
+    if (ret != 0) return ret;
+    return write_local_data(vargs, oid, offset, data, len);
+}
+
+/* Compares the len bytes of data with those of a region, decompressed if
+ * comp says so. Returns 1 if they are the same, 0 if they differ, -1 if
+ * the region could not be read. */
+static int same_region_data(struct mobject_provider*    provider,
+                            bake_provider_handle_t      bake_ph,
+                            const region_descriptor_t*  region,
+                            const region_compression_t* comp,
+                            const char*                 data,
+                            uint64_t                    len)
+{
+    margo_instance_id mid        = provider->mid;
+    bool              compressed = comp->codec != REGION_CODEC_NONE;
+    uint64_t          size       = compressed ? comp->size : len;
+    uint64_t          bytes_read = 0;
+
+    if (compressed && comp->data_size != len) return 0;
+    std::vector<char> stored(size);
+    int ret = bake_read(bake_ph, region->tid, region->rid, 0, stored.data(),
+                        size, &bytes_read);
+    if (ret != 0) {
+        margo_error(mid, "[mobject] %s:%d: bake_read returned %d", __func__,
+                    __LINE__, ret);
+        return -1;
+    }
+    if (bytes_read != size) return 0;
+    if (!compressed) return memcmp(stored.data(), data, len) == 0;
+
+    std::vector<char> decompressed(len);
+    if (mobject_decompress(comp->codec, stored.data(), size,
+                           decompressed.data(), len)
+        != 0)
+        return 0;
+    return memcmp(decompressed.data(), data, len) == 0;
+}
+
+/* Releases a reference on a region shared by deduplication, removing the
+ * region with its last reference. Returns 0 on success. */
+static int release_dedup_region(struct mobject_provider*   provider,
+                                const uint8_t*             digest,
+                                bake_provider_handle_t     bake_ph,
+                                const region_descriptor_t* region)
+{
+    margo_instance_id mid = provider->mid;
+
+    if (provider->dedup_dbh == YOKAN_DATABASE_HANDLE_NULL) {
+        // the region was indexed while deduplication was enabled, and
+        // cannot be removed without knowing its other references
+        margo_error(mid,
+                    "[mobject] %s:%d: region shared by deduplication kept, "
+                    "mobject_dedup_map is not available",
+                    __func__, __LINE__);
+        return -1;
+    }
+    int ret = mobject_dedup_unref(provider, digest);
+    if (ret != 1) return ret;
+    ret = bake_remove(bake_ph, region->tid, region->rid);
+    if (ret != 0)
+        margo_error(mid, "[mobject] %s:%d: bake_remove returned %d", __func__,
+                    __LINE__, ret);
+    return ret;
+}
+
+/* Stores the len bytes of data, held by the server, at offset in the
+ * object, in a new region or in a SMALL_REGION segment. The data of the
+ * region is compressed with provider->compression, unless it does not
+ * get smaller. If digest is not NULL, the region is indexed with it for
+ * deduplication (see region-dedup.h), unless its persistence is deferred,
+ * since writes sharing it could otherwise be acknowledged before it is
+ * persisted. Returns 0 on success. */
+static int write_local_data(server_visitor_args_t vargs,
+                            oid_t                 oid,
+                            uint64_t              offset,
+                            const char*           data,
+                            uint64_t              len,
+                            const uint8_t*        digest)
+{
+    struct mobject_provider* provider = vargs->provider;
+    margo_instance_id        mid      = provider->mid;
+    int                      ret;
+
+    if (len <= SMALL_REGION_THRESHOLD)
+        return insert_small_region_log_entry(provider, oid, offset, len, data);
+
+    unsigned bake_target_idx = oid % provider->num_bake_targets;
+    bake_provider_handle_t bake_ph = provider->bake_targets[bake_target_idx].ph;
+    region_descriptor_t    region
+        = {provider->bake_targets[bake_target_idx].tid, 0};
+    region_compression_t comp = {REGION_CODEC_NONE, 0, 0};
+    std::vector<char>    compressed;
+    uint64_t             size = len;
+
+    if (provider->compression != REGION_CODEC_NONE && len <= UINT32_MAX) {
+        compressed.resize(mobject_compress_bound(provider->compression, len));
+        size_t csize
+            = compressed.empty()
+                ? 0
+                : mobject_compress(provider->compression, data, len,
+                                   compressed.data(), compressed.size());
+        if (csize != 0 && csize < len) {
+            comp.codec     = provider->compression;
+            comp.size      = csize;
+            comp.data_size = len;
+            data           = compressed.data();
+            size           = csize;
+        }
+    }
+
+    if (!vargs->defer_persist) {
+        ret = bake_create_write_persist(bake_ph, region.tid, data, size,
+                                        &region.rid);
+        if (ret != 0) {
+            margo_error(mid,
+                        "[mobject] %s:%d: bake_create_write_persist "
+                        "returned %d",
+                        __func__, __LINE__, ret);
+            return ret;
+        }
+    } else {
+        ret = bake_create(bake_ph, region.tid, size, &region.rid);
+        if (ret != 0) {
+            margo_error(mid, "[mobject] %s:%d: bake_create returned %d",
+                        __func__, __LINE__, ret);
+            return ret;
+        }
+        ret = bake_write(bake_ph, region.tid, region.rid, 0, data, size);
+        if (ret != 0) {
+            margo_error(mid, "[mobject] %s:%d: bake_write returned %d",
+                        __func__, __LINE__, ret);
+            return ret;
+        }
+        vargs->persist_seq = mobject_deferred_persist_add(
+            provider, bake_ph, region.tid, region.rid, 0, size);
+        digest             = nullptr;
+    }
+    if (digest) {
+        char   value[MAX_REGION_VALUE_SIZE];
+        size_t value_size = encode_region_value(value, bake_target_idx,
+                                                &region.rid, &comp, nullptr);
+        // the region stays out of the index if the data was indexed by
+        // another write in the meantime
+        if (mobject_dedup_insert(provider, digest, value, value_size) != 0)
+            digest = nullptr;
+    }
+    return insert_region_log_entry(provider, oid, offset, len,
+                                   bake_target_idx, &region, 0, &comp,
+                                   digest);
+}
+
+/* Writes len bytes of the client's bulk handle, starting at remote_offset,
+ * at region_offset in an existing region (the append region of the
+ * object, see object-tails.h, or a region being overwritten). The bytes
+ * are persisted or registered for deferred persistence like in
+ * write_new_region. Returns 0 on success. */
+static int write_in_place(server_visitor_args_t  vargs,
+                          bake_provider_handle_t bake_ph,
+                          region_descriptor_t*   region,
+                          uint64_t               region_offset,
+                          uint64_t               remote_offset,
+                          uint64_t               len)
+{
+    margo_instance_id mid = vargs->provider->mid;
+    int               ret;
+
+    ret = bake_proxy_write(bake_ph, region->tid, region->rid, region_offset,
+                           vargs->bulk_handle, remote_offset,
+                           vargs->client_addr_str, len);
+    if (ret != 0) {
+        margo_error(mid, "[mobject] %s:%d: bake_proxy_write returned %d",
+                    __func__, __LINE__, ret);
+        return ret;
+    }
+    if (vargs->defer_persist) {
+        vargs->persist_seq = mobject_deferred_persist_add(
+            vargs->provider, bake_ph, region->tid, region->rid, region_offset,
+            len);
+        return 0;
+    }
+    ret = bake_persist(bake_ph, region->tid, region->rid, region_offset, len);
+    if (ret != 0)
+        margo_error(mid, "[mobject] %s:%d: bake_persist returned %d",
+                    __func__, __LINE__, ret);
+    return ret;
+}
+
+/* Finds the BAKE_REGION segment mapping exactly [offset, offset + len) of
+ * the object, provided that no more recent segment overlaps this range,
+ * that no other segment of the object, older or more recent, refers to
+ * the same region (as segments written by writesame do), so that
+ * overwriting the region only changes this range, and that the region is
+ * neither compressed nor shared by deduplication. Returns 0 and sets
+ * bake_ph and region if such a segment exists, -1 otherwise. */
+static int find_overwritable_region(struct mobject_provider* provider,
+                                    oid_t                    oid,
+                                    uint64_t                 offset,
+                                    uint64_t                 len,
+                                    bake_provider_handle_t*  bake_ph,
+                                    region_descriptor_t*     region)
+{
+    margo_instance_id mid = provider->mid;
+    ENTERING;
+    yk_database_handle_t seg_dbh = provider->segment_dbh;
+    segment_key_t        lb;
+    memset(&lb, 0, sizeof(lb));
+    lb.oid       = oid;
+    lb.timestamp = time(NULL);
+    lb.seq_id    = MOBJECT_SEQ_ID_MAX;
+    char   lb_key[MAX_SEGMENT_KEY_SIZE];
+    char   oid_key[OID_KEY_SIZE];
+    size_t lb_size = encode_segment_key(lb_key, &lb);
+    encode_oid_key(oid_key, oid);
+
+    size_t max_segments = 128;
+    char   segment_keys[max_segments * MAX_SEGMENT_KEY_SIZE];
+    size_t segment_keys_sizes[max_segments];
+    char   segment_data[max_segments * MAX_SEGMENT_VALUE_SIZE];
+    size_t segment_data_sizes[max_segments];
+    char   value[MAX_SEGMENT_VALUE_SIZE];
+    size_t value_size = 0;
+    int    found      = 0; // 1 once found, -1 if it cannot be overwritten
+    // regions of the segments more recent than the one found
+    std::vector<std::string> newer_regions;
+
+    bool done = false;
+    while (!done && found >= 0) {
+        yk_return_t yret = yk_list_keyvals_packed(
+            seg_dbh, YOKAN_MODE_DEFAULT, lb_key,
+            lb_size,                                /* strict lower bound */
+            oid_key, OID_KEY_SIZE,                  /* prefix */
+            max_segments,                           /* max key/val pairs */
+            segment_keys,                           /* keys buffer */
+            max_segments * MAX_SEGMENT_KEY_SIZE,    /* keys_buf_size */
+            segment_keys_sizes,                     /* key sizes */
+            segment_data,                           /* vals buffer */
+            max_segments * MAX_SEGMENT_VALUE_SIZE,  /* vals_buf_size */
+            segment_data_sizes);                    /* vals sizes */
+        if (yret != YOKAN_SUCCESS) {
+            margo_error(mid,
+                        "[mobject] %s:%d: yk_list_keyvals_packed returned %d",
+                        __func__, __LINE__, yret);
+            LEAVING;
+            return -1;
+        }
+
+        const char* seg_key = segment_keys;
+        const char* seg_val = segment_data;
+        for (size_t i = 0; i < max_segments && found >= 0; i++) {
+            segment_key_t seg;
+            if (segment_keys_sizes[i] == YOKAN_NO_MORE_KEYS) {
+                done = true;
+                break;
+            }
+            if (decode_segment_key(seg_key, segment_keys_sizes[i], &seg) != 0) {
+                margo_error(mid, "[mobject] %s:%d: invalid segment key",
+                            __func__, __LINE__);
+                LEAVING;
+                return -1;
+            }
+            if (found == 0) {
+                // segments are listed from the most recent one
+                if (seg.start_index < offset + len && seg.end_index > offset) {
+                    if (seg.type == seg_type_t::BAKE_REGION
+                        && seg.start_index == offset
+                        && seg.end_index == offset + len) {
+                        found      = 1;
+                        value_size = segment_data_sizes[i];
+                        memcpy(value, seg_val, value_size);
+                    } else {
+                        found = -1;
+                    }
+                } else if (seg.type == seg_type_t::BAKE_REGION) {
+                    newer_regions.emplace_back(seg_val, segment_data_sizes[i]);
+                }
+            } else if (seg.type == seg_type_t::BAKE_REGION
+                       && segment_data_sizes[i] == value_size
+                       && memcmp(seg_val, value, value_size) == 0) {
+                found = -1;
+            }
+            memcpy(lb_key, seg_key, segment_keys_sizes[i]);
+            lb_size = segment_keys_sizes[i];
+            seg_key += segment_keys_sizes[i];
+            seg_val += segment_data_sizes[i];
+        }
+    }
+
+    for (const auto& r : newer_regions) {
+        if (found == 1 && r.size() == value_size
+            && memcmp(r.data(), value, value_size) == 0)
+            found = -1;
+    }
+
+    LEAVING;
+    region_compression_t comp;
+    int                  dedup;
+    if (found != 1
+        || mobject_decode_region(provider, value, value_size, bake_ph, region,
+                                 &comp, nullptr, &dedup)
+               != 0)
+        return -1;
+    return comp.codec == REGION_CODEC_NONE && !dedup ? 0 : -1;
+}
+
+/* Creates a region holding len bytes of the client's bulk handle, starting
+ * at remote_offset. Unless the client asked for an early acknowledgement,
+ * the region is persisted before returning; otherwise it is registered
+ * for deferred persistence (see deferred-persist.h). */
+static int write_new_region(server_visitor_args_t  vargs,
+                            bake_provider_handle_t bake_ph,
+                            region_descriptor_t*   region,
+                            uint64_t               remote_offset,
+                            uint64_t               len)
+{
+    margo_instance_id mid = vargs->provider->mid;
+    int               ret;
+
+    if (!vargs->defer_persist) {
+        ret = bake_create_write_persist_proxy(
+            bake_ph, region->tid, vargs->bulk_handle, remote_offset,
+            vargs->client_addr_str, len, &region->rid);
+        if (ret != 0)
+            margo_error(mid,
+                        "[mobject] %s:%d: bake_create_write_persist_proxy "
+                        "returned %d",
+                        __func__, __LINE__, ret);
+        return ret;
+    }
+
+    ret = bake_create(bake_ph, region->tid, len, &region->rid);
+    if (ret != 0) {
+        margo_error(mid, "[mobject] %s:%d: bake_create returned %d", __func__,
+                    __LINE__, ret);
+        return ret;
+    }
+    ret = bake_proxy_write(bake_ph, region->tid, region->rid, 0,
+                           vargs->bulk_handle, remote_offset,
+                           vargs->client_addr_str, len);
+    if (ret != 0) {
+        margo_error(mid, "[mobject] %s:%d: bake_proxy_write returned %d",
+                    __func__, __LINE__, ret);
+        return ret;
+    }
+    vargs->persist_seq = mobject_deferred_persist_add(
+        vargs->provider, bake_ph, region->tid, region->rid, 0, len);
+    return 0;
+}
+
+static int insert_region_log_entry(struct mobject_provider*    provider,
+                                   oid_t                       oid,
+                                   uint64_t                    offset,
+                                   uint64_t                    len,
+                                   unsigned                    target_idx,
+                                   const region_descriptor_t*  region,
+                                   time_t                      ts,
+                                   const region_compression_t* comp,
+                                   const uint8_t*              digest)
 {
     margo_instance_id mid = provider->mid;
     ENTERING;
@@ -714,22 +1794,29 @@ static void insert_region_log_entry(struct mobject_provider*   provider,
     seg.seq_id = provider->seq_id++;
     ABT_mutex_unlock(ABT_MUTEX_MEMORY_GET_HANDLE(&provider->mutex));
 
-    yk_return_t yret
-        = yk_put(seg_dbh, YOKAN_MODE_DEFAULT, (const void*)&seg, sizeof(seg),
-                 (const void*)region, sizeof(*region));
+    char   seg_key[MAX_SEGMENT_KEY_SIZE];
+    char   seg_val[MAX_REGION_VALUE_SIZE];
+    size_t key_size = encode_segment_key(seg_key, &seg);
+    size_t val_size
+        = encode_region_value(seg_val, target_idx, &region->rid, comp, digest);
+    yk_return_t yret = yk_put(seg_dbh, YOKAN_MODE_DEFAULT, seg_key, key_size,
+                              seg_val, val_size);
     if (yret != YOKAN_SUCCESS) {
         margo_error(mid, "[mobject] %s:%d: yk_put returned %d", __func__,
                     __LINE__, yret);
+        LEAVING;
+        return -1;
     }
     LEAVING;
+    return 0;
 }
 
-static void insert_small_region_log_entry(struct mobject_provider* provider,
-                                          oid_t                    oid,
-                                          uint64_t                 offset,
-                                          uint64_t                 len,
-                                          const char*              data,
-                                          time_t                   ts)
+static int insert_small_region_log_entry(struct mobject_provider* provider,
+                                         oid_t                    oid,
+                                         uint64_t                 offset,
+                                         uint64_t                 len,
+                                         const char*              data,
+                                         time_t                   ts)
 {
     margo_instance_id mid = provider->mid;
     ENTERING;
@@ -744,20 +1831,25 @@ static void insert_small_region_log_entry(struct mobject_provider* provider,
     ABT_mutex_lock(ABT_MUTEX_MEMORY_GET_HANDLE(&provider->mutex));
     seg.seq_id = provider->seq_id++;
     ABT_mutex_unlock(ABT_MUTEX_MEMORY_GET_HANDLE(&provider->mutex));
-    yk_return_t yret = yk_put(seg_dbh, YOKAN_MODE_DEFAULT, (const void*)&seg,
-                              sizeof(seg), (const void*)data, len);
+    char   seg_key[MAX_SEGMENT_KEY_SIZE];
+    size_t key_size  = encode_segment_key(seg_key, &seg);
+    yk_return_t yret = yk_put(seg_dbh, YOKAN_MODE_DEFAULT, seg_key, key_size,
+                              (const void*)data, len);
     if (yret != YOKAN_SUCCESS) {
         margo_error(mid, "[mobject] %s:%d: yk_put returned %d", __func__,
                     __LINE__, yret);
+        LEAVING;
+        return -1;
     }
     LEAVING;
+    return 0;
 }
 
-static void insert_zero_log_entry(struct mobject_provider* provider,
-                                  oid_t                    oid,
-                                  uint64_t                 offset,
-                                  uint64_t                 len,
-                                  time_t                   ts)
+static int insert_zero_log_entry(struct mobject_provider* provider,
+                                 oid_t                    oid,
+                                 uint64_t                 offset,
+                                 uint64_t                 len,
+                                 time_t                   ts)
 {
     margo_instance_id mid = provider->mid;
     ENTERING;
@@ -773,19 +1865,24 @@ static void insert_zero_log_entry(struct mobject_provider* provider,
     seg.seq_id = provider->seq_id++;
     ABT_mutex_unlock(ABT_MUTEX_MEMORY_GET_HANDLE(&provider->mutex));
 
-    yk_return_t yret = yk_put(seg_dbh, YOKAN_MODE_DEFAULT, (const void*)&seg,
-                              sizeof(seg), (const void*)nullptr, 0);
+    char   seg_key[MAX_SEGMENT_KEY_SIZE];
+    size_t key_size  = encode_segment_key(seg_key, &seg);
+    yk_return_t yret = yk_put(seg_dbh, YOKAN_MODE_DEFAULT, seg_key, key_size,
+                              (const void*)nullptr, 0);
     if (yret != YOKAN_SUCCESS) {
         margo_error(mid, "[mobject] %s:%d: yk_put returned %d", __func__,
                     __LINE__, yret);
+        LEAVING;
+        return -1;
     }
     LEAVING;
+    return 0;
 }
 
-static void insert_punch_log_entry(struct mobject_provider* provider,
-                                   oid_t                    oid,
-                                   uint64_t                 offset,
-                                   time_t                   ts)
+static int insert_punch_log_entry(struct mobject_provider* provider,
+                                  oid_t                    oid,
+                                  uint64_t                 offset,
+                                  time_t                   ts)
 {
     margo_instance_id mid = provider->mid;
     ENTERING;
@@ -801,13 +1898,18 @@ static void insert_punch_log_entry(struct mobject_provider* provider,
     seg.seq_id = provider->seq_id++;
     ABT_mutex_unlock(ABT_MUTEX_MEMORY_GET_HANDLE(&provider->mutex));
 
-    yk_return_t yret = yk_put(seg_dbh, YOKAN_MODE_DEFAULT, (const void*)&seg,
-                              sizeof(seg), (const void*)nullptr, 0);
+    char   seg_key[MAX_SEGMENT_KEY_SIZE];
+    size_t key_size  = encode_segment_key(seg_key, &seg);
+    yk_return_t yret = yk_put(seg_dbh, YOKAN_MODE_DEFAULT, seg_key, key_size,
+                              (const void*)nullptr, 0);
     if (yret != YOKAN_SUCCESS) {
         margo_error(mid, "[mobject] %s:%d: yk_put returned %d", __func__,
                     __LINE__, yret);
+        LEAVING;
+        return -1;
     }
     LEAVING;
+    return 0;
 }
 
 uint64_t mobject_compute_object_size(struct mobject_provider* provider,
@@ -818,28 +1920,33 @@ uint64_t mobject_compute_object_size(struct mobject_provider* provider,
     margo_instance_id mid = provider->mid;
     ENTERING;
     segment_key_t lb;
+    memset(&lb, 0, sizeof(lb));
     lb.oid       = oid;
     lb.timestamp = ts;
     lb.seq_id    = MOBJECT_SEQ_ID_MAX;
+    char   lb_key[MAX_SEGMENT_KEY_SIZE];
+    char   oid_key[OID_KEY_SIZE];
+    size_t lb_size = encode_segment_key(lb_key, &lb);
+    encode_oid_key(oid_key, oid);
 
     uint64_t size     = 0; // current assumed size
     uint64_t max_size = std::numeric_limits<uint64_t>::max();
 
-    size_t         max_segments = 128;
-    segment_key_t* segment_keys
-        = (segment_key_t*)calloc(max_segments, sizeof(segment_key_t));
+    size_t  max_segments = 128;
+    char*   segment_keys
+        = (char*)calloc(max_segments, MAX_SEGMENT_KEY_SIZE);
     size_t* segment_keys_size = (size_t*)calloc(max_segments, sizeof(size_t));
 
     bool done          = false;
     int  seg_start_ndx = 0;
     while (!done) {
         yk_return_t yret = yk_list_keys_packed(
-            seg_dbh, YOKAN_MODE_DEFAULT, (const void*)&lb,
-            sizeof(lb),                           /* strict lower bound */
-            (const void*)&oid, sizeof(oid),       /* prefix */
+            seg_dbh, YOKAN_MODE_DEFAULT, lb_key,
+            lb_size,                              /* strict lower bound */
+            oid_key, OID_KEY_SIZE,                /* prefix */
             max_segments,                         /* count */
             segment_keys,                         /* keys */
-            max_segments * sizeof(segment_key_t), /* buffer size */
+            max_segments * MAX_SEGMENT_KEY_SIZE,  /* buffer size */
             segment_keys_size);                   /* key sizes */
 
         if (yret != YOKAN_SUCCESS) {
@@ -851,12 +1958,19 @@ uint64_t mobject_compute_object_size(struct mobject_provider* provider,
             return 0;
         }
 
+        const char* seg_key = segment_keys;
         for (size_t i = 0; i < max_segments; i++) {
             if (segment_keys_size[i] == YOKAN_NO_MORE_KEYS) {
                 done = true;
                 break;
             }
-            auto& seg = segment_keys[i];
+            segment_key_t seg;
+            if (decode_segment_key(seg_key, segment_keys_size[i], &seg) != 0) {
+                margo_error(mid, "[mobject] %s:%d: invalid segment key",
+                            __func__, __LINE__);
+                done = true;
+                break;
+            }
             if (seg.type < seg_type_t::TOMBSTONE) {
                 if (size < seg.end_index) {
                     size = std::min(seg.end_index, max_size);
@@ -867,8 +1981,9 @@ uint64_t mobject_compute_object_size(struct mobject_provider* provider,
                 done = true;
                 break;
             }
-            lb.timestamp = seg.timestamp;
-            lb.seq_id    = seg.seq_id;
+            memcpy(lb_key, seg_key, segment_keys_size[i]);
+            lb_size = segment_keys_size[i];
+            seg_key += segment_keys_size[i];
         }
     }
 
@@ -877,3 +1992,63 @@ uint64_t mobject_compute_object_size(struct mobject_provider* provider,
     LEAVING;
     return size;
 }
+
+/* Finds the bake provider handle, target id and region id of the region
+ * referenced by the value of a BAKE_REGION segment (see key-encoding.h),
+ * and, if comp, digest and has_digest are not NULL, its compression and
+ * whether (and with which digest) it is shared by deduplication.
+ * Returns 0 on success, -1 if the value is invalid or refers to a target
+ * the provider does not know. */
+int mobject_decode_region(struct mobject_provider* provider,
+                          const void*              value,
+                          size_t                   size,
+                          bake_provider_handle_t*  bake_ph,
+                          region_descriptor_t*     region,
+                          region_compression_t*    comp,
+                          uint8_t*                 digest,
+                          int*                     has_digest)
+{
+    margo_instance_id    mid = provider->mid;
+    uint32_t             target_idx;
+    region_compression_t ignored;
+
+    if (!comp) comp = &ignored;
+    if (size == sizeof(region_descriptor_t)) {
+        // value written by an older version, holding the target id
+        memcpy(region, value, sizeof(*region));
+        comp->codec = REGION_CODEC_NONE;
+        if (has_digest) *has_digest = 0;
+        for (unsigned j = 0; j < provider->num_bake_targets; j++) {
+            if (memcmp(&region->tid, &provider->bake_targets[j].tid,
+                       sizeof(bake_target_id_t))
+                == 0) {
+                *bake_ph = provider->bake_targets[j].ph;
+                return 0;
+            }
+        }
+        margo_error(mid,
+                    "[mobject] %s:%d: could not find bake provider "
+                    "handle associated with stored target id",
+                    __func__, __LINE__);
+        return -1;
+    }
+
+    if (decode_region_value(value, size, &target_idx, &region->rid, comp,
+                            digest, has_digest)
+        != 0) {
+        margo_error(mid, "[mobject] %s:%d: invalid region of size %zu",
+                    __func__, __LINE__, size);
+        return -1;
+    }
+    if (target_idx >= provider->num_bake_targets) {
+        margo_error(mid,
+                    "[mobject] %s:%d: stored target index %u is out of "
+                    "range (%u targets)",
+                    __func__, __LINE__, target_idx,
+                    provider->num_bake_targets);
+        return -1;
+    }
+    *bake_ph    = provider->bake_targets[target_idx].ph;
+    region->tid = provider->bake_targets[target_idx].tid;
+    return 0;
+}
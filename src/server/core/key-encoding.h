@@ -0,0 +1,307 @@
+/*
+ * (C) 2018 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __CORE_KEY_ENCODING_H
+#define __CORE_KEY_ENCODING_H
+
+#include <stdint.h>
+#include <string.h>
+#include "src/server/core/key-types.h"
+
+/**
+ * Keys are stored in the Yokan databases in an encoding that sorts
+ * correctly when compared byte by byte (memcmp, then length), which is
+ * what the default comparator of every Yokan backend does. This allows
+ * the metadata to be stored in any ordered backend (map, rocksdb, lmdb,
+ * ...) without installing custom comparators.
+ *
+ * - oid keys (mobject_oid_map) are the oid in big-endian order;
+ * - name keys (mobject_name_map) are the null-terminated object name;
+ * - segment keys (mobject_seg_map) are the oid in big-endian order, the
+ *   timestamp and the seq_id as descending key integers (so that the
+ *   most recent segments of an object come first), the type on a single
+ *   byte, and the start index and length of the segment as key integers
+ *   (see encode_key_int);
+ * - omap keys (mobject_omap_map) are the oid in big-endian order
+ *   followed by the characters of the key, without terminating null
+ *   byte, so that keys sort as with strcmp and a key prefix is also a
+ *   prefix of the encoded key.
+ *
+ * The oid of a segment or omap key is therefore a prefix of the key.
+ * Databases created before this encoding can be converted with the
+ * mobject-migrate-keys tool.
+ *
+ * The value of a BAKE_REGION segment is the index of the bake target in
+ * the provider's bake_targets array, as a key integer, followed by the
+ * region id. Values written by older versions hold a full
+ * region_descriptor_t instead, and are recognized by their size (the
+ * encoding of an index is always shorter than a bake_target_id_t).
+ * When the region holds compressed data, the value is followed by the
+ * codec on one byte and by the sizes of the compressed and decompressed
+ * data as big-endian 32-bit integers; since a 32-bit index is encoded on
+ * at most 5 bytes, such values remain shorter than legacy ones. When the
+ * region is shared by deduplication (see region-dedup.h), the value ends
+ * with the REGION_DIGEST_SIZE bytes digest of its data, which makes it
+ * longer than legacy values.
+ */
+
+#define OID_KEY_SIZE     8
+#define MAX_KEY_INT_SIZE 9
+
+/* largest encoded segment key: oid, type and four key integers */
+#define MAX_SEGMENT_KEY_SIZE (OID_KEY_SIZE + 1 + 4 * MAX_KEY_INT_SIZE)
+
+/* codecs of the data of BAKE_REGION segments */
+#define REGION_CODEC_NONE 0
+#define REGION_CODEC_LZ4  1
+#define REGION_CODEC_ZSTD 2
+
+/* compression of the data of a region */
+typedef struct region_compression_t {
+    uint8_t  codec;     // REGION_CODEC_*
+    uint32_t size;      // bytes of compressed data in the region
+    uint32_t data_size; // bytes of data once decompressed
+} region_compression_t;
+
+#define REGION_COMPRESSION_SIZE 9
+
+/* size of the digest of the data of a deduplicated region */
+#define REGION_DIGEST_SIZE 16
+
+/* largest encoded BAKE_REGION value */
+#define MAX_REGION_VALUE_SIZE                                               \
+    (MAX_KEY_INT_SIZE + sizeof(bake_region_id_t) + REGION_COMPRESSION_SIZE \
+     + REGION_DIGEST_SIZE)
+
+/* largest value of mobject_seg_map (BAKE_REGION values, legacy ones and
+   SMALL_REGION values) */
+#define MAX_SEGMENT_VALUE_SIZE                           \
+    (MAX_REGION_VALUE_SIZE > sizeof(region_descriptor_t) \
+         ? MAX_REGION_VALUE_SIZE                         \
+         : sizeof(region_descriptor_t))
+
+#define KEY_ASCENDING  0x00
+#define KEY_DESCENDING 0xff
+
+static inline void encode_be64(void* buf, uint64_t v)
+{
+    uint8_t* p = (uint8_t*)buf;
+    int      i;
+    for (i = 7; i >= 0; i--, v >>= 8) p[i] = (uint8_t)v;
+}
+
+static inline uint64_t decode_be64(const void* buf)
+{
+    const uint8_t* p = (const uint8_t*)buf;
+    uint64_t       v = 0;
+    int            i;
+    for (i = 0; i < 8; i++) v = (v << 8) | p[i];
+    return v;
+}
+
+static inline void encode_be32(void* buf, uint32_t v)
+{
+    uint8_t* p = (uint8_t*)buf;
+    int      i;
+    for (i = 3; i >= 0; i--, v >>= 8) p[i] = (uint8_t)v;
+}
+
+static inline uint32_t decode_be32(const void* buf)
+{
+    const uint8_t* p = (const uint8_t*)buf;
+    uint32_t       v = 0;
+    int            i;
+    for (i = 0; i < 4; i++) v = (v << 8) | p[i];
+    return v;
+}
+
+/* buf must hold OID_KEY_SIZE bytes */
+static inline void encode_oid_key(void* buf, oid_t oid)
+{
+    encode_be64(buf, oid);
+}
+
+static inline oid_t decode_oid_key(const void* buf)
+{
+    return decode_be64(buf);
+}
+
+/* Encodes v as a key integer: a byte giving the number n of significant
+ * bytes of v (0 to 8) followed by these n bytes in big-endian order.
+ * Key integers sort as the values they encode and no encoding is a prefix
+ * of another one. With KEY_DESCENDING as mask, all the bytes are
+ * complemented so that the encodings sort in decreasing order. buf must
+ * hold MAX_KEY_INT_SIZE bytes, returns the size used. */
+static inline size_t encode_key_int(void* buf, uint64_t v, uint8_t mask)
+{
+    uint8_t* p = (uint8_t*)buf;
+    size_t   n = 0, i;
+    uint64_t t;
+    for (t = v; t != 0; t >>= 8) n++;
+    p[0] = (uint8_t)n ^ mask;
+    for (i = n; i > 0; i--, v >>= 8) p[i] = (uint8_t)v ^ mask;
+    return n + 1;
+}
+
+/* decodes a key integer encoded with the same mask from the size bytes
+ * of buf, returns the size used (0 if invalid) */
+static inline size_t
+decode_key_int(const void* buf, size_t size, uint64_t* v, uint8_t mask)
+{
+    const uint8_t* p = (const uint8_t*)buf;
+    size_t         n, i;
+    if (size == 0) return 0;
+    n = p[0] ^ mask;
+    if (n > 8 || n + 1 > size) return 0;
+    *v = 0;
+    for (i = 1; i <= n; i++) *v = (*v << 8) | (uint8_t)(p[i] ^ mask);
+    return n + 1;
+}
+
+/* buf must hold MAX_SEGMENT_KEY_SIZE bytes, returns the size used */
+static inline size_t encode_segment_key(void* buf, const segment_key_t* seg)
+{
+    char*  p = (char*)buf;
+    size_t n = OID_KEY_SIZE;
+    encode_be64(p, seg->oid);
+    n += encode_key_int(p + n, (uint64_t)seg->timestamp, KEY_DESCENDING);
+    n += encode_key_int(p + n, seg->seq_id, KEY_DESCENDING);
+    p[n++] = (char)seg->type;
+    n += encode_key_int(p + n, seg->start_index, KEY_ASCENDING);
+    n += encode_key_int(p + n, seg->end_index - seg->start_index,
+                        KEY_ASCENDING);
+    return n;
+}
+
+/* decodes an encoded segment key of the given size,
+ * returns 0 on success, -1 if the key is invalid */
+static inline int
+decode_segment_key(const void* buf, size_t size, segment_key_t* seg)
+{
+    const char* p = (const char*)buf;
+    size_t      n = OID_KEY_SIZE, k;
+    uint64_t    v[4];
+    uint8_t     masks[4]
+        = {KEY_DESCENDING, KEY_DESCENDING, KEY_ASCENDING, KEY_ASCENDING};
+    int i;
+
+    if (size <= OID_KEY_SIZE || size > MAX_SEGMENT_KEY_SIZE) return -1;
+    seg->oid = decode_be64(p);
+    for (i = 0; i < 4; i++) {
+        if (i == 2) {
+            if (n >= size) return -1;
+            seg->type = (uint8_t)p[n++];
+        }
+        k = decode_key_int(p + n, size - n, &v[i], masks[i]);
+        if (k == 0) return -1;
+        n += k;
+    }
+    if (n != size || v[1] > UINT32_MAX) return -1;
+    seg->timestamp   = (time_t)v[0];
+    seg->seq_id      = (uint32_t)v[1];
+    seg->start_index = v[2];
+    seg->end_index   = v[2] + v[3];
+    return 0;
+}
+
+/* buf must hold MAX_REGION_VALUE_SIZE bytes, comp is NULL if the region
+ * is not compressed, digest NULL if it is not deduplicated, returns the
+ * size used */
+static inline size_t encode_region_value(void*                       buf,
+                                         uint32_t                    target_idx,
+                                         const bake_region_id_t*     rid,
+                                         const region_compression_t* comp,
+                                         const uint8_t*              digest)
+{
+    char*  p = (char*)buf;
+    size_t n = encode_key_int(p, target_idx, KEY_ASCENDING);
+    memcpy(p + n, rid, sizeof(*rid));
+    n += sizeof(*rid);
+    if (comp && comp->codec != REGION_CODEC_NONE) {
+        p[n] = (char)comp->codec;
+        encode_be32(p + n + 1, comp->size);
+        encode_be32(p + n + 5, comp->data_size);
+        n += REGION_COMPRESSION_SIZE;
+    }
+    if (digest) {
+        memcpy(p + n, digest, REGION_DIGEST_SIZE);
+        n += REGION_DIGEST_SIZE;
+    }
+    return n;
+}
+
+/* decodes a BAKE_REGION value of the given size written by
+ * encode_region_value, comp->codec being REGION_CODEC_NONE if the region
+ * is not compressed, and *has_digest 0 if the region is not deduplicated
+ * (digest being left unchanged, digest and has_digest may be NULL);
+ * returns 0 on success, -1 if invalid */
+static inline int decode_region_value(const void*           buf,
+                                      size_t                size,
+                                      uint32_t*             target_idx,
+                                      bake_region_id_t*     rid,
+                                      region_compression_t* comp,
+                                      uint8_t*              digest,
+                                      int*                  has_digest)
+{
+    const char* p = (const char*)buf;
+    uint64_t    idx;
+    size_t      n = decode_key_int(p, size, &idx, KEY_ASCENDING);
+    size_t      rest;
+    if (n == 0 || idx > UINT32_MAX || n + sizeof(*rid) > size) return -1;
+    rest = size - n - sizeof(*rid);
+    if (rest == 0 || rest == REGION_DIGEST_SIZE) {
+        comp->codec = REGION_CODEC_NONE;
+    } else if (rest == REGION_COMPRESSION_SIZE
+               || rest == REGION_COMPRESSION_SIZE + REGION_DIGEST_SIZE) {
+        comp->codec     = (uint8_t)p[n + sizeof(*rid)];
+        comp->size      = decode_be32(p + n + sizeof(*rid) + 1);
+        comp->data_size = decode_be32(p + n + sizeof(*rid) + 5);
+        if (comp->codec == REGION_CODEC_NONE) return -1;
+    } else {
+        return -1;
+    }
+    if (rest >= REGION_DIGEST_SIZE && digest)
+        memcpy(digest, p + size - REGION_DIGEST_SIZE, REGION_DIGEST_SIZE);
+    if (has_digest) *has_digest = rest >= REGION_DIGEST_SIZE;
+    memcpy(rid, p + n, sizeof(*rid));
+    *target_idx = (uint32_t)idx;
+    return 0;
+}
+
+/* omap keys have at most MAX_OMAP_KEY_SIZE characters, actions on longer
+ * keys are rejected rather than applied to a truncated key */
+static inline int omap_key_valid(const char* key)
+{
+    return strnlen(key, MAX_OMAP_KEY_SIZE + 1) <= MAX_OMAP_KEY_SIZE;
+}
+
+/* size of the encoding of an omap key of key_len characters */
+static inline size_t omap_key_size(size_t key_len)
+{
+    return OID_KEY_SIZE + key_len;
+}
+
+/* buf must hold omap_key_size(key_len) bytes, returns the size used */
+static inline size_t
+encode_omap_key(void* buf, oid_t oid, const char* key, size_t key_len)
+{
+    encode_be64(buf, oid);
+    memcpy((char*)buf + OID_KEY_SIZE, key, key_len);
+    return omap_key_size(key_len);
+}
+
+/* sets key and key_len to the characters of the key (not null-terminated)
+ * and returns the oid of an encoded omap key of the given size */
+static inline oid_t decode_omap_key(const void*  buf,
+                                    size_t       size,
+                                    const char** key,
+                                    size_t*      key_len)
+{
+    *key     = (const char*)buf + OID_KEY_SIZE;
+    *key_len = size - OID_KEY_SIZE;
+    return decode_be64(buf);
+}
+
+#endif
@@ -49,13 +49,14 @@ typedef struct region_descriptor_t {
     bake_region_id_t rid;
 } region_descriptor_t;
 
+/* layout of omap keys in databases created before keys were
+   encoded (see key-encoding.h), only used to read such databases */
 typedef struct omap_key_t {
     oid_t oid;
     char  key[1];
 } omap_key_t;
 
 #define MAX_OMAP_KEY_SIZE 128
-#define MAX_OMAP_VAL_SIZE 256
 
 #define SMALL_REGION_THRESHOLD (sizeof(region_descriptor_t))
 
@@ -0,0 +1,171 @@
+/*
+ * (C) 2018 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "src/server/deferred-persist.h"
+#include "src/util/utlist.h"
+
+#define PERSIST_MUTEX(p) ABT_MUTEX_MEMORY_GET_HANDLE(&(p)->persist_mutex)
+#define PERSIST_COND(p)  ABT_COND_MEMORY_GET_HANDLE(&(p)->persist_cond)
+
+static int  persist_regions(struct mobject_provider*            provider,
+                            struct mobject_unpersisted_region** regions);
+static void record_failure(struct mobject_provider* provider,
+                           uint64_t                 from,
+                           uint64_t                 to);
+
+uint64_t mobject_deferred_persist_add(struct mobject_provider* provider,
+                                      bake_provider_handle_t   ph,
+                                      bake_target_id_t         tid,
+                                      bake_region_id_t         rid,
+                                      uint64_t                 offset,
+                                      uint64_t                 size)
+{
+    struct mobject_unpersisted_region* region = calloc(1, sizeof(*region));
+    uint64_t                           seq;
+
+    region->ph     = ph;
+    region->tid    = tid;
+    region->rid    = rid;
+    region->offset = offset;
+    region->size   = size;
+
+    ABT_mutex_lock(PERSIST_MUTEX(provider));
+    seq = region->seq = ++provider->persist_seq;
+    DL_APPEND(provider->unpersisted, region);
+    ABT_mutex_unlock(PERSIST_MUTEX(provider));
+
+    return seq;
+}
+
+int mobject_deferred_persist_wait(struct mobject_provider* provider,
+                                  uint64_t                 seq)
+{
+    struct mobject_unpersisted_region* regions;
+    struct mobject_persist_failure*    failure;
+    uint64_t                           upto;
+    int                                failed;
+
+    ABT_mutex_lock(PERSIST_MUTEX(provider));
+    while (provider->persisted_seq < seq) {
+        if (provider->persisting) {
+            ABT_cond_wait(PERSIST_COND(provider), PERSIST_MUTEX(provider));
+            continue;
+        }
+        /* persist everything registered so far on behalf of all waiters */
+        regions               = provider->unpersisted;
+        upto                  = provider->persist_seq;
+        provider->unpersisted = NULL;
+        provider->persisting  = 1;
+        ABT_mutex_unlock(PERSIST_MUTEX(provider));
+
+        failed = persist_regions(provider, &regions);
+
+        ABT_mutex_lock(PERSIST_MUTEX(provider));
+        if (failed) record_failure(provider, provider->persisted_seq + 1, upto);
+        provider->persisted_seq = upto;
+        provider->persisting    = 0;
+        ABT_cond_broadcast(PERSIST_COND(provider));
+    }
+    failed = 0;
+    if (seq != 0) {
+        DL_FOREACH(provider->persist_failures, failure)
+        {
+            if (seq >= failure->from && seq <= failure->to) failed = 1;
+        }
+    }
+    ABT_mutex_unlock(PERSIST_MUTEX(provider));
+
+    return failed ? -1 : 0;
+}
+
+void mobject_deferred_persist_finalize(struct mobject_provider* provider)
+{
+    uint64_t seq;
+
+    ABT_mutex_lock(PERSIST_MUTEX(provider));
+    seq = provider->persist_seq;
+    ABT_mutex_unlock(PERSIST_MUTEX(provider));
+
+    mobject_deferred_persist_wait(provider, seq);
+
+    struct mobject_persist_failure *failure, *tmp;
+    DL_FOREACH_SAFE(provider->persist_failures, failure, tmp)
+    {
+        DL_DELETE(provider->persist_failures, failure);
+        free(failure);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                          STATIC FUNCTIONS BELOW                            //
+////////////////////////////////////////////////////////////////////////////////
+
+static int same_region(struct mobject_unpersisted_region* a,
+                       struct mobject_unpersisted_region* b)
+{
+    return a->ph == b->ph && memcmp(&a->tid, &b->tid, sizeof(a->tid)) == 0
+        && memcmp(&a->rid, &b->rid, sizeof(a->rid)) == 0;
+}
+
+/* persists and frees the regions of a group, merging adjacent or
+ * overlapping ranges of a region; returns 1 if any bake_persist failed */
+static int persist_regions(struct mobject_provider*            provider,
+                           struct mobject_unpersisted_region** regions)
+{
+    struct mobject_unpersisted_region *region, *next;
+    uint64_t                           start, end;
+    int                                ret, failed = 0;
+
+    while ((region = *regions) != NULL) {
+        start = region->offset;
+        end   = region->offset + region->size;
+        DL_DELETE(*regions, region);
+        while ((next = *regions) != NULL && same_region(region, next)
+               && next->offset <= end && next->offset + next->size >= start) {
+            if (next->offset < start) start = next->offset;
+            if (next->offset + next->size > end)
+                end = next->offset + next->size;
+            DL_DELETE(*regions, next);
+            free(next);
+        }
+        ret = bake_persist(region->ph, region->tid, region->rid, start,
+                           end - start);
+        if (ret != 0) {
+            margo_error(provider->mid,
+                        "[mobject] %s:%d: bake_persist returned %d", __func__,
+                        __LINE__, ret);
+            failed = 1;
+        }
+        free(region);
+    }
+    return failed;
+}
+
+/* called with the persist mutex held */
+static void record_failure(struct mobject_provider* provider,
+                           uint64_t                 from,
+                           uint64_t                 to)
+{
+    struct mobject_persist_failure* last = NULL;
+
+    if (provider->persist_failures) last = provider->persist_failures->prev;
+    if (last && last->to + 1 == from) {
+        last->to = to;
+        return;
+    }
+    struct mobject_persist_failure* failure = calloc(1, sizeof(*failure));
+    if (failure == NULL) {
+        margo_error(provider->mid,
+                    "[mobject] %s:%d: could not record failure of seq %lu-%lu",
+                    __func__, __LINE__, (unsigned long)from,
+                    (unsigned long)to);
+        return;
+    }
+    failure->from = from;
+    failure->to   = to;
+    DL_APPEND(provider->persist_failures, failure);
+}
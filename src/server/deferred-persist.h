@@ -0,0 +1,84 @@
+/*
+ * (C) 2018 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __SERVER_DEFERRED_PERSIST_H
+#define __SERVER_DEFERRED_PERSIST_H
+
+#include <stdint.h>
+#include <bake-client.h>
+#include "src/server/mobject-provider.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Write operations sent with LIBMOBJECT_OPERATION_EARLY_ACK are
+ * acknowledged as soon as their data has been written to bake and the
+ * corresponding segments are visible, without waiting for bake_persist.
+ * Each region written this way is registered here and given a sequence
+ * number; the write_op's reply carries the largest sequence number of its
+ * regions.
+ *
+ * Regions are persisted in groups: the first ULT that needs a region to
+ * be persisted persists all the regions registered so far, while other
+ * ULTs wait for it, so that a single pass over the pending regions serves
+ * every request that arrived in the meantime. Within a group, adjacent or
+ * overlapping ranges of the same region are persisted with a single call
+ * to bake_persist.
+ */
+struct mobject_unpersisted_region {
+    bake_provider_handle_t             ph;
+    bake_target_id_t                   tid;
+    bake_region_id_t                   rid;
+    uint64_t                           offset;
+    uint64_t                           size;
+    uint64_t                           seq;
+    struct mobject_unpersisted_region* prev;
+    struct mobject_unpersisted_region* next;
+};
+
+/**
+ * Range of sequence numbers of a group in which persisting a region
+ * failed. Failures are kept for the lifetime of the provider, since
+ * clients may wait for a sequence number long after its group was
+ * persisted; consecutive failed groups are merged into one range.
+ */
+struct mobject_persist_failure {
+    uint64_t                        from;
+    uint64_t                        to;
+    struct mobject_persist_failure* prev;
+    struct mobject_persist_failure* next;
+};
+
+/**
+ * Registers the size bytes at offset in a region, which have been written
+ * but not persisted, and returns their sequence number.
+ */
+uint64_t mobject_deferred_persist_add(struct mobject_provider* provider,
+                                      bake_provider_handle_t   ph,
+                                      bake_target_id_t         tid,
+                                      bake_region_id_t         rid,
+                                      uint64_t                 offset,
+                                      uint64_t                 size);
+
+/**
+ * Blocks until all the regions with a sequence number up to seq are
+ * persisted, persisting pending regions if no other ULT is doing it.
+ * Returns 0 on success, -1 if persisting one of the regions failed.
+ */
+int mobject_deferred_persist_wait(struct mobject_provider* provider,
+                                  uint64_t                 seq);
+
+/**
+ * Persists all the pending regions and releases the recorded failures.
+ */
+void mobject_deferred_persist_finalize(struct mobject_provider* provider);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
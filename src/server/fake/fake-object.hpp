@@ -7,6 +7,7 @@
 #define __FAKE_OBJECT_HPP
 
 #include <iostream>
+#include <cerrno>
 #include <cstring>
 #include <vector>
 #include <string>
@@ -36,6 +37,50 @@ class fake_object {
 
     void omap_rm(const std::string& key) { m_omap.erase(key); }
 
+    // removes the keys in [start, end), or from start on if end is empty
+    void omap_rm_range(const std::string& start, const std::string& end)
+    {
+        if (!end.empty() && end <= start) return;
+        auto first = m_omap.lower_bound(start);
+        auto last  = end.empty() ? m_omap.end() : m_omap.lower_bound(end);
+        m_omap.erase(first, last);
+    }
+
+    void omap_clear() { m_omap.clear(); }
+
+    // adds delta to the int64_t value of key (0 if it does not exist)
+    int omap_add(const std::string& key, int64_t delta, int64_t* result)
+    {
+        int64_t value = 0;
+        auto    it    = m_omap.find(key);
+        if (it != m_omap.end()) {
+            if (it->second.size() != sizeof(value)) return -EINVAL;
+            memcpy(&value, it->second.data(), sizeof(value));
+        }
+        value += delta;
+        omap_set(key, sizeof(value), (const char*)&value);
+        *result = value;
+        return 0;
+    }
+
+    // sets key to val if its value is cmp (if it does not exist if cmp is
+    // NULL)
+    int omap_cmpxchg(const std::string& key,
+                     const char*        cmp,
+                     size_t             cmp_len,
+                     const char*        val,
+                     size_t             val_len)
+    {
+        auto it    = m_omap.find(key);
+        bool match = it == m_omap.end()
+                       ? cmp == NULL
+                       : cmp && it->second.size() == cmp_len
+                             && memcmp(it->second.data(), cmp, cmp_len) == 0;
+        if (!match) return -ECANCELED;
+        omap_set(key, val_len, val);
+        return 0;
+    }
+
     void omap_get_keys(const std::string&        start_after,
                        size_t                    max,
                        mobject_store_omap_iter_t iter) const
@@ -145,15 +190,16 @@ class fake_object {
         }
     }
 
-    void append(margo_instance_id mid,
-                hg_addr_t         client_addr,
-                hg_bulk_t         bulk_handle,
-                uint64_t          remote_offset,
-                size_t            len)
+    uint64_t append(margo_instance_id mid,
+                    hg_addr_t         client_addr,
+                    hg_bulk_t         bulk_handle,
+                    uint64_t          remote_offset,
+                    size_t            len)
     {
 
         uint64_t local_offset = m_data.size();
         write(mid, client_addr, bulk_handle, remote_offset, local_offset, len);
+        return local_offset;
     }
 
     void truncate(uint64_t offset)
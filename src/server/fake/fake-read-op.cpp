@@ -18,11 +18,12 @@ static void read_op_exec_begin(void*);
 static void read_op_exec_stat(void*, uint64_t*, time_t*, int*);
 static void read_op_exec_read(void*, uint64_t, size_t, buffer_u, size_t*, int*);
 static void read_op_exec_omap_get_keys(
-    void*, const char*, uint64_t, mobject_store_omap_iter_t*, int*);
+    void*, const char*, uint64_t, size_t, mobject_store_omap_iter_t*, int*);
 static void read_op_exec_omap_get_vals(void*,
                                        const char*,
                                        const char*,
                                        uint64_t,
+                                       size_t,
                                        mobject_store_omap_iter_t*,
                                        int*);
 static void read_op_exec_omap_get_vals_by_keys(
@@ -87,6 +88,7 @@ void read_op_exec_read(void*    u,
 void read_op_exec_omap_get_keys(void*                      u,
                                 const char*                start_after,
                                 uint64_t                   max_return,
+                                size_t                     max_bytes,
                                 mobject_store_omap_iter_t* iter,
                                 int*                       prval)
 {
@@ -109,6 +111,7 @@ void read_op_exec_omap_get_vals(void*                      u,
                                 const char*                start_after,
                                 const char*                filter_prefix,
                                 uint64_t                   max_return,
+                                size_t                     max_bytes,
                                 mobject_store_omap_iter_t* iter,
                                 int*                       prval)
 {
@@ -18,27 +18,36 @@ static void write_op_exec_create(void*, int);
 static void write_op_exec_write(void*, buffer_u, size_t, uint64_t);
 static void write_op_exec_write_full(void*, buffer_u, size_t);
 static void write_op_exec_writesame(void*, buffer_u, size_t, size_t, uint64_t);
-static void write_op_exec_append(void*, buffer_u, size_t);
+static void write_op_exec_append(void*, buffer_u, size_t, uint64_t*, int*);
 static void write_op_exec_remove(void*);
 static void write_op_exec_truncate(void*, uint64_t);
 static void write_op_exec_zero(void*, uint64_t, uint64_t);
 static void write_op_exec_omap_set(
     void*, char const* const*, char const* const*, const size_t*, size_t);
 static void write_op_exec_omap_rm_keys(void*, char const* const*, size_t);
+static void write_op_exec_omap_rm_range(void*, const char*, const char*);
+static void write_op_exec_omap_clear(void*);
+static void write_op_exec_omap_add(void*, const char*, int64_t, int64_t*, int*);
+static void write_op_exec_omap_cmpxchg(
+    void*, const char*, const char*, size_t, const char*, size_t, int*);
 
 static struct write_op_visitor write_op_exec
-    = {.visit_begin        = write_op_exec_begin,
-       .visit_create       = write_op_exec_create,
-       .visit_write        = write_op_exec_write,
-       .visit_write_full   = write_op_exec_write_full,
-       .visit_writesame    = write_op_exec_writesame,
-       .visit_append       = write_op_exec_append,
-       .visit_remove       = write_op_exec_remove,
-       .visit_truncate     = write_op_exec_truncate,
-       .visit_zero         = write_op_exec_zero,
-       .visit_omap_set     = write_op_exec_omap_set,
-       .visit_omap_rm_keys = write_op_exec_omap_rm_keys,
-       .visit_end          = write_op_exec_end};
+    = {.visit_begin         = write_op_exec_begin,
+       .visit_create        = write_op_exec_create,
+       .visit_write         = write_op_exec_write,
+       .visit_write_full    = write_op_exec_write_full,
+       .visit_writesame     = write_op_exec_writesame,
+       .visit_append        = write_op_exec_append,
+       .visit_remove        = write_op_exec_remove,
+       .visit_truncate      = write_op_exec_truncate,
+       .visit_zero          = write_op_exec_zero,
+       .visit_omap_set      = write_op_exec_omap_set,
+       .visit_omap_rm_keys  = write_op_exec_omap_rm_keys,
+       .visit_omap_rm_range = write_op_exec_omap_rm_range,
+       .visit_omap_clear    = write_op_exec_omap_clear,
+       .visit_omap_add      = write_op_exec_omap_add,
+       .visit_omap_cmpxchg  = write_op_exec_omap_cmpxchg,
+       .visit_end           = write_op_exec_end};
 
 extern "C" void fake_write_op(mobject_store_write_op_t write_op,
                               server_visitor_args_t    vargs)
@@ -109,7 +118,8 @@ void write_op_exec_writesame(
                             buf.as_offset, offset, data_len, write_len);
 }
 
-void write_op_exec_append(void* u, buffer_u buf, size_t len)
+void write_op_exec_append(
+    void* u, buffer_u buf, size_t len, uint64_t* poffset, int* prval)
 {
     auto        vargs = static_cast<server_visitor_args_t>(u);
     std::string name(vargs->object_name);
@@ -118,8 +128,9 @@ void write_op_exec_append(void* u, buffer_u buf, size_t len)
                   << " does not exist, it will be created" << std::endl;
     }
     margo_instance_id mid = vargs->provider->mid;
-    fake_db[name].append(mid, vargs->client_addr, vargs->bulk_handle,
-                         buf.as_offset, len);
+    *poffset = fake_db[name].append(mid, vargs->client_addr,
+                                    vargs->bulk_handle, buf.as_offset, len);
+    *prval   = 0;
 }
 
 void write_op_exec_remove(void* u)
@@ -188,3 +199,56 @@ void write_op_exec_omap_rm_keys(void*              u,
     auto&    entry = fake_db[name];
     for (i = 0; i < num_keys; i++) { entry.omap_rm(keys[i]); }
 }
+
+void write_op_exec_omap_rm_range(void* u, const char* start, const char* end)
+{
+    auto        vargs = static_cast<server_visitor_args_t>(u);
+    std::string name(vargs->object_name);
+    if (fake_db.count(name) == 0) {
+        std::cerr << "[FAKE-BACKEND-WARNING] (omap_rm_range) Object " << name
+                  << " did not exist" << std::endl;
+        return;
+    }
+    fake_db[name].omap_rm_range(start, end);
+}
+
+void write_op_exec_omap_clear(void* u)
+{
+    auto        vargs = static_cast<server_visitor_args_t>(u);
+    std::string name(vargs->object_name);
+    if (fake_db.count(name) == 0) {
+        std::cerr << "[FAKE-BACKEND-WARNING] (omap_clear) Object " << name
+                  << " did not exist" << std::endl;
+        return;
+    }
+    fake_db[name].omap_clear();
+}
+
+void write_op_exec_omap_add(
+    void* u, const char* key, int64_t delta, int64_t* presult, int* prval)
+{
+    auto        vargs = static_cast<server_visitor_args_t>(u);
+    std::string name(vargs->object_name);
+    if (fake_db.count(name) == 0) {
+        std::cerr << "[FAKE-BACKEND-WARNING] (omap_add) Object " << name
+                  << " does not exist, it will be created" << std::endl;
+    }
+    *prval = fake_db[name].omap_add(key, delta, presult);
+}
+
+void write_op_exec_omap_cmpxchg(void*       u,
+                                const char* key,
+                                const char* cmp,
+                                size_t      cmp_len,
+                                const char* val,
+                                size_t      val_len,
+                                int*        prval)
+{
+    auto        vargs = static_cast<server_visitor_args_t>(u);
+    std::string name(vargs->object_name);
+    if (fake_db.count(name) == 0) {
+        std::cerr << "[FAKE-BACKEND-WARNING] (omap_cmpxchg) Object " << name
+                  << " does not exist, it will be created" << std::endl;
+    }
+    *prval = fake_db[name].omap_cmpxchg(key, cmp, cmp_len, val, val_len);
+}
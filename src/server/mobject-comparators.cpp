@@ -7,6 +7,14 @@
 #include <unistd.h>
 #include "src/server/core/key-types.h"
 
+/*
+ * Comparators for the databases of older versions of Mobject, which
+ * stored keys in their in-memory layout. Current versions encode keys
+ * so that the default comparator of Yokan sorts them (see
+ * key-encoding.h); these comparators are only needed to open existing
+ * databases in order to convert them with mobject-migrate-keys.
+ */
+
 extern "C" bool
 mobject_oid_map_compare(const void* k1, size_t sk1, const void* k2, size_t sk2)
 {
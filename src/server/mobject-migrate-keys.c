@@ -0,0 +1,249 @@
+/*
+ * (C) 2018 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <margo.h>
+#include <yokan/client.h>
+#include <yokan/database.h>
+#include "src/server/core/key-encoding.h"
+
+/*
+ * Converts the databases of a Mobject provider created by a version of
+ * Mobject storing keys in their in-memory layout (and relying on the
+ * comparators of libmobject-comparators.so) into databases using the
+ * encoding described in key-encoding.h.
+ *
+ * The legacy databases must have been renamed by appending a suffix to
+ * their name (e.g. "mobject_seg_map.legacy", still using the legacy
+ * comparators), and empty databases with the usual names must have been
+ * created, with the default comparator, in the same Yokan provider.
+ * Values are copied as they are (BAKE_REGION values holding a full
+ * region_descriptor_t remain readable, see key-encoding.h).
+ */
+
+#define BATCH_SIZE     64
+#define MAX_ENTRY_SIZE 65536
+
+/* converts a legacy key into out, returns its new size (0 if invalid) */
+typedef size_t (*convert_fn)(const char* key, size_t size, char* out);
+
+static size_t convert_oid_key(const char* key, size_t size, char* out)
+{
+    oid_t oid;
+    if (size != sizeof(oid)) return 0;
+    memcpy(&oid, key, sizeof(oid));
+    encode_oid_key(out, oid);
+    return OID_KEY_SIZE;
+}
+
+static size_t convert_name_key(const char* key, size_t size, char* out)
+{
+    memcpy(out, key, size);
+    return size;
+}
+
+static size_t convert_segment_key(const char* key, size_t size, char* out)
+{
+    segment_key_t seg;
+    if (size != sizeof(seg)) return 0;
+    memcpy(&seg, key, sizeof(seg));
+    return encode_segment_key(out, &seg);
+}
+
+static size_t convert_omap_key(const char* key, size_t size, char* out)
+{
+    oid_t  oid;
+    size_t header = offsetof(omap_key_t, key);
+    if (size <= header) return 0;
+    memcpy(&oid, key, sizeof(oid));
+    return encode_omap_key(out, oid, key + header,
+                           strnlen(key + header, size - header));
+}
+
+static const struct {
+    const char* name;
+    size_t      first_key_size; // size of a legacy key sorting first
+    convert_fn  convert;
+} databases[]
+    = {{"mobject_oid_map", sizeof(oid_t), convert_oid_key},
+       {"mobject_name_map", 1, convert_name_key},
+       {"mobject_seg_map", sizeof(segment_key_t), convert_segment_key},
+       {"mobject_omap_map", sizeof(omap_key_t), convert_omap_key}};
+
+static int open_database(yk_client_t           client,
+                         hg_addr_t             addr,
+                         uint16_t              provider_id,
+                         const char*           name,
+                         yk_database_handle_t* dbh)
+{
+    yk_database_id_t id;
+    yk_return_t      yret;
+
+    yret = yk_database_find_by_name(client, addr, provider_id, name, &id);
+    if (yret != YOKAN_SUCCESS) {
+        fprintf(stderr, "Error: Unable to find database %s (ret = %d)\n",
+                name, yret);
+        return -1;
+    }
+    yret = yk_database_handle_create(client, addr, provider_id, id, dbh);
+    if (yret != YOKAN_SUCCESS) {
+        fprintf(stderr, "Error: Unable to open database %s (ret = %d)\n", name,
+                yret);
+        return -1;
+    }
+    return 0;
+}
+
+static int migrate(yk_database_handle_t src,
+                   yk_database_handle_t dst,
+                   size_t               first_key_size,
+                   convert_fn           convert,
+                   size_t*              count)
+{
+    void*       keys[BATCH_SIZE];
+    void*       vals[BATCH_SIZE];
+    size_t      ksizes[BATCH_SIZE];
+    size_t      vsizes[BATCH_SIZE];
+    char*       lb      = calloc(1, MAX_ENTRY_SIZE);
+    char*       new_key = malloc(MAX_ENTRY_SIZE + OID_KEY_SIZE);
+    size_t      lb_size = first_key_size;
+    int32_t     mode    = YOKAN_MODE_INCLUSIVE;
+    size_t      i, n;
+    int         ret = 0;
+    yk_return_t yret;
+
+    for (i = 0; i < BATCH_SIZE; i++) {
+        keys[i] = malloc(MAX_ENTRY_SIZE);
+        vals[i] = malloc(MAX_ENTRY_SIZE);
+    }
+
+    *count = 0;
+    do {
+        for (i = 0; i < BATCH_SIZE; i++) {
+            ksizes[i] = MAX_ENTRY_SIZE;
+            vsizes[i] = MAX_ENTRY_SIZE;
+        }
+        yret = yk_list_keyvals(src, mode, lb, lb_size, NULL, 0, BATCH_SIZE,
+                               keys, ksizes, vals, vsizes);
+        if (yret != YOKAN_SUCCESS) {
+            fprintf(stderr, "Error: yk_list_keyvals returned %d\n", yret);
+            ret = -1;
+            break;
+        }
+        mode = YOKAN_MODE_DEFAULT;
+
+        for (n = 0; n < BATCH_SIZE && ksizes[n] != YOKAN_NO_MORE_KEYS; n++) {
+            if (ksizes[n] > YOKAN_LAST_VALID_SIZE
+                || vsizes[n] > YOKAN_LAST_VALID_SIZE) {
+                fprintf(stderr, "Error: entry larger than %d bytes\n",
+                        MAX_ENTRY_SIZE);
+                ret = -1;
+                goto out;
+            }
+            size_t new_size = convert(keys[n], ksizes[n], new_key);
+            if (new_size == 0) {
+                fprintf(stderr, "Error: invalid key of size %zu\n", ksizes[n]);
+                ret = -1;
+                goto out;
+            }
+            yret = yk_put(dst, YOKAN_MODE_DEFAULT, new_key, new_size, vals[n],
+                          vsizes[n]);
+            if (yret != YOKAN_SUCCESS) {
+                fprintf(stderr, "Error: yk_put returned %d\n", yret);
+                ret = -1;
+                goto out;
+            }
+            *count += 1;
+        }
+        if (n != 0) {
+            memcpy(lb, keys[n - 1], ksizes[n - 1]);
+            lb_size = ksizes[n - 1];
+        }
+    } while (n == BATCH_SIZE);
+
+out:
+    for (i = 0; i < BATCH_SIZE; i++) {
+        free(keys[i]);
+        free(vals[i]);
+    }
+    free(new_key);
+    free(lb);
+    return ret;
+}
+
+int main(int argc, char* argv[])
+{
+    margo_instance_id    mid;
+    hg_addr_t            addr = HG_ADDR_NULL;
+    yk_client_t          client;
+    yk_database_handle_t src, dst;
+    uint16_t             provider_id;
+    char                 proto[24] = {0};
+    char                 src_name[256];
+    size_t               i, count;
+    int                  ret = 0;
+
+    if (argc != 4) {
+        fprintf(stderr,
+                "Usage: mobject-migrate-keys <address> <provider_id> "
+                "<suffix>\n");
+        fprintf(stderr,
+                "  <address>      address of the Yokan provider\n"
+                "  <provider_id>  id of the Yokan provider\n"
+                "  <suffix>       suffix appended to the names of the legacy "
+                "databases\n");
+        return -1;
+    }
+    provider_id = atoi(argv[2]);
+
+    for (i = 0; i < 23 && argv[1][i] != '\0' && argv[1][i] != ':'; i++)
+        proto[i] = argv[1][i];
+
+    mid = margo_init(proto, MARGO_CLIENT_MODE, 0, 0);
+    if (mid == MARGO_INSTANCE_NULL) {
+        fprintf(stderr, "Error: Unable to initialize margo\n");
+        return -1;
+    }
+    if (margo_addr_lookup(mid, argv[1], &addr) != HG_SUCCESS) {
+        fprintf(stderr, "Error: Unable to lookup %s\n", argv[1]);
+        margo_finalize(mid);
+        return -1;
+    }
+    if (yk_client_init(mid, &client) != YOKAN_SUCCESS) {
+        fprintf(stderr, "Error: Unable to initialize the Yokan client\n");
+        margo_addr_free(mid, addr);
+        margo_finalize(mid);
+        return -1;
+    }
+
+    for (i = 0; i < sizeof(databases) / sizeof(databases[0]) && ret == 0;
+         i++) {
+        snprintf(src_name, sizeof(src_name), "%s%s", databases[i].name,
+                 argv[3]);
+        ret = open_database(client, addr, provider_id, src_name, &src);
+        if (ret != 0) break;
+        ret = open_database(client, addr, provider_id, databases[i].name,
+                            &dst);
+        if (ret != 0) {
+            yk_database_handle_release(src);
+            break;
+        }
+        ret = migrate(src, dst, databases[i].first_key_size,
+                      databases[i].convert, &count);
+        if (ret == 0)
+            printf("%s: %zu entries migrated from %s\n", databases[i].name,
+                   count, src_name);
+        yk_database_handle_release(dst);
+        yk_database_handle_release(src);
+    }
+
+    yk_client_finalize(client);
+    margo_addr_free(mid, addr);
+    margo_finalize(mid);
+    return ret;
+}
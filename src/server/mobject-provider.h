@@ -18,6 +18,21 @@ extern "C" {
 
 #define MOBJECT_SEQ_ID_MAX UINT32_MAX
 
+#define MOBJECT_DEFAULT_OMAP_PAGE_SIZE (64 * 1024)
+
+/* largest buffer through which written data goes when it is checked for
+ * zeros, compressed or deduplicated */
+#define MOBJECT_WRITE_BUFFER_SIZE (4 * 1024 * 1024)
+
+/* number of mutexes serializing the updates of the dedup index, each
+ * covering the digests starting with the same byte modulo this number */
+#define MOBJECT_DEDUP_MUTEXES 64
+
+struct mobject_unpersisted_region;
+struct mobject_persist_failure;
+struct mobject_object_lock_bucket;
+struct mobject_object_tail_bucket;
+
 struct mobject_bake_target {
     bake_provider_handle_t ph;
     bake_target_id_t       tid;
@@ -38,9 +53,31 @@ struct mobject_provider {
     yk_database_handle_t name_dbh;
     yk_database_handle_t segment_dbh;
     yk_database_handle_t omap_dbh;
+    yk_database_handle_t dedup_dbh; // see region-dedup.h, may be NULL
+    /* configuration */
+    uint32_t read_lease_ms;
+    uint32_t omap_page_size;      // bytes of keys (or values) per omap listing
+    uint32_t zero_detection_size; // block size of zero detection, 0 if off
+    int      compression;         // see region-compression.h
+    uint32_t dedup_chunk_size;    // see region-dedup.h, 0 if off
+    int      dedup_chunking;      // MOBJECT_DEDUP_*
     /* other data */
-    uint32_t seq_id;
-    int      ref_count;
+    uint32_t                           seq_id;
+    int                                ref_count;
+    ABT_mutex_memory                   versions_mutex;
+    uint64_t*                          versions;     // see object-versions.h
+    struct mobject_object_lock_bucket* object_locks; // see object-locks.h
+    struct mobject_object_tail_bucket* object_tails; // see object-tails.h
+    /* updates of the dedup index (see region-dedup.h) */
+    ABT_mutex_memory dedup_mutexes[MOBJECT_DEDUP_MUTEXES];
+    /* regions written with deferred persistence (see deferred-persist.h) */
+    ABT_mutex_memory                   persist_mutex;
+    ABT_cond_memory                    persist_cond;
+    uint64_t                           persist_seq;   // last seq handed out
+    uint64_t                           persisted_seq; // persisted up to
+    int                                persisting;
+    struct mobject_unpersisted_region* unpersisted;
+    struct mobject_persist_failure*    persist_failures;
     /* stats/counters/timers and helpers */
     uint32_t segs;
     uint64_t total_seg_size;
@@ -52,6 +89,11 @@ struct mobject_provider {
     hg_id_t read_op_id;
     hg_id_t clean_id;
     hg_id_t stat_id;
+    hg_id_t version_id;
+    hg_id_t write_op_batch_id;
+    hg_id_t read_op_batch_id;
+    hg_id_t persist_wait_id;
+    hg_id_t wire_format_id;
 };
 
 #ifdef __cplusplus
@@ -11,14 +11,26 @@
 #include <unistd.h>
 #include <abt.h>
 #include <margo.h>
+#include <json-c/json.h>
 
 #include "mobject-server.h"
 #include "src/server/mobject-provider.h"
+#include "src/server/object-versions.h"
+#include "src/server/object-locks.h"
+#include "src/server/object-tails.h"
+#include "src/server/deferred-persist.h"
+#include "src/server/region-compression.h"
+#include "src/server/region-dedup.h"
 #include "src/rpc-types/write-op.h"
 #include "src/rpc-types/read-op.h"
+#include "src/rpc-types/object-version.h"
+#include "src/rpc-types/batch-op.h"
+#include "src/rpc-types/wire-format.h"
+#include "src/io-chain/wire-format.h"
 #include "src/io-chain/write-op-impl.h"
 #include "src/io-chain/read-op-impl.h"
 #include "src/server/visitor-args.h"
+#include "src/util/utlist.h"
 #ifdef FAKE_CPP_SERVER
     #include "src/server/fake/fake-read-op.h"
     #include "src/server/fake/fake-write-op.h"
@@ -31,9 +43,19 @@ DECLARE_MARGO_RPC_HANDLER(mobject_write_op_ult)
 DECLARE_MARGO_RPC_HANDLER(mobject_read_op_ult)
 DECLARE_MARGO_RPC_HANDLER(mobject_server_clean_ult)
 DECLARE_MARGO_RPC_HANDLER(mobject_server_stat_ult)
+DECLARE_MARGO_RPC_HANDLER(mobject_object_version_ult)
+DECLARE_MARGO_RPC_HANDLER(mobject_write_op_batch_ult)
+DECLARE_MARGO_RPC_HANDLER(mobject_read_op_batch_ult)
+DECLARE_MARGO_RPC_HANDLER(mobject_persist_wait_ult)
+DECLARE_MARGO_RPC_HANDLER(mobject_wire_format_ult)
 
 static void mobject_finalize_cb(void* data);
 
+static int mobject_parse_config(struct mobject_provider* provider,
+                                const char*              json_config);
+
+static int write_op_lock_mode(mobject_store_write_op_t write_op, int flags);
+
 int mobject_provider_register(margo_instance_id                  mid,
                               uint16_t                           provider_id,
                               unsigned                           num_bake_phs,
@@ -64,10 +86,38 @@ int mobject_provider_register(margo_instance_id                  mid,
 
     tmp_provider = calloc(1, sizeof(*tmp_provider));
     if (!tmp_provider) return -1;
-    tmp_provider->mid         = mid;
-    tmp_provider->provider_id = provider_id;
-    tmp_provider->pool        = args ? args->pool : ABT_POOL_NULL;
-    tmp_provider->ref_count   = 1;
+    tmp_provider->mid            = mid;
+    tmp_provider->provider_id    = provider_id;
+    tmp_provider->pool           = args ? args->pool : ABT_POOL_NULL;
+    tmp_provider->ref_count      = 1;
+    tmp_provider->omap_page_size = MOBJECT_DEFAULT_OMAP_PAGE_SIZE;
+
+    ret = mobject_parse_config(tmp_provider, args ? args->json_config : NULL);
+    if (ret != 0) {
+        free(tmp_provider);
+        return -1;
+    }
+
+    ret = mobject_object_versions_init(tmp_provider);
+    if (ret != 0) {
+        free(tmp_provider);
+        return -1;
+    }
+
+    ret = mobject_object_locks_init(tmp_provider);
+    if (ret != 0) {
+        mobject_object_versions_finalize(tmp_provider);
+        free(tmp_provider);
+        return -1;
+    }
+
+    ret = mobject_object_tails_init(tmp_provider);
+    if (ret != 0) {
+        mobject_object_locks_finalize(tmp_provider);
+        mobject_object_versions_finalize(tmp_provider);
+        free(tmp_provider);
+        return -1;
+    }
 
     /* Bake settings initialization */
     for(unsigned i = 0; i < num_bake_phs; i++) {
@@ -79,6 +129,9 @@ int mobject_provider_register(margo_instance_id                  mid,
             margo_error(mid,
                         "mobject_provider_register(): "
                         "unable to probe bake server for targets");
+            mobject_object_tails_finalize(tmp_provider);
+            mobject_object_locks_finalize(tmp_provider);
+            mobject_object_versions_finalize(tmp_provider);
             free(tmp_provider);
             return -1;
         }
@@ -86,6 +139,9 @@ int mobject_provider_register(margo_instance_id                  mid,
             margo_error(mid,
                         "mobject_provider_register(): "
                         "unable to find a target on bake provider");
+            mobject_object_tails_finalize(tmp_provider);
+            mobject_object_locks_finalize(tmp_provider);
+            mobject_object_versions_finalize(tmp_provider);
             free(tmp_provider);
             return -1;
         }
@@ -163,6 +219,23 @@ int mobject_provider_register(margo_instance_id                  mid,
                               yokan_ph->provider_id, db_id,
                               &(tmp_provider->omap_dbh));
 
+    /* -- dedup_map -- */
+    /* only required with deduplication, but opened whenever it exists so
+     * that removals release the regions written while it was enabled */
+    yret = yk_database_find_by_name(yokan_ph->client, yokan_ph->addr,
+                                    yokan_ph->provider_id, "mobject_dedup_map",
+                                    &db_id);
+    if (yret == YOKAN_SUCCESS) {
+        yk_database_handle_create(yokan_ph->client, yokan_ph->addr,
+                                  yokan_ph->provider_id, db_id,
+                                  &(tmp_provider->dedup_dbh));
+    } else if (tmp_provider->dedup_chunk_size != 0) {
+        margo_error(
+            mid,
+            "[mobject] Unable to find mobject_dedup_map from Yokan provider");
+        goto error;
+    }
+
     hg_id_t rpc_id;
 
     /* read/write op RPCs */
@@ -178,6 +251,32 @@ int mobject_provider_register(margo_instance_id                  mid,
     margo_register_data(mid, rpc_id, tmp_provider, NULL);
     tmp_provider->read_op_id = rpc_id;
 
+    rpc_id = MARGO_REGISTER_PROVIDER(
+        mid, "mobject_write_op_batch", write_op_batch_in_t,
+        write_op_batch_out_t, mobject_write_op_batch_ult, provider_id,
+        tmp_provider->pool);
+    margo_register_data(mid, rpc_id, tmp_provider, NULL);
+    tmp_provider->write_op_batch_id = rpc_id;
+
+    rpc_id = MARGO_REGISTER_PROVIDER(
+        mid, "mobject_read_op_batch", read_op_batch_in_t, read_op_batch_out_t,
+        mobject_read_op_batch_ult, provider_id, tmp_provider->pool);
+    margo_register_data(mid, rpc_id, tmp_provider, NULL);
+    tmp_provider->read_op_batch_id = rpc_id;
+
+    rpc_id = MARGO_REGISTER_PROVIDER(mid, "mobject_persist_wait",
+                                     persist_wait_in_t, persist_wait_out_t,
+                                     mobject_persist_wait_ult, provider_id,
+                                     tmp_provider->pool);
+    margo_register_data(mid, rpc_id, tmp_provider, NULL);
+    tmp_provider->persist_wait_id = rpc_id;
+
+    rpc_id = MARGO_REGISTER_PROVIDER(mid, "mobject_wire_format", void,
+                                     wire_format_out_t, mobject_wire_format_ult,
+                                     provider_id, tmp_provider->pool);
+    margo_register_data(mid, rpc_id, tmp_provider, NULL);
+    tmp_provider->wire_format_id = rpc_id;
+
     /* server ctl RPCs */
     rpc_id = MARGO_REGISTER_PROVIDER(mid, "mobject_server_clean", void, void,
                                      mobject_server_clean_ult, provider_id,
@@ -191,6 +290,14 @@ int mobject_provider_register(margo_instance_id                  mid,
     margo_register_data(mid, rpc_id, tmp_provider, NULL);
     tmp_provider->stat_id = rpc_id;
 
+    /* read cache RPCs */
+    rpc_id = MARGO_REGISTER_PROVIDER(mid, "mobject_object_version",
+                                     object_version_in_t, object_version_out_t,
+                                     mobject_object_version_ult, provider_id,
+                                     tmp_provider->pool);
+    margo_register_data(mid, rpc_id, tmp_provider, NULL);
+    tmp_provider->version_id = rpc_id;
+
     margo_push_finalize_callback(mid, mobject_finalize_cb, (void*)tmp_provider);
 
     *provider = tmp_provider;
@@ -202,6 +309,22 @@ error:
     return -1;
 }
 
+/* write_ops made only of appends do not exclude each other, since
+ * appends reserve the range they write (see object-tails.h), but still
+ * exclude read_ops */
+static int write_op_lock_mode(mobject_store_write_op_t write_op, int flags)
+{
+    int              mode = mobject_object_lock_mode(flags, 1);
+    wr_action_base_t a;
+
+    if (mode != MOBJECT_LOCK_EXCLUSIVE) return mode;
+    DL_FOREACH(write_op->actions, a)
+    {
+        if (a->type != WRITE_OPCODE_APPEND) return mode;
+    }
+    return MOBJECT_LOCK_APPEND;
+}
+
 static hg_return_t mobject_write_op_ult(hg_handle_t h)
 {
     hg_return_t ret;
@@ -213,6 +336,9 @@ static hg_return_t mobject_write_op_ult(hg_handle_t h)
     ret = margo_get_input(h, &in);
     assert(ret == HG_SUCCESS);
 
+    /* Point the actions returning a result to the output */
+    build_matching_write_results(in.write_op, &out.results);
+
     const struct hg_info* info = margo_get_info(h);
     margo_instance_id     mid  = margo_hg_handle_get_instance(h);
 
@@ -225,6 +351,13 @@ static hg_return_t mobject_write_op_ult(hg_handle_t h)
     vargs.client_addr_str = in.client_addr;
     vargs.client_addr     = info->addr;
     vargs.bulk_handle     = in.write_op->bulk_handle;
+    vargs.defer_persist   = !!(in.flags & LIBMOBJECT_OPERATION_EARLY_ACK);
+    vargs.persist_seq     = 0;
+    vargs.overwrite
+        = !!(in.flags & LIBMOBJECT_OPERATION_OVERWRITE_IN_PLACE);
+    vargs.lock_mode       = write_op_lock_mode(in.write_op, in.flags);
+    vargs.locked          = 0;
+    vargs.ret             = 0;
 
     /* Execute the operation chain */
     // print_write_op(in.write_op, in.object_name);
@@ -234,12 +367,23 @@ static hg_return_t mobject_write_op_ult(hg_handle_t h)
     core_write_op(in.write_op, &vargs);
 #endif
 
+    // invalidate the object in the clients' read caches
+    mobject_object_version_bump(vargs.provider, in.object_name);
+
     // set the return value of the RPC
-    out.ret = 0;
+    out.ret         = vargs.ret;
+    out.persist_seq = vargs.persist_seq;
 
     ret = margo_respond(h, &out);
     assert(ret == HG_SUCCESS);
 
+    free_write_results(&out.results);
+
+    /* The client has been acknowledged, now make sure the data it sent
+     * gets persisted along with that of other pending requests */
+    if (vargs.persist_seq)
+        mobject_deferred_persist_wait(vargs.provider, vargs.persist_seq);
+
     /* Free the input data. */
     ret = margo_free_input(h, &in);
     assert(ret == HG_SUCCESS);
@@ -278,6 +422,17 @@ static hg_return_t mobject_read_op_ult(hg_handle_t h)
     vargs.client_addr_str = in.client_addr;
     vargs.client_addr     = info->addr;
     vargs.bulk_handle     = in.read_op->bulk_handle;
+    vargs.defer_persist   = 0;
+    vargs.persist_seq     = 0;
+    vargs.overwrite       = 0;
+    vargs.lock_mode       = mobject_object_lock_mode(in.flags, 0);
+    vargs.locked          = 0;
+    vargs.ret             = 0;
+
+    /* The version is taken before reading, so that data modified by a
+     * concurrent write is cached at most until the client revalidates */
+    out.version  = mobject_object_version_get(vargs.provider, in.object_name);
+    out.lease_ms = vargs.provider->read_lease_ms;
 
     /* Compute the result. */
     // print_read_op(in.read_op, in.object_name);
@@ -287,6 +442,9 @@ static hg_return_t mobject_read_op_ult(hg_handle_t h)
     core_read_op(in.read_op, &vargs);
 #endif
 
+    /* Large omap results go through the bulk handle */
+    push_omap_results(mid, in.read_op, resp, info->addr, vargs.bulk_handle);
+
     out.responses = resp;
 
     ret = margo_respond(h, &out);
@@ -358,6 +516,362 @@ static hg_return_t mobject_server_stat_ult(hg_handle_t h)
 }
 DEFINE_MARGO_RPC_HANDLER(mobject_server_stat_ult)
 
+static hg_return_t mobject_object_version_ult(hg_handle_t h)
+{
+    hg_return_t          ret;
+    object_version_in_t  in;
+    object_version_out_t out;
+
+    const struct hg_info* info = margo_get_info(h);
+    margo_instance_id     mid  = margo_hg_handle_get_instance(h);
+
+    struct mobject_provider* provider = margo_registered_data(mid, info->id);
+    if (provider == NULL) return HG_OTHER_ERROR;
+
+    ret = margo_get_input(h, &in);
+    assert(ret == HG_SUCCESS);
+
+    out.version  = mobject_object_version_get(provider, in.object_name);
+    out.lease_ms = provider->read_lease_ms;
+
+    ret = margo_respond(h, &out);
+    assert(ret == HG_SUCCESS);
+
+    ret = margo_free_input(h, &in);
+    assert(ret == HG_SUCCESS);
+
+    ret = margo_destroy(h);
+    assert(ret == HG_SUCCESS);
+
+    return ret;
+}
+DEFINE_MARGO_RPC_HANDLER(mobject_object_version_ult)
+
+static hg_return_t mobject_write_op_batch_ult(hg_handle_t h)
+{
+    hg_return_t          ret;
+    write_op_batch_in_t  in;
+    write_op_batch_out_t out;
+    uint32_t             i;
+
+    const struct hg_info* info = margo_get_info(h);
+    margo_instance_id     mid  = margo_hg_handle_get_instance(h);
+
+    struct mobject_provider* provider = margo_registered_data(mid, info->id);
+    if (provider == NULL) return HG_OTHER_ERROR;
+
+    ret = margo_get_input(h, &in);
+    assert(ret == HG_SUCCESS);
+
+    out.results.count   = in.batch.count;
+    out.results.rets    = calloc(in.batch.count, sizeof(int32_t));
+    out.results.results = calloc(in.batch.count, sizeof(write_results_t));
+
+    /* Execute each write_op in turn, as if it had been sent on its own */
+    for (i = 0; i < in.batch.count; i++) {
+        mobject_store_write_op_t write_op = in.batch.write_ops[i];
+
+        build_matching_write_results(write_op, &out.results.results[i]);
+
+        server_visitor_args vargs;
+        vargs.object_name     = in.batch.object_names[i];
+        vargs.oid             = 0;
+        vargs.pool_name       = in.pool_name;
+        vargs.provider        = provider;
+        vargs.client_addr_str = in.client_addr;
+        vargs.client_addr     = info->addr;
+        vargs.bulk_handle     = write_op->bulk_handle != HG_BULK_NULL
+                                  ? write_op->bulk_handle
+                                  : in.bulk_handle;
+        vargs.defer_persist   = 0;
+        vargs.persist_seq     = 0;
+        vargs.overwrite
+            = !!(in.flags & LIBMOBJECT_OPERATION_OVERWRITE_IN_PLACE);
+        vargs.lock_mode       = write_op_lock_mode(write_op, in.flags);
+        vargs.locked          = 0;
+        vargs.ret             = 0;
+
+#ifdef FAKE_CPP_SERVER
+        fake_write_op(write_op, &vargs);
+#else
+        core_write_op(write_op, &vargs);
+#endif
+        out.results.rets[i] = vargs.ret;
+
+        mobject_object_version_bump(provider, vargs.object_name);
+    }
+
+    ret = margo_respond(h, &out);
+    assert(ret == HG_SUCCESS);
+
+    for (i = 0; i < in.batch.count; i++)
+        free_write_results(&out.results.results[i]);
+    free(out.results.rets);
+    free(out.results.results);
+
+    ret = margo_free_input(h, &in);
+    assert(ret == HG_SUCCESS);
+
+    ret = margo_destroy(h);
+    assert(ret == HG_SUCCESS);
+
+    return ret;
+}
+DEFINE_MARGO_RPC_HANDLER(mobject_write_op_batch_ult)
+
+static hg_return_t mobject_read_op_batch_ult(hg_handle_t h)
+{
+    hg_return_t         ret;
+    read_op_batch_in_t  in;
+    read_op_batch_out_t out;
+    uint32_t            i;
+
+    const struct hg_info* info = margo_get_info(h);
+    margo_instance_id     mid  = margo_hg_handle_get_instance(h);
+
+    struct mobject_provider* provider = margo_registered_data(mid, info->id);
+    if (provider == NULL) return HG_OTHER_ERROR;
+
+    ret = margo_get_input(h, &in);
+    assert(ret == HG_SUCCESS);
+
+    out.results.count     = in.batch.count;
+    out.results.responses = calloc(in.batch.count, sizeof(read_response_t));
+    out.results.versions  = calloc(in.batch.count, sizeof(uint64_t));
+    out.lease_ms          = provider->read_lease_ms;
+
+    /* Execute each read_op in turn, as if it had been sent on its own */
+    for (i = 0; i < in.batch.count; i++) {
+        mobject_store_read_op_t read_op = in.batch.read_ops[i];
+
+        out.results.responses[i] = build_matching_read_responses(read_op);
+
+        server_visitor_args vargs;
+        vargs.object_name     = in.batch.object_names[i];
+        vargs.oid             = 0;
+        vargs.pool_name       = in.pool_name;
+        vargs.provider        = provider;
+        vargs.client_addr_str = in.client_addr;
+        vargs.client_addr     = info->addr;
+        vargs.bulk_handle     = read_op->bulk_handle != HG_BULK_NULL
+                                  ? read_op->bulk_handle
+                                  : in.bulk_handle;
+        vargs.defer_persist   = 0;
+        vargs.persist_seq     = 0;
+        vargs.overwrite       = 0;
+        vargs.lock_mode       = mobject_object_lock_mode(in.flags, 0);
+        vargs.locked          = 0;
+        vargs.ret             = 0;
+
+        out.results.versions[i]
+            = mobject_object_version_get(provider, vargs.object_name);
+
+#ifdef FAKE_CPP_SERVER
+        fake_read_op(read_op, &vargs);
+#else
+        core_read_op(read_op, &vargs);
+#endif
+
+        push_omap_results(mid, read_op, out.results.responses[i], info->addr,
+                          vargs.bulk_handle);
+    }
+
+    ret = margo_respond(h, &out);
+    assert(ret == HG_SUCCESS);
+
+    for (i = 0; i < in.batch.count; i++)
+        free_read_responses(out.results.responses[i]);
+    free(out.results.responses);
+    free(out.results.versions);
+
+    ret = margo_free_input(h, &in);
+    assert(ret == HG_SUCCESS);
+
+    ret = margo_destroy(h);
+    assert(ret == HG_SUCCESS);
+
+    return ret;
+}
+DEFINE_MARGO_RPC_HANDLER(mobject_read_op_batch_ult)
+
+static hg_return_t mobject_persist_wait_ult(hg_handle_t h)
+{
+    hg_return_t        ret;
+    persist_wait_in_t  in;
+    persist_wait_out_t out;
+
+    const struct hg_info* info = margo_get_info(h);
+    margo_instance_id     mid  = margo_hg_handle_get_instance(h);
+
+    struct mobject_provider* provider = margo_registered_data(mid, info->id);
+    if (provider == NULL) return HG_OTHER_ERROR;
+
+    ret = margo_get_input(h, &in);
+    assert(ret == HG_SUCCESS);
+
+    out.ret = mobject_deferred_persist_wait(provider, in.persist_seq);
+
+    ret = margo_respond(h, &out);
+    assert(ret == HG_SUCCESS);
+
+    ret = margo_free_input(h, &in);
+    assert(ret == HG_SUCCESS);
+
+    ret = margo_destroy(h);
+    assert(ret == HG_SUCCESS);
+
+    return ret;
+}
+DEFINE_MARGO_RPC_HANDLER(mobject_persist_wait_ult)
+
+/* tells clients which wire format they may encode ops in, clients that
+ * never ask keep using MOBJECT_WIRE_FORMAT_LEGACY */
+static hg_return_t mobject_wire_format_ult(hg_handle_t h)
+{
+    hg_return_t       ret;
+    wire_format_out_t out;
+
+    out.wire_format = MOBJECT_WIRE_FORMAT_COMPACT;
+
+    ret = margo_respond(h, &out);
+    assert(ret == HG_SUCCESS);
+
+    ret = margo_destroy(h);
+    assert(ret == HG_SUCCESS);
+
+    return ret;
+}
+DEFINE_MARGO_RPC_HANDLER(mobject_wire_format_ult)
+
+static int mobject_parse_config(struct mobject_provider* provider,
+                                const char*              json_config)
+{
+    struct json_object* config;
+    struct json_object* val;
+
+    if (!json_config || !json_config[0]) return 0;
+
+    config = json_tokener_parse(json_config);
+    if (!config) {
+        margo_error(provider->mid,
+                    "mobject_provider_register(): could not parse JSON config");
+        return -1;
+    }
+
+    /* "read_lease_ms": time during which clients may serve reads from
+     * their cache without checking the object's version (default 0) */
+    if (json_object_object_get_ex(config, "read_lease_ms", &val)) {
+        if (!json_object_is_type(val, json_type_int)
+            || json_object_get_int64(val) < 0) {
+            margo_error(provider->mid,
+                        "mobject_provider_register(): \"read_lease_ms\" "
+                        "should be a positive integer");
+            json_object_put(config);
+            return -1;
+        }
+        provider->read_lease_ms = json_object_get_int64(val);
+    }
+
+    /* "omap_page_size": size (in bytes) of the buffers into which omap
+     * keys and values are listed from Yokan (default 64 KiB) */
+    if (json_object_object_get_ex(config, "omap_page_size", &val)) {
+        if (!json_object_is_type(val, json_type_int)
+            || json_object_get_int64(val) <= 0
+            || json_object_get_int64(val) > UINT32_MAX) {
+            margo_error(provider->mid,
+                        "mobject_provider_register(): \"omap_page_size\" "
+                        "should be a strictly positive 32-bit integer");
+            json_object_put(config);
+            return -1;
+        }
+        provider->omap_page_size = json_object_get_int64(val);
+    }
+
+    /* "zero_detection_size": size (in bytes) of the blocks of written data
+     * checked for zeros, all-zero blocks being recorded as ZERO segments
+     * instead of being written to bake (default 0, disabled) */
+    if (json_object_object_get_ex(config, "zero_detection_size", &val)) {
+        if (!json_object_is_type(val, json_type_int)
+            || json_object_get_int64(val) < 0
+            || json_object_get_int64(val) > UINT32_MAX) {
+            margo_error(provider->mid,
+                        "mobject_provider_register(): \"zero_detection_size\" "
+                        "should be a positive 32-bit integer");
+            json_object_put(config);
+            return -1;
+        }
+        provider->zero_detection_size = json_object_get_int64(val);
+    }
+
+    /* "compression": codec compressing the regions written from the
+     * server's memory, "none" (default), "lz4" or "zstd" */
+    if (json_object_object_get_ex(config, "compression", &val)) {
+        int codec = json_object_is_type(val, json_type_string)
+                      ? mobject_compression_codec(json_object_get_string(val))
+                      : -1;
+        if (codec < 0) {
+            margo_error(provider->mid,
+                        "mobject_provider_register(): \"compression\" "
+                        "should be \"none\" or a codec available in this "
+                        "build (\"lz4\", \"zstd\")");
+            json_object_put(config);
+            return -1;
+        }
+        provider->compression = codec;
+    }
+
+    /* "dedup_chunk_size": size (in bytes) of the chunks of written data
+     * indexed for deduplication (default 0, disabled) */
+    if (json_object_object_get_ex(config, "dedup_chunk_size", &val)) {
+        if (!json_object_is_type(val, json_type_int)
+            || json_object_get_int64(val) < 0
+            || json_object_get_int64(val) > UINT32_MAX) {
+            margo_error(provider->mid,
+                        "mobject_provider_register(): \"dedup_chunk_size\" "
+                        "should be a positive 32-bit integer");
+            json_object_put(config);
+            return -1;
+        }
+        provider->dedup_chunk_size = json_object_get_int64(val);
+    }
+
+    /* "dedup_chunking": how written data is cut into chunks, "fixed"
+     * (default) or "content" (content-defined boundaries) */
+    if (json_object_object_get_ex(config, "dedup_chunking", &val)) {
+        int chunking = json_object_is_type(val, json_type_string)
+                         ? mobject_dedup_chunking(json_object_get_string(val))
+                         : -1;
+        if (chunking < 0) {
+            margo_error(provider->mid,
+                        "mobject_provider_register(): \"dedup_chunking\" "
+                        "should be \"fixed\" or \"content\"");
+            json_object_put(config);
+            return -1;
+        }
+        provider->dedup_chunking = chunking;
+    }
+
+    /* write_buffered cuts writes into buffers holding whole zero detection
+     * blocks and fixed-size dedup chunks */
+    uint32_t block = provider->zero_detection_size;
+    uint32_t chunk = provider->dedup_chunking == MOBJECT_DEDUP_FIXED
+                       ? provider->dedup_chunk_size
+                       : 0;
+    if (block > MOBJECT_WRITE_BUFFER_SIZE || chunk > MOBJECT_WRITE_BUFFER_SIZE
+        || (block && chunk && block % chunk != 0 && chunk % block != 0)) {
+        margo_error(provider->mid,
+                    "mobject_provider_register(): \"zero_detection_size\" "
+                    "and \"dedup_chunk_size\" (with \"fixed\" chunking) "
+                    "should be at most %d, and one should divide the other",
+                    MOBJECT_WRITE_BUFFER_SIZE);
+        json_object_put(config);
+        return -1;
+    }
+
+    json_object_put(config);
+    return 0;
+}
+
 static void mobject_finalize_cb(void* data)
 {
     mobject_provider_t provider = (mobject_provider_t)data;
@@ -368,14 +882,32 @@ static void mobject_finalize_cb(void* data)
         margo_deregister(provider->mid, provider->read_op_id);
     if (provider->clean_id) margo_deregister(provider->mid, provider->clean_id);
     if (provider->stat_id) margo_deregister(provider->mid, provider->stat_id);
+    if (provider->version_id)
+        margo_deregister(provider->mid, provider->version_id);
+    if (provider->write_op_batch_id)
+        margo_deregister(provider->mid, provider->write_op_batch_id);
+    if (provider->read_op_batch_id)
+        margo_deregister(provider->mid, provider->read_op_batch_id);
+    if (provider->persist_wait_id)
+        margo_deregister(provider->mid, provider->persist_wait_id);
+    if (provider->wire_format_id)
+        margo_deregister(provider->mid, provider->wire_format_id);
+
+    /* regions written with LIBMOBJECT_OPERATION_EARLY_ACK */
+    if (provider->bake_targets) mobject_deferred_persist_finalize(provider);
 
     yk_database_handle_release(provider->oid_dbh);
     yk_database_handle_release(provider->name_dbh);
     yk_database_handle_release(provider->segment_dbh);
     yk_database_handle_release(provider->omap_dbh);
+    if (provider->dedup_dbh != YOKAN_DATABASE_HANDLE_NULL)
+        yk_database_handle_release(provider->dedup_dbh);
     for (unsigned i = 0; i < provider->num_bake_targets; i++) {
         bake_provider_handle_release(provider->bake_targets[i].ph);
     }
 
+    mobject_object_tails_finalize(provider);
+    mobject_object_locks_finalize(provider);
+    mobject_object_versions_finalize(provider);
     free(provider);
 }
@@ -0,0 +1,159 @@
+/*
+ * (C) 2018 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <stdlib.h>
+#include "libmobject-store.h"
+#include "src/server/object-locks.h"
+#include "src/util/utlist.h"
+
+int mobject_object_locks_init(struct mobject_provider* provider)
+{
+    // zeroed memory holds initialized mutexes
+    provider->object_locks = (struct mobject_object_lock_bucket*)calloc(
+        MOBJECT_OBJECT_LOCK_TABLE_SIZE,
+        sizeof(struct mobject_object_lock_bucket));
+    if (!provider->object_locks) return -1;
+    return 0;
+}
+
+void mobject_object_locks_finalize(struct mobject_provider* provider)
+{
+    if (!provider->object_locks) return;
+    for (unsigned i = 0; i < MOBJECT_OBJECT_LOCK_TABLE_SIZE; i++) {
+        struct mobject_object_lock *lock, *tmp;
+        DL_FOREACH_SAFE(provider->object_locks[i].locks, lock, tmp)
+        {
+            DL_DELETE(provider->object_locks[i].locks, lock);
+            free(lock);
+        }
+    }
+    free(provider->object_locks);
+    provider->object_locks = NULL;
+}
+
+int mobject_object_lock_mode(int flags, int is_write_op)
+{
+    if (flags & LIBMOBJECT_OPERATION_SKIPRWLOCKS) return MOBJECT_LOCK_NONE;
+    if (is_write_op) return MOBJECT_LOCK_EXCLUSIVE;
+    if (flags & LIBMOBJECT_OPERATION_ORDER_READS_WRITES)
+        return MOBJECT_LOCK_ORDERED_SHARED;
+    return MOBJECT_LOCK_SHARED;
+}
+
+static struct mobject_object_lock_bucket*
+bucket_of(struct mobject_provider* provider, oid_t oid)
+{
+    return &provider->object_locks[oid % MOBJECT_OBJECT_LOCK_TABLE_SIZE];
+}
+
+/* returns the lock of oid in the bucket, creating it if create is set
+ * (NULL if it does not exist or could not be allocated) */
+static struct mobject_object_lock*
+find_lock(struct mobject_object_lock_bucket* bucket, oid_t oid, int create)
+{
+    struct mobject_object_lock* lock;
+    DL_FOREACH(bucket->locks, lock)
+    {
+        if (lock->oid == oid) return lock;
+    }
+    if (!create) return NULL;
+    // zeroed memory holds an initialized condition variable
+    lock = (struct mobject_object_lock*)calloc(1, sizeof(*lock));
+    if (!lock) return NULL;
+    lock->oid = oid;
+    DL_APPEND(bucket->locks, lock);
+    return lock;
+}
+
+/* frees the lock once no operation holds or waits for it */
+static void release_lock(struct mobject_object_lock_bucket* bucket,
+                         struct mobject_object_lock*        lock)
+{
+    if (lock->writer || lock->readers || lock->appenders || lock->waiters)
+        return;
+    DL_DELETE(bucket->locks, lock);
+    free(lock);
+}
+
+void mobject_object_lock(struct mobject_provider* provider,
+                         oid_t                    oid,
+                         int                      mode)
+{
+    if (mode == MOBJECT_LOCK_NONE) return;
+    struct mobject_object_lock_bucket* bucket = bucket_of(provider, oid);
+    ABT_mutex mutex = ABT_MUTEX_MEMORY_GET_HANDLE(&bucket->mutex);
+
+    ABT_mutex_lock(mutex);
+    struct mobject_object_lock* lock = find_lock(bucket, oid, 1);
+    while (!lock) {
+        // out of memory, wait for other operations to free theirs
+        ABT_mutex_unlock(mutex);
+        ABT_thread_yield();
+        ABT_mutex_lock(mutex);
+        lock = find_lock(bucket, oid, 1);
+    }
+    ABT_cond cond = ABT_COND_MEMORY_GET_HANDLE(&lock->cond);
+
+    lock->waiters += 1;
+    switch (mode) {
+    case MOBJECT_LOCK_EXCLUSIVE:
+        lock->waiting_writers += 1;
+        while (lock->writer || lock->readers || lock->appenders)
+            ABT_cond_wait(cond, mutex);
+        lock->waiting_writers -= 1;
+        lock->writer = 1;
+        break;
+    case MOBJECT_LOCK_APPEND:
+        // don't overtake the exclusive write_ops waiting for the lock
+        lock->waiting_appenders += 1;
+        while (lock->writer || lock->readers || lock->waiting_writers)
+            ABT_cond_wait(cond, mutex);
+        lock->waiting_appenders -= 1;
+        lock->appenders += 1;
+        break;
+    case MOBJECT_LOCK_ORDERED_SHARED:
+        // wait for the write_ops received before this read_op
+        while (lock->writer || lock->appenders || lock->waiting_writers
+               || lock->waiting_appenders)
+            ABT_cond_wait(cond, mutex);
+        lock->readers += 1;
+        break;
+    default:
+        while (lock->writer || lock->appenders) ABT_cond_wait(cond, mutex);
+        lock->readers += 1;
+        break;
+    }
+    lock->waiters -= 1;
+    ABT_mutex_unlock(mutex);
+}
+
+void mobject_object_unlock(struct mobject_provider* provider,
+                           oid_t                    oid,
+                           int                      mode)
+{
+    if (mode == MOBJECT_LOCK_NONE) return;
+    struct mobject_object_lock_bucket* bucket = bucket_of(provider, oid);
+    ABT_mutex mutex = ABT_MUTEX_MEMORY_GET_HANDLE(&bucket->mutex);
+
+    ABT_mutex_lock(mutex);
+    struct mobject_object_lock* lock = find_lock(bucket, oid, 0);
+    if (!lock) { // unlocking an object that was not locked
+        ABT_mutex_unlock(mutex);
+        return;
+    }
+    if (mode == MOBJECT_LOCK_EXCLUSIVE)
+        lock->writer = 0;
+    else if (mode == MOBJECT_LOCK_APPEND)
+        lock->appenders -= 1;
+    else
+        lock->readers -= 1;
+    if (!lock->writer && !lock->readers && !lock->appenders) {
+        if (lock->waiters)
+            ABT_cond_broadcast(ABT_COND_MEMORY_GET_HANDLE(&lock->cond));
+        else
+            release_lock(bucket, lock);
+    }
+    ABT_mutex_unlock(mutex);
+}
@@ -0,0 +1,90 @@
+/*
+ * (C) 2018 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __SERVER_OBJECT_LOCKS_H
+#define __SERVER_OBJECT_LOCKS_H
+
+#include <abt.h>
+#include "src/server/mobject-provider.h"
+#include "src/server/core/key-types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Operations on an object are serialized by a reader-writer lock, held
+ * from the beginning to the end of the visit of the operation: write_ops
+ * take it exclusively and read_ops take it shared, so a read_op never
+ * observes part of a write_op. Each object being accessed has its own
+ * lock, created on first use and freed when no operation holds or waits
+ * for it. Locks are found in a hash table of
+ * MOBJECT_OBJECT_LOCK_TABLE_SIZE buckets indexed by oid, whose mutex is
+ * only held to update the lock, so operations on different objects never
+ * wait for each other.
+ *
+ * write_ops made only of appends reserve the range they write (see
+ * object-tails.h), so they take the lock in MOBJECT_LOCK_APPEND mode,
+ * shared with each other but exclusive with read_ops and other
+ * write_ops: a read_op still never observes part of them. They do not
+ * overtake the exclusive write_ops waiting for the lock, which a steady
+ * flow of appends would otherwise starve.
+ *
+ * A read_op waits for the write_ops holding the lock, but may overtake
+ * the write_ops waiting for it, unless it is issued with
+ * LIBMOBJECT_OPERATION_ORDER_READS_WRITES. Operations issued with
+ * LIBMOBJECT_OPERATION_SKIPRWLOCKS do not take the lock at all.
+ */
+#define MOBJECT_OBJECT_LOCK_TABLE_SIZE 256
+
+enum {
+    MOBJECT_LOCK_NONE = 0,
+    MOBJECT_LOCK_SHARED,         // read_op
+    MOBJECT_LOCK_ORDERED_SHARED, // read_op ordered with write_ops
+    MOBJECT_LOCK_EXCLUSIVE,      // write_op
+    MOBJECT_LOCK_APPEND          // write_op made only of appends
+};
+
+struct mobject_object_lock {
+    oid_t                       oid;
+    ABT_cond_memory             cond;
+    uint32_t                    readers;
+    uint32_t                    appenders;
+    int                         writer;
+    uint32_t                    waiters;           // operations waiting
+    uint32_t                    waiting_writers;   // of which exclusive
+    uint32_t                    waiting_appenders; // of which appends
+    struct mobject_object_lock* prev;
+    struct mobject_object_lock* next;
+};
+
+struct mobject_object_lock_bucket {
+    ABT_mutex_memory            mutex;
+    struct mobject_object_lock* locks;
+};
+
+int mobject_object_locks_init(struct mobject_provider* provider);
+
+void mobject_object_locks_finalize(struct mobject_provider* provider);
+
+/**
+ * Returns the mode in which an operation issued with the provided
+ * LIBMOBJECT_OPERATION_* flags locks its object.
+ */
+int mobject_object_lock_mode(int flags, int is_write_op);
+
+void mobject_object_lock(struct mobject_provider* provider,
+                         oid_t                    oid,
+                         int                      mode);
+
+void mobject_object_unlock(struct mobject_provider* provider,
+                           oid_t                    oid,
+                           int                      mode);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,385 @@
+/*
+ * (C) 2018 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "src/server/object-tails.h"
+#include "src/util/utlist.h"
+
+#define ZERO_BUFFER_SIZE 65536
+
+/* range of the append region written by an append waiting for the
+ * segment to cover it */
+struct mobject_tail_written {
+    uint64_t                     offset;
+    uint64_t                     end;
+    int                          status; // 1 until extended, then 0 or -1
+    struct mobject_tail_written* prev;
+    struct mobject_tail_written* next;
+};
+
+int mobject_object_tails_init(struct mobject_provider* provider)
+{
+    // zeroed memory holds initialized mutexes
+    provider->object_tails = (struct mobject_object_tail_bucket*)calloc(
+        MOBJECT_TAIL_TABLE_SIZE, sizeof(struct mobject_object_tail_bucket));
+    if (!provider->object_tails) return -1;
+    return 0;
+}
+
+void mobject_object_tails_finalize(struct mobject_provider* provider)
+{
+    if (!provider->object_tails) return;
+    for (unsigned i = 0; i < MOBJECT_TAIL_TABLE_SIZE; i++) {
+        struct mobject_object_tail *t, *tmp;
+        DL_FOREACH_SAFE(provider->object_tails[i].tails, t, tmp)
+        {
+            DL_DELETE(provider->object_tails[i].tails, t);
+            free(t);
+        }
+    }
+    free(provider->object_tails);
+    provider->object_tails = NULL;
+}
+
+static struct mobject_object_tail_bucket*
+bucket_of(struct mobject_provider* provider, oid_t oid)
+{
+    return &provider->object_tails[oid % MOBJECT_TAIL_TABLE_SIZE];
+}
+
+/* returns the tail of oid in the bucket, NULL if it is not cached */
+static struct mobject_object_tail*
+find_tail(struct mobject_object_tail_bucket* bucket, oid_t oid)
+{
+    struct mobject_object_tail* t;
+    DL_FOREACH(bucket->tails, t)
+    {
+        if (t->oid == oid) return t;
+    }
+    return NULL;
+}
+
+/* returns the tail of oid, moved to the front of the bucket, or a new tail
+ * to compute, evicting the least recently used idle tail of a full bucket
+ * (NULL if it could not be allocated) */
+static struct mobject_object_tail*
+get_tail(struct mobject_object_tail_bucket* bucket, oid_t oid)
+{
+    struct mobject_object_tail *t = find_tail(bucket, oid), *victim = NULL;
+    int                         count = 0;
+    if (t) {
+        DL_DELETE(bucket->tails, t);
+        DL_PREPEND(bucket->tails, t);
+        return t;
+    }
+    DL_FOREACH(bucket->tails, t)
+    {
+        count += 1;
+        if (!t->pending && !t->waiters) victim = t;
+    }
+    if (count >= MOBJECT_TAIL_BUCKET_SIZE && victim) {
+        DL_DELETE(bucket->tails, victim);
+        free(victim);
+    }
+    // zeroed memory holds an initialized condition variable
+    t = (struct mobject_object_tail*)calloc(1, sizeof(*t));
+    if (!t) return NULL;
+    t->oid       = oid;
+    t->next_size = MOBJECT_APPEND_REGION_MIN;
+    DL_PREPEND(bucket->tails, t);
+    return t;
+}
+
+/* whether len bytes at the tail fit in the append region */
+static int fits_in_region(struct mobject_object_tail* t, uint64_t len)
+{
+    return t->region_size != 0
+        && t->tail + len <= t->region_start + t->region_size;
+}
+
+/* allocates an append region starting at the tail, large enough for len
+ * bytes, without holding the mutex of the bucket; the other appends to
+ * the object wait for it. On failure, the object is left without append
+ * region. */
+static void new_region(struct mobject_provider*    provider,
+                       struct mobject_object_tail* t,
+                       ABT_mutex                   mutex,
+                       uint64_t                    len)
+{
+    unsigned target_idx = t->oid % provider->num_bake_targets;
+    struct mobject_bake_target* target = &provider->bake_targets[target_idx];
+    uint64_t         size = t->next_size > len ? t->next_size : len;
+    bake_region_id_t rid;
+    int              ret;
+
+    t->region_size = 0;
+    t->allocating  = 1;
+    ABT_mutex_unlock(mutex);
+    ret = bake_create(target->ph, target->tid, size, &rid);
+    ABT_mutex_lock(mutex);
+    t->allocating = 0;
+    ABT_cond_broadcast(ABT_COND_MEMORY_GET_HANDLE(&t->cond));
+    if (ret != 0) {
+        margo_error(provider->mid, "[mobject] %s:%d: bake_create returned %d",
+                    __func__, __LINE__, ret);
+        return;
+    }
+    t->rid          = rid;
+    t->target_idx   = target_idx;
+    t->region_start = t->tail;
+    t->region_size  = size;
+    t->region_end   = t->tail;
+    t->written_end  = t->tail;
+    t->seg_key_size = 0;
+    if (t->next_size < MOBJECT_APPEND_REGION_MAX) t->next_size *= 2;
+}
+
+/* overwrites a range of the append region that could not be written */
+static void zero_range(struct mobject_provider*         provider,
+                       const struct mobject_tail_range* range)
+{
+    static const char zeros[ZERO_BUFFER_SIZE];
+    struct mobject_bake_target* target
+        = &provider->bake_targets[range->target_idx];
+    uint64_t done = 0, n;
+    int      ret  = 0;
+
+    while (ret == 0 && done < range->len) {
+        n = range->len - done;
+        if (n > ZERO_BUFFER_SIZE) n = ZERO_BUFFER_SIZE;
+        ret = bake_write(target->ph, target->tid, range->rid,
+                         range->region_offset + done, zeros, n);
+        done += n;
+    }
+    if (ret == 0)
+        ret = bake_persist(target->ph, target->tid, range->rid,
+                           range->region_offset, range->len);
+    if (ret != 0)
+        margo_error(provider->mid,
+                    "[mobject] %s:%d: could not fill a failed append with "
+                    "zeros (bake returned %d)",
+                    __func__, __LINE__, ret);
+}
+
+/* replaces the segment of the append region by one ending at end */
+static int extend_segment(struct mobject_provider*    provider,
+                          struct mobject_object_tail* t,
+                          uint64_t                    end)
+{
+    segment_key_t seg;
+    char          key[MAX_SEGMENT_KEY_SIZE];
+    char          val[MAX_REGION_VALUE_SIZE];
+    size_t        key_size, val_size;
+    yk_return_t   yret;
+
+    seg.oid         = t->oid;
+    seg.timestamp   = time(NULL);
+    seg.start_index = t->region_start;
+    seg.end_index   = end;
+    seg.type        = BAKE_REGION;
+    ABT_mutex_lock(ABT_MUTEX_MEMORY_GET_HANDLE(&provider->mutex));
+    seg.seq_id = provider->seq_id++;
+    ABT_mutex_unlock(ABT_MUTEX_MEMORY_GET_HANDLE(&provider->mutex));
+
+    key_size = encode_segment_key(key, &seg);
+    val_size = encode_region_value(val, t->target_idx, &t->rid, NULL,
+                                   NULL);
+    yret     = yk_put(provider->segment_dbh, YOKAN_MODE_DEFAULT, key, key_size,
+                      val, val_size);
+    if (yret != YOKAN_SUCCESS) {
+        margo_error(provider->mid, "[mobject] %s:%d: yk_put returned %d",
+                    __func__, __LINE__, yret);
+        return -1;
+    }
+    // the new segment is more recent, so reads ignore the old one even if
+    // it cannot be erased
+    if (t->seg_key_size) {
+        yret = yk_erase(provider->segment_dbh, YOKAN_MODE_DEFAULT,
+                        t->seg_key, t->seg_key_size);
+        if (yret != YOKAN_SUCCESS)
+            margo_error(provider->mid, "[mobject] %s:%d: yk_erase returned %d",
+                        __func__, __LINE__, yret);
+    }
+    memcpy(t->seg_key, key, key_size);
+    t->seg_key_size = key_size;
+    return 0;
+}
+
+/* advances the end of the ranges written right after the segment */
+static void advance_written_end(struct mobject_object_tail* t)
+{
+    struct mobject_tail_written* w;
+    int                          advanced = 1;
+    while (advanced) {
+        advanced = 0;
+        DL_FOREACH(t->written, w)
+        {
+            if (w->offset == t->written_end && w->end > w->offset) {
+                t->written_end = w->end;
+                advanced       = 1;
+            }
+        }
+    }
+}
+
+/* extends the segment over the ranges written right after it, as many
+ * at once as have been written, without holding the mutex of the bucket.
+ * A failed extension is tried once more, then the appends of the ranges
+ * it covered fail, and the ranges are given back if none was reserved
+ * after them. */
+static void extend_written(struct mobject_provider*    provider,
+                           struct mobject_object_tail* t,
+                           ABT_mutex                   mutex)
+{
+    struct mobject_tail_written *w, *tmp;
+    uint64_t                     failed_end = 0;
+    int                          ret;
+
+    t->extending = 1;
+    while (t->written_end > t->region_end && t->written_end != failed_end) {
+        uint64_t end = t->written_end;
+        ABT_mutex_unlock(mutex);
+        ret = extend_segment(provider, t, end);
+        if (ret != 0) ret = extend_segment(provider, t, end);
+        ABT_mutex_lock(mutex);
+        DL_FOREACH_SAFE(t->written, w, tmp)
+        {
+            if (w->end > end) continue;
+            w->status = ret;
+            DL_DELETE(t->written, w);
+        }
+        if (ret == 0) {
+            t->region_end = end;
+        } else {
+            failed_end = end;
+            if (t->tail == end) t->tail = t->written_end = t->region_end;
+        }
+    }
+    t->extending = 0;
+    ABT_cond_broadcast(ABT_COND_MEMORY_GET_HANDLE(&t->cond));
+}
+
+void mobject_object_tail_reserve(struct mobject_provider*   provider,
+                                 oid_t                      oid,
+                                 uint64_t                   len,
+                                 mobject_size_fn            size_fn,
+                                 struct mobject_tail_range* range)
+{
+    struct mobject_object_tail_bucket* bucket = bucket_of(provider, oid);
+    ABT_mutex mutex = ABT_MUTEX_MEMORY_GET_HANDLE(&bucket->mutex);
+
+    ABT_mutex_lock(mutex);
+    struct mobject_object_tail* t = get_tail(bucket, oid);
+    while (!t) {
+        // out of memory, wait for other appends to release theirs
+        ABT_mutex_unlock(mutex);
+        ABT_thread_yield();
+        ABT_mutex_lock(mutex);
+        t = get_tail(bucket, oid);
+    }
+    ABT_cond cond = ABT_COND_MEMORY_GET_HANDLE(&t->cond);
+
+    // counted as pending while waiting, so the tail is not evicted
+    t->pending += 1;
+    while (t->loading || t->allocating) ABT_cond_wait(cond, mutex);
+    if (!t->loaded) {
+        t->loading = 1;
+        ABT_mutex_unlock(mutex);
+        uint64_t size = size_fn(provider, oid);
+        ABT_mutex_lock(mutex);
+        t->tail    = size;
+        t->loading = 0;
+        t->loaded  = 1;
+        ABT_cond_broadcast(cond);
+    }
+    t->appends += 1;
+    if (t->appends > MOBJECT_APPEND_REGION_THRESHOLD) {
+        // a full region is replaced once all its ranges are in its segment
+        while (t->allocating
+               || (t->region_size && !fits_in_region(t, len)
+                   && t->region_end != t->tail))
+            ABT_cond_wait(cond, mutex);
+        if (!fits_in_region(t, len)) new_region(provider, t, mutex, len);
+    }
+    range->offset    = t->tail;
+    range->len       = len;
+    range->in_region = len && fits_in_region(t, len);
+    if (range->in_region) {
+        range->target_idx    = t->target_idx;
+        range->rid           = t->rid;
+        range->region_offset = t->tail - t->region_start;
+    }
+    t->tail += len;
+    ABT_mutex_unlock(mutex);
+}
+
+int mobject_object_tail_release(struct mobject_provider*         provider,
+                                oid_t                            oid,
+                                const struct mobject_tail_range* range,
+                                int                              failed)
+{
+    struct mobject_object_tail_bucket* bucket = bucket_of(provider, oid);
+    ABT_mutex mutex = ABT_MUTEX_MEMORY_GET_HANDLE(&bucket->mutex);
+    uint64_t  end   = range->offset + range->len;
+    int       ret   = 0;
+
+    if (range->in_region && failed) zero_range(provider, range);
+
+    ABT_mutex_lock(mutex);
+    // pending reservations keep the tail in the bucket
+    struct mobject_object_tail* t    = find_tail(bucket, oid);
+    ABT_cond                    cond = ABT_COND_MEMORY_GET_HANDLE(&t->cond);
+    if (range->in_region) {
+        // the segment must not cover ranges that are not written yet, so
+        // the range waits for the append that completes the ranges before
+        // it, or extends the segment itself if it is that append
+        struct mobject_tail_written w = {range->offset, end, 1, NULL, NULL};
+        DL_APPEND(t->written, &w);
+        advance_written_end(t);
+        if (!t->extending) extend_written(provider, t, mutex);
+        while (w.status > 0) ABT_cond_wait(cond, mutex);
+        ret = w.status;
+    } else if (failed) {
+        if (t->tail == end && t->region_size == 0)
+            t->tail = range->offset;
+        else
+            ret = 1;
+    }
+    t->pending -= 1;
+    if (t->pending == 0 || range->in_region) ABT_cond_broadcast(cond);
+    ABT_mutex_unlock(mutex);
+    return ret;
+}
+
+void mobject_object_tail_invalidate(struct mobject_provider* provider,
+                                    oid_t                    oid)
+{
+    struct mobject_object_tail_bucket* bucket = bucket_of(provider, oid);
+    ABT_mutex mutex = ABT_MUTEX_MEMORY_GET_HANDLE(&bucket->mutex);
+
+    ABT_mutex_lock(mutex);
+    struct mobject_object_tail* t = find_tail(bucket, oid);
+    if (t) {
+        // appends issued with LIBMOBJECT_OPERATION_SKIPRWLOCKS may be running
+        t->waiters += 1;
+        while (t->pending)
+            ABT_cond_wait(ABT_COND_MEMORY_GET_HANDLE(&t->cond), mutex);
+        t->waiters -= 1;
+        if (!t->waiters) {
+            DL_DELETE(bucket->tails, t);
+            free(t);
+        } else {
+            // other invalidations still refer to it, the tail is recomputed
+            // by the next append
+            t->loaded      = 0;
+            t->appends     = 0;
+            t->region_size = 0;
+            t->next_size   = MOBJECT_APPEND_REGION_MIN;
+        }
+    }
+    ABT_mutex_unlock(mutex);
+}
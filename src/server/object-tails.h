@@ -0,0 +1,137 @@
+/*
+ * (C) 2018 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __SERVER_OBJECT_TAILS_H
+#define __SERVER_OBJECT_TAILS_H
+
+#include <abt.h>
+#include <bake-client.h>
+#include "src/server/mobject-provider.h"
+#include "src/server/core/key-encoding.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Appends reserve the range they write by advancing the tail of the
+ * object, i.e. the end of the last range reserved, so concurrent appends
+ * to an object never write at the same offset and do not need to lock
+ * it exclusively (see object-locks.h). Tails are cached per object in a
+ * hash table of MOBJECT_TAIL_TABLE_SIZE buckets indexed by oid. The
+ * bucket mutex is only held to update the tail and counters: the tail
+ * of an object is computed from its segments by the first append that
+ * does not find it, the other appends to the object waiting for it, and
+ * bake regions are created, written and mapped without holding it.
+ * Idle tails are evicted when a bucket holds more than
+ * MOBJECT_TAIL_BUCKET_SIZE of them. Other operations changing the size
+ * of an object invalidate its tail.
+ *
+ * Once an object has received more than MOBJECT_APPEND_REGION_THRESHOLD
+ * appends while its tail is cached, a bake region larger than the append
+ * is allocated at the tail, and the following appends write into it in
+ * place instead of creating a region and a segment each. The region is
+ * mapped by a single segment whose end is extended as appends complete,
+ * by replacing its key: the append completing the ranges written right
+ * after the segment extends it over all of them at once. When a region is
+ * full, the next one is twice as large, up to MOBJECT_APPEND_REGION_MAX
+ * bytes. The unused end of a region is lost when the tail is invalidated
+ * or evicted.
+ */
+#define MOBJECT_TAIL_TABLE_SIZE         1024
+#define MOBJECT_TAIL_BUCKET_SIZE        4
+#define MOBJECT_APPEND_REGION_THRESHOLD 4
+#define MOBJECT_APPEND_REGION_MIN       (1ULL << 20)
+#define MOBJECT_APPEND_REGION_MAX       (256ULL << 20)
+
+struct mobject_object_tail {
+    oid_t                        oid;
+    ABT_cond_memory              cond;
+    int                          loading;      // tail being computed
+    int                          loaded;       // tail computed
+    int                          allocating;   // append region being created
+    int                          extending;    // segment being extended
+    uint64_t                     tail;         // end of last range reserved
+    uint32_t                     pending;      // reservations not released
+    uint32_t                     waiters;      // invalidations waiting
+    uint32_t                     appends;      // appends since tail computed
+    unsigned                     target_idx;   // bake target of the region
+    bake_region_id_t             rid;          // append region
+    uint64_t                     region_start; // offset of region in object
+    uint64_t                     region_size;  // 0 if no append region
+    uint64_t                     region_end;   // end of the region's segment
+    uint64_t                     written_end;  // end of written ranges
+    uint64_t                     next_size;    // size of next append region
+    size_t                       seg_key_size; // 0 until segment is created
+    char                         seg_key[MAX_SEGMENT_KEY_SIZE];
+    struct mobject_tail_written* written;      // written, not in the segment
+    struct mobject_object_tail*  prev;
+    struct mobject_object_tail*  next;
+};
+
+struct mobject_tail_written;
+
+struct mobject_object_tail_bucket {
+    ABT_mutex_memory            mutex;
+    struct mobject_object_tail* tails; // most recently used first
+};
+
+/* range reserved by an append */
+struct mobject_tail_range {
+    uint64_t         offset;        // offset of the range in the object
+    uint64_t         len;
+    int              in_region;     // the range is in the append region
+    unsigned         target_idx;    // bake target of the append region
+    bake_region_id_t rid;           // append region
+    uint64_t         region_offset; // offset of the range in the region
+};
+
+/* computes the size of an object from its segments */
+typedef uint64_t (*mobject_size_fn)(struct mobject_provider* provider,
+                                    oid_t                    oid);
+
+int mobject_object_tails_init(struct mobject_provider* provider);
+
+void mobject_object_tails_finalize(struct mobject_provider* provider);
+
+/**
+ * Reserves the len bytes following the tail of the object into range.
+ * If range->in_region is set, the caller writes the data at
+ * range->region_offset in the append region instead of creating a new
+ * region. Every reservation must be released with
+ * mobject_object_tail_release.
+ */
+void mobject_object_tail_reserve(struct mobject_provider*   provider,
+                                 oid_t                      oid,
+                                 uint64_t                   len,
+                                 mobject_size_fn            size_fn,
+                                 struct mobject_tail_range* range);
+
+/**
+ * Releases a reservation. A range of the append region is added to the
+ * segment of the region, together with the ranges written right after
+ * the segment, once the ranges before it have been written. It is
+ * filled with zeros first if it could not be written (failed is set).
+ * If the segment could not be updated, -1 is returned, and the range is
+ * given back if no range was reserved after it (otherwise the next
+ * extension of the segment covers it). A range outside of the append
+ * region that could not be written is given back when it is the last
+ * one reserved, in which case 0 is returned; else 1 is returned and the
+ * caller must fill the range, since later appends have been written
+ * after it.
+ */
+int mobject_object_tail_release(struct mobject_provider*         provider,
+                                oid_t                            oid,
+                                const struct mobject_tail_range* range,
+                                int                              failed);
+
+void mobject_object_tail_invalidate(struct mobject_provider* provider,
+                                    oid_t                    oid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
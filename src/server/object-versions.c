@@ -0,0 +1,54 @@
+/*
+ * (C) 2018 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <stdlib.h>
+#include <time.h>
+#include "src/server/object-versions.h"
+
+static unsigned long version_slot(const char* object_name)
+{
+    unsigned long hash = 0;
+    int           c;
+
+    while ((c = *object_name++)) hash = c + (hash << 6) + (hash << 16) - hash;
+
+    return hash % MOBJECT_VERSION_TABLE_SIZE;
+}
+
+int mobject_object_versions_init(struct mobject_provider* provider)
+{
+    provider->versions
+        = (uint64_t*)malloc(MOBJECT_VERSION_TABLE_SIZE * sizeof(uint64_t));
+    if (!provider->versions) return -1;
+    uint64_t epoch = ((uint64_t)time(NULL)) << 32;
+    for (unsigned i = 0; i < MOBJECT_VERSION_TABLE_SIZE; i++)
+        provider->versions[i] = epoch;
+    return 0;
+}
+
+void mobject_object_versions_finalize(struct mobject_provider* provider)
+{
+    free(provider->versions);
+    provider->versions = NULL;
+}
+
+uint64_t mobject_object_version_get(struct mobject_provider* provider,
+                                    const char*              object_name)
+{
+    unsigned long slot = version_slot(object_name);
+    ABT_mutex_lock(ABT_MUTEX_MEMORY_GET_HANDLE(&provider->versions_mutex));
+    uint64_t version = provider->versions[slot];
+    ABT_mutex_unlock(ABT_MUTEX_MEMORY_GET_HANDLE(&provider->versions_mutex));
+    return version;
+}
+
+void mobject_object_version_bump(struct mobject_provider* provider,
+                                 const char*              object_name)
+{
+    unsigned long slot = version_slot(object_name);
+    ABT_mutex_lock(ABT_MUTEX_MEMORY_GET_HANDLE(&provider->versions_mutex));
+    provider->versions[slot] += 1;
+    ABT_mutex_unlock(ABT_MUTEX_MEMORY_GET_HANDLE(&provider->versions_mutex));
+}
@@ -0,0 +1,41 @@
+/*
+ * (C) 2018 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __SERVER_OBJECT_VERSIONS_H
+#define __SERVER_OBJECT_VERSIONS_H
+
+#include <stdint.h>
+#include "src/server/mobject-provider.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Object versions are used by clients to validate the content of their
+ * read cache. Versions are kept in a fixed-size table indexed by a hash
+ * of the object name, so two objects may share a version: this only
+ * causes spurious cache invalidations. All the slots start at a value
+ * derived from the provider's start time, so versions handed out by a
+ * restarted provider never match versions cached by clients before the
+ * restart.
+ */
+#define MOBJECT_VERSION_TABLE_SIZE 4096
+
+int mobject_object_versions_init(struct mobject_provider* provider);
+
+void mobject_object_versions_finalize(struct mobject_provider* provider);
+
+uint64_t mobject_object_version_get(struct mobject_provider* provider,
+                                    const char*              object_name);
+
+void mobject_object_version_bump(struct mobject_provider* provider,
+                                 const char*              object_name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -14,11 +14,12 @@ static void read_op_printer_stat(void*, uint64_t*, time_t*, int*);
 static void
 read_op_printer_read(void*, uint64_t, size_t, buffer_u, size_t*, int*);
 static void read_op_printer_omap_get_keys(
-    void*, const char*, uint64_t, mobject_store_omap_iter_t*, int*);
+    void*, const char*, uint64_t, size_t, mobject_store_omap_iter_t*, int*);
 static void read_op_printer_omap_get_vals(void*,
                                           const char*,
                                           const char*,
                                           uint64_t,
+                                          size_t,
                                           mobject_store_omap_iter_t*,
                                           int*);
 static void read_op_printer_omap_get_vals_by_keys(
@@ -68,6 +69,7 @@ void read_op_printer_read(void*    u,
 void read_op_printer_omap_get_keys(void*                      u,
                                    const char*                start_after,
                                    uint64_t                   max_return,
+                                   size_t                     max_bytes,
                                    mobject_store_omap_iter_t* iter,
                                    int*                       prval)
 {
@@ -82,6 +84,7 @@ void read_op_printer_omap_get_vals(void*                      u,
                                    const char*                start_after,
                                    const char*                filter_prefix,
                                    uint64_t                   max_return,
+                                   size_t                     max_bytes,
                                    mobject_store_omap_iter_t* iter,
                                    int*                       prval)
 {
@@ -4,6 +4,7 @@
  * See COPYRIGHT in top-level directory.
  */
 #include <stdio.h>
+#include <inttypes.h>
 #include "src/server/printer/print-write-op.h"
 #include "src/io-chain/write-op-visitor.h"
 
@@ -14,27 +15,37 @@ static void write_op_printer_write(void*, buffer_u, size_t, uint64_t);
 static void write_op_printer_write_full(void*, buffer_u, size_t);
 static void
 write_op_printer_writesame(void*, buffer_u, size_t, size_t, uint64_t);
-static void write_op_printer_append(void*, buffer_u, size_t);
+static void write_op_printer_append(void*, buffer_u, size_t, uint64_t*, int*);
 static void write_op_printer_remove(void*);
 static void write_op_printer_truncate(void*, uint64_t);
 static void write_op_printer_zero(void*, uint64_t, uint64_t);
 static void write_op_printer_omap_set(
     void*, char const* const*, char const* const*, const size_t*, size_t);
 static void write_op_printer_omap_rm_keys(void*, char const* const*, size_t);
+static void write_op_printer_omap_rm_range(void*, const char*, const char*);
+static void write_op_printer_omap_clear(void*);
+static void
+write_op_printer_omap_add(void*, const char*, int64_t, int64_t*, int*);
+static void write_op_printer_omap_cmpxchg(
+    void*, const char*, const char*, size_t, const char*, size_t, int*);
 
 struct write_op_visitor write_op_printer
-    = {.visit_begin        = write_op_printer_begin,
-       .visit_create       = write_op_printer_create,
-       .visit_write        = write_op_printer_write,
-       .visit_write_full   = write_op_printer_write_full,
-       .visit_writesame    = write_op_printer_writesame,
-       .visit_append       = write_op_printer_append,
-       .visit_remove       = write_op_printer_remove,
-       .visit_truncate     = write_op_printer_truncate,
-       .visit_zero         = write_op_printer_zero,
-       .visit_omap_set     = write_op_printer_omap_set,
-       .visit_omap_rm_keys = write_op_printer_omap_rm_keys,
-       .visit_end          = write_op_printer_end};
+    = {.visit_begin         = write_op_printer_begin,
+       .visit_create        = write_op_printer_create,
+       .visit_write         = write_op_printer_write,
+       .visit_write_full    = write_op_printer_write_full,
+       .visit_writesame     = write_op_printer_writesame,
+       .visit_append        = write_op_printer_append,
+       .visit_remove        = write_op_printer_remove,
+       .visit_truncate      = write_op_printer_truncate,
+       .visit_zero          = write_op_printer_zero,
+       .visit_omap_set      = write_op_printer_omap_set,
+       .visit_omap_rm_keys  = write_op_printer_omap_rm_keys,
+       .visit_omap_rm_range = write_op_printer_omap_rm_range,
+       .visit_omap_clear    = write_op_printer_omap_clear,
+       .visit_omap_add      = write_op_printer_omap_add,
+       .visit_omap_cmpxchg  = write_op_printer_omap_cmpxchg,
+       .visit_end           = write_op_printer_end};
 
 void print_write_op(mobject_store_write_op_t write_op, const char* object_name)
 {
@@ -75,7 +86,8 @@ void write_op_printer_writesame(
            buf.as_offset, data_len, write_len, offset);
 }
 
-void write_op_printer_append(void* u, buffer_u buf, size_t len)
+void write_op_printer_append(
+    void* u, buffer_u buf, size_t len, uint64_t* poffset, int* prval)
 {
     printf("\t<append from=%ld length=%ld />\n", buf.as_offset, len);
 }
@@ -118,3 +130,29 @@ void write_op_printer_omap_rm_keys(void*              u,
     }
     printf("\t</omap_rm_keys>\n");
 }
+
+void write_op_printer_omap_rm_range(void* u, const char* start, const char* end)
+{
+    printf("\t<omap_rm_range start=\"%s\" end=\"%s\" />\n", start, end);
+}
+
+void write_op_printer_omap_clear(void* u) { printf("\t<omap_clear />\n"); }
+
+void write_op_printer_omap_add(
+    void* u, const char* key, int64_t delta, int64_t* presult, int* prval)
+{
+    printf("\t<omap_add key=\"%s\" delta=%" PRId64 " />\n", key, delta);
+}
+
+void write_op_printer_omap_cmpxchg(void*       u,
+                                   const char* key,
+                                   const char* cmp,
+                                   size_t      cmp_len,
+                                   const char* val,
+                                   size_t      val_len,
+                                   int*        prval)
+{
+    printf("\t<omap_cmpxchg key=\"%s\" absent=%d cmp_len=%ld "
+           "val_len=%ld />\n",
+           key, cmp == NULL, cmp_len, val_len);
+}
@@ -0,0 +1,91 @@
+/*
+ * (C) 2018 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <limits.h>
+#include <string.h>
+#include "mobject-store-config.h"
+#ifdef HAVE_LZ4
+#include <lz4.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#include "src/server/region-compression.h"
+
+/* favors speed, the data being compressed on the write path */
+#define ZSTD_LEVEL 1
+
+int mobject_compression_codec(const char* name)
+{
+    if (strcmp(name, "none") == 0) return REGION_CODEC_NONE;
+#ifdef HAVE_LZ4
+    if (strcmp(name, "lz4") == 0) return REGION_CODEC_LZ4;
+#endif
+#ifdef HAVE_ZSTD
+    if (strcmp(name, "zstd") == 0) return REGION_CODEC_ZSTD;
+#endif
+    return -1;
+}
+
+size_t mobject_compress_bound(int codec, size_t size)
+{
+    switch (codec) {
+#ifdef HAVE_LZ4
+    case REGION_CODEC_LZ4:
+        if (size > LZ4_MAX_INPUT_SIZE) return 0;
+        return LZ4_compressBound((int)size);
+#endif
+#ifdef HAVE_ZSTD
+    case REGION_CODEC_ZSTD:
+        return ZSTD_compressBound(size);
+#endif
+    default:
+        return 0;
+    }
+}
+
+size_t mobject_compress(
+    int codec, const char* src, size_t size, char* dst, size_t capacity)
+{
+    switch (codec) {
+#ifdef HAVE_LZ4
+    case REGION_CODEC_LZ4: {
+        if (size > LZ4_MAX_INPUT_SIZE || capacity > INT_MAX) return 0;
+        int n = LZ4_compress_default(src, dst, (int)size, (int)capacity);
+        return n > 0 ? (size_t)n : 0;
+    }
+#endif
+#ifdef HAVE_ZSTD
+    case REGION_CODEC_ZSTD: {
+        size_t n = ZSTD_compress(dst, capacity, src, size, ZSTD_LEVEL);
+        return ZSTD_isError(n) ? 0 : n;
+    }
+#endif
+    default:
+        return 0;
+    }
+}
+
+int mobject_decompress(
+    int codec, const char* src, size_t size, char* dst, size_t data_size)
+{
+    switch (codec) {
+#ifdef HAVE_LZ4
+    case REGION_CODEC_LZ4: {
+        if (size > INT_MAX || data_size > INT_MAX) return -1;
+        int n = LZ4_decompress_safe(src, dst, (int)size, (int)data_size);
+        return n >= 0 && (size_t)n == data_size ? 0 : -1;
+    }
+#endif
+#ifdef HAVE_ZSTD
+    case REGION_CODEC_ZSTD: {
+        size_t n = ZSTD_decompress(dst, data_size, src, size);
+        return !ZSTD_isError(n) && n == data_size ? 0 : -1;
+    }
+#endif
+    default:
+        return -1;
+    }
+}
@@ -0,0 +1,48 @@
+/*
+ * (C) 2018 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __SERVER_REGION_COMPRESSION_H
+#define __SERVER_REGION_COMPRESSION_H
+
+#include <stddef.h>
+#include "src/server/core/key-encoding.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Providers configured with a "compression" codec compress the data of
+ * the regions they create from data held in their memory (see
+ * write_local_data in core-write-op.cpp); the codec and the sizes of the
+ * compressed and decompressed data are recorded in the value of the
+ * segment (see key-encoding.h). Reads decompress the whole region before
+ * pushing the requested part of it to the client. LZ4 and zstd are only
+ * available if Mobject was built with liblz4 and libzstd respectively.
+ */
+
+/* returns the REGION_CODEC_* named name ("none", "lz4" or "zstd"), or -1
+ * if it is unknown or not available in this build */
+int mobject_compression_codec(const char* name);
+
+/* largest size of the compression of size bytes with codec */
+size_t mobject_compress_bound(int codec, size_t size);
+
+/* compresses the size bytes of src into dst, which holds capacity
+ * bytes, returns the size of the compressed data, 0 on failure */
+size_t mobject_compress(
+    int codec, const char* src, size_t size, char* dst, size_t capacity);
+
+/* decompresses the size bytes of src into the data_size bytes of dst,
+ * returns 0 on success, -1 if the data is invalid or does not
+ * decompress into exactly data_size bytes */
+int mobject_decompress(
+    int codec, const char* src, size_t size, char* dst, size_t data_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,256 @@
+/*
+ * (C) 2018 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#include <string.h>
+#include "src/server/region-dedup.h"
+
+int mobject_dedup_chunking(const char* name)
+{
+    if (strcmp(name, "fixed") == 0) return MOBJECT_DEDUP_FIXED;
+    if (strcmp(name, "content") == 0) return MOBJECT_DEDUP_CONTENT;
+    return -1;
+}
+
+/* value of a byte in the gear hash, spread over the 64 bits */
+static inline uint64_t gear(uint8_t b)
+{
+    uint64_t g = ((uint64_t)b + 1) * 0x9e3779b97f4a7c15ULL;
+    return g ^ (g >> 29);
+}
+
+size_t mobject_dedup_next_chunk(int         chunking,
+                                size_t      chunk_size,
+                                size_t      pos,
+                                const char* data,
+                                size_t      size)
+{
+    if (chunking == MOBJECT_DEDUP_FIXED) {
+        size_t n = chunk_size - pos % chunk_size;
+        return n < size ? n : size;
+    }
+
+    /* content-defined chunking with a gear hash (each byte shifts the
+     * previous ones one bit up, so that the top bits of the hash depend
+     * on the last 64 bytes): a chunk ends after at least min bytes, where
+     * the top k bits of the hash are zero, or after max bytes */
+    size_t   min = chunk_size / 4 ? chunk_size / 4 : 1;
+    size_t   max = chunk_size * 4;
+    unsigned k   = 0;
+    while (((size_t)2 << k) <= chunk_size - min) k++;
+    uint64_t mask = k ? ~0ULL << (64 - k) : 0;
+    uint64_t h    = 0;
+    size_t   i;
+
+    if (size <= min) return size;
+    if (max > size) max = size;
+    for (i = 0; i < min; i++) h = (h << 1) + gear((uint8_t)data[i]);
+    for (; i < max; i++) {
+        if ((h & mask) == 0) return i;
+        h = (h << 1) + gear((uint8_t)data[i]);
+    }
+    return max;
+}
+
+static inline uint64_t rotl64(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t fmix64(uint64_t k)
+{
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+static inline uint64_t load_le64(const uint8_t* p)
+{
+    uint64_t v = 0;
+    int      i;
+    for (i = 7; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+/* MurmurHash3 (x64, 128 bits) with a zero seed; the data of indexed
+ * regions is compared with that of new chunks before being shared, so the
+ * digest only has to make collisions unlikely, not impossible */
+void mobject_dedup_digest(const void* data, size_t size, uint8_t* digest)
+{
+    const uint64_t c1 = 0x87c37b91114253d5ULL;
+    const uint64_t c2 = 0x4cf5ad432745937fULL;
+    const uint8_t* p  = (const uint8_t*)data;
+    uint64_t       h1 = 0, h2 = 0, k1, k2;
+    uint8_t        tail[16] = {0};
+    size_t         i, rem = size % 16;
+
+    for (i = 0; i + 16 <= size; i += 16) {
+        k1 = load_le64(p + i) * c1;
+        k2 = load_le64(p + i + 8) * c2;
+        h1 ^= rotl64(k1, 31) * c2;
+        h1 = (rotl64(h1, 27) + h2) * 5 + 0x52dce729;
+        h2 ^= rotl64(k2, 33) * c1;
+        h2 = (rotl64(h2, 31) + h1) * 5 + 0x38495ab5;
+    }
+    if (rem) {
+        memcpy(tail, p + i, rem);
+        k1 = load_le64(tail) * c1;
+        k2 = load_le64(tail + 8) * c2;
+        if (rem > 8) h2 ^= rotl64(k2, 33) * c1;
+        h1 ^= rotl64(k1, 31) * c2;
+    }
+    h1 ^= size;
+    h2 ^= size;
+    h1 += h2;
+    h2 += h1;
+    h1 = fmix64(h1);
+    h2 = fmix64(h2);
+    h1 += h2;
+    h2 += h1;
+    encode_be64(digest, h1);
+    encode_be64(digest + 8, h2);
+}
+
+/* reads the entry of digest into value (MAX_DEDUP_VALUE_SIZE bytes);
+ * returns 0 on success, 1 if there is none, -1 on error */
+static int get_entry(struct mobject_provider* provider,
+                     const uint8_t*           digest,
+                     char*                    value,
+                     size_t*                  value_size)
+{
+    yk_return_t yret;
+
+    *value_size = MAX_DEDUP_VALUE_SIZE;
+    yret = yk_get(provider->dedup_dbh, YOKAN_MODE_DEFAULT, digest,
+                  REGION_DIGEST_SIZE, value, value_size);
+    if (yret == YOKAN_ERR_KEY_NOT_FOUND) return 1;
+    if (yret != YOKAN_SUCCESS) {
+        margo_error(provider->mid, "[mobject] %s:%d: yk_get returned %d",
+                    __func__, __LINE__, yret);
+        return -1;
+    }
+    if (*value_size <= 8) {
+        margo_error(provider->mid, "[mobject] %s:%d: invalid index entry",
+                    __func__, __LINE__);
+        return -1;
+    }
+    return 0;
+}
+
+static int put_entry(struct mobject_provider* provider,
+                     const uint8_t*           digest,
+                     const char*              value,
+                     size_t                   value_size)
+{
+    yk_return_t yret = yk_put(provider->dedup_dbh, YOKAN_MODE_DEFAULT, digest,
+                              REGION_DIGEST_SIZE, value, value_size);
+    if (yret != YOKAN_SUCCESS) {
+        margo_error(provider->mid, "[mobject] %s:%d: yk_put returned %d",
+                    __func__, __LINE__, yret);
+        return -1;
+    }
+    return 0;
+}
+
+/* mutex serializing the updates of the index entry of digest, digests
+ * being evenly spread, so that only writes of chunks with digests sharing
+ * it wait for each other */
+static ABT_mutex dedup_mutex(struct mobject_provider* provider,
+                             const uint8_t*           digest)
+{
+    return ABT_MUTEX_MEMORY_GET_HANDLE(
+        &provider->dedup_mutexes[digest[0] % MOBJECT_DEDUP_MUTEXES]);
+}
+
+int mobject_dedup_ref(struct mobject_provider* provider,
+                      const uint8_t*           digest,
+                      void*                    value,
+                      size_t*                  value_size)
+{
+    ABT_mutex mutex = dedup_mutex(provider, digest);
+    char      entry[MAX_DEDUP_VALUE_SIZE];
+    size_t    entry_size;
+    int       ret;
+
+    ABT_mutex_lock(mutex);
+    ret = get_entry(provider, digest, entry, &entry_size);
+    if (ret == 0) {
+        encode_be64(entry, decode_be64(entry) + 1);
+        ret = put_entry(provider, digest, entry, entry_size);
+    }
+    ABT_mutex_unlock(mutex);
+    if (ret != 0) return ret;
+
+    *value_size = entry_size - 8;
+    memcpy(value, entry + 8, *value_size);
+    return 0;
+}
+
+int mobject_dedup_insert(struct mobject_provider* provider,
+                         const uint8_t*           digest,
+                         const void*              value,
+                         size_t                   value_size)
+{
+    ABT_mutex mutex = dedup_mutex(provider, digest);
+    char      entry[MAX_DEDUP_VALUE_SIZE];
+    size_t    entry_size;
+    int       ret;
+
+    ABT_mutex_lock(mutex);
+    ret = get_entry(provider, digest, entry, &entry_size);
+    if (ret == 1) {
+        // not indexed yet (another write may have indexed the same data
+        // since this one looked it up)
+        encode_be64(entry, 1);
+        memcpy(entry + 8, value, value_size);
+        ret = put_entry(provider, digest, entry, 8 + value_size);
+    } else if (ret == 0) {
+        ret = 1;
+    }
+    ABT_mutex_unlock(mutex);
+    return ret;
+}
+
+int mobject_dedup_unref(struct mobject_provider* provider,
+                        const uint8_t*           digest)
+{
+    ABT_mutex   mutex = dedup_mutex(provider, digest);
+    char        entry[MAX_DEDUP_VALUE_SIZE];
+    size_t      entry_size;
+    uint64_t    count;
+    yk_return_t yret;
+    int         ret;
+
+    ABT_mutex_lock(mutex);
+    ret = get_entry(provider, digest, entry, &entry_size);
+    if (ret == 1) {
+        margo_error(provider->mid,
+                    "[mobject] %s:%d: region referenced by a segment is not "
+                    "indexed",
+                    __func__, __LINE__);
+        ret = -1;
+    } else if (ret == 0) {
+        count = decode_be64(entry);
+        if (count > 1) {
+            encode_be64(entry, count - 1);
+            ret = put_entry(provider, digest, entry, entry_size);
+        } else {
+            yret = yk_erase(provider->dedup_dbh, YOKAN_MODE_DEFAULT, digest,
+                            REGION_DIGEST_SIZE);
+            if (yret != YOKAN_SUCCESS) {
+                margo_error(provider->mid,
+                            "[mobject] %s:%d: yk_erase returned %d", __func__,
+                            __LINE__, yret);
+                ret = -1;
+            } else {
+                ret = 1;
+            }
+        }
+    }
+    ABT_mutex_unlock(mutex);
+    return ret;
+}
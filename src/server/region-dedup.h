@@ -0,0 +1,87 @@
+/*
+ * (C) 2018 The University of Chicago
+ *
+ * See COPYRIGHT in top-level directory.
+ */
+#ifndef __SERVER_REGION_DEDUP_H
+#define __SERVER_REGION_DEDUP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "src/server/mobject-provider.h"
+#include "src/server/core/key-encoding.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Providers configured with a "dedup_chunk_size" cut the data of the
+ * writes going through their memory (see write_buffered in
+ * core-write-op.cpp) into chunks, either of that fixed size or at
+ * boundaries that depend on their content (averaging about that size).
+ * Each chunk stored in a region of its own is indexed by its digest in
+ * the mobject_dedup_map database, whose values are a reference count,
+ * as a big-endian 64-bit integer, followed by the value of a segment
+ * pointing at the region (see key-encoding.h). A chunk whose digest is
+ * already indexed, and whose data is the same as that of the indexed
+ * region, only adds a segment pointing at that region and a reference.
+ *
+ * Segments pointing at an indexed region carry the digest in their
+ * value, so that removing the object releases a reference instead of
+ * removing the region, which is only removed with its last reference.
+ * Updates of an index entry are serialized by one of the
+ * provider->dedup_mutexes, chosen by the digest, so that only chunks
+ * whose digests share a mutex wait for each other's Yokan round trips.
+ */
+
+#define MOBJECT_DEDUP_FIXED   0
+#define MOBJECT_DEDUP_CONTENT 1
+
+/* largest value of mobject_dedup_map */
+#define MAX_DEDUP_VALUE_SIZE (8 + MAX_REGION_VALUE_SIZE)
+
+/* returns the MOBJECT_DEDUP_* chunking named name ("fixed" or
+ * "content"), or -1 if it is unknown */
+int mobject_dedup_chunking(const char* name);
+
+/* returns the size of the chunk starting at data, with at most size
+ * bytes, for chunks of chunk_size bytes starting pos bytes after a chunk
+ * boundary (only used by fixed chunking) */
+size_t mobject_dedup_next_chunk(int         chunking,
+                                size_t      chunk_size,
+                                size_t      pos,
+                                const char* data,
+                                size_t      size);
+
+/* computes the REGION_DIGEST_SIZE bytes digest of the size bytes of data */
+void mobject_dedup_digest(const void* data, size_t size, uint8_t* digest);
+
+/* takes a reference on the region indexed with digest and copies the
+ * value of its segments (without digest) into value, which must hold
+ * MAX_REGION_VALUE_SIZE bytes; returns 0 on success, 1 if digest is not
+ * indexed, -1 on error */
+int mobject_dedup_ref(struct mobject_provider* provider,
+                      const uint8_t*           digest,
+                      void*                    value,
+                      size_t*                  value_size);
+
+/* indexes the region of the size bytes of value with digest, with a
+ * single reference; returns 0 on success, 1 if digest is already
+ * indexed (the region is then left out of the index), -1 on error */
+int mobject_dedup_insert(struct mobject_provider* provider,
+                         const uint8_t*           digest,
+                         const void*              value,
+                         size_t                   value_size);
+
+/* releases a reference on the region indexed with digest; returns 1 if
+ * it was the last one (the region is then no longer indexed and should
+ * be removed), 0 if other references remain, -1 on error */
+int mobject_dedup_unref(struct mobject_provider* provider,
+                        const uint8_t*           digest);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -23,6 +23,12 @@ typedef struct {
     const char*              client_addr_str;
     hg_addr_t                client_addr;
     hg_bulk_t                bulk_handle;
+    int                      defer_persist; // see deferred-persist.h
+    uint64_t                 persist_seq;   // set if defer_persist
+    int                      overwrite;     // overwrite regions in place
+    int                      lock_mode;     // see object-locks.h
+    int                      locked;        // set while the object is locked
+    int                      ret;           // -1 if a write action failed
 } server_visitor_args;
 
 typedef server_visitor_args* server_visitor_args_t;
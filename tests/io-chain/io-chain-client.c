@@ -6,6 +6,7 @@
 #include "src/rpc-types/read-op.h"
 #include "src/io-chain/prepare-write-op.h"
 #include "src/io-chain/prepare-read-op.h"
+#include "src/io-chain/wire-format.h"
 
 /* Main function. */
 int main(int argc, char** argv)
@@ -62,6 +63,7 @@ int main(int argc, char** argv)
 
 		write_op_in_t in;
                 in.object_name = "test-object";
+		in.wire_format = MOBJECT_WIRE_FORMAT_COMPACT;
 		in.write_op = write_op;
 
 		prepare_write_op(mid, write_op);
@@ -115,6 +117,7 @@ int main(int argc, char** argv)
 
 		read_op_in_t in;
 		in.object_name = "test-object";
+		in.wire_format = MOBJECT_WIRE_FORMAT_COMPACT;
 		in.read_op = read_op;
 
 		prepare_read_op(mid, read_op);
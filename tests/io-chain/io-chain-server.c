@@ -129,8 +129,8 @@ DEFINE_MARGO_RPC_HANDLER(mobject_write_op_rpc)
 static void read_op_printer_begin(void*);
 static void read_op_printer_stat(void*, uint64_t*, time_t*, int*);
 static void read_op_printer_read(void*, uint64_t, size_t, buffer_u, size_t*, int*);
-static void read_op_printer_omap_get_keys(void*, const char*, uint64_t, mobject_store_omap_iter_t*, int*);
-static void read_op_printer_omap_get_vals(void*, const char*, const char*, uint64_t, mobject_store_omap_iter_t*, int*);
+static void read_op_printer_omap_get_keys(void*, const char*, uint64_t, size_t, mobject_store_omap_iter_t*, int*);
+static void read_op_printer_omap_get_vals(void*, const char*, const char*, uint64_t, size_t, mobject_store_omap_iter_t*, int*);
 static void read_op_printer_omap_get_vals_by_keys(void*, char const* const*, size_t, mobject_store_omap_iter_t*, int*);
 static void read_op_printer_end(void*);
 
@@ -288,7 +288,7 @@ void read_op_printer_read(void* u, uint64_t offset, size_t len, buffer_u buf, si
 }
 
 void read_op_printer_omap_get_keys(void* u, const char* start_after, uint64_t max_return, 
-				mobject_store_omap_iter_t* iter, int* prval)
+				size_t max_bytes, mobject_store_omap_iter_t* iter, int* prval)
 {
 	printf("\t<omap_get_keys start_after=\"%s\" max_return=%ld />\n", start_after, max_return);
 	omap_iter_create(iter);
@@ -296,7 +296,7 @@ void read_op_printer_omap_get_keys(void* u, const char* start_after, uint64_t ma
 	*prval = 1236;
 }
 
-void read_op_printer_omap_get_vals(void* u, const char* start_after, const char* filter_prefix, uint64_t max_return, mobject_store_omap_iter_t* iter, int* prval)
+void read_op_printer_omap_get_vals(void* u, const char* start_after, const char* filter_prefix, uint64_t max_return, size_t max_bytes, mobject_store_omap_iter_t* iter, int* prval)
 {
 	printf("\t<omap_get_vals start_after=\"%s\" filter_prefix=\"%s\" max_return=%ld />\n",
 		start_after, filter_prefix, max_return);
@@ -1,10 +1,25 @@
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <margo.h>
 #include <libmobject-store.h>
 
 const char* content = "AAAABBBBCCCCDDDDEEEEFFFF";
 
+/* NUM_OVERWRITES regions of OVERWRITE_SIZE bytes do not fit in the bake
+ * pool created by mobject-test-util.sh (50 MiB) */
+#define OVERWRITE_SIZE (8 * 1024 * 1024)
+#define NUM_OVERWRITES 16
+
+static void count_callback(mobject_store_completion_t c, void* arg)
+{
+    int* count = (int*)arg;
+    *count += 1;
+    // completions may be released from their own callback
+    mobject_store_aio_release(c);
+}
+
 /* Main function. */
 int main(int argc, char** argv)
 {
@@ -144,6 +159,250 @@ int main(int argc, char** argv)
         }
     }
 
+    { // COMPLETION QUEUE TEST
+
+#define NUM_AIO_OPS 16
+        mobject_store_completion_queue_t cq = MOBJECT_COMPLETION_QUEUE_NULL;
+        mobject_store_aio_create_completion_queue(&cq);
+
+        mobject_store_write_op_t   write_ops[NUM_AIO_OPS];
+        mobject_store_completion_t completions[NUM_AIO_OPS];
+        char names[NUM_AIO_OPS][32];
+        int i;
+        for(i = 0; i < NUM_AIO_OPS; i++) {
+            sprintf(names[i], "cq-object-%d", i);
+            write_ops[i] = mobject_store_create_write_op();
+            mobject_store_write_op_write_full(write_ops[i], content, 8);
+            mobject_store_aio_create_completion(NULL,NULL,NULL, &completions[i]);
+            mobject_store_aio_completion_queue_add(cq, completions[i]);
+            mobject_store_aio_write_op_operate(write_ops[i], ioctx, completions[i], names[i], NULL, LIBMOBJECT_OPERATION_NOFLAG);
+        }
+
+        // reap one operation, then the next NUM_AIO_OPS/2, then the rest
+        mobject_store_completion_t done[NUM_AIO_OPS];
+        size_t count = 0, total = 0;
+        int ret = mobject_store_aio_wait_any(cq, &done[0]);
+        assert(ret == 0);
+        total += 1;
+        ret = mobject_store_aio_wait_n(cq, NUM_AIO_OPS/2, done + total, &count);
+        assert(ret == 0 && count == NUM_AIO_OPS/2);
+        total += count;
+        while(total < NUM_AIO_OPS) {
+            ret = mobject_store_aio_reap(cq, NUM_AIO_OPS, done + total, &count);
+            assert(ret == 0);
+            total += count;
+            if(count == 0) {
+                ret = mobject_store_aio_wait_any(cq, done + total);
+                assert(ret == 0);
+                total += 1;
+            }
+        }
+        // the queue is now empty
+        assert(mobject_store_aio_wait_any(cq, &done[0]) == -1);
+
+        for(i = 0; i < NUM_AIO_OPS; i++) {
+            assert(mobject_store_aio_is_complete(completions[i]));
+            assert(mobject_store_aio_get_return_value(completions[i]) == 0);
+            mobject_store_release_write_op(write_ops[i]);
+            mobject_store_aio_release(completions[i]);
+        }
+        mobject_store_aio_release_completion_queue(cq);
+    }
+
+    { // CALLBACK TEST
+
+        // callbacks must fire without waiting on the completions
+        int num_callbacks = 0;
+        mobject_store_write_op_t write_ops[NUM_AIO_OPS];
+        int i;
+        for(i = 0; i < NUM_AIO_OPS; i++) {
+            mobject_store_completion_t completion = MOBJECT_COMPLETION_NULL;
+            mobject_store_aio_create_completion(&num_callbacks, count_callback, NULL, &completion);
+            write_ops[i] = mobject_store_create_write_op();
+            mobject_store_write_op_append(write_ops[i], content, 4);
+            mobject_store_aio_write_op_operate(write_ops[i], ioctx, completion, "cb-object", NULL, LIBMOBJECT_OPERATION_NOFLAG);
+        }
+        while(num_callbacks != NUM_AIO_OPS)
+            ABT_thread_yield();
+        for(i = 0; i < NUM_AIO_OPS; i++)
+            mobject_store_release_write_op(write_ops[i]);
+
+        // the concurrent appends must not overwrite each other
+        uint64_t psize = 0;
+        time_t pmtime;
+        int prval = -1;
+        mobject_store_read_op_t read_op = mobject_store_create_read_op();
+        mobject_store_read_op_stat(read_op, &psize, &pmtime, &prval);
+        mobject_store_read_op_operate(read_op, ioctx, "cb-object", LIBMOBJECT_OPERATION_ORDER_READS_WRITES);
+        assert(prval == 0 && psize == NUM_AIO_OPS * 4);
+        mobject_store_release_read_op(read_op);
+    }
+
+    { // CONCURRENT APPEND TEST
+
+        // each append gets its own offset, where its data is written
+        mobject_store_write_op_t   write_ops[NUM_AIO_OPS];
+        mobject_store_completion_t completions[NUM_AIO_OPS];
+        char     data[NUM_AIO_OPS][4];
+        uint64_t offsets[NUM_AIO_OPS];
+        int      rvals[NUM_AIO_OPS];
+        int i, j;
+        for(i = 0; i < NUM_AIO_OPS; i++) {
+            memset(data[i], 'a' + i, 4);
+            write_ops[i] = mobject_store_create_write_op();
+            mobject_store_write_op_append2(write_ops[i], data[i], 4, &offsets[i], &rvals[i]);
+            mobject_store_aio_create_completion(NULL, NULL, NULL, &completions[i]);
+            mobject_store_aio_write_op_operate(write_ops[i], ioctx, completions[i], "log-object", NULL, LIBMOBJECT_OPERATION_NOFLAG);
+        }
+        for(i = 0; i < NUM_AIO_OPS; i++) {
+            mobject_store_aio_wait_for_complete(completions[i]);
+            assert(rvals[i] == 0);
+            assert(offsets[i] % 4 == 0 && offsets[i] < NUM_AIO_OPS * 4);
+            for(j = 0; j < i; j++) assert(offsets[i] != offsets[j]);
+            mobject_store_aio_release(completions[i]);
+            mobject_store_release_write_op(write_ops[i]);
+        }
+
+        char out[NUM_AIO_OPS * 4];
+        size_t bytes_read;
+        int prval;
+        mobject_store_read_op_t read_op = mobject_store_create_read_op();
+        mobject_store_read_op_read(read_op, 0, sizeof(out), out, &bytes_read, &prval);
+        mobject_store_read_op_operate(read_op, ioctx, "log-object", LIBMOBJECT_OPERATION_NOFLAG);
+        assert(bytes_read == sizeof(out));
+        for(i = 0; i < NUM_AIO_OPS; i++)
+            assert(memcmp(out + offsets[i], data[i], 4) == 0);
+        mobject_store_release_read_op(read_op);
+    }
+
+    { // EARLY ACK TEST
+
+        // large enough to be stored in a bake region
+        char data[4096], out[4096];
+        memset(data, 'G', sizeof(data));
+        mobject_store_write_op_t write_op = mobject_store_create_write_op();
+        mobject_store_write_op_write_full(write_op, data, sizeof(data));
+        mobject_store_completion_t completion = MOBJECT_COMPLETION_NULL;
+        mobject_store_aio_create_completion(NULL, NULL, NULL, &completion);
+        mobject_store_aio_write_op_operate(write_op, ioctx, completion, "early-ack-object", NULL, LIBMOBJECT_OPERATION_EARLY_ACK);
+        mobject_store_aio_wait_for_complete(completion);
+        assert(mobject_store_aio_is_complete(completion));
+        mobject_store_aio_wait_for_safe(completion);
+        assert(mobject_store_aio_is_safe(completion));
+        assert(mobject_store_aio_get_return_value(completion) == 0);
+        mobject_store_aio_release(completion);
+        mobject_store_release_write_op(write_op);
+
+        size_t bytes_read;
+        int prval;
+        mobject_store_read_op_t read_op = mobject_store_create_read_op();
+        mobject_store_read_op_read(read_op, 0, sizeof(out), out, &bytes_read, &prval);
+        mobject_store_read_op_operate(read_op, ioctx, "early-ack-object", LIBMOBJECT_OPERATION_NOFLAG);
+        assert(bytes_read == sizeof(out));
+        assert(memcmp(data, out, sizeof(out)) == 0);
+        mobject_store_release_read_op(read_op);
+    }
+
+    { // OVERWRITE IN PLACE TEST
+
+        // the second write_full overwrites the region of the first one, the
+        // partial write cannot and creates a new region
+        char data[4096], out[4096], expected[4096];
+        int i;
+        for(i = 0; i < 3; i++) {
+            memset(data, 'H' + i, sizeof(data));
+            mobject_store_write_op_t write_op = mobject_store_create_write_op();
+            if(i < 2)
+                mobject_store_write_op_write_full(write_op, data, sizeof(data));
+            else
+                mobject_store_write_op_write(write_op, data, 1024, 1024);
+            int ret = mobject_store_write_op_operate(write_op, ioctx, "restart-object", NULL,
+                                                     LIBMOBJECT_OPERATION_OVERWRITE_IN_PLACE);
+            assert(ret == 0);
+            mobject_store_release_write_op(write_op);
+        }
+        memset(expected, 'I', sizeof(expected));
+        memset(expected + 1024, 'J', 1024);
+
+        uint64_t psize;
+        time_t pmtime;
+        size_t bytes_read;
+        int prval1, prval2;
+        mobject_store_read_op_t read_op = mobject_store_create_read_op();
+        mobject_store_read_op_stat(read_op, &psize, &pmtime, &prval1);
+        mobject_store_read_op_read(read_op, 0, sizeof(out), out, &bytes_read, &prval2);
+        mobject_store_read_op_operate(read_op, ioctx, "restart-object", LIBMOBJECT_OPERATION_NOFLAG);
+        assert(psize == sizeof(out));
+        assert(bytes_read == sizeof(out));
+        assert(memcmp(expected, out, sizeof(out)) == 0);
+        mobject_store_release_read_op(read_op);
+    }
+
+    { // OVERWRITE IN PLACE TEST, REPEATED
+
+        // the data only fits in the bake pool if every write after the
+        // first one overwrites its region in place; otherwise bake runs out
+        // of space and the object keeps the data of an earlier write
+        char* data = malloc(OVERWRITE_SIZE);
+        char* out  = malloc(OVERWRITE_SIZE);
+        assert(data && out);
+        int i;
+        for(i = 0; i < NUM_OVERWRITES; i++) {
+            memset(data, 'a' + i, OVERWRITE_SIZE);
+            mobject_store_write_op_t write_op = mobject_store_create_write_op();
+            mobject_store_write_op_write(write_op, data, OVERWRITE_SIZE, 0);
+            int ret = mobject_store_write_op_operate(write_op, ioctx, "overwritten-object", NULL,
+                                                     LIBMOBJECT_OPERATION_OVERWRITE_IN_PLACE);
+            assert(ret == 0);
+            mobject_store_release_write_op(write_op);
+        }
+
+        size_t bytes_read;
+        int prval;
+        mobject_store_read_op_t read_op = mobject_store_create_read_op();
+        mobject_store_read_op_read(read_op, 0, OVERWRITE_SIZE, out, &bytes_read, &prval);
+        mobject_store_read_op_operate(read_op, ioctx, "overwritten-object", LIBMOBJECT_OPERATION_NOFLAG);
+        assert(prval == 0 && bytes_read == OVERWRITE_SIZE);
+        assert(memcmp(data, out, OVERWRITE_SIZE) == 0);
+        mobject_store_release_read_op(read_op);
+        free(data);
+        free(out);
+    }
+
+    { // OVERWRITE AFTER WRITESAME TEST
+
+        // the repetitions of a writesame share a region, so overwriting
+        // the first one must not be done in place, even though the segments
+        // of the other repetitions are more recent and do not overlap it
+        char data[4096], out[4 * 4096], expected[4 * 4096];
+        memset(data, 'K', sizeof(data));
+        mobject_store_write_op_t write_op = mobject_store_create_write_op();
+        mobject_store_write_op_writesame(write_op, data, sizeof(data), sizeof(out), 0);
+        int ret = mobject_store_write_op_operate(write_op, ioctx, "writesame-object", NULL,
+                                                 LIBMOBJECT_OPERATION_NOFLAG);
+        assert(ret == 0);
+        mobject_store_release_write_op(write_op);
+
+        memset(data, 'L', sizeof(data));
+        write_op = mobject_store_create_write_op();
+        mobject_store_write_op_write(write_op, data, sizeof(data), 0);
+        ret = mobject_store_write_op_operate(write_op, ioctx, "writesame-object", NULL,
+                                             LIBMOBJECT_OPERATION_OVERWRITE_IN_PLACE);
+        assert(ret == 0);
+        mobject_store_release_write_op(write_op);
+        memset(expected, 'K', sizeof(expected));
+        memset(expected, 'L', sizeof(data));
+
+        size_t bytes_read;
+        int prval;
+        mobject_store_read_op_t read_op = mobject_store_create_read_op();
+        mobject_store_read_op_read(read_op, 0, sizeof(out), out, &bytes_read, &prval);
+        mobject_store_read_op_operate(read_op, ioctx, "writesame-object", LIBMOBJECT_OPERATION_NOFLAG);
+        assert(prval == 0 && bytes_read == sizeof(out));
+        assert(memcmp(expected, out, sizeof(out)) == 0);
+        mobject_store_release_read_op(read_op);
+    }
+
     mobject_store_ioctx_destroy(ioctx);
 
     mobject_store_shutdown(cluster);
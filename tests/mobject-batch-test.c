@@ -0,0 +1,161 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <margo.h>
+#include <libmobject-store.h>
+
+#define NUM_OBJECTS 64
+#define OBJECT_SIZE 16
+
+/* Main function. */
+int main(int argc, char** argv)
+{
+    int ret;
+    mobject_store_t cluster;
+    mobject_store_create(&cluster, "admin");
+    mobject_store_connect(cluster);
+    mobject_store_ioctx_t ioctx;
+    mobject_store_ioctx_create(cluster, "my-object-pool", &ioctx);
+
+    char        names[NUM_OBJECTS][32];
+    const char* oids[NUM_OBJECTS];
+    char        data[NUM_OBJECTS][OBJECT_SIZE];
+    int         rets[NUM_OBJECTS];
+    int         i;
+
+    for(i = 0; i < NUM_OBJECTS; i++) {
+        sprintf(names[i], "batch-object-%d", i);
+        oids[i] = names[i];
+        memset(data[i], 'A' + (i % 26), OBJECT_SIZE);
+    }
+
+    fprintf(stderr, "********** WRITE PHASE **********\n");
+    {
+        mobject_store_write_op_t write_ops[NUM_OBJECTS];
+        for(i = 0; i < NUM_OBJECTS; i++) {
+            write_ops[i] = mobject_store_create_write_op();
+            mobject_store_write_op_write_full(write_ops[i], data[i], OBJECT_SIZE);
+            rets[i] = -1;
+        }
+        ret = mobject_store_write_op_operate_batch(write_ops, ioctx, oids, NUM_OBJECTS,
+                                                   LIBMOBJECT_OPERATION_NOFLAG, rets);
+        assert(ret == 0);
+        for(i = 0; i < NUM_OBJECTS; i++) {
+            assert(rets[i] == 0);
+            mobject_store_release_write_op(write_ops[i]);
+        }
+    }
+
+    fprintf(stderr, "********** READ PHASE **********\n");
+    {
+        mobject_store_read_op_t read_ops[NUM_OBJECTS];
+        char     read_buf[NUM_OBJECTS][OBJECT_SIZE];
+        size_t   bytes_read[NUM_OBJECTS];
+        int      prval[NUM_OBJECTS];
+        uint64_t psize[NUM_OBJECTS];
+        time_t   pmtime[NUM_OBJECTS];
+        int      stat_prval[NUM_OBJECTS];
+        for(i = 0; i < NUM_OBJECTS; i++) {
+            read_ops[i] = mobject_store_create_read_op();
+            mobject_store_read_op_stat(read_ops[i], &psize[i], &pmtime[i], &stat_prval[i]);
+            mobject_store_read_op_read(read_ops[i], 0, OBJECT_SIZE, read_buf[i], &bytes_read[i], &prval[i]);
+        }
+        ret = mobject_store_read_op_operate_batch(read_ops, ioctx, oids, NUM_OBJECTS,
+                                                  LIBMOBJECT_OPERATION_NOFLAG);
+        assert(ret == 0);
+        for(i = 0; i < NUM_OBJECTS; i++) {
+            assert(psize[i] == OBJECT_SIZE);
+            assert(bytes_read[i] == OBJECT_SIZE);
+            assert(memcmp(read_buf[i], data[i], OBJECT_SIZE) == 0);
+            mobject_store_release_read_op(read_ops[i]);
+        }
+    }
+
+    fprintf(stderr, "********** REUSE PHASE **********\n");
+    {
+        /* operations sent as part of a batch can be sent again, on their
+         * own or in another batch */
+        char   buf[OBJECT_SIZE];
+        char   read_buf[OBJECT_SIZE];
+        size_t bytes_read;
+        int    prval;
+        memset(buf, 'z', OBJECT_SIZE);
+        mobject_store_write_op_t write_op = mobject_store_create_write_op();
+        mobject_store_write_op_write_full(write_op, buf, OBJECT_SIZE);
+        mobject_store_write_op_t write_ops[2] = { write_op, write_op };
+        ret = mobject_store_write_op_operate_batch(write_ops, ioctx, oids, 1,
+                                                   LIBMOBJECT_OPERATION_NOFLAG, rets);
+        assert(ret == 0 && rets[0] == 0);
+        ret = mobject_store_write_op_operate(write_op, ioctx, oids[1], NULL,
+                                             LIBMOBJECT_OPERATION_NOFLAG);
+        assert(ret == 0);
+        ret = mobject_store_write_op_operate_batch(write_ops, ioctx, oids + 2, 2,
+                                                   LIBMOBJECT_OPERATION_NOFLAG, rets);
+        assert(ret == 0 && rets[0] == 0 && rets[1] == 0);
+        mobject_store_release_write_op(write_op);
+        for(i = 0; i < 4; i++) memcpy(data[i], buf, OBJECT_SIZE);
+
+        mobject_store_read_op_t read_op = mobject_store_create_read_op();
+        mobject_store_read_op_read(read_op, 0, OBJECT_SIZE, read_buf, &bytes_read, &prval);
+        for(i = 0; i < 4; i++) {
+            memset(read_buf, 0, OBJECT_SIZE);
+            if(i % 2 == 0)
+                ret = mobject_store_read_op_operate_batch(&read_op, ioctx, oids + i, 1,
+                                                          LIBMOBJECT_OPERATION_NOFLAG);
+            else
+                ret = mobject_store_read_op_operate(read_op, ioctx, oids[i],
+                                                    LIBMOBJECT_OPERATION_NOFLAG);
+            assert(ret == 0 && prval == 0);
+            assert(bytes_read == OBJECT_SIZE);
+            assert(memcmp(read_buf, data[i], OBJECT_SIZE) == 0);
+        }
+        mobject_store_release_read_op(read_op);
+    }
+
+    fprintf(stderr, "********** PREPARED PHASE **********\n");
+    {
+        /* the same write_op and read_op are performed on every object,
+         * each time on a different part of it */
+        char   buf[OBJECT_SIZE];
+        char   read_buf[OBJECT_SIZE];
+        size_t bytes_read;
+        int    prval;
+        mobject_store_write_op_t write_op = mobject_store_create_write_op();
+        mobject_store_write_op_write(write_op, buf, OBJECT_SIZE, 0);
+        ret = mobject_store_write_op_prepare(write_op, ioctx);
+        assert(ret == 0);
+        mobject_store_read_op_t read_op = mobject_store_create_read_op();
+        mobject_store_read_op_read(read_op, 0, OBJECT_SIZE, read_buf, &bytes_read, &prval);
+        ret = mobject_store_read_op_prepare(read_op, ioctx);
+        assert(ret == 0);
+        /* the data must fit in the registered buffer */
+        assert(mobject_store_write_op_rebind(write_op, 0, 0, OBJECT_SIZE + 1) != 0);
+        for(i = 0; i < NUM_OBJECTS; i++) {
+            size_t len = 1 + i % OBJECT_SIZE;
+            memset(buf, 'a' + (i % 26), len);
+            ret = mobject_store_write_op_rebind(write_op, 0, OBJECT_SIZE - len, len);
+            assert(ret == 0);
+            ret = mobject_store_write_op_operate(write_op, ioctx, oids[i], NULL,
+                                                 LIBMOBJECT_OPERATION_NOFLAG);
+            assert(ret == 0);
+            memcpy(data[i] + OBJECT_SIZE - len, buf, len);
+        }
+        for(i = 0; i < NUM_OBJECTS; i++) {
+            ret = mobject_store_read_op_rebind(read_op, 0, 0, OBJECT_SIZE);
+            assert(ret == 0);
+            ret = mobject_store_read_op_operate(read_op, ioctx, oids[i],
+                                                LIBMOBJECT_OPERATION_NOFLAG);
+            assert(ret == 0);
+            assert(bytes_read == OBJECT_SIZE);
+            assert(memcmp(read_buf, data[i], OBJECT_SIZE) == 0);
+        }
+        mobject_store_release_read_op(read_op);
+        mobject_store_release_write_op(write_op);
+    }
+
+    mobject_store_ioctx_destroy(ioctx);
+
+    mobject_store_shutdown(cluster);
+
+    return 0;
+}
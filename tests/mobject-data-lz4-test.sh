@@ -0,0 +1,9 @@
+#!/bin/bash -x
+
+if [ -z $srcdir ]; then
+    echo srcdir variable not set.
+    exit 1
+fi
+
+# same as mobject-data-test.sh, with regions compressed with lz4
+MOBJECT_TEST_COMPRESSION=lz4 exec $srcdir/tests/mobject-data-test.sh
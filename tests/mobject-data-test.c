@@ -0,0 +1,119 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <margo.h>
+#include <libmobject-store.h>
+
+/* size of the buffers in which the server splits large writes */
+#define WRITE_BUFFER_SIZE (4 * 1024 * 1024)
+
+#define ZERO_DATA_SIZE (WRITE_BUFFER_SIZE + 512 * 1024)
+
+#define COMPRESSIBLE_DATA_SIZE (1024 * 1024)
+
+static void write_data(mobject_store_ioctx_t ioctx,
+                       const char*           oid,
+                       const char*           data,
+                       size_t                size,
+                       uint64_t              offset)
+{
+    mobject_store_write_op_t write_op = mobject_store_create_write_op();
+    mobject_store_write_op_write(write_op, data, size, offset);
+    int ret = mobject_store_write_op_operate(write_op, ioctx, oid, NULL,
+                                             LIBMOBJECT_OPERATION_NOFLAG);
+    assert(ret == 0);
+    mobject_store_release_write_op(write_op);
+}
+
+/* reads size bytes at offset and compares them with expected */
+static void check_data(mobject_store_ioctx_t ioctx,
+                       const char*           oid,
+                       const char*           expected,
+                       size_t                size,
+                       uint64_t              offset)
+{
+    char*  out        = malloc(size);
+    size_t bytes_read = 0;
+    int    prval      = -1;
+    assert(out);
+    mobject_store_read_op_t read_op = mobject_store_create_read_op();
+    mobject_store_read_op_read(read_op, offset, size, out, &bytes_read, &prval);
+    int ret = mobject_store_read_op_operate(read_op, ioctx, oid,
+                                            LIBMOBJECT_OPERATION_NOFLAG);
+    assert(ret == 0 && prval == 0);
+    assert(bytes_read == size);
+    assert(memcmp(out, expected, size) == 0);
+    mobject_store_release_read_op(read_op);
+    free(out);
+}
+
+/* Main function. */
+int main(int argc, char** argv)
+{
+    mobject_store_t cluster;
+    mobject_store_create(&cluster, "admin");
+    mobject_store_connect(cluster);
+    mobject_store_ioctx_t ioctx;
+    mobject_store_ioctx_create(cluster, "my-object-pool", &ioctx);
+
+    fprintf(stderr, "********** ZERO BLOCKS **********\n");
+    {
+        /* data mixed with zeros, including a zero range across the end of
+         * the first buffer of the server and ranges that are not aligned
+         * on blocks, written over older data that the zeros must hide */
+        char*  data = malloc(ZERO_DATA_SIZE);
+        size_t i;
+        assert(data);
+        memset(data, 'x', ZERO_DATA_SIZE);
+        write_data(ioctx, "zero-object", data, ZERO_DATA_SIZE, 0);
+
+        for (i = 0; i < ZERO_DATA_SIZE; i++) data[i] = 1 + i % 251;
+        memset(data, 0, 64 * 1024);
+        memset(data + 1024 * 1024, 0, 4096);
+        memset(data + 2 * 1024 * 1024 + 100, 0, 10000);
+        memset(data + WRITE_BUFFER_SIZE - 96 * 1024, 0, 192 * 1024);
+        memset(data + ZERO_DATA_SIZE - 8192, 0, 8192);
+        write_data(ioctx, "zero-object", data, ZERO_DATA_SIZE, 0);
+
+        check_data(ioctx, "zero-object", data, ZERO_DATA_SIZE, 0);
+        check_data(ioctx, "zero-object", data + 1024 * 1024 - 10, 4116,
+                   1024 * 1024 - 10);
+        check_data(ioctx, "zero-object", data + WRITE_BUFFER_SIZE - 100 * 1024,
+                   200 * 1024, WRITE_BUFFER_SIZE - 100 * 1024);
+        check_data(ioctx, "zero-object", data + ZERO_DATA_SIZE - 10000, 10000,
+                   ZERO_DATA_SIZE - 10000);
+        free(data);
+    }
+
+    fprintf(stderr, "********** COMPRESSIBLE DATA **********\n");
+    {
+        /* regions are compressed as a whole, reads of parts of them must
+         * return the right bytes */
+        const char* text = "the quick brown fox jumps over the lazy dog ";
+        char*       data = malloc(COMPRESSIBLE_DATA_SIZE);
+        size_t      i;
+        assert(data);
+        for (i = 0; i < COMPRESSIBLE_DATA_SIZE; i++)
+            data[i] = text[i % strlen(text)];
+        for (i = 0; i < COMPRESSIBLE_DATA_SIZE; i += 65536) data[i] = '#';
+        write_data(ioctx, "compressed-object", data, COMPRESSIBLE_DATA_SIZE,
+                   4096);
+
+        check_data(ioctx, "compressed-object", data, COMPRESSIBLE_DATA_SIZE,
+                   4096);
+        check_data(ioctx, "compressed-object", data + 1000, 5000, 4096 + 1000);
+        check_data(ioctx, "compressed-object", data + 512 * 1024 - 100, 200,
+                   4096 + 512 * 1024 - 100);
+        check_data(ioctx, "compressed-object",
+                   data + COMPRESSIBLE_DATA_SIZE - 1, 1,
+                   4096 + COMPRESSIBLE_DATA_SIZE - 1);
+        free(data);
+    }
+
+    mobject_store_ioctx_destroy(ioctx);
+
+    mobject_store_shutdown(cluster);
+
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <margo.h>
+#include <libmobject-store.h>
+
+/* chunk size of the server, see mobject-dedup-test.sh */
+#define CHUNK_SIZE (64 * 1024)
+
+#define DATA_SIZE (4 * CHUNK_SIZE)
+
+static void write_full(mobject_store_ioctx_t ioctx,
+                       const char*           oid,
+                       const char*           data,
+                       size_t                size)
+{
+    mobject_store_write_op_t write_op = mobject_store_create_write_op();
+    mobject_store_write_op_write_full(write_op, data, size);
+    int ret = mobject_store_write_op_operate(write_op, ioctx, oid, NULL,
+                                             LIBMOBJECT_OPERATION_NOFLAG);
+    assert(ret == 0);
+    mobject_store_release_write_op(write_op);
+}
+
+static void remove_object(mobject_store_ioctx_t ioctx, const char* oid)
+{
+    mobject_store_write_op_t write_op = mobject_store_create_write_op();
+    mobject_store_write_op_remove(write_op);
+    int ret = mobject_store_write_op_operate(write_op, ioctx, oid, NULL,
+                                             LIBMOBJECT_OPERATION_NOFLAG);
+    assert(ret == 0);
+    mobject_store_release_write_op(write_op);
+}
+
+static void check_data(mobject_store_ioctx_t ioctx,
+                       const char*           oid,
+                       const char*           expected,
+                       size_t                size)
+{
+    char*  out        = malloc(size);
+    size_t bytes_read = 0;
+    int    prval      = -1;
+    assert(out);
+    mobject_store_read_op_t read_op = mobject_store_create_read_op();
+    mobject_store_read_op_read(read_op, 0, size, out, &bytes_read, &prval);
+    int ret = mobject_store_read_op_operate(read_op, ioctx, oid,
+                                            LIBMOBJECT_OPERATION_NOFLAG);
+    assert(ret == 0 && prval == 0);
+    assert(bytes_read == size);
+    assert(memcmp(out, expected, size) == 0);
+    mobject_store_release_read_op(read_op);
+    free(out);
+}
+
+/* Main function. */
+int main(int argc, char** argv)
+{
+    mobject_store_t cluster;
+    mobject_store_create(&cluster, "admin");
+    mobject_store_connect(cluster);
+    mobject_store_ioctx_t ioctx;
+    mobject_store_ioctx_create(cluster, "my-object-pool", &ioctx);
+
+    char*  data = malloc(DATA_SIZE);
+    size_t i;
+    assert(data);
+    for (i = 0; i < DATA_SIZE; i++) data[i] = 'a' + (i / CHUNK_SIZE) % 3;
+
+    fprintf(stderr, "********** SHARED CHUNKS **********\n");
+    {
+        // the chunks of the second object are those of the first one, and
+        // the first and last chunks of each object are identical
+        write_full(ioctx, "dedup-object-1", data, DATA_SIZE);
+        write_full(ioctx, "dedup-object-2", data, DATA_SIZE);
+        check_data(ioctx, "dedup-object-1", data, DATA_SIZE);
+        check_data(ioctx, "dedup-object-2", data, DATA_SIZE);
+    }
+
+    fprintf(stderr, "********** REMOVE ONE REFERENCE **********\n");
+    {
+        // the chunks are still referenced by the second object
+        remove_object(ioctx, "dedup-object-1");
+        check_data(ioctx, "dedup-object-2", data, DATA_SIZE);
+    }
+
+    fprintf(stderr, "********** REMOVE THE LAST REFERENCE **********\n");
+    {
+        // the chunks are written again once their regions are removed
+        remove_object(ioctx, "dedup-object-2");
+        write_full(ioctx, "dedup-object-3", data, DATA_SIZE);
+        check_data(ioctx, "dedup-object-3", data, DATA_SIZE);
+    }
+
+    free(data);
+
+    mobject_store_ioctx_destroy(ioctx);
+
+    mobject_store_shutdown(cluster);
+
+    return 0;
+}
@@ -0,0 +1,293 @@
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <margo.h>
+#include <libmobject-store.h>
+
+#define NUM_KEYS   2000
+#define VALUE_SIZE 200
+
+static void make_value(char* value, int i)
+{
+    memset(value, 'a' + (i % 26), VALUE_SIZE);
+}
+
+/* Counts the omap keys of the object, checking that they are in order. */
+static int count_keys(mobject_store_ioctx_t ioctx, const char* first)
+{
+    mobject_store_read_op_t read_op = mobject_store_create_read_op();
+    mobject_store_omap_iter_t iter = NULL;
+    int prval = -1;
+    mobject_store_read_op_omap_get_keys(read_op, "", UINT64_MAX, &iter, &prval);
+    int ret = mobject_store_read_op_operate(read_op, ioctx, "omap-object",
+                                            LIBMOBJECT_OPERATION_NOFLAG);
+    assert(ret == 0);
+    assert(prval == 0);
+
+    char*  key   = NULL;
+    char*  val   = NULL;
+    size_t size  = 0;
+    int    count = 0;
+    char   prev[16] = "";
+    while(mobject_store_omap_get_next(iter, &key, &val, &size) == 0) {
+        if(count == 0 && first) assert(strcmp(key, first) == 0);
+        assert(strcmp(prev, key) < 0);
+        strcpy(prev, key);
+        count += 1;
+    }
+    mobject_store_omap_get_end(iter);
+    mobject_store_release_read_op(read_op);
+    return count;
+}
+
+static void operate(mobject_store_ioctx_t ioctx, mobject_store_write_op_t write_op)
+{
+    int ret = mobject_store_write_op_operate(write_op, ioctx, "omap-object", NULL,
+                                             LIBMOBJECT_OPERATION_NOFLAG);
+    assert(ret == 0);
+    mobject_store_release_write_op(write_op);
+}
+
+/* Main function. */
+int main(int argc, char** argv)
+{
+    int ret;
+    mobject_store_t cluster;
+    mobject_store_create(&cluster, "admin");
+    mobject_store_connect(cluster);
+    mobject_store_ioctx_t ioctx;
+    mobject_store_ioctx_create(cluster, "my-object-pool", &ioctx);
+
+    static char names[NUM_KEYS][16];
+    static char values[NUM_KEYS][VALUE_SIZE];
+    const char* keys[NUM_KEYS];
+    const char* vals[NUM_KEYS];
+    size_t      val_sizes[NUM_KEYS];
+    int         i;
+
+    for(i = 0; i < NUM_KEYS; i++) {
+        sprintf(names[i], "key-%05d", i);
+        make_value(values[i], i);
+        keys[i]      = names[i];
+        vals[i]      = values[i];
+        val_sizes[i] = VALUE_SIZE;
+    }
+
+    fprintf(stderr, "********** WRITE PHASE **********\n");
+    {
+        mobject_store_write_op_t write_op = mobject_store_create_write_op();
+        mobject_store_write_op_create(write_op, LIBMOBJECT_CREATE_EXCLUSIVE, NULL);
+        mobject_store_write_op_omap_set(write_op, keys, vals, val_sizes, NUM_KEYS);
+        ret = mobject_store_write_op_operate(write_op, ioctx, "omap-object", NULL,
+                                             LIBMOBJECT_OPERATION_NOFLAG);
+        assert(ret == 0);
+        mobject_store_release_write_op(write_op);
+    }
+
+    fprintf(stderr, "********** PAGED LISTING **********\n");
+    {
+        // the values do not fit in a single bulk region, so they are
+        // returned in several pages
+        char          start_after[16] = "";
+        unsigned char more            = 1;
+        int           count           = 0;
+        int           pages           = 0;
+        while(more) {
+            mobject_store_read_op_t read_op = mobject_store_create_read_op();
+            mobject_store_omap_iter_t iter = NULL;
+            int prval = -1;
+            mobject_store_read_op_omap_get_vals2(read_op, start_after, "", UINT64_MAX,
+                                                 &iter, &more, &prval);
+            ret = mobject_store_read_op_operate(read_op, ioctx, "omap-object",
+                                                LIBMOBJECT_OPERATION_NOFLAG);
+            assert(ret == 0);
+            assert(prval == 0);
+
+            char*  key  = NULL;
+            char*  val  = NULL;
+            size_t size = 0;
+            char   expected[VALUE_SIZE];
+            while(mobject_store_omap_get_next(iter, &key, &val, &size) == 0) {
+                assert(count < NUM_KEYS);
+                assert(strcmp(key, names[count]) == 0);
+                make_value(expected, count);
+                assert(size == VALUE_SIZE && memcmp(val, expected, size) == 0);
+                strcpy(start_after, key);
+                count += 1;
+            }
+            mobject_store_omap_get_end(iter);
+            mobject_store_release_read_op(read_op);
+            pages += 1;
+        }
+        fprintf(stderr, "%d entries listed in %d pages\n", count, pages);
+        assert(count == NUM_KEYS);
+        assert(pages > 1);
+    }
+
+    fprintf(stderr, "********** UNPAGED LISTING **********\n");
+    {
+        // without pmore, all the keys are returned at once
+        mobject_store_read_op_t read_op = mobject_store_create_read_op();
+        mobject_store_omap_iter_t iter = NULL;
+        int prval = -1;
+        mobject_store_read_op_omap_get_vals(read_op, "", "", UINT64_MAX, &iter, &prval);
+        ret = mobject_store_read_op_operate(read_op, ioctx, "omap-object",
+                                            LIBMOBJECT_OPERATION_NOFLAG);
+        assert(ret == 0);
+        assert(prval == 0);
+
+        char*  key  = NULL;
+        char*  val  = NULL;
+        size_t size = 0;
+        int    count = 0;
+        while(mobject_store_omap_get_next(iter, &key, &val, &size) == 0) {
+            assert(strcmp(key, names[count]) == 0);
+            count += 1;
+        }
+        assert(count == NUM_KEYS);
+        mobject_store_omap_get_end(iter);
+        mobject_store_release_read_op(read_op);
+    }
+
+    fprintf(stderr, "********** RANGE REMOVAL **********\n");
+    {
+        mobject_store_write_op_t write_op = mobject_store_create_write_op();
+        mobject_store_write_op_omap_rm_range(write_op, "key-00000", "key-00100");
+        mobject_store_write_op_omap_rm_range(write_op, "key-01500", "");
+        operate(ioctx, write_op);
+        assert(count_keys(ioctx, "key-00100") == 1400);
+    }
+
+    fprintf(stderr, "********** CLEAR **********\n");
+    {
+        mobject_store_write_op_t write_op = mobject_store_create_write_op();
+        mobject_store_write_op_omap_clear(write_op);
+        operate(ioctx, write_op);
+        assert(count_keys(ioctx, NULL) == 0);
+    }
+
+    fprintf(stderr, "********** REMOVAL OF THE OBJECT **********\n");
+    {
+        // the omap of a removed object does not reappear when an object
+        // with the same name is created
+        mobject_store_write_op_t write_op = mobject_store_create_write_op();
+        mobject_store_write_op_omap_set(write_op, keys, vals, val_sizes, 10);
+        operate(ioctx, write_op);
+        assert(count_keys(ioctx, "key-00000") == 10);
+
+        write_op = mobject_store_create_write_op();
+        mobject_store_write_op_remove(write_op);
+        operate(ioctx, write_op);
+
+        write_op = mobject_store_create_write_op();
+        mobject_store_write_op_create(write_op, LIBMOBJECT_CREATE_EXCLUSIVE, NULL);
+        operate(ioctx, write_op);
+        assert(count_keys(ioctx, NULL) == 0);
+    }
+
+    fprintf(stderr, "********** ATOMIC ACTIONS **********\n");
+    {
+        int64_t result1 = 0, result2 = 0;
+        int     rval1 = -1, rval2 = -1, rval3 = -1, rval4 = -1, rval5 = -1;
+        mobject_store_write_op_t write_op = mobject_store_create_write_op();
+        mobject_store_write_op_omap_add(write_op, "counter", 5, &result1, &rval1);
+        mobject_store_write_op_omap_add(write_op, "counter", -2, &result2, &rval2);
+        mobject_store_write_op_omap_cmpxchg(write_op, "state", NULL, 0, "init", 4, &rval3);
+        mobject_store_write_op_omap_cmpxchg(write_op, "state", NULL, 0, "init", 4, &rval4);
+        mobject_store_write_op_omap_cmpxchg(write_op, "state", "init", 4, "done", 4, &rval5);
+        operate(ioctx, write_op);
+        assert(rval1 == 0 && result1 == 5);
+        assert(rval2 == 0 && result2 == 3);
+        assert(rval3 == 0);
+        assert(rval4 == -ECANCELED);
+        assert(rval5 == 0);
+
+        write_op = mobject_store_create_write_op();
+        mobject_store_write_op_omap_add(write_op, "state", 1, NULL, &rval1);
+        mobject_store_write_op_omap_cmpxchg(write_op, "state", "init", 4, "oops", 4, &rval2);
+        operate(ioctx, write_op);
+        assert(rval1 == -EINVAL);
+        assert(rval2 == -ECANCELED);
+
+        mobject_store_read_op_t read_op = mobject_store_create_read_op();
+        mobject_store_omap_iter_t iter = NULL;
+        const char* atomic_keys[] = {"counter", "state"};
+        int prval = -1;
+        mobject_store_read_op_omap_get_vals_by_keys(read_op, atomic_keys, 2, &iter, &prval);
+        int ret = mobject_store_read_op_operate(read_op, ioctx, "omap-object",
+                                                LIBMOBJECT_OPERATION_NOFLAG);
+        assert(ret == 0 && prval == 0);
+        char*   key  = NULL;
+        char*   val  = NULL;
+        size_t  size = 0;
+        int64_t counter;
+        assert(mobject_store_omap_get_next(iter, &key, &val, &size) == 0);
+        assert(strcmp(key, "counter") == 0 && size == sizeof(counter));
+        memcpy(&counter, val, sizeof(counter));
+        assert(counter == 3);
+        assert(mobject_store_omap_get_next(iter, &key, &val, &size) == 0);
+        assert(strcmp(key, "state") == 0 && size == 4 && memcmp(val, "done", 4) == 0);
+        mobject_store_omap_get_end(iter);
+        mobject_store_release_read_op(read_op);
+    }
+
+    fprintf(stderr, "********** LONG KEYS **********\n");
+    {
+        char key[130];
+        memset(key, 'k', 129);
+        key[129] = '\0';
+        const char* keys[] = {key};
+        const char* vals[] = {"v"};
+        size_t      lens[] = {1};
+        int         before = count_keys(ioctx, NULL);
+
+        // keys longer than 128 characters are rejected, not truncated
+        int prval = 0;
+        mobject_store_write_op_t write_op = mobject_store_create_write_op();
+        mobject_store_write_op_omap_set(write_op, keys, vals, lens, 1);
+        mobject_store_write_op_omap_add(write_op, key, 1, NULL, &prval);
+        ret = mobject_store_write_op_operate(write_op, ioctx, "omap-object", NULL,
+                                             LIBMOBJECT_OPERATION_NOFLAG);
+        assert(ret != 0);
+        assert(prval == -EINVAL);
+        mobject_store_release_write_op(write_op);
+        assert(count_keys(ioctx, NULL) == before);
+
+        mobject_store_read_op_t read_op = mobject_store_create_read_op();
+        mobject_store_omap_iter_t iter = NULL;
+        mobject_store_read_op_omap_get_vals_by_keys(read_op, keys, 1, &iter, &prval);
+        ret = mobject_store_read_op_operate(read_op, ioctx, "omap-object",
+                                            LIBMOBJECT_OPERATION_NOFLAG);
+        assert(ret == 0 && prval == -EINVAL);
+        mobject_store_release_read_op(read_op);
+
+        // 128 characters are fine
+        key[128] = '\0';
+        write_op = mobject_store_create_write_op();
+        mobject_store_write_op_omap_set(write_op, keys, vals, lens, 1);
+        operate(ioctx, write_op);
+
+        read_op = mobject_store_create_read_op();
+        iter    = NULL;
+        prval   = -1;
+        mobject_store_read_op_omap_get_vals_by_keys(read_op, keys, 1, &iter, &prval);
+        ret = mobject_store_read_op_operate(read_op, ioctx, "omap-object",
+                                            LIBMOBJECT_OPERATION_NOFLAG);
+        assert(ret == 0 && prval == 0);
+        char*  k    = NULL;
+        char*  v    = NULL;
+        size_t size = 0;
+        assert(mobject_store_omap_get_next(iter, &k, &v, &size) == 0);
+        assert(strcmp(k, key) == 0 && size == 1);
+        mobject_store_omap_get_end(iter);
+        mobject_store_release_read_op(read_op);
+    }
+
+    mobject_store_ioctx_destroy(ioctx);
+
+    mobject_store_shutdown(cluster);
+
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <margo.h>
+#include <libmobject-store.h>
+
+#define DATA_SIZE 64
+
+/* lease granted by the server, see mobject-read-cache-test.sh */
+#define LEASE_MS 2000
+
+static void write_full(mobject_store_ioctx_t ioctx, char c, size_t size)
+{
+    char data[2 * DATA_SIZE];
+    memset(data, c, size);
+    mobject_store_write_op_t write_op = mobject_store_create_write_op();
+    mobject_store_write_op_write_full(write_op, data, size);
+    int ret = mobject_store_write_op_operate(write_op, ioctx, "cached-object",
+                                             NULL, LIBMOBJECT_OPERATION_NOFLAG);
+    assert(ret == 0);
+    mobject_store_release_write_op(write_op);
+}
+
+/* reads the object and returns its first byte */
+static char read_first(mobject_store_ioctx_t ioctx)
+{
+    char   data[DATA_SIZE];
+    size_t bytes_read = 0;
+    int    prval      = -1;
+    mobject_store_read_op_t read_op = mobject_store_create_read_op();
+    mobject_store_read_op_read(read_op, 0, DATA_SIZE, data, &bytes_read, &prval);
+    int ret = mobject_store_read_op_operate(read_op, ioctx, "cached-object",
+                                            LIBMOBJECT_OPERATION_NOFLAG);
+    assert(ret == 0 && prval == 0);
+    assert(bytes_read == DATA_SIZE);
+    mobject_store_release_read_op(read_op);
+    return data[0];
+}
+
+static uint64_t stat_size(mobject_store_ioctx_t ioctx, time_t* pmtime)
+{
+    uint64_t size  = 0;
+    int      prval = -1;
+    mobject_store_read_op_t read_op = mobject_store_create_read_op();
+    mobject_store_read_op_stat(read_op, &size, pmtime, &prval);
+    int ret = mobject_store_read_op_operate(read_op, ioctx, "cached-object",
+                                            LIBMOBJECT_OPERATION_NOFLAG);
+    assert(ret == 0 && prval == 0);
+    mobject_store_release_read_op(read_op);
+    return size;
+}
+
+/* Main function. */
+int main(int argc, char** argv)
+{
+    int ret;
+    mobject_store_t cluster;
+    mobject_store_create(&cluster, "admin");
+    mobject_store_connect(cluster);
+
+    // writes go through an ioctx without cache, so that they do not
+    // invalidate the cache of the other one
+    mobject_store_ioctx_t writer, reader;
+    mobject_store_ioctx_create(cluster, "my-object-pool", &writer);
+    mobject_store_ioctx_create(cluster, "my-object-pool", &reader);
+    ret = mobject_store_ioctx_set_read_cache(reader, 1024 * 1024);
+    assert(ret == 0);
+
+    fprintf(stderr, "********** LEASE HIT **********\n");
+    {
+        write_full(writer, 'A', DATA_SIZE);
+        assert(read_first(reader) == 'A');
+        write_full(writer, 'B', DATA_SIZE);
+        // the lease is still valid, the cached data is returned
+        assert(read_first(reader) == 'A');
+    }
+
+    fprintf(stderr, "********** VERSION INVALIDATION **********\n");
+    {
+        // once the lease has expired, the version of the object is
+        // checked and the cached data dropped
+        usleep((LEASE_MS + 500) * 1000);
+        assert(read_first(reader) == 'B');
+        assert(read_first(reader) == 'B');
+    }
+
+    fprintf(stderr, "********** INVALIDATION BY WRITES **********\n");
+    {
+        write_full(reader, 'C', DATA_SIZE);
+        assert(read_first(reader) == 'C');
+    }
+
+    fprintf(stderr, "********** STAT **********\n");
+    {
+        time_t mtime;
+        assert(stat_size(reader, NULL) == DATA_SIZE);
+        write_full(writer, 'D', 2 * DATA_SIZE);
+        // the cached size is returned while the lease is valid
+        assert(stat_size(reader, NULL) == DATA_SIZE);
+        // but the mtime was not cached, so the stat is sent to the server
+        assert(stat_size(reader, &mtime) == 2 * DATA_SIZE);
+    }
+
+    mobject_store_ioctx_destroy(reader);
+    mobject_store_ioctx_destroy(writer);
+
+    mobject_store_shutdown(cluster);
+
+    return 0;
+}
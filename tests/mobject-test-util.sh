@@ -22,11 +22,20 @@ function mobject_test_start_servers()
     startwait=${1:-15}
     maxtime=${2:-120}
     storage=${3:-/dev/shm/mobject.dat}
+    provider_config=${4:-}
+
+    config=$SCRIPT_DIR/config.json
+    if [ -n "$provider_config" ]; then
+        # same configuration, with the given mobject provider settings
+        config=`$MKTEMP`
+        sed "s|\"config\" : {},|\"config\" : $provider_config,|" \
+            $SCRIPT_DIR/config.json > $config
+    fi
 
     rm -rf ${storage}
     bake-mkpool -s 50M /dev/shm/mobject.dat
 
-    run_to $maxtime bedrock na+sm -c $SCRIPT_DIR/config.json -v trace &
+    run_to $maxtime bedrock na+sm -c $config -v trace &
     if [ $? -ne 0 ]; then
         # TODO: this doesn't actually work; can't check return code of
         # something executing in background.  We have to rely on the
@@ -37,4 +46,5 @@ function mobject_test_start_servers()
 
     # wait for servers to start
     sleep ${startwait}
+    if [ -n "$provider_config" ]; then rm -f $config; fi
 }
@@ -0,0 +1,85 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <margo.h>
+#include <libmobject-store.h>
+
+#define RECORD_SIZE 8
+#define NUM_RECORDS 100
+
+/* Main function. */
+int main(int argc, char** argv)
+{
+    int ret;
+    mobject_store_t cluster;
+    mobject_store_create(&cluster, "admin");
+    mobject_store_connect(cluster);
+    mobject_store_ioctx_t ioctx;
+    mobject_store_ioctx_create(cluster, "my-object-pool", &ioctx);
+
+    // buffer up to 128 bytes per object for at most 10 seconds
+    ret = mobject_store_ioctx_set_write_buffer(ioctx, 128, 10.0);
+    assert(ret == 0);
+
+    char expected[RECORD_SIZE * NUM_RECORDS];
+    char record[RECORD_SIZE];
+    int  i;
+
+    fprintf(stderr, "********** APPEND PHASE **********\n");
+    for(i = 0; i < NUM_RECORDS; i++) {
+        memset(record, 'A' + (i % 26), RECORD_SIZE);
+        memcpy(expected + i*RECORD_SIZE, record, RECORD_SIZE);
+        mobject_store_write_op_t write_op = mobject_store_create_write_op();
+        mobject_store_write_op_append(write_op, record, RECORD_SIZE);
+        ret = mobject_store_write_op_operate(write_op, ioctx, "log-object", NULL, LIBMOBJECT_OPERATION_NOFLAG);
+        assert(ret == 0);
+        mobject_store_release_write_op(write_op);
+    }
+
+    fprintf(stderr, "********** WRITE PHASE **********\n");
+    for(i = 0; i < NUM_RECORDS; i++) {
+        memset(record, 'a' + (i % 26), RECORD_SIZE);
+        mobject_store_write_op_t write_op = mobject_store_create_write_op();
+        mobject_store_write_op_write(write_op, record, RECORD_SIZE, i*RECORD_SIZE);
+        ret = mobject_store_write_op_operate(write_op, ioctx, "seq-object", NULL, LIBMOBJECT_OPERATION_NOFLAG);
+        assert(ret == 0);
+        mobject_store_release_write_op(write_op);
+    }
+    ret = mobject_store_ioctx_flush(ioctx, "seq-object");
+    assert(ret == 0);
+
+    fprintf(stderr, "********** READ PHASE **********\n");
+    { // the read must see the appends still pending in the buffer
+        char   read_buf[RECORD_SIZE * NUM_RECORDS];
+        size_t bytes_read = 0;
+        int    prval;
+        mobject_store_read_op_t read_op = mobject_store_create_read_op();
+        mobject_store_read_op_read(read_op, 0, sizeof(read_buf), read_buf, &bytes_read, &prval);
+        ret = mobject_store_read_op_operate(read_op, ioctx, "log-object", LIBMOBJECT_OPERATION_NOFLAG);
+        assert(ret == 0);
+        mobject_store_release_read_op(read_op);
+        printf("log-object: bytes_read = %ld, prval=%d\n", bytes_read, prval);
+        assert(bytes_read == sizeof(read_buf));
+        assert(memcmp(read_buf, expected, sizeof(read_buf)) == 0);
+    }
+    {
+        char   read_buf[RECORD_SIZE * NUM_RECORDS];
+        size_t bytes_read = 0;
+        int    prval;
+        mobject_store_read_op_t read_op = mobject_store_create_read_op();
+        mobject_store_read_op_read(read_op, 0, sizeof(read_buf), read_buf, &bytes_read, &prval);
+        ret = mobject_store_read_op_operate(read_op, ioctx, "seq-object", LIBMOBJECT_OPERATION_NOFLAG);
+        assert(ret == 0);
+        mobject_store_release_read_op(read_op);
+        printf("seq-object: bytes_read = %ld, prval=%d\n", bytes_read, prval);
+        assert(bytes_read == sizeof(read_buf));
+        for(i = 0; i < NUM_RECORDS; i++)
+            assert(read_buf[i*RECORD_SIZE] == 'a' + (i % 26));
+    }
+
+    mobject_store_ioctx_destroy(ioctx);
+
+    mobject_store_shutdown(cluster);
+
+    return 0;
+}